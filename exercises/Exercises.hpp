@@ -9,10 +9,29 @@
 #define EXERCISES_EXERCISES_HPP_
 
 #include <string>
+#include <vector>
+
+class RenderStatistics;
+class YamlParser;
 
 void RunSimulation(const float gravity, const float wind, const float startingHeight, const float startingXVelocity, const float deltaTime);
 void RenderClockFace(const std::string& fileName);
 void RenderSphere(const std::string& fileName);
 void RenderChapter7Scene(const std::string& fileName);
+// Prints statistics and writes them to imageName.stats.json, in builds with ENABLE_STATISTICS
+void WriteStatistics(const RenderStatistics& statistics, const std::string& imageName);
+// Renders the scene as the parser's camera now sees it to imageName.ppm, denoised if the camera asks
+// for it, and its costs to imageName.heatmap.ppm if the camera asks for a heatmap. label names the
+// image in the times printed, and its statistics are written as by WriteStatistics.
+void RenderImage(const YamlParser& parser, const std::string& imageName, const std::string& label);
+// Renders every frame of the parser's sequence to fileName.0000.ppm, fileName.0001.ppm and so on,
+// each denoised or with a heatmap as the camera asks
+void RenderSequence(YamlParser& parser, const std::string& fileName);
+// Renders the scene, and every frame of it if it is a sequence, on already connected workers, with
+// what the workers counted for each frame written as by WriteStatistics
+void RenderOnFarm(const std::string& fileName, const std::string& sceneDescription, const std::vector<int>& workerDescriptors);
+// Renders the scene on a render service that is already running --serve, with what it counted
+// written as by WriteStatistics
+void RenderOnService(const std::string& fileName, const std::string& sceneDescription, const std::string& endpoint);
 
 #endif /* EXERCISES_EXERCISES_HPP_ */
@@ -0,0 +1,45 @@
+/*
+ * RenderOnFarm.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Exercises.hpp"
+#include "RenderFarm.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+void RenderOnFarm(const std::string& fileName, const std::string& sceneDescription, const std::vector<int>& workerDescriptors)
+{
+    RenderCoordinator coordinator(workerDescriptors);
+    // Absolute, as workers may not share this process's working directory
+    const std::string directory = std::filesystem::absolute(fileName).parent_path().string();
+    auto startSequenceTime = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < coordinator.frameCount() || frame == 0; frame++)
+    {
+        auto startRenderTime = std::chrono::steady_clock::now();
+        Canvas canvas = coordinator.render(sceneDescription, frame, directory);
+        auto endRenderTime = std::chrono::steady_clock::now();
+
+        std::cout << "Time to render frame " << frame << " on " << coordinator.liveWorkerCount() << " workers: "
+                  << static_cast<std::chrono::duration<double>>(endRenderTime - startRenderTime).count() << std::endl;
+
+        std::ostringstream frameName;
+        frameName << fileName;
+        if (coordinator.frameCount() > 1)
+        {
+            frameName << "." << std::setw(4) << std::setfill('0') << frame;
+        }
+        std::ofstream imageFile(frameName.str() + ".ppm", std::ios::out);
+        imageFile << canvas.GetPPMString();
+        WriteStatistics(coordinator.statistics(), frameName.str());
+    }
+    auto endSequenceTime = std::chrono::steady_clock::now();
+
+    std::cout << "Time to render on farm: " << static_cast<std::chrono::duration<double>>(endSequenceTime - startSequenceTime).count() << std::endl;
+}
@@ -0,0 +1,35 @@
+/*
+ * RenderOnService.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Exercises.hpp"
+#include "RenderService.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+void RenderOnService(const std::string& fileName, const std::string& sceneDescription, const std::string& endpoint)
+{
+    RenderRequest request;
+    request.scene = sceneDescription;
+    // Absolute, as the service does not share this process's working directory
+    request.directory = std::filesystem::absolute(fileName).parent_path().string();
+
+    const int service = OpenEndpoint(endpoint, false);
+    auto startRenderTime = std::chrono::steady_clock::now();
+    RenderStatistics statistics;
+    Canvas canvas = RequestRender(service, request, &statistics);
+    auto endRenderTime = std::chrono::steady_clock::now();
+    close(service);
+
+    std::cout << "Time to render on service: " << static_cast<std::chrono::duration<double>>(endRenderTime - startRenderTime).count() << std::endl;
+
+    std::ofstream imageFile(fileName + ".ppm", std::ios::out);
+    imageFile << canvas.GetPPMString();
+    WriteStatistics(statistics, fileName);
+}
@@ -0,0 +1,29 @@
+/*
+ * RenderSequence.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Exercises.hpp"
+#include "YamlParser.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+void RenderSequence(YamlParser& parser, const std::string& fileName)
+{
+    auto startSequenceTime = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < parser.worldSequence.frameCount; frame++)
+    {
+        parser.worldSequence.apply(frame, parser.world, parser.worldCamera);
+
+        std::ostringstream frameName;
+        frameName << fileName << "." << std::setw(4) << std::setfill('0') << frame;
+        RenderImage(parser, frameName.str(), "frame " + std::to_string(frame));
+    }
+    auto endSequenceTime = std::chrono::steady_clock::now();
+
+    std::cout << "Time to render sequence: " << static_cast<std::chrono::duration<double>>(endSequenceTime - startSequenceTime).count() << std::endl;
+}
@@ -1,39 +1,161 @@
 #include "Exercises.hpp"
 #include "YamlParser.hpp"
+#include "Denoiser.hpp"
+#include "Heatmap.hpp"
+#include "RenderFarm.hpp"
+#include "RenderService.hpp"
+#include "Statistics.hpp"
+#include "Texture.hpp"
+#include "Trace.hpp"
+#include <sys/wait.h>
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <chrono>
+#include <optional>
+
+std::string ReadSceneFile(const char* fileName)
+{
+    std::ifstream yamlFile(fileName, std::ios::binary);
+    std::ostringstream sceneDescription;
+    sceneDescription << yamlFile.rdbuf();
+    return sceneDescription.str();
+}
+
+void WriteStatistics(const RenderStatistics& statistics, const std::string& imageName)
+{
+    if constexpr (RenderStatistics::Enabled)
+    {
+        std::cout << statistics.summary();
+        std::ofstream statisticsFile(imageName + ".stats.json", std::ios::out);
+        statisticsFile << statistics.json() << "\n";
+    }
+}
+
+void RenderImage(const YamlParser& parser, const std::string& imageName, const std::string& label)
+{
+    // Costs are only measured when the scene asks for a heatmap, and features when it asks to be
+    // denoised. A heatmap takes precedence, as its costs would include the denoising.
+    const Camera& camera = parser.worldCamera;
+    const bool denoise = camera.denoise && camera.costMeasure == Camera::NoCost;
+    std::optional<Canvas> costs;
+    std::optional<FeatureBuffers> features;
+    auto startRenderTime = std::chrono::steady_clock::now();
+    Canvas rendered = [&]() {
+        if (camera.costMeasure != Camera::NoCost)
+        {
+            return camera.Render(parser.world, costs.emplace(camera.hSize, camera.vSize));
+        }
+        if (denoise)
+        {
+            return camera.Render(parser.world, features.emplace(camera.hSize, camera.vSize));
+        }
+        return camera.Render(parser.world);
+    }();
+    auto endRenderTime = std::chrono::steady_clock::now();
+
+    std::cout << "Time to render " << label << ": " << static_cast<std::chrono::duration<double>>(endRenderTime - startRenderTime).count() << std::endl;
+    // Collected before denoising, as Render resets the counts and the denoiser counts nothing of its own
+    WriteStatistics(RenderStatistics::Collect(), imageName);
+    const Canvas canvas = features ? Denoise(rendered, *features, *camera.denoise) : std::move(rendered);
+    if (features)
+    {
+        std::cout << "Time to denoise " << label << ": " << static_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - endRenderTime).count() << std::endl;
+    }
+
+    std::ofstream imageFile(imageName + ".ppm", std::ios::out);
+    imageFile << canvas.GetPPMString();
+
+    if (costs)
+    {
+        std::ofstream heatmapFile(imageName + ".heatmap.ppm", std::ios::out);
+        heatmapFile << CostHeatmap(*costs).GetPPMString();
+    }
+}
+
+// Renders a scene file to fileName.ppm, or every frame of it if it is a sequence
+void RenderScene(const std::string& fileName)
+{
+    YamlParser parser = YamlParser::FromFile(fileName);
+
+    if (parser.worldSequence.animated())
+    {
+        RenderSequence(parser, fileName);
+        return;
+    }
+
+    RenderImage(parser, fileName, "scene");
+}
 
 int main(int argc, char** argv)
 {
-    if (argc == 6)
+    if (argc == 3 && std::string(argv[1]) == "--worker-fd")
+    {
+        RunRenderWorker(std::stoi(argv[2]));
+    } else if (argc == 3 && std::string(argv[1]) == "--worker")
+    {
+        ServeRenderWorker(argv[2]);
+    } else if (argc == 3 && std::string(argv[1]) == "--serve")
+    {
+        RenderService service;
+        service.serve(argv[2]);
+    } else if (argc == 4 && std::string(argv[2]) == "--service")
+    {
+        RenderOnService(argv[1], ReadSceneFile(argv[1]), argv[3]);
+    } else if (argc == 4 && std::string(argv[2]) == "--trace")
+    {
+        Tracer::Enable();
+        RenderScene(argv[1]);
+        Tracer::Disable();
+        std::ofstream traceFile(argv[3], std::ios::out);
+        traceFile << Tracer::json() << "\n";
+    } else if (argc == 4 && std::string(argv[2]) == "--texture-cache")
+    {
+        // Megabytes of texture tiles to keep in memory while rendering
+        TextureCache::Shared().setBudget(std::stoul(argv[3]) << 20U);
+        RenderScene(argv[1]);
+    } else if (argc == 4 && std::string(argv[2]) == "--farm")
+    {
+        // Local workers are this same executable, started over socket pairs
+        std::vector<int> workers;
+        const int workerCount = std::stoi(argv[3]);
+        for (int i = 0; i < workerCount; i++)
+        {
+            workers.push_back(SpawnLocalRenderWorker("/proc/self/exe"));
+        }
+        RenderOnFarm(argv[1], ReadSceneFile(argv[1]), workers);
+        while (wait(nullptr) > 0)
+        {
+        }
+    } else if (argc == 4 && std::string(argv[2]) == "--workers")
+    {
+        // A comma separated list of endpoints that are running --worker
+        std::vector<int> workers;
+        std::string endpoints = argv[3];
+        size_t begin = 0;
+        while (begin <= endpoints.size())
+        {
+            size_t end = endpoints.find(',', begin);
+            if (end == std::string::npos)
+            {
+                end = endpoints.size();
+            }
+            if (end > begin)
+            {
+                workers.push_back(ConnectToRenderWorker(endpoints.substr(begin, end - begin)));
+            }
+            begin = end + 1;
+        }
+        RenderOnFarm(argv[1], ReadSceneFile(argv[1]), workers);
+    } else if (argc == 6)
     {
         RunSimulation(std::stof(argv[1]), std::stof(argv[2]), std::stof(argv[3]), std::stof(argv[4]), std::stof(argv[5]));
     } else if (argc == 2)
     {
     	if (std::string(argv[1]).ends_with(".yml"))
     	{
-    		std::ifstream yamlFile;
-    		yamlFile.open(argv[1]);
-    		std::string sceneDescription;
-    		std::string line;
-    		while (getline(yamlFile, line))
-    		{
-    			sceneDescription += line + "\n";
-    		}
-    		yamlFile.close();
-    		YamlParser parser(sceneDescription);
-
-    	    auto startRenderTime = std::chrono::steady_clock::now();
-    	    Canvas canvas = parser.worldCamera.Render(parser.world);
-    	    auto endRenderTime = std::chrono::steady_clock::now();
-
-    	    std::cout << "Time to render scene: " << static_cast<std::chrono::duration<double>>(endRenderTime - startRenderTime).count() << std::endl;
-
-    	    std::ofstream imageFile(std::string(argv[1]) + ".ppm", std::ios::out);
-    	    //imageFile.open(fileName, std::ios::out);
-    	    imageFile << canvas.GetPPMString();
+    		RenderScene(argv[1]);
     	} else
     	{
     		//RenderClockFace(argv[1]);
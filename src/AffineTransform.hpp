@@ -0,0 +1,112 @@
+/*
+ * AffineTransform.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_AFFINETRANSFORM_HPP_
+#define SRC_AFFINETRANSFORM_HPP_
+
+#include "Matrix.hpp"
+#include "Tuple.hpp"
+
+#include <array>
+
+// A 4x4 matrix whose bottom row is 0, 0, 0, 1, stored as its top three rows along with the
+// inverse. Shape, camera and pattern transforms are all of this form, so transforming a tuple
+// costs three dot products instead of four and nothing has to be inverted per ray. Composing
+// two transforms composes their inverses as well, so a shape's full transform never needs a
+// general inversion either. Matrix<4> remains for anything genuinely projective.
+class AffineTransform
+{
+  public:
+    // Identity, which is its own inverse, so nothing is inverted for the default transform of every shape
+    constexpr AffineTransform() noexcept : AffineTransform(IDENTITY_ROWS, IDENTITY_ROWS) {}
+    // Implicit so the transform builders in Transformation.hpp can be assigned directly;
+    // the bottom row of m is assumed to be 0, 0, 0, 1
+    constexpr AffineTransform(const Matrix<4>& m) noexcept;
+
+    [[nodiscard]] constexpr bool operator==(const AffineTransform& other) const noexcept;
+    [[nodiscard]] constexpr Tuple operator*(const Tuple& t) const noexcept;
+    [[nodiscard]] friend constexpr AffineTransform operator*(const AffineTransform& a, const AffineTransform& b) noexcept
+    {
+        return {Compose(a.rows, b.rows), Compose(b.inverseRows, a.inverseRows)};
+    }
+
+    [[nodiscard]] constexpr AffineTransform inverse() const noexcept;
+    // Takes an object space normal to the space this transform maps into, which is the
+    // inverse transpose of the linear part; the result is not normalized
+    [[nodiscard]] constexpr Tuple transformNormal(const Tuple& normal) const noexcept;
+    [[nodiscard]] constexpr Matrix<4> matrix() const noexcept;
+
+  private:
+    using Rows = std::array<Tuple, 3>;
+
+    static constexpr Rows IDENTITY_ROWS = {Tuple(1, 0, 0, 0), Tuple(0, 1, 0, 0), Tuple(0, 0, 1, 0)};
+
+    constexpr AffineTransform(const Rows& rowsIn, const Rows& inverseRowsIn) noexcept : rows(rowsIn), inverseRows(inverseRowsIn) {}
+
+    // Product of a and b, treating each as a 4x4 matrix with an implicit 0, 0, 0, 1 bottom row
+    static constexpr Rows Compose(const Rows& a, const Rows& b) noexcept;
+
+    Rows rows;
+    Rows inverseRows;
+};
+
+constexpr AffineTransform::AffineTransform(const Matrix<4>& m) noexcept
+    : rows({Tuple(m[0][0], m[0][1], m[0][2], m[0][3]),
+            Tuple(m[1][0], m[1][1], m[1][2], m[1][3]),
+            Tuple(m[2][0], m[2][1], m[2][2], m[2][3])})
+{
+    // The inverse of [L | t] is [L^-1 | -L^-1 t], so only the 3x3 linear part needs inverting
+    const Matrix<3> linearInverse = m.submatrix(3, 3).inverse();
+    const Tuple translationPart = Vector(m[0][3], m[1][3], m[2][3]);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        const Tuple row = Vector(linearInverse[i][0], linearInverse[i][1], linearInverse[i][2]);
+        inverseRows[i] = Tuple(row.x, row.y, row.z, -row.dot(translationPart));
+    }
+}
+
+constexpr bool AffineTransform::operator==(const AffineTransform& other) const noexcept
+{
+    return matrix() == other.matrix();
+}
+
+constexpr Tuple AffineTransform::operator*(const Tuple& t) const noexcept
+{
+    return {rows[0].dot(t), rows[1].dot(t), rows[2].dot(t), t.w};
+}
+
+constexpr AffineTransform AffineTransform::inverse() const noexcept
+{
+    return {inverseRows, rows};
+}
+
+constexpr Tuple AffineTransform::transformNormal(const Tuple& normal) const noexcept
+{
+    Tuple n = inverseRows[0] * normal.x + inverseRows[1] * normal.y + inverseRows[2] * normal.z;
+    n.w = 0.0F;
+    return n;
+}
+
+constexpr Matrix<4> AffineTransform::matrix() const noexcept
+{
+    return Matrix<4>({{{rows[0].x, rows[0].y, rows[0].z, rows[0].w},
+                       {rows[1].x, rows[1].y, rows[1].z, rows[1].w},
+                       {rows[2].x, rows[2].y, rows[2].z, rows[2].w},
+                       {0, 0, 0, 1}}});
+}
+
+constexpr AffineTransform::Rows AffineTransform::Compose(const Rows& a, const Rows& b) noexcept
+{
+    Rows product;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        product[i] = b[0] * a[i].x + b[1] * a[i].y + b[2] * a[i].z + Tuple(0, 0, 0, a[i].w);
+    }
+    return product;
+}
+
+#endif /* SRC_AFFINETRANSFORM_HPP_ */
@@ -0,0 +1,132 @@
+/*
+ * Animation.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Animation.hpp"
+#include "Camera.hpp"
+#include "Transformation.hpp"
+#include "World.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+// The keyframes either side of frame and how far frame is from the first to the second
+template <typename Keyframe>
+static std::tuple<const Keyframe&, const Keyframe&, float> BracketKeyframes(const std::vector<Keyframe>& keyframes, const uint32_t frame) noexcept
+{
+    const auto next = std::upper_bound(keyframes.begin(), keyframes.end(), frame, [](const uint32_t f, const Keyframe& keyframe) {
+        return f < keyframe.frame;
+    });
+    if (next == keyframes.begin())
+    {
+        return {keyframes.front(), keyframes.front(), 0.0F};
+    }
+    if (next == keyframes.end())
+    {
+        return {keyframes.back(), keyframes.back(), 0.0F};
+    }
+    const Keyframe& previous = *(next - 1);
+    return {previous, *next, static_cast<float>(frame - previous.frame) / static_cast<float>(next->frame - previous.frame)};
+}
+
+static Tuple Lerp(const Tuple& a, const Tuple& b, const float t) noexcept
+{
+    return a + (b - a) * t;
+}
+
+AffineTransform TransformStep::transform() const noexcept
+{
+    switch (operation)
+    {
+    case Translate:
+        return translation(amount.x, amount.y, amount.z);
+    case Scale:
+        return scaling(amount.x, amount.y, amount.z);
+    case Rotate:
+        return rotationZ(amount.z) * rotationY(amount.y) * rotationX(amount.x);
+    }
+    return {};
+}
+
+AffineTransform TransformKeyframe::transform() const noexcept
+{
+    AffineTransform result = base;
+    for (const TransformStep& step : steps)
+    {
+        result = step.transform() * result;
+    }
+    return result;
+}
+
+AffineTransform ObjectAnimation::transformAt(const uint32_t frame) const noexcept
+{
+    const auto [previous, next, t] = BracketKeyframes(keyframes, frame);
+    if (t == 0.0F)
+    {
+        return previous.transform();
+    }
+
+    const bool sameSteps = previous.base == next.base && std::equal(previous.steps.begin(), previous.steps.end(), next.steps.begin(), next.steps.end(),
+                                                                    [](const TransformStep& a, const TransformStep& b) {
+                                                                        return a.operation == b.operation;
+                                                                    });
+    if (sameSteps)
+    {
+        AffineTransform result = previous.base;
+        for (size_t i = 0; i < previous.steps.size(); i++)
+        {
+            const TransformStep step = {previous.steps[i].operation, Lerp(previous.steps[i].amount, next.steps[i].amount, t)};
+            result = step.transform() * result;
+        }
+        return result;
+    }
+
+    const Matrix<4> a = previous.transform().matrix();
+    const Matrix<4> b = next.transform().matrix();
+    Matrix<4> blended;
+    for (uint32_t row = 0; row < 4; row++)
+    {
+        for (uint32_t column = 0; column < 4; column++)
+        {
+            blended[row][column] = a[row][column] + (b[row][column] - a[row][column]) * t;
+        }
+    }
+    return blended;
+}
+
+bool Sequence::animated() const noexcept
+{
+    return frameCount > 1;
+}
+
+void Sequence::apply(const uint32_t frame, World& world, Camera& camera) const
+{
+    for (const ObjectAnimation& animation : objects)
+    {
+        if (animation.object >= world.objectCount())
+        {
+            throw std::runtime_error("Sequence: Animated object " + std::to_string(animation.object) + " is not in a world of " + std::to_string(world.objectCount()) + " objects");
+        }
+    }
+    if (!cameraKeyframes.empty())
+    {
+        camera.transform = cameraTransformAt(frame);
+    }
+    for (const ObjectAnimation& animation : objects)
+    {
+        world.objectAt(animation.object).transform = animation.transformAt(frame);
+    }
+    world.refitAcceleration();
+    world.selectDetail(camera);
+}
+
+AffineTransform Sequence::cameraTransformAt(const uint32_t frame) const noexcept
+{
+    const auto [previous, next, t] = BracketKeyframes(cameraKeyframes, frame);
+    return ViewTransform(Lerp(previous.from, next.from, t), Lerp(previous.to, next.to, t), Lerp(previous.up, next.up, t));
+}
@@ -0,0 +1,89 @@
+/*
+ * Animation.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_ANIMATION_HPP_
+#define SRC_ANIMATION_HPP_
+
+#include "AffineTransform.hpp"
+#include "Tuple.hpp"
+
+#include <cstdint>
+#include <vector>
+
+class Camera;
+class World;
+
+// One operation of a transform as written in a scene file. Keyframes keep these rather than the
+// finished matrix so they can be interpolated parameter by parameter; interpolating the matrices
+// of a spinning object instead would shrink it halfway through every turn.
+class TransformStep
+{
+  public:
+    enum Operation
+    {
+        Translate,
+        Scale,
+        Rotate // Amount holds the x, y and z angles, applied in that order
+    };
+
+    Operation operation = Translate;
+    Tuple amount;
+
+    [[nodiscard]] bool operator==(const TransformStep& other) const noexcept = default;
+    [[nodiscard]] AffineTransform transform() const noexcept;
+};
+
+class TransformKeyframe
+{
+  public:
+    uint32_t frame = 0;
+    AffineTransform base; // A named transform the steps start from
+    std::vector<TransformStep> steps;
+
+    // base followed by each step in order
+    [[nodiscard]] AffineTransform transform() const noexcept;
+};
+
+class CameraKeyframe
+{
+  public:
+    uint32_t frame = 0;
+    Tuple from;
+    Tuple to;
+    Tuple up;
+};
+
+class ObjectAnimation
+{
+  public:
+    size_t object = 0;                        // Index into World::objects()
+    std::vector<TransformKeyframe> keyframes; // Sorted by frame
+
+    // Interpolates linearly between the keyframes either side of frame, holding the first and last
+    // keyframes before and after them. Keyframes with the same base and the same operations in the
+    // same order are interpolated step by step, anything else element by element.
+    [[nodiscard]] AffineTransform transformAt(uint32_t frame) const noexcept;
+};
+
+// Everything that changes over a sequence of frames. Only transforms are animated, so a sequence
+// renders every frame from one parsed world, refitting its top level hierarchy between frames.
+class Sequence
+{
+  public:
+    uint32_t frameCount = 1;
+    std::vector<CameraKeyframe> cameraKeyframes; // Sorted by frame; empty if the camera does not move
+    std::vector<ObjectAnimation> objects;
+
+    [[nodiscard]] bool animated() const noexcept;
+    // Poses the camera and every animated object for frame; throws, leaving the world and camera as
+    // they were, if an animation names an object the world does not have
+    void apply(uint32_t frame, World& world, Camera& camera) const;
+    // The camera's view transform at frame, interpolating from, to and up; needs a camera keyframe
+    [[nodiscard]] AffineTransform cameraTransformAt(uint32_t frame) const noexcept;
+};
+
+#endif /* SRC_ANIMATION_HPP_ */
@@ -0,0 +1,100 @@
+/*
+ * Arena.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Arena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+void* Arena::allocate(const size_t bytes, const size_t alignment)
+{
+    while (activeBlock < blocks.size())
+    {
+        const Block& block = blocks[activeBlock];
+        const uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        const uintptr_t aligned = (base + offset + alignment - 1) & ~(alignment - 1);
+        if (aligned + bytes <= base + block.size)
+        {
+            offset = aligned + bytes - base;
+            return reinterpret_cast<void*>(aligned);
+        }
+        // Blocks kept from before the last reset are reused in order before growing
+        activeBlock++;
+        offset = 0;
+    }
+
+    const size_t size = std::max(blockSize, bytes + alignment);
+    blocks.push_back({std::make_unique<std::byte[]>(size), size});
+    activeBlock = blocks.size() - 1;
+    offset = 0;
+    return allocate(bytes, alignment);
+}
+
+void Arena::deallocate(void* pointer, const size_t bytes) noexcept
+{
+    // Only the most recent allocation can be given back early; everything else waits for reset()
+    if (activeBlock < blocks.size() && static_cast<std::byte*>(pointer) + bytes == blocks[activeBlock].data.get() + offset)
+    {
+        offset -= bytes;
+    }
+}
+
+void Arena::reset() noexcept
+{
+    activeBlock = 0;
+    offset = 0;
+}
+
+size_t Arena::bytesInUse() const noexcept
+{
+    size_t bytes = offset;
+    for (size_t i = 0; i < activeBlock && i < blocks.size(); i++)
+    {
+        bytes += blocks[i].size;
+    }
+    return bytes;
+}
+
+size_t Arena::capacity() const noexcept
+{
+    size_t bytes = 0;
+    for (const Block& block : blocks)
+    {
+        bytes += block.size;
+    }
+    return bytes;
+}
+
+Arena& Arena::threadLocal() noexcept
+{
+    thread_local Arena arena;
+    return arena;
+}
+
+Arena* Arena::current() noexcept
+{
+    return active();
+}
+
+Arena*& Arena::active() noexcept
+{
+    thread_local Arena* activeArena = nullptr;
+    return activeArena;
+}
+
+ArenaScope::ArenaScope() noexcept : previous(Arena::active())
+{
+    Arena::active() = &Arena::threadLocal();
+}
+
+ArenaScope::~ArenaScope() noexcept
+{
+    Arena::active() = previous;
+    if (previous == nullptr)
+    {
+        Arena::threadLocal().reset();
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * Arena.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_ARENA_HPP_
+#define SRC_ARENA_HPP_
+
+#include "Statistics.hpp"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bump allocator for short-lived render temporaries. Memory is handed out by advancing an offset
+// through large blocks and is only reclaimed all at once by reset(), which keeps the blocks around
+// for the next pixel or tile. Each thread owns one arena, so allocation never takes a lock.
+class Arena
+{
+  public:
+    explicit Arena(size_t blockSizeIn = 64 * 1024) noexcept : blockSize(blockSizeIn){};
+    ~Arena() noexcept = default;
+    Arena(const Arena&) = delete;
+    Arena(Arena&&) noexcept = default;
+    Arena& operator=(const Arena&) = delete;
+    Arena& operator=(Arena&&) noexcept = default;
+
+    [[nodiscard]] void* allocate(size_t bytes, size_t alignment);
+    void deallocate(void* pointer, size_t bytes) noexcept;
+    void reset() noexcept;
+    [[nodiscard]] size_t bytesInUse() const noexcept;
+    [[nodiscard]] size_t capacity() const noexcept;
+
+    // The calling thread's arena
+    static Arena& threadLocal() noexcept;
+    // The arena render-time containers should allocate from, or nullptr outside of an ArenaScope
+    static Arena* current() noexcept;
+
+  private:
+    class Block
+    {
+      public:
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    size_t blockSize;
+    std::vector<Block> blocks;
+    size_t activeBlock = 0;
+    size_t offset = 0;
+
+    friend class ArenaScope;
+    static Arena*& active() noexcept;
+};
+
+// Makes the calling thread's arena current for its lifetime and resets it when the outermost
+// scope ends. Anything allocated from the arena must not outlive the scope.
+class ArenaScope
+{
+  public:
+    ArenaScope() noexcept;
+    ~ArenaScope() noexcept;
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope(ArenaScope&&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+    ArenaScope& operator=(ArenaScope&&) = delete;
+
+  private:
+    Arena* previous;
+};
+
+// Standard allocator that binds to the current arena when constructed, and falls back to the
+// global heap when no ArenaScope is active (e.g. outside of Camera::Render).
+template <typename T>
+class ArenaAllocator
+{
+  public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    Arena* arena;
+
+    ArenaAllocator() noexcept : arena(Arena::current()){};
+    template <typename U>
+    explicit(false) ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    [[nodiscard]] T* allocate(size_t n)
+    {
+        if (arena == nullptr)
+        {
+            CountStatistic(RenderStatistics::HeapAllocations);
+            return std::allocator<T>().allocate(n);
+        }
+        CountStatistic(RenderStatistics::ArenaAllocations);
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* pointer, size_t n) noexcept
+    {
+        if (arena == nullptr)
+        {
+            std::allocator<T>().deallocate(pointer, n);
+        } else
+        {
+            arena->deallocate(pointer, n * sizeof(T));
+        }
+    }
+
+    // Copies of a container bind to whichever arena is current where the copy is made
+    [[nodiscard]] ArenaAllocator select_on_container_copy_construction() const noexcept { return {}; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena == other.arena; }
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif /* SRC_ARENA_HPP_ */
@@ -0,0 +1,141 @@
+/*
+ * BoundingBox.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "BoundingBox.hpp"
+#include "Ray.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+bool BoundingBox::operator==(const BoundingBox& other) const noexcept
+{
+    return minimum.x == other.minimum.x && minimum.y == other.minimum.y && minimum.z == other.minimum.z &&
+           maximum.x == other.maximum.x && maximum.y == other.maximum.y && maximum.z == other.maximum.z;
+}
+
+void BoundingBox::add(const Tuple& point) noexcept
+{
+    minimum = Point(std::min(minimum.x, point.x), std::min(minimum.y, point.y), std::min(minimum.z, point.z));
+    maximum = Point(std::max(maximum.x, point.x), std::max(maximum.y, point.y), std::max(maximum.z, point.z));
+}
+
+void BoundingBox::add(const BoundingBox& other) noexcept
+{
+    if (other.empty())
+    {
+        return;
+    }
+    add(other.minimum);
+    add(other.maximum);
+}
+
+bool BoundingBox::empty() const noexcept
+{
+    return minimum.x > maximum.x || minimum.y > maximum.y || minimum.z > maximum.z;
+}
+
+bool BoundingBox::bounded() const noexcept
+{
+    return !empty() &&
+           std::isfinite(minimum.x) && std::isfinite(minimum.y) && std::isfinite(minimum.z) &&
+           std::isfinite(maximum.x) && std::isfinite(maximum.y) && std::isfinite(maximum.z);
+}
+
+bool BoundingBox::contains(const Tuple& point) const noexcept
+{
+    return point.x >= minimum.x && point.x <= maximum.x &&
+           point.y >= minimum.y && point.y <= maximum.y &&
+           point.z >= minimum.z && point.z <= maximum.z;
+}
+
+Tuple BoundingBox::centroid() const noexcept
+{
+    return Point((minimum.x + maximum.x) * 0.5F, (minimum.y + maximum.y) * 0.5F, (minimum.z + maximum.z) * 0.5F);
+}
+
+float BoundingBox::surfaceArea() const noexcept
+{
+    if (empty())
+    {
+        return 0.0F;
+    }
+    const Tuple extent = maximum - minimum;
+    return 2.0F * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+uint32_t BoundingBox::largestAxis() const noexcept
+{
+    const Tuple extent = maximum - minimum;
+    if (extent.x >= extent.y && extent.x >= extent.z)
+    {
+        return 0;
+    }
+    return extent.y >= extent.z ? 1 : 2;
+}
+
+BoundingBox BoundingBox::transform(const AffineTransform& m) const noexcept
+{
+    if (empty())
+    {
+        return {};
+    }
+    if (!bounded())
+    {
+        return Infinite();
+    }
+
+    BoundingBox transformed;
+    for (uint32_t corner = 0; corner < 8; corner++)
+    {
+        transformed.add(m * Point((corner & 1U) != 0 ? maximum.x : minimum.x,
+                                  (corner & 2U) != 0 ? maximum.y : minimum.y,
+                                  (corner & 4U) != 0 ? maximum.z : minimum.z));
+    }
+    return transformed;
+}
+
+std::optional<std::pair<float, float>> BoundingBox::intersect(const Ray& r, float tMin, float tMax) const noexcept
+{
+    const std::array<float, 3> origin = {r.origin.x, r.origin.y, r.origin.z};
+    const std::array<float, 3> direction = {r.direction.x, r.direction.y, r.direction.z};
+    const std::array<float, 3> lower = {minimum.x, minimum.y, minimum.z};
+    const std::array<float, 3> upper = {maximum.x, maximum.y, maximum.z};
+
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        if (direction[axis] == 0.0F)
+        {
+            // Parallel to this pair of slabs, so either always between them or never
+            if (origin[axis] < lower[axis] || origin[axis] > upper[axis])
+            {
+                return std::nullopt;
+            }
+            continue;
+        }
+        const float inverseDirection = 1.0F / direction[axis];
+        float tNear = (lower[axis] - origin[axis]) * inverseDirection;
+        float tFar = (upper[axis] - origin[axis]) * inverseDirection;
+        if (tNear > tFar)
+        {
+            std::swap(tNear, tFar);
+        }
+        tMin = std::max(tMin, tNear);
+        tMax = std::min(tMax, tFar);
+        if (tMin > tMax)
+        {
+            return std::nullopt;
+        }
+    }
+    return std::make_pair(tMin, tMax);
+}
+
+BoundingBox BoundingBox::Infinite() noexcept
+{
+    constexpr float infinity = std::numeric_limits<float>::infinity();
+    return {Point(-infinity, -infinity, -infinity), Point(infinity, infinity, infinity)};
+}
@@ -0,0 +1,52 @@
+/*
+ * BoundingBox.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_BOUNDINGBOX_HPP_
+#define SRC_BOUNDINGBOX_HPP_
+
+#include "AffineTransform.hpp"
+#include "Tuple.hpp"
+
+#include <limits>
+#include <optional>
+#include <utility>
+
+class Ray;
+
+// Axis-aligned box. A default constructed box is empty (minimum above maximum) so that adding
+// points or boxes to it grows it from nothing. Infinite extents are allowed for shapes like planes.
+class BoundingBox
+{
+  public:
+    Tuple minimum = Point(std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity());
+    Tuple maximum = Point(-std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity());
+
+    BoundingBox() noexcept = default;
+    BoundingBox(const Tuple& minimumIn, const Tuple& maximumIn) noexcept : minimum(minimumIn), maximum(maximumIn) {}
+
+    // Exact comparison; Tuple's epsilon comparison does not work with infinite extents
+    [[nodiscard]] bool operator==(const BoundingBox& other) const noexcept;
+
+    void add(const Tuple& point) noexcept;
+    void add(const BoundingBox& other) noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] bool bounded() const noexcept;
+    [[nodiscard]] bool contains(const Tuple& point) const noexcept;
+    [[nodiscard]] Tuple centroid() const noexcept;
+    [[nodiscard]] float surfaceArea() const noexcept;
+    [[nodiscard]] uint32_t largestAxis() const noexcept;
+    // The box around this box's corners after transformation; unbounded boxes stay unbounded
+    [[nodiscard]] BoundingBox transform(const AffineTransform& m) const noexcept;
+    // Parameter range over which r is inside the box, clipped to [tMin, tMax]
+    [[nodiscard]] std::optional<std::pair<float, float>> intersect(const Ray& r,
+                                                                   float tMin = -std::numeric_limits<float>::infinity(),
+                                                                   float tMax = std::numeric_limits<float>::infinity()) const noexcept;
+
+    static BoundingBox Infinite() noexcept;
+};
+
+#endif /* SRC_BOUNDINGBOX_HPP_ */
@@ -0,0 +1,344 @@
+/*
+ * BoundingVolumeHierarchy.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "BoundingVolumeHierarchy.hpp"
+#include "Ray.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+std::string BVHStatistics::summary() const
+{
+    std::ostringstream text;
+    text << nodeCount << " nodes, " << leafCount << " leaves of " << minimumLeafSize << "-" << maximumLeafSize
+         << " primitives (" << averageLeafSize << " average), depth " << depth << ", SAH cost " << sahCost
+         << ", built in " << buildSeconds << "s";
+    return text.str();
+}
+
+const BVHStatistics& BoundingVolumeHierarchy::build(std::span<const BoundingBox> primitiveBounds)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    clear();
+    isBuilt = true;
+    builtPrimitiveCount = static_cast<uint32_t>(primitiveBounds.size());
+
+    for (uint32_t i = 0; i < primitiveBounds.size(); i++)
+    {
+        if (primitiveBounds[i].bounded())
+        {
+            primitiveIndices.push_back(i);
+        } else if (!primitiveBounds[i].empty())
+        {
+            unbounded.push_back(i);
+        }
+    }
+
+    if (!primitiveIndices.empty())
+    {
+        std::vector<Tuple> centroids(primitiveBounds.size());
+        const auto primitives = static_cast<int64_t>(primitiveBounds.size());
+#pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < primitives; i++)
+        {
+            centroids[static_cast<size_t>(i)] = primitiveBounds[static_cast<size_t>(i)].centroid();
+        }
+
+        // A binary tree with one primitive per leaf is the largest possible, so nodes are
+        // claimed from this up front and no task ever reallocates the list
+        nodeList.resize(2 * primitiveIndices.size() - 1);
+        std::atomic<uint32_t> nodesUsed = 1;
+        const auto primitiveCount = static_cast<uint32_t>(primitiveIndices.size());
+#pragma omp parallel
+#pragma omp single
+        buildNode(primitiveBounds, centroids, 0, 0, primitiveCount, nodesUsed);
+        nodeList.resize(nodesUsed);
+    }
+
+    gatherStatistics();
+    buildStatistics.buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return buildStatistics;
+}
+
+bool BoundingVolumeHierarchy::refit(std::span<const BoundingBox> primitiveBounds) noexcept
+{
+    if (!isBuilt || primitiveBounds.size() != builtPrimitiveCount)
+    {
+        return false;
+    }
+    // Primitives that were empty at build time are in neither list, so must still be empty
+    const auto nonEmpty = std::count_if(primitiveBounds.begin(), primitiveBounds.end(), [](const BoundingBox& box) {
+        return !box.empty();
+    });
+    const bool treeStillBounded = std::all_of(primitiveIndices.begin(), primitiveIndices.end(), [&](const uint32_t primitive) {
+        return primitiveBounds[primitive].bounded();
+    });
+    const bool unboundedStillUnbounded = std::none_of(unbounded.begin(), unbounded.end(), [&](const uint32_t primitive) {
+        return primitiveBounds[primitive].bounded() || primitiveBounds[primitive].empty();
+    });
+    if (static_cast<size_t>(nonEmpty) != primitiveIndices.size() + unbounded.size() || !treeStillBounded || !unboundedStillUnbounded)
+    {
+        return false;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    // Children are always claimed after their parent, so walking backwards visits both before it
+    for (auto node = nodeList.rbegin(); node != nodeList.rend(); node++)
+    {
+        node->bounds = BoundingBox();
+        if (node->isLeaf())
+        {
+            for (uint32_t i = node->first; i < node->first + node->count; i++)
+            {
+                node->bounds.add(primitiveBounds[primitiveIndices[i]]);
+            }
+        } else
+        {
+            node->bounds.add(nodeList[node->first].bounds);
+            node->bounds.add(nodeList[node->first + 1].bounds);
+        }
+    }
+
+    gatherStatistics();
+    buildStatistics.buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
+
+void BoundingVolumeHierarchy::clear() noexcept
+{
+    nodeList.clear();
+    primitiveIndices.clear();
+    unbounded.clear();
+    buildStatistics = BVHStatistics();
+    builtPrimitiveCount = 0;
+    isBuilt = false;
+}
+
+uint32_t BoundingVolumeHierarchy::primitiveCount() const noexcept
+{
+    return builtPrimitiveCount;
+}
+
+bool BoundingVolumeHierarchy::built() const noexcept
+{
+    return isBuilt;
+}
+
+const std::vector<BVHNode>& BoundingVolumeHierarchy::nodes() const noexcept
+{
+    return nodeList;
+}
+
+const std::vector<uint32_t>& BoundingVolumeHierarchy::primitives() const noexcept
+{
+    return primitiveIndices;
+}
+
+const std::vector<uint32_t>& BoundingVolumeHierarchy::unboundedPrimitives() const noexcept
+{
+    return unbounded;
+}
+
+const BVHStatistics& BoundingVolumeHierarchy::statistics() const noexcept
+{
+    return buildStatistics;
+}
+
+ArenaVector<uint32_t> BoundingVolumeHierarchy::candidates(const Ray& r) const noexcept
+{
+    ArenaVector<uint32_t> found(unbounded.begin(), unbounded.end());
+    if (nodeList.empty())
+    {
+        return found;
+    }
+
+    // Binned SAH trees stay shallow, but fall back to the heap rather than overflow on a degenerate one
+    ArenaVector<uint32_t> stack;
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const BVHNode& node = nodeList[stack.back()];
+        stack.pop_back();
+        if (!node.bounds.intersect(r))
+        {
+            continue;
+        }
+        if (node.isLeaf())
+        {
+            found.insert(found.end(), primitiveIndices.begin() + node.first, primitiveIndices.begin() + node.first + node.count);
+        } else
+        {
+            stack.push_back(node.first + 1);
+            stack.push_back(node.first);
+        }
+    }
+
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+void BoundingVolumeHierarchy::buildNode(std::span<const BoundingBox> primitiveBounds, std::span<const Tuple> centroids, const uint32_t nodeIndex,
+                                        const uint32_t begin, const uint32_t end, std::atomic<uint32_t>& nodesUsed)
+{
+    BVHNode& node = nodeList[nodeIndex];
+    BoundingBox centroidBounds;
+    node.bounds = BoundingBox();
+    for (uint32_t i = begin; i < end; i++)
+    {
+        node.bounds.add(primitiveBounds[primitiveIndices[i]]);
+        centroidBounds.add(centroids[primitiveIndices[i]]);
+    }
+
+    const uint32_t count = end - begin;
+    node.first = begin;
+    node.count = count;
+    if (count == 1)
+    {
+        return;
+    }
+
+    class Bin
+    {
+      public:
+        BoundingBox bounds;
+        uint32_t count = 0;
+    };
+
+    // Try a split after every bin on every axis; a split's cost is the traversal step plus the
+    // primitives on each side weighted by the chance a ray hitting the parent also hits that side
+    const float parentArea = node.bounds.surfaceArea();
+    float bestCost = std::numeric_limits<float>::infinity();
+    uint32_t bestAxis = 0;
+    uint32_t bestSplit = 0;
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        const float lower = AxisOf(centroidBounds.minimum, axis);
+        const float extent = AxisOf(centroidBounds.maximum, axis) - lower;
+        if (extent <= 0.0F)
+        {
+            continue;
+        }
+
+        std::array<Bin, BIN_COUNT> bins{};
+        const float scale = static_cast<float>(BIN_COUNT) / extent;
+        for (uint32_t i = begin; i < end; i++)
+        {
+            const uint32_t primitive = primitiveIndices[i];
+            const auto bin = std::min(BIN_COUNT - 1, static_cast<uint32_t>((AxisOf(centroids[primitive], axis) - lower) * scale));
+            bins[bin].count++;
+            bins[bin].bounds.add(primitiveBounds[primitive]);
+        }
+
+        std::array<float, BIN_COUNT - 1> leftCost{};
+        BoundingBox left;
+        uint32_t leftCount = 0;
+        for (uint32_t split = 0; split < BIN_COUNT - 1; split++)
+        {
+            left.add(bins[split].bounds);
+            leftCount += bins[split].count;
+            leftCost[split] = left.surfaceArea() * static_cast<float>(leftCount);
+        }
+        BoundingBox right;
+        uint32_t rightCount = 0;
+        for (uint32_t split = BIN_COUNT - 1; split > 0; split--)
+        {
+            right.add(bins[split].bounds);
+            rightCount += bins[split].count;
+            const float cost = TRAVERSAL_COST + (leftCost[split - 1] + right.surfaceArea() * static_cast<float>(rightCount)) / parentArea;
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split - 1;
+            }
+        }
+    }
+
+    // Stop when no split beats intersecting everything here. Larger ranges always split, in half
+    // when every centroid coincides, so no leaf holds more than MAXIMUM_LEAF_SIZE primitives.
+    const bool foundSplit = bestCost != std::numeric_limits<float>::infinity();
+    const auto leafCost = static_cast<float>(count);
+    if (count <= MAXIMUM_LEAF_SIZE && (!foundSplit || leafCost <= bestCost))
+    {
+        return;
+    }
+
+    uint32_t middle = begin + count / 2;
+    if (foundSplit)
+    {
+        const float lower = AxisOf(centroidBounds.minimum, bestAxis);
+        const float scale = static_cast<float>(BIN_COUNT) / (AxisOf(centroidBounds.maximum, bestAxis) - lower);
+        const auto partitioned = static_cast<uint32_t>(std::partition(primitiveIndices.begin() + begin, primitiveIndices.begin() + end, [&](const uint32_t primitive) {
+                                                           return std::min(BIN_COUNT - 1, static_cast<uint32_t>((AxisOf(centroids[primitive], bestAxis) - lower) * scale)) <= bestSplit;
+                                                       }) -
+                                                       primitiveIndices.begin());
+        if (partitioned != begin && partitioned != end)
+        {
+            middle = partitioned;
+        }
+    }
+
+    const uint32_t children = nodesUsed.fetch_add(2);
+    node.first = children;
+    node.count = 0;
+    if (count > TASK_THRESHOLD)
+    {
+#pragma omp task shared(nodesUsed)
+        buildNode(primitiveBounds, centroids, children, begin, middle, nodesUsed);
+        buildNode(primitiveBounds, centroids, children + 1, middle, end, nodesUsed);
+#pragma omp taskwait
+    } else
+    {
+        buildNode(primitiveBounds, centroids, children, begin, middle, nodesUsed);
+        buildNode(primitiveBounds, centroids, children + 1, middle, end, nodesUsed);
+    }
+}
+
+void BoundingVolumeHierarchy::gatherStatistics() noexcept
+{
+    buildStatistics = BVHStatistics();
+    if (nodeList.empty())
+    {
+        return;
+    }
+
+    const float rootArea = nodeList[0].bounds.surfaceArea();
+    buildStatistics.nodeCount = static_cast<uint32_t>(nodeList.size());
+    buildStatistics.minimumLeafSize = std::numeric_limits<uint32_t>::max();
+
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{0, 1}};
+    while (!stack.empty())
+    {
+        const auto [index, depth] = stack.back();
+        stack.pop_back();
+        const BVHNode& node = nodeList[index];
+        const float areaRatio = rootArea > 0.0F ? node.bounds.surfaceArea() / rootArea : 1.0F;
+        buildStatistics.depth = std::max(buildStatistics.depth, depth);
+        if (node.isLeaf())
+        {
+            buildStatistics.leafCount++;
+            buildStatistics.minimumLeafSize = std::min(buildStatistics.minimumLeafSize, node.count);
+            buildStatistics.maximumLeafSize = std::max(buildStatistics.maximumLeafSize, node.count);
+            buildStatistics.sahCost += areaRatio * static_cast<float>(node.count);
+        } else
+        {
+            buildStatistics.sahCost += areaRatio * TRAVERSAL_COST;
+            stack.emplace_back(node.first, depth + 1);
+            stack.emplace_back(node.first + 1, depth + 1);
+        }
+    }
+    buildStatistics.averageLeafSize = static_cast<float>(primitiveIndices.size()) / static_cast<float>(buildStatistics.leafCount);
+}
+
+float BoundingVolumeHierarchy::AxisOf(const Tuple& t, const uint32_t axis) noexcept
+{
+    return axis == 0 ? t.x : (axis == 1 ? t.y : t.z);
+}
@@ -0,0 +1,95 @@
+/*
+ * BoundingVolumeHierarchy.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_BOUNDINGVOLUMEHIERARCHY_HPP_
+#define SRC_BOUNDINGVOLUMEHIERARCHY_HPP_
+
+#include "Arena.hpp"
+#include "BoundingBox.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+class Ray;
+
+class BVHNode
+{
+  public:
+    BoundingBox bounds;
+    uint32_t first = 0; // Leaves: first entry in the primitive list; interior nodes: left child, with the right child after it
+    uint32_t count = 0; // Primitives in a leaf; zero for interior nodes
+
+    [[nodiscard]] bool isLeaf() const noexcept { return count > 0; }
+};
+
+// Build time and quality of a hierarchy. The SAH cost is the expected cost of a random ray through
+// the root bounds, in units of one primitive intersection, so lower is better.
+class BVHStatistics
+{
+  public:
+    double buildSeconds = 0.0; // Of the last build or refit
+    float sahCost = 0.0F;
+    uint32_t depth = 0;
+    uint32_t nodeCount = 0;
+    uint32_t leafCount = 0;
+    uint32_t minimumLeafSize = 0;
+    uint32_t maximumLeafSize = 0;
+    float averageLeafSize = 0.0F;
+
+    [[nodiscard]] std::string summary() const;
+};
+
+// Binary hierarchy over primitives, identified by their index in the bounds passed to build().
+// Each node is split where the surface area heuristic, evaluated over a fixed number of centroid
+// bins per axis, is cheapest. Subtrees above a size threshold are built as OpenMP tasks.
+// Unbounded primitives cannot be placed in the tree and are returned as candidates for every ray.
+class BoundingVolumeHierarchy
+{
+  public:
+    constexpr static uint32_t BIN_COUNT = 16;
+    constexpr static uint32_t MAXIMUM_LEAF_SIZE = 4; // Never exceeded, even where primitives cannot be told apart
+    constexpr static uint32_t TASK_THRESHOLD = 4096; // Smaller subtrees are built by the task that split them off
+    constexpr static float TRAVERSAL_COST = 1.0F;    // Relative to the cost of one primitive intersection
+
+    const BVHStatistics& build(std::span<const BoundingBox> primitiveBounds);
+    // Moves every node's bounds to fit new bounds for the same primitives, keeping the tree's shape,
+    // in a single pass over the nodes. The tree degrades as primitives move away from where it was
+    // built; the SAH cost in statistics() is updated so callers can decide when to rebuild instead.
+    // Returns false, leaving the tree untouched, if the primitives no longer match the ones it was
+    // built over or one has become bounded or unbounded.
+    bool refit(std::span<const BoundingBox> primitiveBounds) noexcept;
+    void clear() noexcept;
+    [[nodiscard]] bool built() const noexcept;
+    [[nodiscard]] uint32_t primitiveCount() const noexcept; // Including unbounded and empty primitives
+    [[nodiscard]] const std::vector<BVHNode>& nodes() const noexcept;
+    // Bounded primitives in leaf order; a leaf covers count entries from its first
+    [[nodiscard]] const std::vector<uint32_t>& primitives() const noexcept;
+    [[nodiscard]] const std::vector<uint32_t>& unboundedPrimitives() const noexcept;
+    [[nodiscard]] const BVHStatistics& statistics() const noexcept;
+    // Sorted indices of every primitive in a leaf the line of r passes through, including behind its
+    // origin, since group intersections must report every hit
+    [[nodiscard]] ArenaVector<uint32_t> candidates(const Ray& r) const noexcept;
+
+  private:
+    std::vector<BVHNode> nodeList;
+    std::vector<uint32_t> primitiveIndices;
+    std::vector<uint32_t> unbounded;
+    BVHStatistics buildStatistics;
+    uint32_t builtPrimitiveCount = 0;
+    bool isBuilt = false;
+
+    void buildNode(std::span<const BoundingBox> primitiveBounds, std::span<const Tuple> centroids, uint32_t nodeIndex,
+                   uint32_t begin, uint32_t end, std::atomic<uint32_t>& nodesUsed);
+    void gatherStatistics() noexcept;
+
+    static float AxisOf(const Tuple& t, uint32_t axis) noexcept;
+};
+
+#endif /* SRC_BOUNDINGVOLUMEHIERARCHY_HPP_ */
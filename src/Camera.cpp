@@ -6,6 +6,11 @@
  */
 
 #include "Camera.hpp"
+#include "Statistics.hpp"
+#include "Trace.hpp"
+#include "Wavefront.hpp"
+#include <algorithm>
+#include <chrono>
 #include <omp.h>
 
 bool Camera::operator==(const Camera& other) const noexcept
@@ -16,35 +21,116 @@ bool Camera::operator==(const Camera& other) const noexcept
            transform == other.transform &&
            pixelSize == other.pixelSize &&
            halfWidth == other.halfWidth &&
-           halfHeight == other.halfHeight;
+           halfHeight == other.halfHeight &&
+           renderMode == other.renderMode &&
+           costMeasure == other.costMeasure &&
+           tileSize == other.tileSize &&
+           sampler == other.sampler &&
+           samplesPerPixel == other.samplesPerPixel &&
+           denoise == other.denoise;
 }
 
 Ray Camera::rayForPixel(const uint32_t px, const uint32_t py) const noexcept
 {
-    const float xOffset = (static_cast<float>(px) + 0.5F) * pixelSize;
-    const float yOffset = (static_cast<float>(py) + 0.5F) * pixelSize;
+    return rayForPixel(px, py, 0.5F, 0.5F);
+}
+
+Ray Camera::rayForPixel(const uint32_t px, const uint32_t py, const float xOffset, const float yOffset) const noexcept
+{
+    return differentialRayForPixel(px, py, xOffset, yOffset).ray;
+}
+
+DifferentialRay Camera::differentialRayForPixel(const uint32_t px, const uint32_t py, const float xOffset, const float yOffset) const noexcept
+{
+    CountStatistic(RenderStatistics::PrimaryRays);
+    const float worldX = halfWidth - (static_cast<float>(px) + xOffset) * pixelSize;
+    const float worldY = halfHeight - (static_cast<float>(py) + yOffset) * pixelSize;
+
+    const AffineTransform cameraToWorld = transform.inverse();
+    const Tuple pixel = cameraToWorld * Point(worldX, worldY, -1);
+    const Tuple origin = cameraToWorld * Point(0, 0, 0);
+    const Tuple toPixel = pixel - origin;
+    const Tuple direction = toPixel.normalize();
 
-    const float worldX = halfWidth - xOffset;
-    const float worldY = halfHeight - yOffset;
+    // The next pixel over moves the point on the canvas by pixelSize, against the canvas axes.
+    // Differentiating the normalized direction gives (d - direction (direction . d)) / |toPixel|.
+    const float distance = toPixel.magnitude();
+    const auto directionChange = [&](const Tuple& pixelChange) {
+        return (pixelChange - direction * direction.dot(pixelChange)) * (1.0F / distance);
+    };
+    const RayDifferential differential = {Vector(0, 0, 0), directionChange(cameraToWorld * Vector(-pixelSize, 0, 0)),
+                                          Vector(0, 0, 0), directionChange(cameraToWorld * Vector(0, -pixelSize, 0))};
 
-    const Tuple pixel = transform.inverse() * Point(worldX, worldY, -1);
-    const Tuple origin = transform.inverse() * Point(0, 0, 0);
-    const Tuple direction = (pixel - origin).normalize();
+    return {Ray(origin, direction), differential};
+}
 
-    return {origin, direction};
+DifferentialRay Camera::rayForSample(const uint32_t x, const uint32_t y, const uint32_t index) const noexcept
+{
+    const std::array<float, 2> position = sampler.sample(x, y, index);
+    DifferentialRay ray = differentialRayForPixel(x, y, position[0], position[1]);
+    if (samplesPerPixel > 1)
+    {
+        // n well spread samples are about 1 / sqrt(n) of a pixel apart on each axis
+        const float spacing = 1.0F / std::sqrt(static_cast<float>(samplesPerPixel));
+        ray.differential->directionX = ray.differential->directionX * spacing;
+        ray.differential->directionY = ray.differential->directionY * spacing;
+    }
+    return ray;
+}
+
+Color Camera::pixelColor(const World& w, const uint32_t x, const uint32_t y, SurfaceFeatures* features) const noexcept
+{
+    if (samplesPerPixel <= 1)
+    {
+        return features == nullptr ? w.colorAt(rayForSample(x, y, 0)) : w.colorAt(rayForSample(x, y, 0), *features);
+    }
+    const float sampleWeight = 1.0F / static_cast<float>(samplesPerPixel);
+    Color sum;
+    SurfaceFeatures average;
+    for (uint32_t sample = 0; sample < samplesPerPixel; sample++)
+    {
+        if (features == nullptr)
+        {
+            sum = sum + w.colorAt(rayForSample(x, y, sample));
+            continue;
+        }
+        SurfaceFeatures sampleFeatures;
+        sum = sum + w.colorAt(rayForSample(x, y, sample), sampleFeatures);
+        average.albedo = average.albedo + sampleFeatures.albedo * sampleWeight;
+        average.normal = average.normal + sampleFeatures.normal * sampleWeight;
+        average.depth += sampleFeatures.depth * sampleWeight;
+    }
+    if (features != nullptr)
+    {
+        *features = average;
+    }
+    return sum * sampleWeight;
 }
 
 Canvas Camera::Render(const World& w) const noexcept
 {
+    const TraceScope trace("Camera::Render");
+    if constexpr (RenderStatistics::Enabled)
+    {
+        RenderStatistics::Reset();
+    }
+
+    if (renderMode == Wavefront)
+    {
+        return RenderWavefront(w);
+    }
+
     Canvas image = Canvas(hSize, vSize);
 
 #pragma omp parallel for
     for (uint32_t i = 0; i < vSize; i++)
     {
+        const TraceScope rowTrace("Render row");
         for (uint32_t j = 0; j < hSize; j++)
         {
-            const Ray r = rayForPixel(j, i);
-            const Color c = w.colorAt(r);
+            // Per-ray temporaries are released in one go when the pixel is finished
+            const ArenaScope arenaScope;
+            const Color c = pixelColor(w, j, i);
 #pragma omp critical
             image.pixels[i][j] = c;
         }
@@ -52,6 +138,122 @@ Canvas Camera::Render(const World& w) const noexcept
     return image;
 }
 
+Canvas Camera::Render(const World& w, Canvas& costs) const noexcept
+{
+    const TraceScope trace("Camera::Render");
+    if constexpr (RenderStatistics::Enabled)
+    {
+        RenderStatistics::Reset();
+    }
+
+    Canvas image = Canvas(hSize, vSize);
+
+    // Rows write disjoint pixel ranges, so no synchronisation is needed on either canvas
+#pragma omp parallel for schedule(dynamic)
+    for (uint32_t i = 0; i < vSize; i++)
+    {
+        const TraceScope rowTrace("Render row");
+        const RenderStatistics& counters = RenderStatistics::threadLocal();
+        for (uint32_t j = 0; j < hSize; j++)
+        {
+            const ArenaScope arenaScope;
+            const auto start = std::chrono::steady_clock::now();
+            const uint64_t raysBefore = counters.rays();
+            const uint64_t testsBefore = counters.intersectionTests();
+
+            image.pixels[i][j] = pixelColor(w, j, i);
+
+            float cost = 0.0F;
+            switch (costMeasure)
+            {
+            case Time:
+                cost = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+                break;
+            case Rays:
+                cost = static_cast<float>(counters.rays() - raysBefore);
+                break;
+            case IntersectionTests:
+                cost = static_cast<float>(counters.intersectionTests() - testsBefore);
+                break;
+            case NoCost:
+                break;
+            }
+            costs.pixels[i][j] = Color(cost, cost, cost);
+        }
+    }
+    return image;
+}
+
+Canvas Camera::Render(const World& w, FeatureBuffers& features) const noexcept
+{
+    const TraceScope trace("Camera::Render");
+    if constexpr (RenderStatistics::Enabled)
+    {
+        RenderStatistics::Reset();
+    }
+
+    Canvas image = Canvas(hSize, vSize);
+
+    // Rows write disjoint pixel ranges, so no synchronisation is needed on any canvas
+#pragma omp parallel for schedule(dynamic)
+    for (uint32_t i = 0; i < vSize; i++)
+    {
+        const TraceScope rowTrace("Render row");
+        for (uint32_t j = 0; j < hSize; j++)
+        {
+            const ArenaScope arenaScope;
+            SurfaceFeatures pixel;
+            image.pixels[i][j] = pixelColor(w, j, i, &pixel);
+            features.albedo.pixels[i][j] = pixel.albedo;
+            features.normal.pixels[i][j] = Color(pixel.normal.x, pixel.normal.y, pixel.normal.z);
+            features.depth.pixels[i][j] = Color(pixel.depth, pixel.depth, pixel.depth);
+        }
+    }
+    return image;
+}
+
+void Camera::RenderTile(const World& w, const uint32_t xBegin, const uint32_t yBegin, const uint32_t xEnd, const uint32_t yEnd, Canvas& image) const noexcept
+{
+    const TraceScope trace("Camera::RenderTile");
+    if (renderMode == Wavefront)
+    {
+        WavefrontRenderer(w).RenderTile(*this, xBegin, yBegin, xEnd, yEnd, image);
+        return;
+    }
+
+    // Rows write disjoint pixel ranges, so no synchronisation is needed on the canvas
+#pragma omp parallel for schedule(dynamic)
+    for (uint32_t i = yBegin; i < yEnd; i++)
+    {
+        const TraceScope rowTrace("Render row");
+        for (uint32_t j = xBegin; j < xEnd; j++)
+        {
+            const ArenaScope arenaScope;
+            image.pixels[i][j] = pixelColor(w, j, i);
+        }
+    }
+}
+
+Canvas Camera::RenderWavefront(const World& w) const noexcept
+{
+    Canvas image = Canvas(hSize, vSize);
+    const WavefrontRenderer renderer(w);
+    const uint32_t tileEdge = std::max(tileSize, 1U);
+    const uint32_t tilesX = (hSize + tileEdge - 1) / tileEdge;
+    const uint32_t tilesY = (vSize + tileEdge - 1) / tileEdge;
+
+    // Tiles write disjoint pixel ranges, so no synchronisation is needed on the canvas
+#pragma omp parallel for schedule(dynamic)
+    for (uint32_t tile = 0; tile < tilesX * tilesY; tile++)
+    {
+        const uint32_t xBegin = (tile % tilesX) * tileEdge;
+        const uint32_t yBegin = (tile / tilesX) * tileEdge;
+        const TraceScope tileTrace("Render tile");
+        renderer.RenderTile(*this, xBegin, yBegin, std::min(xBegin + tileEdge, hSize), std::min(yBegin + tileEdge, vSize), image);
+    }
+    return image;
+}
+
 void Camera::RecalculateProperties() noexcept
 {
     const float halfView = std::tan(fov / 2);
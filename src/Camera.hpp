@@ -8,22 +8,47 @@
 #ifndef SRC_CAMERA_HPP_
 #define SRC_CAMERA_HPP_
 
+#include "AffineTransform.hpp"
 #include "Canvas.hpp"
-#include "Matrix.hpp"
+#include "Denoiser.hpp"
 #include "Ray.hpp"
+#include "Sampler.hpp"
 #include "World.hpp"
 #include <cmath>
+#include <optional>
 
 class Camera
 {
   public:
+    enum RenderMode
+    {
+        DepthFirst,
+        Wavefront
+    };
+
     uint32_t hSize;
     uint32_t vSize;
     float fov;
-    Matrix<4> transform;
+    AffineTransform transform;
     float pixelSize;
     float halfWidth;
     float halfHeight;
+    // What Render measures for each pixel when it is given a cost canvas
+    enum CostMeasure
+    {
+        NoCost,
+        Time,             // Seconds spent on the pixel
+        Rays,             // Rays of every kind traced for the pixel
+        IntersectionTests // objectIntersect calls of every shape type made for the pixel
+    };
+
+    RenderMode renderMode = DepthFirst;
+    CostMeasure costMeasure = NoCost;
+    uint32_t tileSize = 16;       // Edge length of the square tiles used by the wavefront renderer
+    Sampler sampler;              // Where in each pixel its samples are taken
+    uint32_t samplesPerPixel = 1; // Averaged into each pixel
+    // Filtering scenes ask for once they are rendered with features; Render itself never denoises
+    std::optional<DenoiseSettings> denoise;
 
     Camera(uint32_t horizontalSize, uint32_t verticalSize, float fieldOfView, const Matrix<4>& viewTransform = IdentityMatrix()) noexcept : hSize(horizontalSize),
                                                                                                                                             vSize(verticalSize),
@@ -38,8 +63,31 @@ class Camera
     [[nodiscard]] bool operator==(const Camera& other) const noexcept;
 
     [[nodiscard]] Ray rayForPixel(uint32_t x, uint32_t y) const noexcept;
+    // Through the point (xOffset, yOffset) of the pixel, where (0, 0) is its top left corner and
+    // (1, 1) its bottom right; the single ray above goes through (0.5, 0.5)
+    [[nodiscard]] Ray rayForPixel(uint32_t x, uint32_t y, float xOffset, float yOffset) const noexcept;
+    // The same ray, with how it changes from one pixel to the next
+    [[nodiscard]] DifferentialRay differentialRayForPixel(uint32_t x, uint32_t y, float xOffset, float yOffset) const noexcept;
+    // The index-th of the pixel's samplesPerPixel rays, placed by sampler. Its differentials are
+    // narrowed to the spacing of the samples rather than of the pixels.
+    [[nodiscard]] DifferentialRay rayForSample(uint32_t x, uint32_t y, uint32_t index) const noexcept;
+    // Resets RenderStatistics when they are enabled, so they can be collected for just this render
     [[nodiscard]] Canvas Render(const World& w) const noexcept;
+    // Also records each pixel's costMeasure into every channel of costs, which has the camera's size.
+    // Rays and IntersectionTests are only counted when statistics are enabled. Pixels are measured
+    // one at a time, so this always renders depth first.
+    [[nodiscard]] Canvas Render(const World& w, Canvas& costs) const noexcept;
+    // Also records the features of what each pixel sees into features, which have the camera's size,
+    // for Denoise. Pixels are traced one at a time, so this always renders depth first.
+    [[nodiscard]] Canvas Render(const World& w, FeatureBuffers& features) const noexcept;
+    // Renders only the pixels in [xBegin, xEnd) x [yBegin, yEnd) into image, which has the camera's size
+    void RenderTile(const World& w, uint32_t xBegin, uint32_t yBegin, uint32_t xEnd, uint32_t yEnd, Canvas& image) const noexcept;
     void RecalculateProperties() noexcept;
+
+  private:
+    [[nodiscard]] Canvas RenderWavefront(const World& w) const noexcept;
+    // The average of the pixel's samples, and of their features when they are given
+    [[nodiscard]] Color pixelColor(const World& w, uint32_t x, uint32_t y, SurfaceFeatures* features = nullptr) const noexcept;
 };
 
 #endif /* SRC_CAMERA_HPP_ */
@@ -6,6 +6,8 @@
  */
 
 #include "Canvas.hpp"
+#include "Trace.hpp"
+#include <algorithm>
 #include <cmath>
 
 Canvas::Canvas(const uint32_t widthIn, const uint32_t heightIn) noexcept : width(widthIn), height(heightIn)
@@ -24,6 +26,7 @@ Canvas::Canvas(const uint32_t widthIn, const uint32_t heightIn) noexcept : width
 
 std::string Canvas::GetPPMString() const noexcept
 {
+    const TraceScope trace("Canvas::GetPPMString");
     // PPM Header
     std::string ppmData = "P3\n" + std::to_string(this->width) + " " + std::to_string(this->height) + "\n255\n";
 
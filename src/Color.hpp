@@ -9,28 +9,101 @@
 #define SRC_COLOR_HPP_
 
 #include "Tuple.hpp"
+#include <type_traits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 constexpr float COLOR_EPSILON = 0.001F;
 
-class Color
+// Padded out to four lanes so colors get the same SSE treatment as Tuple
+class alignas(16) Color
 {
   public:
     float r = 0.0F;
     float g = 0.0F;
     float b = 0.0F;
+    float padding = 0.0F;
 
-    Color() noexcept = default;
-    Color(float red, float green, float blue) noexcept : r(red), g(green), b(blue){};
-    explicit Color(const Tuple& value) noexcept : r(value.x), g(value.y), b(value.z){};
+    constexpr Color() noexcept = default;
+    constexpr Color(float red, float green, float blue) noexcept : r(red), g(green), b(blue) {}
+    constexpr explicit Color(const Tuple& value) noexcept : r(value.x), g(value.y), b(value.z) {}
 
     // Operator overloads
-    bool operator==(const Color& other) const noexcept;
-    bool operator!=(const Color& other) const noexcept;
-    Color operator+(const Color& other) const noexcept;
-    Color operator-(const Color& other) const noexcept;
-    Color operator*(float scalar) const noexcept;
-    Color operator*(const Color& other) const noexcept;
-    Color& operator=(const Tuple& other) noexcept
+    constexpr bool operator==(const Color& other) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            const __m128 difference = _mm_andnot_ps(_mm_set1_ps(-0.0F), _mm_sub_ps(lanes(), other.lanes()));
+            return (_mm_movemask_ps(_mm_cmplt_ps(difference, _mm_set1_ps(COLOR_EPSILON))) & 0x7) == 0x7;
+        }
+#endif
+        return (Abs(r - other.r) < COLOR_EPSILON &&
+                Abs(g - other.g) < COLOR_EPSILON &&
+                Abs(b - other.b) < COLOR_EPSILON);
+    }
+
+    constexpr bool operator!=(const Color& other) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            const __m128 difference = _mm_andnot_ps(_mm_set1_ps(-0.0F), _mm_sub_ps(lanes(), other.lanes()));
+            return (_mm_movemask_ps(_mm_cmpgt_ps(difference, _mm_set1_ps(COLOR_EPSILON))) & 0x7) != 0;
+        }
+#endif
+        return (Abs(r - other.r) > COLOR_EPSILON ||
+                Abs(g - other.g) > COLOR_EPSILON ||
+                Abs(b - other.b) > COLOR_EPSILON);
+    }
+
+    constexpr Color operator+(const Color& other) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            return Color(_mm_add_ps(lanes(), other.lanes()));
+        }
+#endif
+        return {r + other.r, g + other.g, b + other.b};
+    }
+
+    constexpr Color operator-(const Color& other) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            return Color(_mm_sub_ps(lanes(), other.lanes()));
+        }
+#endif
+        return {r - other.r, g - other.g, b - other.b};
+    }
+
+    constexpr Color operator*(const float scalar) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            return Color(_mm_mul_ps(lanes(), _mm_set1_ps(scalar)));
+        }
+#endif
+        return {r * scalar, g * scalar, b * scalar};
+    }
+
+    constexpr Color operator*(const Color& other) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            return Color(_mm_mul_ps(lanes(), other.lanes()));
+        }
+#endif
+        return {r * other.r, g * other.g, b * other.b};
+    }
+
+    constexpr Color& operator=(const Tuple& other) noexcept
     {
         r = other.x;
         g = other.y;
@@ -40,6 +113,32 @@ class Color
 
     const static Color Black;
     const static Color White;
+
+  private:
+    static constexpr float Abs(const float value) noexcept
+    {
+        return value < 0.0F ? -value : value;
+    }
+
+#ifdef __SSE2__
+    explicit Color(const __m128 value) noexcept
+    {
+        alignas(16) float lane[4];
+        _mm_store_ps(lane, value);
+        r = lane[0];
+        g = lane[1];
+        b = lane[2];
+        padding = lane[3];
+    }
+
+    [[nodiscard]] __m128 lanes() const noexcept
+    {
+        return _mm_set_ps(padding, b, g, r);
+    }
+#endif
 };
 
+constexpr Color Color::Black = Color(0.0F, 0.0F, 0.0F);
+constexpr Color Color::White = Color(1.0F, 1.0F, 1.0F);
+
 #endif /* SRC_COLOR_HPP_ */
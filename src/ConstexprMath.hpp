@@ -0,0 +1,87 @@
+/*
+ * ConstexprMath.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_CONSTEXPRMATH_HPP_
+#define SRC_CONSTEXPRMATH_HPP_
+
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <type_traits>
+
+// The standard library's sqrt/sin/cos are not usable in constant expressions. These fall back to
+// series evaluated in double precision during constant evaluation, and call straight through to
+// the standard functions at runtime so rendered output is unchanged.
+
+constexpr float ConstexprSqrt(const float value) noexcept
+{
+    if (!std::is_constant_evaluated())
+    {
+        return std::sqrt(value);
+    }
+    if (value < 0.0F)
+    {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+    if (value == 0.0F || value == std::numeric_limits<float>::infinity())
+    {
+        return value;
+    }
+    const double target = static_cast<double>(value);
+    double estimate = target > 1.0 ? target : 1.0;
+    double previous = 0.0;
+    // Newton's method halves large estimates each step, so even FLT_MAX settles well within the cap
+    for (int i = 0; i < 256 && estimate != previous; i++)
+    {
+        previous = estimate;
+        estimate = 0.5 * (estimate + target / estimate);
+    }
+    return static_cast<float>(estimate);
+}
+
+// Reduces an angle to [-pi, pi] and sums the Taylor series, which converges quickly in that range
+constexpr double ConstexprSinSeries(double angle) noexcept
+{
+    constexpr double twoPi = 2.0 * std::numbers::pi;
+    angle -= twoPi * static_cast<double>(static_cast<long long>(angle / twoPi));
+    if (angle > std::numbers::pi)
+    {
+        angle -= twoPi;
+    } else if (angle < -std::numbers::pi)
+    {
+        angle += twoPi;
+    }
+
+    double term = angle;
+    double sum = angle;
+    for (int n = 1; n < 20; n++)
+    {
+        term *= -angle * angle / static_cast<double>((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr float ConstexprSin(const float angle) noexcept
+{
+    if (!std::is_constant_evaluated())
+    {
+        return std::sin(angle);
+    }
+    return static_cast<float>(ConstexprSinSeries(static_cast<double>(angle)));
+}
+
+constexpr float ConstexprCos(const float angle) noexcept
+{
+    if (!std::is_constant_evaluated())
+    {
+        return std::cos(angle);
+    }
+    return static_cast<float>(ConstexprSinSeries(static_cast<double>(angle) + std::numbers::pi / 2.0));
+}
+
+#endif /* SRC_CONSTEXPRMATH_HPP_ */
@@ -0,0 +1,195 @@
+/*
+ * Denoiser.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Denoiser.hpp"
+#include "Trace.hpp"
+#include "Tuple.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+// Albedo channels darker than this are not divided out, as there is little lighting left to recover
+constexpr float MINIMUM_ALBEDO = 0.01F;
+// Weights of the taps 0, 1 and 2 steps from the centre
+constexpr std::array<float, 3> B3_SPLINE = {3.0F / 8.0F, 1.0F / 4.0F, 1.0F / 16.0F};
+
+FeatureBuffers::FeatureBuffers(const uint32_t width, const uint32_t height) noexcept : albedo(width, height), normal(width, height), depth(width, height)
+{
+}
+
+// What the filter compares pixels by. The depth slopes are how much depth changes from one pixel to
+// the next on the pixel's own surface, so depth differences across a slanted surface are not taken
+// for edges.
+class DenoiseGuide
+{
+  public:
+    Tuple normal;
+    float depth;
+    float slopeX;
+    float slopeY;
+};
+
+// Whichever one sided difference is smaller, as the other may cross onto another surface
+float DepthSlope(const float before, const float depth, const float after) noexcept
+{
+    if (before <= 0.0F)
+    {
+        return after <= 0.0F ? 0.0F : after - depth;
+    }
+    if (after <= 0.0F)
+    {
+        return depth - before;
+    }
+    return std::abs(after - depth) < std::abs(depth - before) ? after - depth : depth - before;
+}
+
+float Demodulate(const float value, const float albedo) noexcept
+{
+    return albedo > MINIMUM_ALBEDO ? value / albedo : value;
+}
+
+float Remodulate(const float value, const float albedo) noexcept
+{
+    return albedo > MINIMUM_ALBEDO ? value * albedo : value;
+}
+
+void FilterPass(const std::vector<Color>& source, std::vector<Color>& destination, const std::vector<DenoiseGuide>& guides, const uint32_t width, const uint32_t height, const uint32_t step, const float colorSigma, const DenoiseSettings& settings)
+{
+    const TraceScope trace("Denoise pass");
+    const uint32_t tileEdge = std::max(settings.tileSize, 1U);
+    const uint32_t tilesX = (width + tileEdge - 1) / tileEdge;
+    const uint32_t tilesY = (height + tileEdge - 1) / tileEdge;
+    const float inverseColorVariance = 1.0F / (colorSigma * colorSigma);
+
+    // Tiles write disjoint pixel ranges of destination and only read source
+#pragma omp parallel for schedule(dynamic)
+    for (uint32_t tile = 0; tile < tilesX * tilesY; tile++)
+    {
+        const uint32_t xBegin = (tile % tilesX) * tileEdge;
+        const uint32_t yBegin = (tile / tilesX) * tileEdge;
+        for (uint32_t y = yBegin; y < std::min(yBegin + tileEdge, height); y++)
+        {
+            for (uint32_t x = xBegin; x < std::min(xBegin + tileEdge, width); x++)
+            {
+                const size_t index = size_t{y} * width + x;
+                const DenoiseGuide& centre = guides[index];
+                if (centre.depth <= 0.0F)
+                {
+                    destination[index] = source[index];
+                    continue;
+                }
+
+                Color sum = Color::Black;
+                float weightSum = 0.0F;
+                for (int64_t dy = -2; dy <= 2; dy++)
+                {
+                    const int64_t ty = int64_t{y} + dy * step;
+                    if (ty < 0 || ty >= height)
+                    {
+                        continue;
+                    }
+                    for (int64_t dx = -2; dx <= 2; dx++)
+                    {
+                        const int64_t tx = int64_t{x} + dx * step;
+                        if (tx < 0 || tx >= width)
+                        {
+                            continue;
+                        }
+                        const size_t tap = static_cast<size_t>(ty) * width + static_cast<size_t>(tx);
+                        const DenoiseGuide& other = guides[tap];
+                        if (other.depth <= 0.0F)
+                        {
+                            continue;
+                        }
+
+                        const float normalAlignment = centre.normal.dot(other.normal);
+                        if (normalAlignment <= 0.0F)
+                        {
+                            continue;
+                        }
+                        const float expectedDepthChange = std::abs(centre.slopeX * static_cast<float>(dx * step) + centre.slopeY * static_cast<float>(dy * step));
+                        const Color difference = source[tap] - source[index];
+                        const float colorDistance = difference.r * difference.r + difference.g * difference.g + difference.b * difference.b;
+
+                        // The normal, depth and lighting weights, alignment^power e^-depth e^-color, in one exponential
+                        const float exponent = settings.normalPower * std::log(normalAlignment) -
+                                               std::abs(other.depth - centre.depth) / (settings.depthSigma * expectedDepthChange + 1e-3F * centre.depth) -
+                                               colorDistance * inverseColorVariance;
+                        const float weight = B3_SPLINE[static_cast<size_t>(std::abs(dx))] * B3_SPLINE[static_cast<size_t>(std::abs(dy))] * std::exp(exponent);
+                        sum = sum + source[tap] * weight;
+                        weightSum += weight;
+                    }
+                }
+                // The centre tap always counts, unless its normal is zero, which leaves the pixel as it was
+                destination[index] = weightSum > 0.0F ? sum * (1.0F / weightSum) : source[index];
+            }
+        }
+    }
+}
+
+Canvas Denoise(const Canvas& image, const FeatureBuffers& features, const DenoiseSettings& settings)
+{
+    const TraceScope trace("Denoise");
+    const uint32_t width = image.width;
+    const uint32_t height = image.height;
+    for (const Canvas* buffer : {&features.albedo, &features.normal, &features.depth})
+    {
+        if (buffer->width != width || buffer->height != height)
+        {
+            throw std::runtime_error("Denoise: Feature buffers must be the size of the image");
+        }
+    }
+
+    const size_t count = size_t{width} * height;
+    std::vector<Color> lighting(count);
+    std::vector<DenoiseGuide> guides(count);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const Color& color = image.pixels[y][x];
+            const Color& albedo = features.albedo.pixels[y][x];
+            const Color& normal = features.normal.pixels[y][x];
+            const Tuple normalVector = Vector(normal.r, normal.g, normal.b);
+            const size_t index = size_t{y} * width + x;
+            lighting[index] = Color(Demodulate(color.r, albedo.r), Demodulate(color.g, albedo.g), Demodulate(color.b, albedo.b));
+            guides[index] = {normalVector.magnitude() > 0.0F ? normalVector.normalize() : normalVector, features.depth.pixels[y][x].r, 0.0F, 0.0F};
+        }
+    }
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            DenoiseGuide& guide = guides[size_t{y} * width + x];
+            const auto depthAt = [&](const uint32_t px, const uint32_t py) { return px < width && py < height ? guides[size_t{py} * width + px].depth : 0.0F; };
+            guide.slopeX = DepthSlope(depthAt(x - 1, y), guide.depth, depthAt(x + 1, y));
+            guide.slopeY = DepthSlope(depthAt(x, y - 1), guide.depth, depthAt(x, y + 1));
+        }
+    }
+
+    std::vector<Color> filtered(count);
+    float colorSigma = settings.colorSigma;
+    for (uint32_t iteration = 0; iteration < std::min(settings.iterations, MAXIMUM_DENOISE_ITERATIONS); iteration++)
+    {
+        FilterPass(lighting, filtered, guides, width, height, 1U << iteration, colorSigma, settings);
+        lighting.swap(filtered);
+        colorSigma *= 0.5F;
+    }
+
+    Canvas result(width, height);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const Color& light = lighting[size_t{y} * width + x];
+            const Color& albedo = features.albedo.pixels[y][x];
+            result.pixels[y][x] = Color(Remodulate(light.r, albedo.r), Remodulate(light.g, albedo.g), Remodulate(light.b, albedo.b));
+        }
+    }
+    return result;
+}
@@ -0,0 +1,47 @@
+/*
+ * Denoiser.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_DENOISER_HPP_
+#define SRC_DENOISER_HPP_
+
+#include "Canvas.hpp"
+
+// Per pixel averages of the SurfaceFeatures of each sample's camera ray, written alongside the image
+// by Camera::Render. Pixels whose rays all miss have zero depth and normal.
+class FeatureBuffers
+{
+  public:
+    Canvas albedo;
+    Canvas normal; // x, y and z in r, g and b, not renormalized after averaging
+    Canvas depth;  // In every channel
+
+    FeatureBuffers(uint32_t width, uint32_t height) noexcept;
+};
+
+// Past this the taps of the last iteration are thousands of pixels apart
+constexpr uint32_t MAXIMUM_DENOISE_ITERATIONS = 12;
+
+class DenoiseSettings
+{
+  public:
+    uint32_t iterations = 5;    // Each doubles how far the filter reaches; five reach 62 pixels either way. At most MAXIMUM_DENOISE_ITERATIONS.
+    float colorSigma = 0.5F;    // Lighting differences blended on the first iteration, halved for each after
+    float normalPower = 128.0F; // Higher keeps creases sharper
+    float depthSigma = 1.0F;    // Depth differences blended, in multiples of what the surface's slope accounts for
+    uint32_t tileSize = 32;     // Edge length of the square tiles the image is filtered in, in parallel
+
+    [[nodiscard]] bool operator==(const DenoiseSettings& other) const noexcept = default;
+};
+
+// Edge avoiding a-trous wavelet filtering (Dammertz et al.): repeated 5x5 B3 spline blurs, each with
+// its taps twice as far apart as the last, where each tap is weighted down by how much its normal,
+// depth and lighting differ from the pixel's. Lighting is filtered apart from albedo, which is divided
+// out first and multiplied back in after, so texture detail stays sharp. Pixels that hit nothing are
+// left as they are. Throws if the features are not the image's size.
+[[nodiscard]] Canvas Denoise(const Canvas& image, const FeatureBuffers& features, const DenoiseSettings& settings = DenoiseSettings());
+
+#endif /* SRC_DENOISER_HPP_ */
@@ -0,0 +1,60 @@
+/*
+ * Heatmap.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Heatmap.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+constexpr std::array<Color, 5> HEATMAP_STOPS = {
+    Color(0.0F, 0.0F, 0.2F),
+    Color(0.3F, 0.0F, 0.6F),
+    Color(0.8F, 0.1F, 0.3F),
+    Color(1.0F, 0.6F, 0.0F),
+    Color(1.0F, 1.0F, 0.8F)};
+
+constexpr float HEATMAP_PERCENTILE = 0.99F;
+
+Canvas CostHeatmap(const Canvas& costs)
+{
+    std::vector<float> sorted;
+    sorted.reserve(static_cast<size_t>(costs.width) * costs.height);
+    for (const auto& row : costs.pixels)
+    {
+        for (const Color& cost : row)
+        {
+            sorted.push_back(cost.r);
+        }
+    }
+
+    float scale = 0.0F;
+    if (!sorted.empty())
+    {
+        const auto percentile = sorted.begin() + static_cast<std::ptrdiff_t>(static_cast<float>(sorted.size() - 1) * HEATMAP_PERCENTILE);
+        std::nth_element(sorted.begin(), percentile, sorted.end());
+        scale = *percentile > 0.0F ? *percentile : *std::max_element(percentile, sorted.end());
+    }
+
+    Canvas heatmap(costs.width, costs.height);
+    for (uint32_t y = 0; y < costs.height; y++)
+    {
+        for (uint32_t x = 0; x < costs.width; x++)
+        {
+            heatmap.pixels[y][x] = HeatmapColor(scale > 0.0F ? costs.pixels[y][x].r / scale : 0.0F);
+        }
+    }
+    return heatmap;
+}
+
+Color HeatmapColor(const float scaledCost) noexcept
+{
+    const float position = std::clamp(scaledCost, 0.0F, 1.0F) * static_cast<float>(HEATMAP_STOPS.size() - 1);
+    const auto stop = std::min(static_cast<size_t>(position), HEATMAP_STOPS.size() - 2);
+    const float t = position - static_cast<float>(stop);
+    return HEATMAP_STOPS[stop] * (1.0F - t) + HEATMAP_STOPS[stop + 1] * t;
+}
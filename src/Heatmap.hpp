@@ -0,0 +1,21 @@
+/*
+ * Heatmap.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_HEATMAP_HPP_
+#define SRC_HEATMAP_HPP_
+
+#include "Canvas.hpp"
+
+// False colors for the per-pixel costs from Camera::Render, from dark blue for the cheapest pixels
+// through red to pale yellow for the most expensive. Costs are scaled so the 99th percentile is the
+// top of the scale, which keeps a few outlying pixels from washing out the rest of the image.
+[[nodiscard]] Canvas CostHeatmap(const Canvas& costs);
+
+// The color for a cost already scaled to [0, 1]
+[[nodiscard]] Color HeatmapColor(float scaledCost) noexcept;
+
+#endif /* SRC_HEATMAP_HPP_ */
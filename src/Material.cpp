@@ -6,16 +6,28 @@
  */
 
 #include "Material.hpp"
+#include "Statistics.hpp"
+#include <algorithm>
 #include <cmath>
 
+// Filter widths below this are treated as a point sample, so a footprint lying in a cell boundary,
+// like that of a plane through the origin, does not average the cells on either side
+constexpr float MINIMUM_FILTER_WIDTH = 1e-4F;
+
 bool Material::operator==(const Material& other) const noexcept
 {
     return color == other.color && ambient == other.ambient && diffuse == other.diffuse && shininess == other.shininess;
 }
 
-Color Material::light(const Light& light, const Tuple& point, const Tuple& eyeVector, const Tuple& normalVector, const bool inShadow) const noexcept
+Color Material::albedo(const Tuple& point, const Footprint& footprint, const TextureCoordinates& coordinates) const noexcept
+{
+    return texture ? texture->sample(coordinates) : pattern ? pattern->colorAt(point, footprint) : color;
+}
+
+Color Material::light(const Light& light, const Tuple& point, const Tuple& eyeVector, const Tuple& normalVector, const bool inShadow, const Footprint& footprint, const TextureCoordinates& coordinates) const noexcept
 {
-    const Color effectiveColor = light.intensity * (pattern ? pattern->colorAt(pattern->transform.inverse() * point) : color);
+    CountStatistic(RenderStatistics::LightingCalls);
+    const Color effectiveColor = light.intensity * albedo(point, footprint, coordinates);
     const Tuple lightVector = (light.position - point).normalize();
     const Color ambientLight = effectiveColor * ambient;
     const float lightDotNormal = lightVector.dot(normalVector);
@@ -47,6 +59,40 @@ Color Pattern::colorAt(const Tuple& p) const noexcept
     return f(a, b, p);
 }
 
+Color Pattern::colorAt(const Tuple& p, const Tuple& width) const noexcept
+{
+    if (!filtered || (width.x < MINIMUM_FILTER_WIDTH && width.y < MINIMUM_FILTER_WIDTH && width.z < MINIMUM_FILTER_WIDTH))
+    {
+        return f(a, b, p);
+    }
+    return filtered(a, b, p, width);
+}
+
+Color Pattern::colorAt(const Tuple& point, const Footprint& footprint) const noexcept
+{
+    const AffineTransform worldToPattern = transform.inverse();
+    const Tuple dpdx = worldToPattern * footprint.dpdx;
+    const Tuple dpdy = worldToPattern * footprint.dpdy;
+    // The box around the footprint is as wide along each axis as the longer of its two sides
+    const Tuple width = Vector(std::max(std::abs(dpdx.x), std::abs(dpdy.x)), std::max(std::abs(dpdx.y), std::abs(dpdy.y)), std::max(std::abs(dpdx.z), std::abs(dpdy.z)));
+    return colorAt(worldToPattern * point, width);
+}
+
+// The fraction of [x - width, x + width] where floor(x) is odd, from the integral of that square
+// wave: floor(x / 2) whole periods, plus however far x is into the odd half of the last one
+float OddFraction(const float x, const float width) noexcept
+{
+    if (width < MINIMUM_FILTER_WIDTH)
+    {
+        return std::fmod(std::floor(x), 2.0F) == 0.0F ? 0.0F : 1.0F;
+    }
+    const auto integral = [](const float v) {
+        const float periods = std::floor(v / 2.0F);
+        return periods + std::max(0.0F, v - 2.0F * periods - 1.0F);
+    };
+    return (integral(x + width) - integral(x - width)) / (2.0F * width);
+}
+
 Pattern Pattern::Test() noexcept
 {
     std::function<Color(const Color&, const Color&, const Tuple&)> f = []([[maybe_unused]] const Color& aP, [[maybe_unused]] const Color& bP, const Tuple& p) -> Color {
@@ -60,8 +106,12 @@ Pattern Pattern::Stripe(const Color& aIn, const Color& bIn) noexcept
     std::function<Color(const Color&, const Color&, const Tuple&)> f = [](const Color& aP, const Color& bP, const Tuple& p) -> Color {
         return std::fmod(p.x, 2.0F) >= 1.0F || (std::fmod(p.x, 2.0F) < 0.0F && std::fmod(p.x, 2.0F) >= -1.0F) ? bP : aP;
     };
+    // Stripes of b are where floor(x) is odd
+    std::function<Color(const Color&, const Color&, const Tuple&, const Tuple&)> filtered = [](const Color& aP, const Color& bP, const Tuple& p, const Tuple& w) -> Color {
+        return aP + (bP - aP) * OddFraction(p.x, w.x);
+    };
 
-    return {aIn, bIn, IdentityMatrix(), f};
+    return {aIn, bIn, IdentityMatrix(), f, filtered};
 }
 
 Pattern Pattern::Gradient(const Color& aIn, const Color& bIn) noexcept
@@ -87,6 +137,12 @@ Pattern Pattern::Checker(const Color& aIn, const Color& bIn) noexcept
     std::function<Color(const Color&, const Color&, const Tuple&)> f = [](const Color& aP, const Color& bP, const Tuple& p) -> Color {
         return std::floor(std::fmod(std::floor(p.x) + std::floor(p.y) + std::floor(p.z), 2.0F)) == 0 ? aP : bP;
     };
+    // A cell is b when an odd number of its coordinates' floors are odd. The box filter is separable,
+    // so with o the odd fraction along each axis, 1 - 2o per axis multiplies out to the b fraction.
+    std::function<Color(const Color&, const Color&, const Tuple&, const Tuple&)> filtered = [](const Color& aP, const Color& bP, const Tuple& p, const Tuple& w) -> Color {
+        const float parity = (1.0F - 2.0F * OddFraction(p.x, w.x)) * (1.0F - 2.0F * OddFraction(p.y, w.y)) * (1.0F - 2.0F * OddFraction(p.z, w.z));
+        return aP + (bP - aP) * ((1.0F - parity) / 2.0F);
+    };
 
-    return {aIn, bIn, IdentityMatrix(), f};
+    return {aIn, bIn, IdentityMatrix(), f, filtered};
 }
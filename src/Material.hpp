@@ -8,23 +8,43 @@
 #ifndef SRC_MATERIAL_HPP_
 #define SRC_MATERIAL_HPP_
 
+#include "AffineTransform.hpp"
 #include "Color.hpp"
 #include "Light.hpp"
 #include "Matrix.hpp"
+#include "Texture.hpp"
 #include "Tuple.hpp"
 #include <functional>
+#include <memory>
 #include <optional>
 
+// The world space offsets from a shaded point to where the rays of the next pixel over in x and
+// in y hit the same surface. The default, zero footprint is that of a ray without differentials.
+class Footprint
+{
+  public:
+    Tuple dpdx = Vector(0, 0, 0);
+    Tuple dpdy = Vector(0, 0, 0);
+};
+
 class Pattern
 {
   public:
     Color a;
     Color b;
-    Matrix<4> transform;
+    AffineTransform transform;
 
     Pattern() noexcept : a(Color::White), b(Color::Black), transform(IdentityMatrix()), f([]([[maybe_unused]] Color aF, [[maybe_unused]] Color bF, [[maybe_unused]] Tuple pF) { return Color::Black; }){};
-    Pattern(const Color& aIn, const Color& bIn, const Matrix<4>& transformIn, std::function<Color(const Color& aF, const Color& bF, const Tuple& pF)> fIn) noexcept : a(aIn), b(bIn), transform(transformIn), f(std::move(fIn)){};
+    Pattern(const Color& aIn, const Color& bIn, const AffineTransform& transformIn, std::function<Color(const Color& aF, const Color& bF, const Tuple& pF)> fIn) noexcept : a(aIn), b(bIn), transform(transformIn), f(std::move(fIn)){};
+    // filteredIn gives the pattern's average over the box of half widths wF along each axis around pF
+    Pattern(const Color& aIn, const Color& bIn, const AffineTransform& transformIn, std::function<Color(const Color& aF, const Color& bF, const Tuple& pF)> fIn,
+            std::function<Color(const Color& aF, const Color& bF, const Tuple& pF, const Tuple& wF)> filteredIn) noexcept : a(aIn), b(bIn), transform(transformIn), f(std::move(fIn)), filtered(std::move(filteredIn)){};
     [[nodiscard]] Color colorAt(const Tuple& p) const noexcept;
+    // The average color over the box of half widths width along each axis around p, both in pattern
+    // space. Patterns without a filtered form are sampled at just p.
+    [[nodiscard]] Color colorAt(const Tuple& p, const Tuple& width) const noexcept;
+    // The color of the pattern at a world space point, averaged over the pixel footprint around it
+    [[nodiscard]] Color colorAt(const Tuple& point, const Footprint& footprint) const noexcept;
 
     static Pattern Test() noexcept;
     static Pattern Stripe(const Color& aIn, const Color& bIn) noexcept;
@@ -34,6 +54,7 @@ class Pattern
 
   private:
     std::function<Color(const Color&, const Color&, const Tuple&)> f;
+    std::function<Color(const Color&, const Color&, const Tuple&, const Tuple&)> filtered;
 };
 
 // All values should be positive, but I'm not sure how to enforce that without something like c++ contracts
@@ -42,6 +63,8 @@ class Material
   public:
     Color color = Color::White;
     std::optional<Pattern> pattern;
+    // Replaces color and pattern where set, looked up at the texture coordinates light is given
+    std::shared_ptr<const Texture> texture;
     float ambient = 0.1F;
     float diffuse = 0.9F;
     float specular = 0.9F;
@@ -54,7 +77,9 @@ class Material
     Material(const Color& colorIn, float ambientIn, float diffuseIn, float specularIn, float shininessIn, float reflectivityIn, float transparencyIn, float refractiveIndexIn) noexcept : color(colorIn), ambient(ambientIn), diffuse(diffuseIn), specular(specularIn), shininess(shininessIn), reflectivity(reflectivityIn), transparency(transparencyIn), refractiveIndex(refractiveIndexIn){};
 
     [[nodiscard]] bool operator==(const Material& other) const noexcept;
-    [[nodiscard]] Color light(const Light& light, const Tuple& point, const Tuple& eyeVector, const Tuple& normalVector, bool inShadow) const noexcept;
+    // The surface's own color at point, before any lighting: from the texture, pattern or color
+    [[nodiscard]] Color albedo(const Tuple& point, const Footprint& footprint = Footprint(), const TextureCoordinates& coordinates = TextureCoordinates()) const noexcept;
+    [[nodiscard]] Color light(const Light& light, const Tuple& point, const Tuple& eyeVector, const Tuple& normalVector, bool inShadow, const Footprint& footprint = Footprint(), const TextureCoordinates& coordinates = TextureCoordinates()) const noexcept;
 };
 
 #endif /* SRC_MATERIAL_HPP_ */
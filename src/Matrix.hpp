@@ -7,191 +7,199 @@
 #ifndef SRC_MATRIX_HPP_
 #define SRC_MATRIX_HPP_
 
+#include "Statistics.hpp"
 #include "Tuple.hpp"
 
 #include <array>
+#include <cstdint>
 #include <iostream>
+#include <utility>
 
 constexpr float MATRIX_EPSILON = 0.00001F;
 
+// Header-only and constexpr throughout. Every operation is written as a fold over an index
+// sequence rather than a loop, so each size is fully unrolled and inlines at the call site.
 template <uint32_t N>
 class Matrix
 {
   public:
-    Matrix() noexcept
-    {
-        for (auto& row : data)
-        {
-            row = {};
-        }
-    }
-    explicit Matrix(const std::array<std::array<float, N>, N>& initialData) noexcept : data(initialData){};
-
-    std::array<float, N>& operator[](uint32_t index) noexcept;
-    const std::array<float, N>& operator[](uint32_t index) const noexcept;
-    [[nodiscard]] bool operator==(const Matrix<N>& other) const noexcept;
-    [[nodiscard]] bool operator!=(const Matrix<N>& other) const noexcept; // The inequality operator tests passed without this... what?!
-    [[nodiscard]] Matrix<N> operator*(const Matrix<N>& other) const noexcept;
-    [[nodiscard]] Tuple operator*(const Tuple& other) const noexcept;
-
-    [[nodiscard]] Matrix<N> transpose() const noexcept;
-    [[nodiscard]] float determinant() const noexcept;
-    [[nodiscard]] Matrix<N - 1> submatrix(uint32_t row, uint32_t col) const noexcept;
-    [[nodiscard]] float minor(uint32_t row, uint32_t col) const noexcept;
-    [[nodiscard]] float cofactor(uint32_t row, uint32_t col) const noexcept;
-    [[nodiscard]] bool invertible() const noexcept;
-    [[nodiscard]] Matrix<N> inverse() const noexcept;
+    constexpr Matrix() noexcept = default;
+    constexpr explicit Matrix(const std::array<std::array<float, N>, N>& initialData) noexcept : data(initialData) {}
+
+    constexpr std::array<float, N>& operator[](uint32_t index) noexcept;
+    constexpr const std::array<float, N>& operator[](uint32_t index) const noexcept;
+    [[nodiscard]] constexpr bool operator==(const Matrix<N>& other) const noexcept;
+    [[nodiscard]] constexpr bool operator!=(const Matrix<N>& other) const noexcept;
+    [[nodiscard]] constexpr Matrix<N> operator*(const Matrix<N>& other) const noexcept;
+    [[nodiscard]] constexpr Tuple operator*(const Tuple& other) const noexcept
+        requires(N == 4);
+
+    [[nodiscard]] constexpr Matrix<N> transpose() const noexcept;
+    [[nodiscard]] constexpr float determinant() const noexcept;
+    [[nodiscard]] constexpr Matrix<N - 1> submatrix(uint32_t row, uint32_t col) const noexcept;
+    [[nodiscard]] constexpr float minor(uint32_t row, uint32_t col) const noexcept;
+    [[nodiscard]] constexpr float cofactor(uint32_t row, uint32_t col) const noexcept;
+    [[nodiscard]] constexpr bool invertible() const noexcept;
+    [[nodiscard]] constexpr Matrix<N> inverse() const noexcept;
 
   private:
-    std::array<std::array<float, N>, N> data;
+    // Visits every element in row-major order; the function receives the row and column
+    template <uint32_t Size = N, typename Function>
+    static constexpr void ForEachElement(Function&& function) noexcept;
+
+    std::array<std::array<float, N>, N> data{};
 };
 
-Matrix<4> IdentityMatrix() noexcept;
+constexpr Matrix<4> IdentityMatrix() noexcept
+{
+    return Matrix<4>({{{1, 0, 0, 0},
+                       {0, 1, 0, 0},
+                       {0, 0, 1, 0},
+                       {0, 0, 0, 1}}});
+}
+
+template <uint32_t N>
+template <uint32_t Size, typename Function>
+constexpr void Matrix<N>::ForEachElement(Function&& function) noexcept
+{
+    [&]<uint32_t... Index>(std::integer_sequence<uint32_t, Index...>)
+    {
+        (function(Index / Size, Index % Size), ...);
+    }(std::make_integer_sequence<uint32_t, Size * Size>{});
+}
 
-// Due to the nature of templates, non-specialized template members must
-// be defined in the same header as the template declaration
-// Template specializations seem to still need to be in a
 template <uint32_t N>
-std::array<float, N>& Matrix<N>::operator[](const uint32_t index) noexcept
+constexpr std::array<float, N>& Matrix<N>::operator[](const uint32_t index) noexcept
 {
     return data[index];
 }
 
 template <uint32_t N>
-const std::array<float, N>& Matrix<N>::operator[](const uint32_t index) const noexcept
+constexpr const std::array<float, N>& Matrix<N>::operator[](const uint32_t index) const noexcept
 {
     return data[index];
 }
 
 template <uint32_t N>
-bool Matrix<N>::operator==(const Matrix<N>& other) const noexcept
+constexpr bool Matrix<N>::operator==(const Matrix<N>& other) const noexcept
 {
-    for (uint32_t i = 0; i < N; i++)
-    {
-        for (uint32_t j = 0; j < N; j++)
-        {
-            if (std::abs(data[i][j] - other.data[i][j]) > MATRIX_EPSILON)
-            {
-                return false;
-            }
-        }
-    }
-    return true;
+    return !(*this != other);
 }
 
 template <uint32_t N>
-bool Matrix<N>::operator!=(const Matrix<N>& other) const noexcept // The inequality operator tests passed without this... what?!
+constexpr bool Matrix<N>::operator!=(const Matrix<N>& other) const noexcept
 {
-    for (int i = 0; i < N; i++)
-    {
-        for (int j = 0; j < N; j++)
-        {
-            if (std::abs(data[i][j] - other.data[i][j]) > MATRIX_EPSILON)
-            {
-                return true;
-            }
-        }
-    }
-    return false;
+    bool different = false;
+    ForEachElement([&](const uint32_t i, const uint32_t j) {
+        const float difference = data[i][j] - other.data[i][j];
+        different |= (difference < 0.0F ? -difference : difference) > MATRIX_EPSILON;
+    });
+    return different;
 }
 
 template <uint32_t N>
-Matrix<N> Matrix<N>::operator*(const Matrix<N>& other) const noexcept
+constexpr Matrix<N> Matrix<N>::operator*(const Matrix<N>& other) const noexcept
 {
     Matrix<N> product;
-    for (uint32_t i = 0; i < N; i++)
-    {
-        for (uint32_t j = 0; j < N; j++)
+    ForEachElement([&](const uint32_t i, const uint32_t j) {
+        product.data[i][j] = [&]<uint32_t... K>(std::integer_sequence<uint32_t, K...>)
         {
-            float partialProduct = 0;
-            for (uint32_t k = 0; k < N; k++)
-            {
-                partialProduct += data[i][k] * other.data[k][j];
-            }
-            product[i][j] = partialProduct;
-        }
-    }
+            return (... + (data[i][K] * other.data[K][j]));
+        }(std::make_integer_sequence<uint32_t, N>{});
+    });
     return product;
 }
 
 template <uint32_t N>
-Matrix<N> Matrix<N>::transpose() const noexcept
+constexpr Tuple Matrix<N>::operator*(const Tuple& other) const noexcept
+    requires(N == 4)
 {
-    Matrix<N> t;
-
-    for (uint32_t i = 0; i < N; i++)
-    {
-        for (uint32_t j = 0; j < N; j++)
-        {
-            t.data[i][j] = data[j][i];
-        }
-    }
+    return {
+        data[0][0] * other.x + data[0][1] * other.y + data[0][2] * other.z + data[0][3] * other.w,
+        data[1][0] * other.x + data[1][1] * other.y + data[1][2] * other.z + data[1][3] * other.w,
+        data[2][0] * other.x + data[2][1] * other.y + data[2][2] * other.z + data[2][3] * other.w,
+        data[3][0] * other.x + data[3][1] * other.y + data[3][2] * other.z + data[3][3] * other.w};
+}
 
+template <uint32_t N>
+constexpr Matrix<N> Matrix<N>::transpose() const noexcept
+{
+    Matrix<N> t;
+    ForEachElement([&](const uint32_t i, const uint32_t j) {
+        t.data[i][j] = data[j][i];
+    });
     return t;
 }
 
-template <>
-float Matrix<2>::determinant() const noexcept;
-
 template <uint32_t N>
-float Matrix<N>::determinant() const noexcept
+constexpr float Matrix<N>::determinant() const noexcept
 {
-    float d = 0;
-    for (uint32_t i = 0; i < N; i++)
+    if constexpr (N == 1)
+    {
+        return data[0][0];
+    } else if constexpr (N == 2)
     {
-        d += data[0][i] * this->cofactor(0, i);
+        return data[0][0] * data[1][1] - data[0][1] * data[1][0];
+    } else
+    {
+        return [&]<uint32_t... Col>(std::integer_sequence<uint32_t, Col...>)
+        {
+            return (... + (data[0][Col] * cofactor(0, Col)));
+        }(std::make_integer_sequence<uint32_t, N>{});
     }
-    return d;
 }
 
 template <uint32_t N>
-Matrix<N - 1> Matrix<N>::submatrix(const uint32_t row, const uint32_t col) const noexcept
+constexpr Matrix<N - 1> Matrix<N>::submatrix(const uint32_t row, const uint32_t col) const noexcept
 {
     Matrix<N - 1> s;
-    uint32_t rowOffset = 0;
-    for (uint32_t i = 0; i < N; i++)
-    {
-        uint32_t colOffset = 0;
-        if (i == row)
-        {
-            rowOffset++;
-        } else
-        {
-            for (uint32_t j = 0; j < N; j++)
-            {
-                if (j == col)
-                {
-                    colOffset++;
-                } else
-                {
-                    s[i - rowOffset][j - colOffset] = data[i][j];
-                }
-            }
-        }
-    }
+    ForEachElement<N - 1>([&](const uint32_t i, const uint32_t j) {
+        s[i][j] = data[i < row ? i : i + 1][j < col ? j : j + 1];
+    });
     return s;
 }
 
 template <uint32_t N>
-bool Matrix<N>::invertible() const noexcept
+constexpr float Matrix<N>::minor(const uint32_t row, const uint32_t col) const noexcept
 {
-    return this->determinant() != 0;
+    return submatrix(row, col).determinant();
 }
 
 template <uint32_t N>
-Matrix<N> Matrix<N>::inverse() const noexcept
+constexpr float Matrix<N>::cofactor(const uint32_t row, const uint32_t col) const noexcept
 {
-    Matrix<N> I;
+    return (row + col) % 2 > 0 ? -1 * minor(row, col) : minor(row, col);
+}
+
+template <uint32_t N>
+constexpr bool Matrix<N>::invertible() const noexcept
+{
+    return determinant() != 0;
+}
 
-    float d = determinant();
-    for (uint32_t i = 0; i < N; i++)
+template <uint32_t N>
+constexpr Matrix<N> Matrix<N>::inverse() const noexcept
+{
+    if (!std::is_constant_evaluated())
     {
-        for (uint32_t j = 0; j < N; j++)
-        {
-            I[j][i] = cofactor(i, j) / d;
-        }
+        CountStatistic(RenderStatistics::MatrixInversions);
     }
 
+    // Every cofactor is needed anyway, so take the determinant from the first row of them
+    // rather than expanding it separately
+    Matrix<N> cofactors;
+    ForEachElement([&](const uint32_t i, const uint32_t j) {
+        cofactors.data[i][j] = cofactor(i, j);
+    });
+    const float d = [&]<uint32_t... Col>(std::integer_sequence<uint32_t, Col...>)
+    {
+        return (... + (data[0][Col] * cofactors.data[0][Col]));
+    }(std::make_integer_sequence<uint32_t, N>{});
+
+    Matrix<N> I;
+    ForEachElement([&](const uint32_t i, const uint32_t j) {
+        I.data[j][i] = cofactors.data[i][j] / d;
+    });
     return I;
 }
 
@@ -0,0 +1,464 @@
+/*
+ * MeshSimplification.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "MeshSimplification.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+// Borders are held in place by planes along them weighted this much more than the faces' own
+constexpr double BORDER_WEIGHT = 1000.0;
+
+// The symmetric 4x4 matrix of the summed squared distances to a set of planes, upper triangle only
+class Quadric
+{
+  public:
+    std::array<double, 10> terms{};
+
+    // Of the plane a x + b y + c z + d = 0, scaled by weight
+    static Quadric Plane(double a, double b, double c, double d, double weight) noexcept
+    {
+        return {{weight * a * a, weight * a * b, weight * a * c, weight * a * d, weight * b * b,
+                 weight * b * c, weight * b * d, weight * c * c, weight * c * d, weight * d * d}};
+    }
+
+    Quadric& operator+=(const Quadric& other) noexcept
+    {
+        for (size_t i = 0; i < terms.size(); i++)
+        {
+            terms[i] += other.terms[i];
+        }
+        return *this;
+    }
+
+    [[nodiscard]] double error(const std::array<double, 3>& p) const noexcept
+    {
+        const auto& [aa, ab, ac, ad, bb, bc, bd, cc, cd, dd] = terms;
+        return aa * p[0] * p[0] + 2 * ab * p[0] * p[1] + 2 * ac * p[0] * p[2] + 2 * ad * p[0] + bb * p[1] * p[1] +
+               2 * bc * p[1] * p[2] + 2 * bd * p[1] + cc * p[2] * p[2] + 2 * cd * p[2] + dd;
+    }
+};
+
+using Point3 = std::array<double, 3>;
+
+Point3 Subtract(const Point3& a, const Point3& b) noexcept
+{
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+Point3 Cross(const Point3& a, const Point3& b) noexcept
+{
+    return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+double Dot(const Point3& a, const Point3& b) noexcept
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// A possible collapse of edge a, b, valid only while neither end has changed since it was found
+class EdgeCollapse
+{
+  public:
+    double cost;
+    uint32_t a;
+    uint32_t b;
+    uint32_t versionA;
+    uint32_t versionB;
+    Point3 position;
+
+    bool operator>(const EdgeCollapse& other) const noexcept { return cost > other.cost; }
+};
+
+class MeshSimplifier
+{
+  public:
+    std::vector<Point3> positions;
+    std::vector<TriangleMesh::Vertex> normals;
+    std::vector<TriangleMesh::TextureVertex> textureCoordinates;
+    std::vector<std::array<uint32_t, 3>> faces;
+    std::vector<bool> faceAlive;
+    std::vector<std::vector<uint32_t>> vertexFaces;
+    std::vector<Quadric> quadrics;
+    std::vector<uint32_t> versions;
+    std::priority_queue<EdgeCollapse, std::vector<EdgeCollapse>, std::greater<>> collapses;
+    size_t faceCount = 0;
+
+    explicit MeshSimplifier(const TriangleMesh& mesh);
+    void addQuadrics();
+    void queueEdges(uint32_t vertex);
+    [[nodiscard]] bool flipsFace(uint32_t moved, uint32_t removed, const Point3& position) const noexcept;
+    [[nodiscard]] size_t sharedFaces(uint32_t a, uint32_t b) const noexcept;
+    [[nodiscard]] std::vector<uint32_t> neighbours(uint32_t vertex) const;
+    [[nodiscard]] bool onBorder(uint32_t vertex) const noexcept;
+    [[nodiscard]] bool keepsManifold(uint32_t a, uint32_t b) const;
+    void collapse(const EdgeCollapse& edge);
+    [[nodiscard]] TriangleMesh result() const;
+};
+
+MeshSimplifier::MeshSimplifier(const TriangleMesh& mesh) :
+    normals(mesh.normals()),
+    textureCoordinates(mesh.textureVertices()),
+    faceAlive(mesh.faceCount(), true),
+    vertexFaces(mesh.positions().size()),
+    quadrics(mesh.positions().size()),
+    versions(mesh.positions().size(), 0),
+    faceCount(mesh.faceCount())
+{
+    positions.reserve(mesh.positions().size());
+    for (const TriangleMesh::Vertex& position : mesh.positions())
+    {
+        positions.push_back({position[0], position[1], position[2]});
+    }
+    faces.resize(faceCount);
+    for (uint32_t face = 0; face < faceCount; face++)
+    {
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            faces[face][corner] = mesh.indices()[face * 3 + corner];
+            vertexFaces[faces[face][corner]].push_back(face);
+        }
+    }
+}
+
+void MeshSimplifier::addQuadrics()
+{
+    // Each face's plane, weighted by its area so slivers count for little
+    std::unordered_map<uint64_t, uint32_t> edgeUses;
+    for (uint32_t face = 0; face < faces.size(); face++)
+    {
+        const auto& [v0, v1, v2] = faces[face];
+        const Point3 normal = Cross(Subtract(positions[v1], positions[v0]), Subtract(positions[v2], positions[v0]));
+        const double length = std::sqrt(Dot(normal, normal));
+        if (length > 0.0)
+        {
+            const Point3 unit = {normal[0] / length, normal[1] / length, normal[2] / length};
+            const Quadric plane = Quadric::Plane(unit[0], unit[1], unit[2], -Dot(unit, positions[v0]), length / 2);
+            for (const uint32_t vertex : faces[face])
+            {
+                quadrics[vertex] += plane;
+            }
+        }
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            const uint32_t a = faces[face][corner];
+            const uint32_t b = faces[face][(corner + 1) % 3];
+            edgeUses[(uint64_t{std::min(a, b)} << 32U) | std::max(a, b)]++;
+        }
+    }
+
+    // A plane through each border edge, square to its face, keeps the edge's vertices on it
+    for (uint32_t face = 0; face < faces.size(); face++)
+    {
+        const auto& [v0, v1, v2] = faces[face];
+        const Point3 normal = Cross(Subtract(positions[v1], positions[v0]), Subtract(positions[v2], positions[v0]));
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            const uint32_t a = faces[face][corner];
+            const uint32_t b = faces[face][(corner + 1) % 3];
+            if (edgeUses[(uint64_t{std::min(a, b)} << 32U) | std::max(a, b)] != 1)
+            {
+                continue;
+            }
+            const Point3 edge = Subtract(positions[b], positions[a]);
+            const Point3 border = Cross(edge, normal);
+            const double length = std::sqrt(Dot(border, border));
+            if (length > 0.0)
+            {
+                const Point3 unit = {border[0] / length, border[1] / length, border[2] / length};
+                const Quadric plane = Quadric::Plane(unit[0], unit[1], unit[2], -Dot(unit, positions[a]), BORDER_WEIGHT * Dot(edge, edge));
+                quadrics[a] += plane;
+                quadrics[b] += plane;
+            }
+        }
+    }
+}
+
+// Queues the collapse of every edge from vertex, with vertex kept. Edges are queued from both
+// ends, and whichever is popped first leaves the other out of date.
+void MeshSimplifier::queueEdges(const uint32_t vertex)
+{
+    for (const uint32_t face : vertexFaces[vertex])
+    {
+        for (const uint32_t other : faces[face])
+        {
+            if (other == vertex)
+            {
+                continue;
+            }
+            Quadric combined = quadrics[vertex];
+            combined += quadrics[other];
+            // Only the ends and the midpoint are tried, so vertices never leave the mesh's bounds
+            const Point3& a = positions[vertex];
+            const Point3& b = positions[other];
+            const std::array<Point3, 3> candidates = {a, b, Point3{(a[0] + b[0]) / 2, (a[1] + b[1]) / 2, (a[2] + b[2]) / 2}};
+            EdgeCollapse best{combined.error(candidates[0]), vertex, other, versions[vertex], versions[other], candidates[0]};
+            for (size_t i = 1; i < candidates.size(); i++)
+            {
+                const double cost = combined.error(candidates[i]);
+                if (cost < best.cost)
+                {
+                    best.cost = cost;
+                    best.position = candidates[i];
+                }
+            }
+            collapses.push(best);
+        }
+    }
+}
+
+bool MeshSimplifier::flipsFace(const uint32_t moved, const uint32_t removed, const Point3& position) const noexcept
+{
+    for (const uint32_t face : vertexFaces[moved])
+    {
+        const auto& corners = faces[face];
+        if (!faceAlive[face] || std::find(corners.begin(), corners.end(), removed) != corners.end())
+        {
+            continue;
+        }
+        std::array<Point3, 3> before;
+        std::array<Point3, 3> after;
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            before[corner] = positions[corners[corner]];
+            after[corner] = corners[corner] == moved ? position : before[corner];
+        }
+        const Point3 normalBefore = Cross(Subtract(before[1], before[0]), Subtract(before[2], before[0]));
+        const Point3 normalAfter = Cross(Subtract(after[1], after[0]), Subtract(after[2], after[0]));
+        if (Dot(normalBefore, normalAfter) <= 0.0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t MeshSimplifier::sharedFaces(const uint32_t a, const uint32_t b) const noexcept
+{
+    return static_cast<size_t>(std::count_if(vertexFaces[a].begin(), vertexFaces[a].end(), [&](const uint32_t face) {
+        return faceAlive[face] && std::find(faces[face].begin(), faces[face].end(), b) != faces[face].end();
+    }));
+}
+
+// Sorted, of the live faces only
+std::vector<uint32_t> MeshSimplifier::neighbours(const uint32_t vertex) const
+{
+    std::vector<uint32_t> joined;
+    for (const uint32_t face : vertexFaces[vertex])
+    {
+        if (!faceAlive[face])
+        {
+            continue;
+        }
+        for (const uint32_t other : faces[face])
+        {
+            if (other != vertex)
+            {
+                joined.push_back(other);
+            }
+        }
+    }
+    std::sort(joined.begin(), joined.end());
+    joined.erase(std::unique(joined.begin(), joined.end()), joined.end());
+    return joined;
+}
+
+bool MeshSimplifier::onBorder(const uint32_t vertex) const noexcept
+{
+    for (const uint32_t face : vertexFaces[vertex])
+    {
+        if (!faceAlive[face])
+        {
+            continue;
+        }
+        for (const uint32_t other : faces[face])
+        {
+            if (other != vertex && sharedFaces(vertex, other) == 1)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// The link condition (Dey et al.): collapsing a, b keeps the surface a manifold if the vertices
+// joined to both are only those opposite the edge in its own faces, and no faces a c d and b c d
+// exist that would become the same face. An edge across the surface may not join two border
+// vertices either, as that would pinch the surface to a point.
+bool MeshSimplifier::keepsManifold(const uint32_t a, const uint32_t b) const
+{
+    const std::vector<uint32_t> neighboursA = neighbours(a);
+    const std::vector<uint32_t> neighboursB = neighbours(b);
+    std::vector<uint32_t> common;
+    std::set_intersection(neighboursA.begin(), neighboursA.end(), neighboursB.begin(), neighboursB.end(), std::back_inserter(common));
+
+    std::vector<uint32_t> opposite;
+    for (const uint32_t face : vertexFaces[a])
+    {
+        const auto& corners = faces[face];
+        if (!faceAlive[face])
+        {
+            continue;
+        }
+        if (std::find(corners.begin(), corners.end(), b) != corners.end())
+        {
+            opposite.push_back(corners[0] ^ corners[1] ^ corners[2] ^ a ^ b); // The corner that is neither a nor b
+            continue;
+        }
+        // Only faces a c d with both c and d common neighbours can have a twin b c d
+        std::array<uint32_t, 2> others{};
+        size_t count = 0;
+        for (const uint32_t corner : corners)
+        {
+            if (corner != a)
+            {
+                others[count++] = corner;
+            }
+        }
+        if (std::binary_search(common.begin(), common.end(), others[0]) && std::binary_search(common.begin(), common.end(), others[1]))
+        {
+            const bool twin = std::any_of(vertexFaces[b].begin(), vertexFaces[b].end(), [&](const uint32_t other) {
+                const auto& otherCorners = faces[other];
+                return faceAlive[other] && std::find(otherCorners.begin(), otherCorners.end(), others[0]) != otherCorners.end() &&
+                       std::find(otherCorners.begin(), otherCorners.end(), others[1]) != otherCorners.end();
+            });
+            if (twin)
+            {
+                return false;
+            }
+        }
+    }
+    std::sort(opposite.begin(), opposite.end());
+    if (common != opposite)
+    {
+        return false;
+    }
+    return opposite.size() != 2 || !onBorder(a) || !onBorder(b);
+}
+
+void MeshSimplifier::collapse(const EdgeCollapse& edge)
+{
+    const uint32_t kept = edge.a;
+    const uint32_t removed = edge.b;
+    if (!textureCoordinates.empty())
+    {
+        // As far along the edge as the vertex moves, so the image slides no further than the surface
+        const Point3 edgeVector = Subtract(positions[removed], positions[kept]);
+        const double length = Dot(edgeVector, edgeVector);
+        const auto along = static_cast<float>(length > 0.0 ? Dot(Subtract(edge.position, positions[kept]), edgeVector) / length : 0.0);
+        TriangleMesh::TextureVertex& coordinates = textureCoordinates[kept];
+        const TriangleMesh::TextureVertex& other = textureCoordinates[removed];
+        coordinates = {coordinates[0] + (other[0] - coordinates[0]) * along, coordinates[1] + (other[1] - coordinates[1]) * along};
+    }
+    positions[kept] = edge.position;
+    quadrics[kept] += quadrics[removed];
+    versions[kept]++;
+    versions[removed]++;
+    if (!normals.empty())
+    {
+        TriangleMesh::Vertex& normal = normals[kept];
+        const TriangleMesh::Vertex& other = normals[removed];
+        const Tuple sum = Vector(normal[0] + other[0], normal[1] + other[1], normal[2] + other[2]);
+        if (sum.magnitude() > TUPLE_EPSILON)
+        {
+            const Tuple unit = sum.normalize();
+            normal = {unit.x, unit.y, unit.z};
+        }
+    }
+
+    for (const uint32_t face : vertexFaces[removed])
+    {
+        if (!faceAlive[face])
+        {
+            continue;
+        }
+        auto& corners = faces[face];
+        if (std::find(corners.begin(), corners.end(), kept) != corners.end())
+        {
+            faceAlive[face] = false;
+            faceCount--;
+            continue;
+        }
+        std::replace(corners.begin(), corners.end(), removed, kept);
+        vertexFaces[kept].push_back(face);
+    }
+    vertexFaces[removed].clear();
+    std::erase_if(vertexFaces[kept], [&](const uint32_t face) { return !faceAlive[face]; });
+    queueEdges(kept);
+}
+
+TriangleMesh MeshSimplifier::result() const
+{
+    std::vector<uint32_t> remap(positions.size(), UINT32_MAX);
+    std::vector<TriangleMesh::Vertex> keptPositions;
+    std::vector<TriangleMesh::Vertex> keptNormals;
+    std::vector<TriangleMesh::TextureVertex> keptTextureCoordinates;
+    std::vector<uint32_t> indices;
+    indices.reserve(faceCount * 3);
+    for (uint32_t face = 0; face < faces.size(); face++)
+    {
+        if (!faceAlive[face])
+        {
+            continue;
+        }
+        for (const uint32_t vertex : faces[face])
+        {
+            if (remap[vertex] == UINT32_MAX)
+            {
+                remap[vertex] = static_cast<uint32_t>(keptPositions.size());
+                const Point3& position = positions[vertex];
+                keptPositions.push_back({static_cast<float>(position[0]), static_cast<float>(position[1]), static_cast<float>(position[2])});
+                if (!normals.empty())
+                {
+                    keptNormals.push_back(normals[vertex]);
+                }
+                if (!textureCoordinates.empty())
+                {
+                    keptTextureCoordinates.push_back(textureCoordinates[vertex]);
+                }
+            }
+            indices.push_back(remap[vertex]);
+        }
+    }
+    return {std::move(keptPositions), std::move(keptNormals), indices, std::move(keptTextureCoordinates)};
+}
+
+TriangleMesh SimplifyMesh(const TriangleMesh& mesh, const size_t targetFaceCount)
+{
+    const TraceScope trace("SimplifyMesh");
+    MeshSimplifier simplifier(mesh);
+    simplifier.addQuadrics();
+    for (uint32_t vertex = 0; vertex < simplifier.positions.size(); vertex++)
+    {
+        simplifier.queueEdges(vertex);
+    }
+
+    while (simplifier.faceCount > targetFaceCount && !simplifier.collapses.empty())
+    {
+        const EdgeCollapse edge = simplifier.collapses.top();
+        simplifier.collapses.pop();
+        if (edge.versionA != simplifier.versions[edge.a] || edge.versionB != simplifier.versions[edge.b] ||
+            simplifier.flipsFace(edge.a, edge.b, edge.position) || simplifier.flipsFace(edge.b, edge.a, edge.position) ||
+            simplifier.sharedFaces(edge.a, edge.b) == simplifier.faceCount || !simplifier.keepsManifold(edge.a, edge.b))
+        {
+            continue; // Out of date, or would fold the surface over, collapse it away entirely or leave it no longer a manifold
+        }
+        simplifier.collapse(edge);
+    }
+
+    TriangleMesh simplified = simplifier.result();
+    simplified.transform = mesh.transform;
+    simplified.material = mesh.material;
+    return simplified;
+}
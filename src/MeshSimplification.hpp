@@ -0,0 +1,25 @@
+/*
+ * MeshSimplification.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_MESHSIMPLIFICATION_HPP_
+#define SRC_MESHSIMPLIFICATION_HPP_
+
+#include "Shape.hpp"
+
+#include <cstddef>
+
+// Collapses edges of mesh until it has no more than targetFaceCount faces, always the edge whose
+// collapse moves the surface least as measured by the quadric error metric (Garland and Heckbert).
+// Edges with a face on only one side, at the mesh's borders or where vertices were split for their
+// normals or texture coordinates, are held back by heavily weighted planes through them. That keeps
+// open meshes close to their outline, but it is only a cost: each side of a seam is simplified on
+// its own, so the two can drift apart and open a crack. Texture coordinates slide along each
+// collapsed edge with its vertex.
+// Stops early if no collapse is left that would not flip a face.
+[[nodiscard]] TriangleMesh SimplifyMesh(const TriangleMesh& mesh, size_t targetFaceCount);
+
+#endif /* SRC_MESHSIMPLIFICATION_HPP_ */
@@ -6,8 +6,10 @@
  */
 
 #include "ObjParser.hpp"
+#include "Trace.hpp"
 #include <array>
 #include <charconv>
+#include <cmath>
 #include <cstdlib>
 #include <limits>
 #include <stdexcept>
@@ -15,11 +17,29 @@
 std::vector<std::string_view> tokenizeString(std::string_view textLine, char delimiter, bool allowEmptyTokens = true);
 void ParseVertexData(std::vector<std::string_view>& tokens, std::vector<Tuple>& vertices);
 void ParseNormalData(std::vector<std::string_view>& tokens, std::vector<Tuple>& normals);
+void ParseTextureVertexData(std::vector<std::string_view>& tokens, std::vector<TriangleMesh::TextureVertex>& textureVertices);
+std::vector<std::array<uint64_t, 3>> ParseFaceIndices(std::vector<std::string_view>& tokens);
 void ParseFaceData(std::vector<std::string_view>& tokens, std::vector<Tuple>& vertices, std::vector<Tuple>& normals, Group*& currentGroup);
 void ParseGroupData(std::vector<std::string_view>& tokens, std::unordered_map<std::string, Group>& namedGroups, Group*& currentGroup);
 
 ObjParser::ObjParser(const std::string& inputData)
 {
+    Parse(inputData);
+}
+
+ObjParser::ObjParser(const std::string& inputData, const MeshOptions& options) : meshOptions(options)
+{
+    if (options.weld && !(options.weldTolerance > 0.0F))
+    {
+        throw std::runtime_error("ObjParser: Weld tolerance must be positive");
+    }
+    Parse(inputData);
+    FinishMeshes();
+}
+
+void ObjParser::Parse(const std::string& inputData)
+{
+    const TraceScope trace("ObjParser");
     if (inputData.empty())
     {
         return;
@@ -68,6 +88,12 @@ void ObjParser::ParseTokens(std::vector<std::string_view>& tokens, Group*& curre
     } else if (tokens[0] == "vn")
     {
         ParseNormalData(tokens, normals);
+    } else if (tokens[0] == "vt")
+    {
+        ParseTextureVertexData(tokens, textureVertices);
+    } else if (tokens[0] == "f" && meshOptions)
+    {
+        AddMeshFace(ParseFaceIndices(tokens), currentGroup);
     } else if (tokens[0] == "f")
     {
         ParseFaceData(tokens, vertices, normals, currentGroup);
@@ -126,37 +152,60 @@ void ParseNormalData(std::vector<std::string_view>& tokens, std::vector<Tuple>&
     normals.emplace_back(Vector(vertexNormal[0], vertexNormal[1], vertexNormal[2]));
 }
 
-void ParseFaceData(std::vector<std::string_view>& tokens, std::vector<Tuple>& vertices, std::vector<Tuple>& normals, Group*& currentGroup)
+// Texture vertices may have a third, w coordinate, which is ignored
+void ParseTextureVertexData(std::vector<std::string_view>& tokens, std::vector<TriangleMesh::TextureVertex>& textureVertices)
+{
+    if (tokens.size() != 3 && tokens.size() != 4)
+    {
+        throw std::runtime_error("ObjParser: Unable to parse texture vertex");
+    }
+    TriangleMesh::TextureVertex coordinates{};
+    for (uint32_t i = 1; i < 3; i++)
+    {
+        std::from_chars(tokens[i].begin(), tokens[i].end(), coordinates[i - 1]);
+    }
+    textureVertices.push_back(coordinates);
+}
+
+// The vertex, texture vertex and normal index of each corner, with the largest index standing
+// for an index the corner does not give
+std::vector<std::array<uint64_t, 3>> ParseFaceIndices(std::vector<std::string_view>& tokens)
 {
     if (tokens.size() < 4)
     {
         throw std::runtime_error("ObjParser: Unable to parse face");
     }
-    std::vector<std::pair<uint64_t, uint64_t>> vertexIndices(tokens.size() - 1);
+    std::vector<std::array<uint64_t, 3>> vertexIndices(tokens.size() - 1);
     for (uint32_t i = 1; i < tokens.size(); i++)
     {
         std::vector<std::string_view> vertexTokens = tokenizeString(tokens[i], '/');
-        if (vertexTokens.size() == 3)
+        for (uint32_t index = 0; index < 3; index++)
         {
-            std::from_chars(vertexTokens[2].begin(), vertexTokens[2].end(), vertexIndices[i - 1].second);
-        } else
-        {
-            vertexIndices[i - 1].second = std::numeric_limits<uint64_t>::max();
+            vertexIndices[i - 1][index] = std::numeric_limits<uint64_t>::max();
+            if (index < vertexTokens.size() && !vertexTokens[index].empty())
+            {
+                std::from_chars(vertexTokens[index].begin(), vertexTokens[index].end(), vertexIndices[i - 1][index]);
+            }
         }
-        std::from_chars(vertexTokens[0].begin(), vertexTokens[0].end(), vertexIndices[i - 1].first);
     }
-    if (vertexIndices[0].second == std::numeric_limits<uint64_t>::max())
+    return vertexIndices;
+}
+
+void ParseFaceData(std::vector<std::string_view>& tokens, std::vector<Tuple>& vertices, std::vector<Tuple>& normals, Group*& currentGroup)
+{
+    const std::vector<std::array<uint64_t, 3>> vertexIndices = ParseFaceIndices(tokens);
+    if (vertexIndices[0][2] == std::numeric_limits<uint64_t>::max())
     {
         for (uint32_t i = 2; i < vertexIndices.size(); i++)
         {
-            currentGroup->addChild(Triangle(vertices[vertexIndices[0].first - 1], vertices[vertexIndices[i - 1].first - 1], vertices[vertexIndices[i].first - 1]));
+            currentGroup->addChild(Triangle(vertices[vertexIndices[0][0] - 1], vertices[vertexIndices[i - 1][0] - 1], vertices[vertexIndices[i][0] - 1]));
         }
     } else
     {
         for (uint32_t i = 2; i < vertexIndices.size(); i++)
         {
-            currentGroup->addChild(SmoothTriangle(vertices[vertexIndices[0].first - 1], vertices[vertexIndices[i - 1].first - 1], vertices[vertexIndices[i].first - 1],
-                                                  normals[vertexIndices[0].second - 1], normals[vertexIndices[i - 1].second - 1], normals[vertexIndices[i].second - 1]));
+            currentGroup->addChild(SmoothTriangle(vertices[vertexIndices[0][0] - 1], vertices[vertexIndices[i - 1][0] - 1], vertices[vertexIndices[i][0] - 1],
+                                                  normals[vertexIndices[0][2] - 1], normals[vertexIndices[i - 1][2] - 1], normals[vertexIndices[i][2] - 1]));
         }
     }
 }
@@ -170,3 +219,80 @@ void ParseGroupData(std::vector<std::string_view>& tokens, std::unordered_map<st
     namedGroups.emplace(tokens[1], Group());
     currentGroup = &namedGroups[std::string(tokens[1].data(), tokens[1].size())];
 }
+
+size_t ObjParser::VertexKeyHash::operator()(const VertexKey& key) const noexcept
+{
+    size_t hash = 0;
+    for (const int64_t value : key)
+    {
+        hash ^= std::hash<int64_t>()(value) + 0x9e3779b97f4a7c15U + (hash << 6U) + (hash >> 2U);
+    }
+    return hash;
+}
+
+void ObjParser::AddMeshFace(const std::vector<FaceCorner>& corners, Group* group)
+{
+    MeshBuilder& mesh = meshBuilders[group];
+    std::vector<uint32_t> cornerIndices;
+    cornerIndices.reserve(corners.size());
+    for (const FaceCorner& corner : corners)
+    {
+        cornerIndices.push_back(AddMeshVertex(mesh, corner));
+    }
+    // Polygons are split into a fan of triangles, as they are without meshes
+    for (size_t i = 2; i < cornerIndices.size(); i++)
+    {
+        mesh.indices.insert(mesh.indices.end(), {cornerIndices[0], cornerIndices[i - 1], cornerIndices[i]});
+    }
+}
+
+uint32_t ObjParser::AddMeshVertex(MeshBuilder& mesh, const FaceCorner& corner)
+{
+    const auto [vertex, textureVertex, normal] = corner;
+    const bool hasTextureVertex = textureVertex != std::numeric_limits<uint64_t>::max();
+    const bool hasNormal = normal != std::numeric_limits<uint64_t>::max();
+    if (vertex == 0 || vertex > vertices.size() || (hasTextureVertex && (textureVertex == 0 || textureVertex > textureVertices.size())) ||
+        (hasNormal && (normal == 0 || normal > normals.size())))
+    {
+        throw std::runtime_error("ObjParser: Face refers to a vertex, texture vertex or normal that does not exist");
+    }
+    const Tuple& position = vertices[vertex - 1];
+    const Tuple direction = hasNormal ? normals[normal - 1] : Vector(0, 0, 0);
+    const TriangleMesh::TextureVertex coordinates = hasTextureVertex ? textureVertices[textureVertex - 1] : TriangleMesh::TextureVertex{0.0F, 0.0F};
+
+    // Without welding, a vertex is shared by every face that gives the same indices
+    VertexKey key = {static_cast<int64_t>(vertex), static_cast<int64_t>(textureVertex), static_cast<int64_t>(normal), 0, 0, 0, 0, 0};
+    if (meshOptions->weld)
+    {
+        const auto quantize = [&](const float value) { return static_cast<int64_t>(std::llround(value / meshOptions->weldTolerance)); };
+        key = {quantize(position.x), quantize(position.y), quantize(position.z), quantize(direction.x), quantize(direction.y), quantize(direction.z), quantize(coordinates[0]), quantize(coordinates[1])};
+    }
+
+    const auto [found, added] = mesh.vertexIndices.try_emplace(key, static_cast<uint32_t>(mesh.positions.size()));
+    if (added)
+    {
+        mesh.positions.push_back({position.x, position.y, position.z});
+        mesh.normals.push_back({direction.x, direction.y, direction.z});
+        mesh.textureCoordinates.push_back(coordinates);
+        mesh.hasNormals = mesh.hasNormals || hasNormal;
+        mesh.hasTextureCoordinates = mesh.hasTextureCoordinates || hasTextureVertex;
+    }
+    return found->second;
+}
+
+void ObjParser::FinishMeshes()
+{
+    for (auto& [group, mesh] : meshBuilders)
+    {
+        if (!mesh.hasNormals)
+        {
+            mesh.normals.clear();
+        }
+        if (!mesh.hasTextureCoordinates)
+        {
+            mesh.textureCoordinates.clear();
+        }
+        group->addChild(TriangleMesh(std::move(mesh.positions), std::move(mesh.normals), mesh.indices, std::move(mesh.textureCoordinates)));
+    }
+    meshBuilders.clear();
+}
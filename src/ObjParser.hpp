@@ -10,24 +10,72 @@
 
 #include "Shape.hpp"
 #include "Tuple.hpp"
+#include <array>
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+// How ObjParser builds indexed meshes
+class MeshOptions
+{
+  public:
+    // Merge vertices whose positions, and normals if they have them, round to the same point on a
+    // grid of weldTolerance. Exports that repeat each vertex for every face it is part of then share
+    // one vertex per point, though two points either side of a grid line are not merged.
+    bool weld = false;
+    float weldTolerance = 1e-5F;
+};
+
 class ObjParser
 {
   public:
     std::vector<Tuple> vertices;
     std::vector<Tuple> normals;
+    std::vector<TriangleMesh::TextureVertex> textureVertices;
     std::unordered_map<std::string, Group> namedGroups;
     Group defaultGroup;
     uint32_t ignoredLines = 0;
 
     explicit ObjParser(const std::string& inputData);
+    // Gives each group one TriangleMesh of all of its faces, rather than a Triangle or
+    // SmoothTriangle for each face. Only meshes take the texture coordinates of 'vt' lines.
+    ObjParser(const std::string& inputData, const MeshOptions& options);
     Group getGroup();
 
   private:
+    using VertexKey = std::array<int64_t, 8>;
+    // The vertex, texture vertex and normal index of a face corner, the largest index standing for none
+    using FaceCorner = std::array<uint64_t, 3>;
+
+    class VertexKeyHash
+    {
+      public:
+        size_t operator()(const VertexKey& key) const noexcept;
+    };
+
+    // One group's mesh while it is being read
+    class MeshBuilder
+    {
+      public:
+        std::vector<TriangleMesh::Vertex> positions;
+        std::vector<TriangleMesh::Vertex> normals; // Zero for vertices given without one
+        std::vector<TriangleMesh::TextureVertex> textureCoordinates; // Likewise
+        std::vector<uint32_t> indices;
+        std::unordered_map<VertexKey, uint32_t, VertexKeyHash> vertexIndices;
+        bool hasNormals = false;
+        bool hasTextureCoordinates = false;
+    };
+
+    std::optional<MeshOptions> meshOptions;
+    std::unordered_map<Group*, MeshBuilder> meshBuilders;
+
+    void Parse(const std::string& inputData);
     void ParseTokens(std::vector<std::string_view>& tokens, Group*& currentGroup);
+    void AddMeshFace(const std::vector<FaceCorner>& corners, Group* group);
+    uint32_t AddMeshVertex(MeshBuilder& mesh, const FaceCorner& corner);
+    void FinishMeshes();
 };
 
 #endif /* SRC_OBJPARSER_HPP_ */
@@ -10,33 +10,71 @@
 
 #include "Ray.hpp"
 #include <algorithm>
+#include <bit>
 #include <cmath>
 
+Tuple OffsetRayOrigin(const Tuple& point, const Tuple& normal, const float magnitude) noexcept
+{
+    // Stepping the bit pattern of a positive float by n moves it exactly n representable values
+    const float stepped = std::bit_cast<float>(std::bit_cast<int32_t>(magnitude) + RAY_OFFSET_ULPS);
+    const float offset = std::max(stepped - magnitude, RAY_OFFSET_MINIMUM);
+    return point + normal * offset;
+}
+
 Tuple Ray::cast(const float t) const noexcept
 {
     return origin + direction * t;
 }
 
-std::optional<Intersection> Ray::hit(const std::vector<Intersection>& intersections) noexcept
+std::optional<Intersection> Ray::hit(std::span<const Intersection> intersections) noexcept
 {
-    auto sortedIntersections = intersections;
-    std::sort(sortedIntersections.begin(), sortedIntersections.end());
-    for (const auto intersection : sortedIntersections)
+    // The hit is the nearest non-negative intersection; a linear scan finds it without copying and sorting the list
+    std::optional<Intersection> nearest;
+    for (const auto intersection : intersections)
     {
-        if (intersection.t > 0)
+        if (intersection.t > 0 && (!nearest || intersection < *nearest))
         {
-            return intersection;
+            nearest = intersection;
         }
     }
-    return std::nullopt;
+    return nearest;
 }
 
-Ray Ray::transform(const Matrix<4>& m) const noexcept
+Ray Ray::transform(const AffineTransform& m) const noexcept
 {
     return {m * this->origin, m * this->direction};
 }
 
-IntersectionDetails Ray::precomputeDetails(const Intersection& i, const std::vector<Intersection>& intersections) const noexcept
+std::optional<SurfaceDifferential> Ray::transferDifferential(const Intersection& i, const Tuple& position, const Tuple& normalVector, const bool inside, const RayDifferential& differential) const noexcept
+{
+    const float directionDotNormal = direction.dot(normalVector);
+    if (std::abs(directionDotNormal) < RAY_DIFFERENTIAL_MINIMUM_COSINE)
+    {
+        return std::nullopt; // At grazing angles the footprint has no useful bound
+    }
+    // Where the neighbouring pixels' rays meet the plane tangent to the surface at the hit
+    const auto transfer = [&](const Tuple& dOrigin, const Tuple& dDirection) {
+        const Tuple moved = dOrigin + dDirection * i.t;
+        return moved - direction * (moved.dot(normalVector) / directionDotNormal);
+    };
+    const Tuple dpdx = transfer(differential.originX, differential.directionX);
+    const Tuple dpdy = transfer(differential.originY, differential.directionY);
+
+    // The normal's change, which only spawned rays need, is found by evaluating it at the
+    // neighbouring points. That captures the curvature of analytic shapes; shapes whose normals
+    // come from the hit's barycentric coordinates instead see no change, as if flat.
+    Tuple dndx = Vector(0, 0, 0);
+    Tuple dndy = Vector(0, 0, 0);
+    if (i.object->material.reflectivity > 0.0F || i.object->material.transparency > 0.0F)
+    {
+        const float side = inside ? -1.0F : 1.0F;
+        dndx = i.object->normal(position + dpdx, i) * side - normalVector;
+        dndy = i.object->normal(position + dpdy, i) * side - normalVector;
+    }
+    return SurfaceDifferential{{dpdx, dpdy}, dndx, dndy, differential.directionX, differential.directionY};
+}
+
+IntersectionDetails Ray::precomputeDetails(const Intersection& i, std::span<const Intersection> intersections, const std::optional<RayDifferential>& differential) const noexcept
 {
     const Tuple position = cast(i.t);
     const Tuple eyeVector = -direction;
@@ -46,11 +84,13 @@ IntersectionDetails Ray::precomputeDetails(const Intersection& i, const std::vec
     {
         normalVector = -normalVector;
     }
-    const Tuple overPosition = position + normalVector * TUPLE_EPSILON;
-    const Tuple underPosition = position - normalVector * TUPLE_EPSILON;
+    const float magnitude = std::max({std::abs(position.x), std::abs(position.y), std::abs(position.z),
+                                      std::abs(origin.x), std::abs(origin.y), std::abs(origin.z)});
+    const Tuple overPosition = OffsetRayOrigin(position, normalVector, magnitude);
+    const Tuple underPosition = OffsetRayOrigin(position, -normalVector, magnitude);
     const Tuple reflectionVector = direction.reflect(normalVector);
 
-    std::vector<std::reference_wrapper<const Shape>> containers;
+    ArenaVector<std::reference_wrapper<const Shape>> containers;
     float n1 = 0.0F;
     float n2 = 0.0F;
     for (auto intersection : intersections)
@@ -105,7 +145,20 @@ IntersectionDetails Ray::precomputeDetails(const Intersection& i, const std::vec
     const float r0 = powf(((n1 - n2) / (n1 + n2)), 2);
     const float reflectance = sin2T > 1.0F ? 1.0F : r0 + (1 - r0) * powf(1 - cos, 5);
 
-    IntersectionDetails id = {position, overPosition, underPosition, eyeVector, normalVector, reflectionVector, *(i.object), i.t, reflectance, n1, n2, inside};
+    // Only patterns, textures and the rays a surface spawns use the differential
+    const Material& material = i.object->material;
+    std::optional<SurfaceDifferential> surfaceDifferential;
+    if (differential && (material.pattern || material.texture || material.reflectivity > 0.0F || material.transparency > 0.0F))
+    {
+        surfaceDifferential = transferDifferential(i, position, normalVector, inside, *differential);
+    }
+    TextureCoordinates coordinates;
+    if (material.texture)
+    {
+        coordinates = i.object->textureCoordinates(position, i, surfaceDifferential ? surfaceDifferential->footprint : Footprint());
+    }
+
+    IntersectionDetails id = {position, overPosition, underPosition, eyeVector, normalVector, reflectionVector, *(i.object), i.t, reflectance, n1, n2, inside, surfaceDifferential, coordinates};
     return id;
 }
 
@@ -11,8 +11,35 @@
 #include "Shape.hpp"
 #include "Tuple.hpp"
 
+#include <cstdint>
 #include <optional>
-#include <vector>
+#include <span>
+
+// The rounding error of a hit point grows with the largest coordinate that went into computing it
+// (the hit point itself, the ray origin and any translation undone on the way into object space),
+// so secondary rays start a fixed number of float steps of that magnitude away from the surface.
+// The minimum covers the error of intersecting near the origin; the quadric intersections solve for
+// the root nearest zero without cancellation, so rays leaving close to the tangent plane clear it too.
+constexpr int32_t RAY_OFFSET_ULPS = 64;
+constexpr float RAY_OFFSET_MINIMUM = 0.0001F;
+
+// Hits whose ray meets the surface at a smaller cosine than this get no differential
+constexpr float RAY_DIFFERENTIAL_MINIMUM_COSINE = 0.001F;
+
+// Moves a point off a surface along its normal by RAY_OFFSET_ULPS units in the last place of
+// magnitude, or RAY_OFFSET_MINIMUM if that is larger
+[[nodiscard]] Tuple OffsetRayOrigin(const Tuple& point, const Tuple& normal, float magnitude) noexcept;
+
+// How a ray's origin and direction change from the ray of one pixel to that of the next over, in x
+// and in y (Igehy, "Tracing Ray Differentials")
+class RayDifferential
+{
+  public:
+    Tuple originX;
+    Tuple directionX;
+    Tuple originY;
+    Tuple directionY;
+};
 
 class Ray
 {
@@ -22,9 +49,25 @@ class Ray
 
     Ray(const Tuple& originIn, const Tuple& directionIn) noexcept : origin(originIn), direction(directionIn){};
     [[nodiscard]] Tuple cast(float t) const noexcept;
-    [[nodiscard]] static std::optional<Intersection> hit(const std::vector<Intersection>& intersections) noexcept;
-    [[nodiscard]] Ray transform(const Matrix<4>& m) const noexcept;
-    [[nodiscard]] IntersectionDetails precomputeDetails(const Intersection& i, const std::vector<Intersection>& intersections) const noexcept;
+    [[nodiscard]] static std::optional<Intersection> hit(std::span<const Intersection> intersections) noexcept;
+    [[nodiscard]] Ray transform(const AffineTransform& m) const noexcept;
+    // Given this ray's differential, the details also say how much of the surface a pixel covers
+    [[nodiscard]] IntersectionDetails precomputeDetails(const Intersection& i, std::span<const Intersection> intersections, const std::optional<RayDifferential>& differential = std::nullopt) const noexcept;
+
+  private:
+    [[nodiscard]] std::optional<SurfaceDifferential> transferDifferential(const Intersection& i, const Tuple& position, const Tuple& normalVector, bool inside, const RayDifferential& differential) const noexcept;
+};
+
+static_assert(sizeof(Ray) == 2 * sizeof(Tuple));
+
+// Camera rays and the reflections and refractions they spawn carry differentials, so the surfaces
+// they hit know how much of them a pixel covers. They are kept out of Ray itself, which is copied
+// into object space for every intersection test and cast for every shadow.
+class DifferentialRay
+{
+  public:
+    Ray ray;
+    std::optional<RayDifferential> differential;
 };
 
 #endif /* SRC_RAY_HPP_ */
@@ -0,0 +1,682 @@
+/*
+ * RenderFarm.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "RenderFarm.hpp"
+#include "YamlParser.hpp"
+
+#include <algorithm>
+#include <array>
+#include <deque>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+void SendAll(const int descriptor, const uint8_t* data, size_t size)
+{
+    while (size > 0)
+    {
+        // MSG_NOSIGNAL turns a vanished peer into an error rather than a SIGPIPE
+        const ssize_t sent = send(descriptor, data, size, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            throw std::runtime_error("Render farm connection failed while sending.");
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+}
+
+// False if the connection closed before any data arrived
+bool ReceiveAll(const int descriptor, uint8_t* data, size_t size)
+{
+    bool started = false;
+    while (size > 0)
+    {
+        const ssize_t received = recv(descriptor, data, size, 0);
+        if (received == 0 && !started)
+        {
+            return false;
+        }
+        if (received <= 0)
+        {
+            throw std::runtime_error("Render farm connection failed while receiving.");
+        }
+        started = true;
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+void SendFarmMessage(const int descriptor, const FarmMessage& message)
+{
+    if (message.payload.size() > MAXIMUM_FARM_MESSAGE_SIZE)
+    {
+        throw std::runtime_error("Render farm message is larger than the protocol allows.");
+    }
+    FarmMessage header;
+    header.append(static_cast<uint32_t>(message.type));
+    header.append(uint64_t{message.payload.size()});
+    SendAll(descriptor, header.payload.data(), header.payload.size());
+    SendAll(descriptor, message.payload.data(), message.payload.size());
+}
+
+std::optional<FarmMessage> ReceiveFarmMessage(const int descriptor)
+{
+    FarmMessage header;
+    header.payload.resize(sizeof(uint32_t) + sizeof(uint64_t));
+    if (!ReceiveAll(descriptor, header.payload.data(), header.payload.size()))
+    {
+        return std::nullopt;
+    }
+
+    size_t offset = 0;
+    const auto type = header.read<uint32_t>(offset);
+    const auto size = header.read<uint64_t>(offset);
+    if (type > FarmMessage::Statistics)
+    {
+        throw std::runtime_error("Render farm message has an unknown type.");
+    }
+    if (size > MAXIMUM_FARM_MESSAGE_SIZE)
+    {
+        throw std::runtime_error("Render farm message is larger than the protocol allows.");
+    }
+
+    FarmMessage message;
+    message.type = static_cast<FarmMessage::Type>(type);
+    message.payload.resize(size);
+    if (size > 0 && !ReceiveAll(descriptor, message.payload.data(), message.payload.size()))
+    {
+        throw std::runtime_error("Render farm connection closed partway through a message.");
+    }
+    return message;
+}
+
+// Answers messages until the coordinator is done, throwing if one cannot be answered
+void AnswerCoordinator(const int descriptor)
+{
+    std::optional<YamlParser> parser;
+    std::optional<Canvas> image;
+
+    // A coordinator can close while a backup copy of a tile is still being rendered for it, which
+    // is the same as it disconnecting rather than an error
+    const auto reply = [descriptor](const FarmMessage& message) {
+        try
+        {
+            SendFarmMessage(descriptor, message);
+            return true;
+        } catch (const std::exception&)
+        {
+            return false;
+        }
+    };
+
+    while (true)
+    {
+        std::optional<FarmMessage> message;
+        try
+        {
+            message = ReceiveFarmMessage(descriptor);
+        } catch (const std::exception&)
+        {
+            return;
+        }
+        if (!message)
+        {
+            return;
+        }
+        size_t offset = 0;
+        switch (message->type)
+        {
+        case FarmMessage::Scene:
+        {
+            image.reset();
+            const std::string directory = message->readText(offset);
+            parser.emplace(std::string(message->payload.begin() + static_cast<std::ptrdiff_t>(offset), message->payload.end()), directory);
+            // Both need the whole image, where a worker only ever sees tiles of it
+            if (parser->worldCamera.denoise || parser->worldCamera.costMeasure != Camera::NoCost)
+            {
+                throw std::runtime_error("Render farm workers cannot denoise or draw heatmaps; render scenes with 'denoise:' or 'heatmap:' locally.");
+            }
+            break;
+        }
+        case FarmMessage::Frame:
+        {
+            if (!parser)
+            {
+                throw std::runtime_error("Render farm frame requested before a scene was sent.");
+            }
+            const auto frame = message->read<uint32_t>(offset);
+            if (parser->worldSequence.animated())
+            {
+                parser->worldSequence.apply(frame, parser->world, parser->worldCamera);
+            }
+            if (!image)
+            {
+                image.emplace(parser->worldCamera.hSize, parser->worldCamera.vSize);
+            }
+            FarmMessage ready;
+            ready.type = FarmMessage::Ready;
+            ready.append(parser->worldCamera.hSize);
+            ready.append(parser->worldCamera.vSize);
+            ready.append(parser->worldSequence.frameCount);
+            if (!reply(ready))
+            {
+                return;
+            }
+            break;
+        }
+        case FarmMessage::Tile:
+        {
+            if (!parser || !image)
+            {
+                throw std::runtime_error("Render farm tile requested before a frame was set.");
+            }
+            const auto tile = message->read<uint32_t>(offset);
+            const auto xBegin = message->read<uint32_t>(offset);
+            const auto yBegin = message->read<uint32_t>(offset);
+            const auto xEnd = std::min(message->read<uint32_t>(offset), image->width);
+            const auto yEnd = std::min(message->read<uint32_t>(offset), image->height);
+            if (xBegin >= xEnd || yBegin >= yEnd)
+            {
+                throw std::runtime_error("Render farm tile is empty or outside the image.");
+            }
+            if constexpr (RenderStatistics::Enabled)
+            {
+                RenderStatistics::Reset();
+            }
+            parser->worldCamera.RenderTile(parser->world, xBegin, yBegin, xEnd, yEnd, *image);
+            if constexpr (RenderStatistics::Enabled)
+            {
+                // Counts are per process, so a worker sharing its process with another would report both
+                FarmMessage statistics;
+                statistics.type = FarmMessage::Statistics;
+                statistics.appendStatistics(RenderStatistics::Collect());
+                if (!reply(statistics))
+                {
+                    return;
+                }
+            }
+
+            FarmMessage pixels;
+            pixels.type = FarmMessage::Pixels;
+            pixels.append(tile);
+            for (uint32_t y = yBegin; y < yEnd; y++)
+            {
+                for (uint32_t x = xBegin; x < xEnd; x++)
+                {
+                    const Color& c = image->pixels[y][x];
+                    pixels.append(c.r);
+                    pixels.append(c.g);
+                    pixels.append(c.b);
+                }
+            }
+            if (!reply(pixels))
+            {
+                return;
+            }
+            break;
+        }
+        case FarmMessage::Shutdown:
+            return;
+        default:
+            throw std::runtime_error("Render farm worker received a message it does not handle.");
+        }
+    }
+}
+
+void RunRenderWorker(const int descriptor) noexcept
+{
+    try
+    {
+        AnswerCoordinator(descriptor);
+    } catch (const std::exception& error)
+    {
+        // The coordinator drops this worker either way; the reason is only for its error message
+        try
+        {
+            FarmMessage failed;
+            failed.type = FarmMessage::Failed;
+            const std::string reason = error.what();
+            failed.payload.assign(reason.begin(), reason.end());
+            SendFarmMessage(descriptor, failed);
+        } catch (const std::exception&)
+        {
+        }
+    }
+}
+
+int OpenEndpoint(const std::string& endpoint, const bool listening)
+{
+    if (endpoint.starts_with("unix:"))
+    {
+        const std::string path = endpoint.substr(5);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+        {
+            throw std::runtime_error("Render farm socket path is empty or too long: " + path);
+        }
+        std::copy(path.begin(), path.end(), address.sun_path);
+
+        const int descriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listening)
+        {
+            unlink(path.c_str());
+        }
+        const auto* generic = reinterpret_cast<const sockaddr*>(&address);
+        if (descriptor < 0 || (listening ? bind(descriptor, generic, sizeof(address)) : connect(descriptor, generic, sizeof(address))) != 0)
+        {
+            if (descriptor >= 0)
+            {
+                close(descriptor);
+            }
+            throw std::runtime_error("Could not open render farm endpoint " + endpoint);
+        }
+        return descriptor;
+    }
+
+    const size_t separator = endpoint.rfind(':');
+    if (separator == std::string::npos)
+    {
+        throw std::runtime_error("Render farm endpoint in invalid format. Expected: 'unix:/path' or 'host:port'");
+    }
+    const std::string host = endpoint.substr(0, separator);
+    const std::string port = endpoint.substr(separator + 1);
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = listening ? AI_PASSIVE : 0;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &addresses) != 0)
+    {
+        throw std::runtime_error("Could not resolve render farm endpoint " + endpoint);
+    }
+
+    int descriptor = -1;
+    for (const addrinfo* address = addresses; address != nullptr && descriptor < 0; address = address->ai_next)
+    {
+        descriptor = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (descriptor < 0)
+        {
+            continue;
+        }
+        const int reuse = 1;
+        if (listening)
+        {
+            setsockopt(descriptor, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        }
+        if ((listening ? bind(descriptor, address->ai_addr, address->ai_addrlen) : connect(descriptor, address->ai_addr, address->ai_addrlen)) != 0)
+        {
+            close(descriptor);
+            descriptor = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (descriptor < 0)
+    {
+        throw std::runtime_error("Could not open render farm endpoint " + endpoint);
+    }
+    return descriptor;
+}
+
+void ServeRenderWorker(const std::string& endpoint)
+{
+    const int listener = OpenEndpoint(endpoint, true);
+    if (listen(listener, 1) != 0)
+    {
+        close(listener);
+        throw std::runtime_error("Could not listen on render farm endpoint " + endpoint);
+    }
+
+    while (true)
+    {
+        const int connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0)
+        {
+            continue;
+        }
+        // A broken coordinator only loses its own connection; the coordinator retries elsewhere
+        RunRenderWorker(connection);
+        close(connection);
+    }
+}
+
+int ConnectToRenderWorker(const std::string& endpoint)
+{
+    return OpenEndpoint(endpoint, false);
+}
+
+int SpawnLocalRenderWorker(const std::string& executable)
+{
+    // A fresh exec rather than a bare fork, since a forked copy of a process that has already
+    // started OpenMP threads cannot safely start any more
+    int descriptors[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, descriptors) != 0)
+    {
+        throw std::runtime_error("Could not create a socket pair for a render worker.");
+    }
+    fcntl(descriptors[0], F_SETFD, FD_CLOEXEC);
+
+    const pid_t process = fork();
+    if (process == 0)
+    {
+        const std::string workerDescriptor = std::to_string(descriptors[1]);
+        execl(executable.c_str(), executable.c_str(), "--worker-fd", workerDescriptor.c_str(), nullptr);
+        _exit(127);
+    }
+    close(descriptors[1]);
+    if (process < 0)
+    {
+        close(descriptors[0]);
+        throw std::runtime_error("Could not start a render worker.");
+    }
+    return descriptors[0];
+}
+
+RenderCoordinator::RenderCoordinator(const std::vector<int>& workerDescriptors) noexcept
+{
+    for (const int descriptor : workerDescriptors)
+    {
+        workers.push_back({descriptor, false, std::nullopt, {}});
+    }
+}
+
+RenderCoordinator::~RenderCoordinator()
+{
+    FarmMessage shutdown;
+    shutdown.type = FarmMessage::Shutdown;
+    for (Worker& worker : workers)
+    {
+        if (worker.descriptor >= 0)
+        {
+            try
+            {
+                SendFarmMessage(worker.descriptor, shutdown);
+            } catch (const std::exception&)
+            {
+            }
+            dropWorker(worker);
+        }
+    }
+}
+
+Canvas RenderCoordinator::render(const std::string& scene, const uint32_t frame, const std::string& directory)
+{
+    FarmMessage sceneMessage;
+    sceneMessage.type = FarmMessage::Scene;
+    sceneMessage.appendText(directory);
+    sceneMessage.payload.insert(sceneMessage.payload.end(), scene.begin(), scene.end());
+    FarmMessage frameMessage;
+    frameMessage.type = FarmMessage::Frame;
+    frameMessage.append(frame);
+    for (Worker& worker : workers)
+    {
+        if (worker.descriptor < 0)
+        {
+            continue;
+        }
+        worker.ready = false;
+        worker.tile.reset();
+        try
+        {
+            if (scene != sentScene || directory != sentDirectory)
+            {
+                SendFarmMessage(worker.descriptor, sceneMessage);
+            }
+            SendFarmMessage(worker.descriptor, frameMessage);
+            worker.dispatched = std::chrono::steady_clock::now();
+        } catch (const std::exception&)
+        {
+            dropWorker(worker);
+        }
+    }
+    sentScene = scene;
+    sentDirectory = directory;
+    frameStatistics = RenderStatistics();
+    std::string failure; // Of the last worker that said why it failed
+
+    std::optional<Canvas> image;
+    std::vector<std::array<uint32_t, 4>> tiles;
+    std::vector<bool> finished;
+    std::deque<uint32_t> pending;
+    size_t remaining = 1; // Until the first worker reports the canvas size
+
+    // Hands a tile back to the queue unless it is done or another worker still has it
+    const auto requeue = [&](const uint32_t tile) {
+        const bool heldElsewhere = std::any_of(workers.begin(), workers.end(), [&](const Worker& other) {
+            return other.descriptor >= 0 && other.tile == tile;
+        });
+        if (!finished[tile] && !heldElsewhere)
+        {
+            pending.push_front(tile);
+        }
+    };
+    const auto fail = [&](Worker& worker) {
+        const std::optional<uint32_t> lost = worker.tile;
+        dropWorker(worker);
+        if (lost)
+        {
+            requeue(*lost);
+        }
+    };
+
+    while (remaining > 0)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        for (Worker& worker : workers)
+        {
+            if (worker.descriptor < 0 || !worker.ready || worker.tile || !image)
+            {
+                continue;
+            }
+            std::optional<uint32_t> tile;
+            if (!pending.empty())
+            {
+                tile = pending.front();
+                pending.pop_front();
+            } else
+            {
+                // Back up the tile that has been out longest and has no copy yet
+                const Worker* slowest = nullptr;
+                for (const Worker& other : workers)
+                {
+                    if (other.descriptor < 0 || !other.tile || finished[*other.tile])
+                    {
+                        continue;
+                    }
+                    const bool copied = std::count_if(workers.begin(), workers.end(), [&](const Worker& w) {
+                                            return w.descriptor >= 0 && w.tile == other.tile;
+                                        }) > 1;
+                    if (!copied && (slowest == nullptr || other.dispatched < slowest->dispatched))
+                    {
+                        slowest = &other;
+                    }
+                }
+                if (slowest != nullptr)
+                {
+                    tile = slowest->tile;
+                }
+            }
+            if (!tile)
+            {
+                continue;
+            }
+
+            FarmMessage tileMessage;
+            tileMessage.type = FarmMessage::Tile;
+            tileMessage.append(*tile);
+            for (const uint32_t bound : tiles[*tile])
+            {
+                tileMessage.append(bound);
+            }
+            worker.tile = tile;
+            worker.dispatched = now;
+            try
+            {
+                SendFarmMessage(worker.descriptor, tileMessage);
+            } catch (const std::exception&)
+            {
+                fail(worker);
+            }
+        }
+
+        std::vector<pollfd> polled;
+        std::vector<Worker*> polledWorkers;
+        for (Worker& worker : workers)
+        {
+            if (worker.descriptor >= 0)
+            {
+                polled.push_back({worker.descriptor, POLLIN, 0});
+                polledWorkers.push_back(&worker);
+            }
+        }
+        if (polled.empty())
+        {
+            throw std::runtime_error("Every render farm worker failed before the frame was finished." + (failure.empty() ? "" : " The last said: " + failure));
+        }
+        poll(polled.data(), polled.size(), 100);
+
+        for (size_t i = 0; i < polled.size(); i++)
+        {
+            Worker& worker = *polledWorkers[i];
+            if ((polled[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0)
+            {
+                if ((worker.tile || !worker.ready) && std::chrono::steady_clock::now() - worker.dispatched > workerTimeout)
+                {
+                    fail(worker);
+                }
+                continue;
+            }
+
+            try
+            {
+                const std::optional<FarmMessage> message = ReceiveFarmMessage(worker.descriptor);
+                if (!message)
+                {
+                    fail(worker);
+                    continue;
+                }
+                size_t offset = 0;
+                if (message->type == FarmMessage::Ready)
+                {
+                    const auto width = message->read<uint32_t>(offset);
+                    const auto height = message->read<uint32_t>(offset);
+                    sceneFrameCount = message->read<uint32_t>(offset);
+                    worker.ready = true;
+                    if (!image)
+                    {
+                        image.emplace(width, height);
+                        for (uint32_t y = 0; y < height; y += tileSize)
+                        {
+                            for (uint32_t x = 0; x < width; x += tileSize)
+                            {
+                                pending.push_back(static_cast<uint32_t>(tiles.size()));
+                                tiles.push_back({x, y, std::min(x + tileSize, width), std::min(y + tileSize, height)});
+                            }
+                        }
+                        finished.assign(tiles.size(), false);
+                        remaining = tiles.size();
+                    } else if (width != image->width || height != image->height)
+                    {
+                        throw std::runtime_error("Render farm worker disagrees about the canvas size.");
+                    }
+                } else if (message->type == FarmMessage::Statistics)
+                {
+                    // Like pixels, statistics before Ready are for a tile of the previous frame
+                    if (worker.ready)
+                    {
+                        const RenderStatistics tile = message->readStatistics(offset);
+                        const uint32_t threads = std::max(frameStatistics.threads, tile.threads);
+                        frameStatistics += tile;
+                        frameStatistics.threads = threads;
+                    }
+                } else if (message->type == FarmMessage::Pixels)
+                {
+                    // Workers answer in order, so pixels before Ready are a copy of a tile from
+                    // the previous frame that was finished elsewhere
+                    if (!worker.ready)
+                    {
+                        continue;
+                    }
+                    const auto tile = message->read<uint32_t>(offset);
+                    if (!worker.tile || *worker.tile != tile || tile >= tiles.size())
+                    {
+                        throw std::runtime_error("Render farm worker returned a tile it was not given.");
+                    }
+                    if (finished[tile])
+                    {
+                        worker.tile.reset();
+                        continue;
+                    }
+                    // Checked before any pixel is read, and the tile stays the worker's until all
+                    // are, so a short reply fails the worker and its tile goes back in the queue
+                    const auto [xBegin, yBegin, xEnd, yEnd] = tiles[tile];
+                    if (message->payload.size() - offset != size_t{xEnd - xBegin} * (yEnd - yBegin) * 3 * sizeof(float))
+                    {
+                        throw std::runtime_error("Render farm worker returned the wrong number of pixels for its tile.");
+                    }
+                    for (uint32_t y = yBegin; y < yEnd; y++)
+                    {
+                        for (uint32_t x = xBegin; x < xEnd; x++)
+                        {
+                            const auto red = message->read<float>(offset);
+                            const auto green = message->read<float>(offset);
+                            const auto blue = message->read<float>(offset);
+                            image->pixels[y][x] = Color(red, green, blue);
+                        }
+                    }
+                    worker.tile.reset();
+                    finished[tile] = true;
+                    remaining--;
+                } else if (message->type == FarmMessage::Failed)
+                {
+                    failure.assign(message->payload.begin(), message->payload.end());
+                    fail(worker);
+                } else
+                {
+                    throw std::runtime_error("Render farm coordinator received a message it does not handle.");
+                }
+            } catch (const std::exception&)
+            {
+                fail(worker);
+            }
+        }
+    }
+
+    return std::move(*image);
+}
+
+uint32_t RenderCoordinator::frameCount() const noexcept
+{
+    return sceneFrameCount;
+}
+
+const RenderStatistics& RenderCoordinator::statistics() const noexcept
+{
+    return frameStatistics;
+}
+
+size_t RenderCoordinator::liveWorkerCount() const noexcept
+{
+    return static_cast<size_t>(std::count_if(workers.begin(), workers.end(), [](const Worker& worker) {
+        return worker.descriptor >= 0;
+    }));
+}
+
+void RenderCoordinator::dropWorker(Worker& worker) noexcept
+{
+    close(worker.descriptor);
+    worker.descriptor = -1;
+    worker.ready = false;
+    worker.tile.reset();
+}
@@ -0,0 +1,178 @@
+/*
+ * RenderFarm.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_RENDERFARM_HPP_
+#define SRC_RENDERFARM_HPP_
+
+#include "Canvas.hpp"
+#include "Statistics.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Larger than any tile, scene or band of rows, so a corrupt or hostile length is refused rather than allocated
+constexpr uint64_t MAXIMUM_FARM_MESSAGE_SIZE = uint64_t{1} << 28U;
+
+// A message between a render coordinator and a worker, or a render service and its client. Payloads are packed host byte order values,
+// so every machine in a farm must share an endianness, as all current targets do.
+class FarmMessage
+{
+  public:
+    enum Type : uint32_t
+    {
+        Scene,     // Coordinator to worker: the scene's directory as text, then the scene file text
+        Frame,     // Coordinator to worker: frame number to pose the scene at
+        Ready,     // Worker to coordinator: canvas width, height and the scene's frame count
+        Tile,      // Coordinator to worker: tile id and xBegin, yBegin, xEnd, yEnd
+        Pixels,    // Worker to coordinator: tile id and the tile's colors, row by row
+        Shutdown,  // Coordinator to worker: no more work on this connection
+        Render,    // Client to render service: a RenderRequest
+        Image,     // Render service to client: image width and height, followed by Rows
+        Rows,      // Render service to client: yBegin, yEnd and the rows' colors
+        Failed,    // Render service to client, or worker to coordinator: why the request could not be rendered
+        Statistics // Worker to coordinator before each Pixels, or render service to client before the last Rows: the work counted for them
+    };
+
+    Type type = Shutdown;
+    std::vector<uint8_t> payload;
+
+    template <typename T>
+    void append(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const size_t offset = payload.size();
+        payload.resize(offset + sizeof(T));
+        std::memcpy(payload.data() + offset, &value, sizeof(T));
+    }
+
+    // Reads the value at offset and advances offset past it
+    template <typename T>
+    T read(size_t& offset) const
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (offset + sizeof(T) > payload.size())
+        {
+            throw std::runtime_error("Render farm message is shorter than its type requires.");
+        }
+        T value;
+        std::memcpy(&value, payload.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    // A uint32_t byte count followed by the bytes
+    void appendText(const std::string& text)
+    {
+        append(static_cast<uint32_t>(text.size()));
+        payload.insert(payload.end(), text.begin(), text.end());
+    }
+
+    std::string readText(size_t& offset) const
+    {
+        const auto size = read<uint32_t>(offset);
+        if (size > payload.size() - offset)
+        {
+            throw std::runtime_error("Render farm message is shorter than its type requires.");
+        }
+        std::string text(payload.begin() + static_cast<std::ptrdiff_t>(offset), payload.begin() + static_cast<std::ptrdiff_t>(offset + size));
+        offset += size;
+        return text;
+    }
+
+    // The thread count followed by every counter
+    void appendStatistics(const RenderStatistics& statistics)
+    {
+        append(statistics.threads);
+        append(statistics.counts);
+    }
+
+    RenderStatistics readStatistics(size_t& offset) const
+    {
+        RenderStatistics statistics;
+        statistics.threads = read<uint32_t>(offset);
+        statistics.counts = read<decltype(statistics.counts)>(offset);
+        return statistics;
+    }
+};
+
+// Both throw for a payload over MAXIMUM_FARM_MESSAGE_SIZE
+void SendFarmMessage(int descriptor, const FarmMessage& message);
+// Empty once the other end has closed the connection
+std::optional<FarmMessage> ReceiveFarmMessage(int descriptor);
+
+// Either "unix:/path" or "host:port"; the returned socket is bound or connected as asked
+int OpenEndpoint(const std::string& endpoint, bool listening);
+
+// Answers one coordinator on a connected socket until it sends Shutdown or disconnects. A scene
+// that does not parse, or asks to be denoised or for a heatmap, or a message out of turn ends the
+// connection, after a Failed reply saying why, rather than throwing.
+void RunRenderWorker(int descriptor) noexcept;
+// Listens on endpoint, either "unix:/path/to/socket" or "host:port", and serves each coordinator
+// that connects in turn. Only returns by throwing if the endpoint cannot be listened on.
+void ServeRenderWorker(const std::string& endpoint);
+int ConnectToRenderWorker(const std::string& endpoint);
+// Starts executable with the arguments "--worker-fd N", connected over a socket pair to the
+// returned descriptor. The caller reaps the child once it has been shut down.
+int SpawnLocalRenderWorker(const std::string& executable);
+
+// Splits frames into tiles and farms them out to workers. The scene is sent to each worker once
+// and only frame numbers follow, so a sequence does not resend its scene. Files the scene names are
+// not sent: relative paths are found from the scene's directory, which must hold the same files
+// at the same path on every worker's machine, as on a shared file system. A worker that fails or
+// sits on a tile past workerTimeout is dropped and its tile handed to another, and once no new
+// tiles are left, idle workers are given copies of tiles still out so one slow worker cannot hold
+// up the frame; whichever copy comes back first is used. workerTimeout also bounds how long a
+// worker may take to load the scene and answer Ready.
+class RenderCoordinator
+{
+  public:
+    uint32_t tileSize = 32;
+    std::chrono::milliseconds workerTimeout = std::chrono::seconds(60);
+
+    // Takes ownership of the connected worker descriptors
+    explicit RenderCoordinator(const std::vector<int>& workerDescriptors) noexcept;
+    RenderCoordinator(const RenderCoordinator&) = delete;
+    RenderCoordinator& operator=(const RenderCoordinator&) = delete;
+    ~RenderCoordinator();
+
+    // Throws if every worker has failed before the frame is finished. Relative 'file:' and
+    // 'texture:' paths in the scene are found from directory, see YamlParser.
+    [[nodiscard]] Canvas render(const std::string& scene, uint32_t frame, const std::string& directory = {});
+    // Of the scene last rendered
+    [[nodiscard]] uint32_t frameCount() const noexcept;
+    // What the workers counted for the frame last rendered, including tiles that were rendered twice
+    // or by a worker that then failed, with the most threads any one tile was rendered on. Only
+    // workers built with ENABLE_STATISTICS count anything.
+    [[nodiscard]] const RenderStatistics& statistics() const noexcept;
+    [[nodiscard]] size_t liveWorkerCount() const noexcept;
+
+  private:
+    class Worker
+    {
+      public:
+        int descriptor = -1;
+        bool ready = false;
+        std::optional<uint32_t> tile;
+        std::chrono::steady_clock::time_point dispatched; // Of its tile, or of the frame while it is not yet ready
+    };
+
+    std::vector<Worker> workers;
+    std::string sentScene;
+    std::string sentDirectory;
+    uint32_t sceneFrameCount = 1;
+    RenderStatistics frameStatistics;
+
+    void dropWorker(Worker& worker) noexcept;
+};
+
+#endif /* SRC_RENDERFARM_HPP_ */
@@ -0,0 +1,447 @@
+/*
+ * RenderService.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "RenderService.hpp"
+#include "Transformation.hpp"
+#include "YamlParser.hpp"
+
+#include <algorithm>
+#include <numbers>
+#include <optional>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+constexpr uint32_t MAXIMUM_SAMPLES = 256;
+
+FarmMessage RenderRequest::message() const
+{
+    FarmMessage request;
+    request.type = FarmMessage::Render;
+    request.append(frame);
+    request.append(width);
+    request.append(height);
+    request.append(samples);
+    request.append(uint8_t{overrideView});
+    for (const Tuple& point : {from, to, up})
+    {
+        request.append(point.x);
+        request.append(point.y);
+        request.append(point.z);
+    }
+    request.append(fieldOfView);
+    request.appendText(directory);
+    request.payload.insert(request.payload.end(), scene.begin(), scene.end());
+    return request;
+}
+
+RenderRequest RenderRequest::FromMessage(const FarmMessage& message)
+{
+    if (message.type != FarmMessage::Render)
+    {
+        throw std::runtime_error("Render service expected a render request.");
+    }
+    RenderRequest request;
+    size_t offset = 0;
+    request.frame = message.read<uint32_t>(offset);
+    request.width = message.read<uint32_t>(offset);
+    request.height = message.read<uint32_t>(offset);
+    request.samples = message.read<uint32_t>(offset);
+    request.overrideView = message.read<uint8_t>(offset) != 0;
+    for (Tuple* point : {&request.from, &request.to, &request.up})
+    {
+        point->x = message.read<float>(offset);
+        point->y = message.read<float>(offset);
+        point->z = message.read<float>(offset);
+    }
+    request.fieldOfView = message.read<float>(offset);
+    request.directory = message.readText(offset);
+    request.scene.assign(message.payload.begin() + static_cast<std::ptrdiff_t>(offset), message.payload.end());
+    return request;
+}
+
+Canvas RequestRender(const int descriptor, const RenderRequest& request, RenderStatistics* const statistics)
+{
+    SendFarmMessage(descriptor, request.message());
+
+    std::optional<Canvas> image;
+    uint32_t rowsReceived = 0;
+    while (!image || rowsReceived < image->height)
+    {
+        const std::optional<FarmMessage> message = ReceiveFarmMessage(descriptor);
+        if (!message)
+        {
+            throw std::runtime_error("Render service closed the connection before the image was finished.");
+        }
+        size_t offset = 0;
+        switch (message->type)
+        {
+        case FarmMessage::Image:
+        {
+            const auto width = message->read<uint32_t>(offset);
+            const auto height = message->read<uint32_t>(offset);
+            image.emplace(width, height);
+            break;
+        }
+        case FarmMessage::Rows:
+        {
+            const auto yBegin = message->read<uint32_t>(offset);
+            const auto yEnd = message->read<uint32_t>(offset);
+            if (!image || yBegin >= yEnd || yEnd > image->height)
+            {
+                throw std::runtime_error("Render service sent rows outside of its image.");
+            }
+            for (uint32_t y = yBegin; y < yEnd; y++)
+            {
+                for (uint32_t x = 0; x < image->width; x++)
+                {
+                    const auto red = message->read<float>(offset);
+                    const auto green = message->read<float>(offset);
+                    const auto blue = message->read<float>(offset);
+                    image->pixels[y][x] = Color(red, green, blue);
+                }
+            }
+            rowsReceived += yEnd - yBegin;
+            break;
+        }
+        case FarmMessage::Statistics:
+        {
+            const RenderStatistics counted = message->readStatistics(offset);
+            if (statistics != nullptr)
+            {
+                *statistics = counted;
+            }
+            break;
+        }
+        case FarmMessage::Failed:
+            throw std::runtime_error("Render service could not render the request: " + std::string(message->payload.begin(), message->payload.end()));
+        default:
+            throw std::runtime_error("Render service client received a message it does not handle.");
+        }
+    }
+    return std::move(*image);
+}
+
+RenderService::Connection::~Connection()
+{
+    close(descriptor);
+}
+
+RenderService::RenderService() : renderThread([this]() { renderQueue(); })
+{
+}
+
+RenderService::~RenderService()
+{
+    stop();
+    {
+        const std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+        queue.clear();
+    }
+    queueChanged.notify_all();
+    renderThread.join();
+}
+
+Canvas RenderService::render(const RenderRequest& request)
+{
+    return renderBands(request, [](const Canvas&, uint32_t, uint32_t) {});
+}
+
+void RenderService::serveConnection(const int descriptor)
+{
+    readRequests(std::make_shared<Connection>(descriptor));
+}
+
+void RenderService::readRequests(const std::shared_ptr<Connection>& connection)
+{
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(sendTimeout);
+    const timeval timeout{seconds.count(), std::chrono::duration_cast<std::chrono::microseconds>(sendTimeout - seconds).count()};
+    setsockopt(connection->descriptor, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // A client that sends something malformed only loses its own connection
+    try
+    {
+        while (const std::optional<FarmMessage> message = ReceiveFarmMessage(connection->descriptor))
+        {
+            Job job{connection, RenderRequest::FromMessage(*message)};
+            {
+                const std::lock_guard<std::mutex> lock(queueMutex);
+                queue.push_back(std::move(job));
+            }
+            queueChanged.notify_one();
+        }
+    } catch (const std::exception&)
+    {
+    }
+}
+
+void RenderService::serve(const std::string& endpoint)
+{
+    const int descriptor = OpenEndpoint(endpoint, true);
+    if (listen(descriptor, SOMAXCONN) != 0)
+    {
+        close(descriptor);
+        throw std::runtime_error("Could not listen on render service endpoint " + endpoint);
+    }
+    // Published before stopRequested is checked, so that a stop either is seen here or shuts the listener down
+    listener = descriptor;
+
+    while (!stopRequested)
+    {
+        const int accepted = accept4(descriptor, nullptr, nullptr, SOCK_CLOEXEC);
+        if (accepted < 0)
+        {
+            continue;
+        }
+        const auto connection = std::make_shared<Connection>(accepted);
+        const std::lock_guard<std::mutex> lock(clientsMutex);
+        // Clients whose connection has closed are done, so their threads are joined as others arrive
+        for (auto client = clients.begin(); client != clients.end();)
+        {
+            if (client->connection.expired())
+            {
+                client->reader.join();
+                client = clients.erase(client);
+            } else
+            {
+                ++client;
+            }
+        }
+        if (stopRequested)
+        {
+            break;
+        }
+        clients.push_back({std::thread([this, connection]() { readRequests(connection); }), connection});
+    }
+
+    listener = -1;
+    close(descriptor);
+    std::vector<Client> remaining;
+    {
+        const std::lock_guard<std::mutex> lock(clientsMutex);
+        remaining.swap(clients);
+    }
+    for (Client& client : remaining)
+    {
+        client.reader.join();
+    }
+}
+
+void RenderService::stop() noexcept
+{
+    stopRequested = true;
+    const int descriptor = listener;
+    if (descriptor >= 0)
+    {
+        shutdown(descriptor, SHUT_RDWR);
+    }
+    // Readers blocked on a client see the end of its requests; replies can still be sent
+    const std::lock_guard<std::mutex> lock(clientsMutex);
+    for (const Client& client : clients)
+    {
+        if (const std::shared_ptr<Connection> connection = client.connection.lock())
+        {
+            shutdown(connection->descriptor, SHUT_RD);
+        }
+    }
+}
+
+size_t RenderService::cachedSceneCount() const
+{
+    const std::lock_guard<std::mutex> lock(renderMutex);
+    return cache.size();
+}
+
+size_t RenderService::sceneBuildCount() const
+{
+    const std::lock_guard<std::mutex> lock(renderMutex);
+    return builds;
+}
+
+void RenderService::renderQueue()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueChanged.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        Connection& connection = *job.connection;
+        if (connection.dropped)
+        {
+            continue;
+        }
+        // A client that does not take a reply within sendTimeout is dropped, which also ends its reader
+        const auto send = [&connection](const FarmMessage& message) {
+            try
+            {
+                SendFarmMessage(connection.descriptor, message);
+            } catch (const std::exception&)
+            {
+                connection.dropped = true;
+                shutdown(connection.descriptor, SHUT_RDWR);
+                throw;
+            }
+        };
+        try
+        {
+            bool started = false;
+            (void)renderBands(job.request, [&](const Canvas& image, const uint32_t yBegin, const uint32_t yEnd) {
+                if (!started)
+                {
+                    FarmMessage header;
+                    header.type = FarmMessage::Image;
+                    header.append(image.width);
+                    header.append(image.height);
+                    send(header);
+                    started = true;
+                }
+                // Sent ahead of the last rows, as the client stops reading once it has every row
+                if (RenderStatistics::Enabled && yEnd == image.height)
+                {
+                    FarmMessage statistics;
+                    statistics.type = FarmMessage::Statistics;
+                    statistics.appendStatistics(RenderStatistics::Collect());
+                    send(statistics);
+                }
+                FarmMessage rows;
+                rows.type = FarmMessage::Rows;
+                rows.append(yBegin);
+                rows.append(yEnd);
+                for (uint32_t y = yBegin; y < yEnd; y++)
+                {
+                    for (const Color& c : image.pixels[y])
+                    {
+                        rows.append(c.r);
+                        rows.append(c.g);
+                        rows.append(c.b);
+                    }
+                }
+                send(rows);
+            });
+        } catch (const std::exception& error)
+        {
+            if (connection.dropped)
+            {
+                continue;
+            }
+            FarmMessage failed;
+            failed.type = FarmMessage::Failed;
+            const std::string reason = error.what();
+            failed.payload.assign(reason.begin(), reason.end());
+            try
+            {
+                send(failed);
+            } catch (const std::exception&)
+            {
+            }
+        }
+    }
+}
+
+Canvas RenderService::renderBands(const RenderRequest& request, const std::function<void(const Canvas& image, uint32_t yBegin, uint32_t yEnd)>& band)
+{
+    if (request.samples > MAXIMUM_SAMPLES)
+    {
+        throw std::runtime_error("Render request samples must be at most " + std::to_string(MAXIMUM_SAMPLES) + ".");
+    }
+    if ((request.width == 0) != (request.height == 0))
+    {
+        throw std::runtime_error("Render request must give both a width and a height, or neither.");
+    }
+    if (request.overrideView && !(request.fieldOfView > 0.0F && request.fieldOfView < std::numbers::pi_v<float>))
+    {
+        throw std::runtime_error("Render request field of view must be between 0 and pi.");
+    }
+
+    const std::lock_guard<std::mutex> lock(renderMutex);
+    YamlParser& parser = parsedScene(request.scene, request.directory);
+    // Images are streamed as their bands finish, before a denoiser or heatmap could see all of them
+    if (parser.worldCamera.denoise || parser.worldCamera.costMeasure != Camera::NoCost)
+    {
+        throw std::runtime_error("Render service cannot denoise or draw heatmaps; render scenes with 'denoise:' or 'heatmap:' locally.");
+    }
+    if (parser.worldSequence.animated())
+    {
+        parser.worldSequence.apply(request.frame, parser.world, parser.worldCamera);
+    }
+
+    Camera camera = parser.worldCamera;
+    if (request.width > 0)
+    {
+        camera.hSize = request.width;
+        camera.vSize = request.height;
+    }
+    if (uint64_t{camera.hSize} * camera.vSize > MAXIMUM_PIXELS)
+    {
+        throw std::runtime_error("Render request image is larger than " + std::to_string(MAXIMUM_PIXELS) + " pixels.");
+    }
+    if (request.overrideView)
+    {
+        camera.fov = request.fieldOfView;
+        camera.transform = ViewTransform(request.from, request.to, request.up);
+    }
+    if (request.samples > 0)
+    {
+        camera.samplesPerPixel = request.samples;
+        if (request.samples > 1 && camera.sampler.sequence == Sampler::PixelCenter)
+        {
+            camera.sampler.sequence = Sampler::Sobol;
+        }
+    }
+    camera.RecalculateProperties();
+    // Instances are sized by the pixels they cover in this render
+    parser.world.selectDetail(camera);
+
+    if constexpr (RenderStatistics::Enabled)
+    {
+        RenderStatistics::Reset();
+    }
+    Canvas image(camera.hSize, camera.vSize);
+    const uint32_t rows = std::max(bandHeight, 1U);
+    for (uint32_t yBegin = 0; yBegin < camera.vSize; yBegin += rows)
+    {
+        const uint32_t yEnd = std::min(yBegin + rows, camera.vSize);
+        camera.RenderTile(parser.world, 0, yBegin, camera.hSize, yEnd, image);
+        band(image, yBegin, yEnd);
+    }
+    return image;
+}
+
+YamlParser& RenderService::parsedScene(const std::string& scene, const std::string& directory)
+{
+    const size_t hash = std::hash<std::string>{}(scene) ^ std::hash<std::string>{}(directory) * 31;
+    for (auto entry = cache.begin(); entry != cache.end(); ++entry)
+    {
+        if (entry->hash == hash && entry->text == scene && entry->directory == directory)
+        {
+            cache.splice(cache.begin(), cache, entry);
+            return *cache.front().parser;
+        }
+    }
+
+    // Parsed before the cache is touched, so a scene that fails to parse evicts nothing
+    auto parser = std::make_unique<YamlParser>(scene, directory);
+    builds++;
+    cache.push_front({hash, scene, directory, std::move(parser)});
+    while (cache.size() > std::max<size_t>(cacheCapacity, 1))
+    {
+        cache.pop_back();
+    }
+    return *cache.front().parser;
+}
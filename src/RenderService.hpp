@@ -0,0 +1,161 @@
+/*
+ * RenderService.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_RENDERSERVICE_HPP_
+#define SRC_RENDERSERVICE_HPP_
+
+#include "Canvas.hpp"
+#include "RenderFarm.hpp"
+#include "Tuple.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class YamlParser;
+
+class RenderRequest
+{
+  public:
+    std::string scene;
+    // Relative 'file:' and 'texture:' paths in the scene are found from here, on the service's machine
+    std::string directory;
+    uint32_t frame = 0;
+    // Zero keeps the scene camera's size
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // Per pixel, placed by the scene camera's sampler, or by a Sobol sampler if the scene's puts
+    // every sample at the pixel centre. Zero keeps the scene camera's samples.
+    uint32_t samples = 0;
+    // Otherwise the scene camera's view is used
+    bool overrideView = false;
+    Tuple from = Point(0, 0, 0);
+    Tuple to = Point(0, 0, -1);
+    Tuple up = Vector(0, 1, 0);
+    float fieldOfView = 0.0F; // In (0, pi)
+
+    [[nodiscard]] FarmMessage message() const;
+    // Throws if the message is not a well formed Render message
+    [[nodiscard]] static RenderRequest FromMessage(const FarmMessage& message);
+};
+
+// Sends the request on a connected render service and waits for the whole image. Throws with the
+// service's reason if it could not render the request. A service built with ENABLE_STATISTICS also
+// reports what it counted for the image, which is stored in statistics if given.
+[[nodiscard]] Canvas RequestRender(int descriptor, const RenderRequest& request, RenderStatistics* statistics = nullptr);
+
+// A long running renderer that keeps the most recently used scenes parsed, with their acceleration
+// structures built, keyed by a hash of their text and directory. Requests from every connection go into one queue
+// and are rendered in arrival order, each using every core, and images are streamed back a band of
+// rows at a time as they finish.
+// Images are limited to MAXIMUM_PIXELS pixels, and scenes may not ask to be denoised or for a heatmap.
+class RenderService
+{
+  public:
+    constexpr static uint64_t MAXIMUM_PIXELS = uint64_t{1} << 26U;
+
+    size_t cacheCapacity = 4;
+    uint32_t bandHeight = 16;
+    // How long a reply may wait for a client to make room for it before the client is dropped, so
+    // that one client not reading its replies cannot hold up everyone queued behind it
+    std::chrono::milliseconds sendTimeout = std::chrono::seconds(10);
+
+    RenderService();
+    RenderService(const RenderService&) = delete;
+    RenderService& operator=(const RenderService&) = delete;
+    // Drops queued requests, closing their connections unanswered. A thread running serve must
+    // have returned first, see stop.
+    ~RenderService();
+
+    // Renders on the calling thread, bypassing the queue but still sharing the cache
+    [[nodiscard]] Canvas render(const RenderRequest& request);
+    // Queues the requests read from a connected client until it disconnects. Takes ownership of
+    // the descriptor, which is closed once every request from it has been answered.
+    void serveConnection(int descriptor);
+    // Accepts clients on endpoint, see OpenEndpoint, each on its own thread. Throws if the endpoint
+    // cannot be listened on, and otherwise returns once stop is called and every client's thread
+    // has been joined.
+    void serve(const std::string& endpoint);
+    // Has serve stop accepting clients and stop reading from the ones it has. Requests already
+    // queued are still answered.
+    void stop() noexcept;
+
+    [[nodiscard]] size_t cachedSceneCount() const;
+    // How many times a scene had to be parsed and built rather than found in the cache
+    [[nodiscard]] size_t sceneBuildCount() const;
+
+  private:
+    class CachedScene
+    {
+      public:
+        size_t hash = 0;
+        std::string text;
+        std::string directory;
+        std::unique_ptr<YamlParser> parser;
+    };
+
+    // Closes the descriptor once the reader and every queued job are done with it
+    class Connection
+    {
+      public:
+        int descriptor = -1;
+        std::atomic<bool> dropped = false; // After a reply could not be sent; its queued jobs are skipped
+
+        explicit Connection(int descriptorIn) noexcept : descriptor(descriptorIn) {}
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+        ~Connection();
+    };
+
+    class Job
+    {
+      public:
+        std::shared_ptr<Connection> connection;
+        RenderRequest request;
+    };
+
+    // A thread serve started for a client, which it joins once the connection has closed
+    class Client
+    {
+      public:
+        std::thread reader;
+        std::weak_ptr<Connection> connection;
+    };
+
+    // Most recently used first
+    std::list<CachedScene> cache;
+    size_t builds = 0;
+    mutable std::mutex renderMutex;
+
+    std::deque<Job> queue;
+    bool stopping = false;
+    std::mutex queueMutex;
+    std::condition_variable queueChanged;
+    std::thread renderThread;
+
+    std::atomic<bool> stopRequested = false;
+    std::atomic<int> listener = -1;
+    std::vector<Client> clients;
+    std::mutex clientsMutex;
+
+    void readRequests(const std::shared_ptr<Connection>& connection);
+    void renderQueue();
+    // Calls band with the finished image and each [yBegin, yEnd) as it completes
+    Canvas renderBands(const RenderRequest& request, const std::function<void(const Canvas& image, uint32_t yBegin, uint32_t yEnd)>& band);
+    YamlParser& parsedScene(const std::string& scene, const std::string& directory);
+};
+
+#endif /* SRC_RENDERSERVICE_HPP_ */
@@ -0,0 +1,260 @@
+/*
+ * Sampler.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Sampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+constexpr uint32_t BLUE_NOISE_TEXELS = BLUE_NOISE_SIZE * BLUE_NOISE_SIZE;
+constexpr float LARGEST_BELOW_ONE = 0x1.fffffep-1F;
+
+// Direction numbers of the second Sobol dimension; the first is the base 2 radical inverse
+constexpr std::array<uint32_t, 32> SOBOL_DIRECTIONS = []() {
+    std::array<uint32_t, 32> directions{};
+    directions[0] = 1U << 31U;
+    for (size_t i = 1; i < directions.size(); i++)
+    {
+        directions[i] = directions[i - 1] ^ (directions[i - 1] >> 1U);
+    }
+    return directions;
+}();
+
+constexpr std::array<uint32_t, 16> HALTON_BASES = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53};
+
+// A well mixed 32 bit hash, so that nearby pixels and dimensions get unrelated seeds
+uint32_t Mix(uint32_t value) noexcept
+{
+    value ^= value >> 16U;
+    value *= 0x7feb352dU;
+    value ^= value >> 15U;
+    value *= 0x846ca68bU;
+    value ^= value >> 16U;
+    return value;
+}
+
+uint32_t ReverseBits(uint32_t value) noexcept
+{
+    value = ((value >> 1U) & 0x55555555U) | ((value & 0x55555555U) << 1U);
+    value = ((value >> 2U) & 0x33333333U) | ((value & 0x33333333U) << 2U);
+    value = ((value >> 4U) & 0x0f0f0f0fU) | ((value & 0x0f0f0f0fU) << 4U);
+    value = ((value >> 8U) & 0x00ff00ffU) | ((value & 0x00ff00ffU) << 8U);
+    return (value >> 16U) | (value << 16U);
+}
+
+// An Owen scramble of a 32 bit fixed point fraction: each bit is flipped or not depending only on
+// the bits above it, so points that shared an interval still share one after scrambling. The hash
+// of Laine and Karras does this on bit reversed values, as Burley describes.
+uint32_t NestedUniformScramble(uint32_t value, const uint32_t seed) noexcept
+{
+    value = ReverseBits(value);
+    value ^= value * 0x3d20adeaU;
+    value += seed;
+    value *= (seed >> 16U) | 1U;
+    value ^= value * 0x05526c56U;
+    value ^= value * 0x53a22864U;
+    return ReverseBits(value);
+}
+
+uint32_t SobolSecondDimension(uint32_t index) noexcept
+{
+    uint32_t value = 0;
+    for (size_t bit = 0; index != 0; index >>= 1U, bit++)
+    {
+        if ((index & 1U) != 0)
+        {
+            value ^= SOBOL_DIRECTIONS[bit];
+        }
+    }
+    return value;
+}
+
+// A 2D Sobol point as 32 bit fractions. Its index is scrambled the same way first, which picks
+// another block of points that is just as well stratified, so the two axes and each seed differ.
+std::array<uint32_t, 2> ScrambledSobol(const uint32_t index, const uint32_t seed) noexcept
+{
+    const uint32_t shuffled = NestedUniformScramble(index, Mix(seed));
+    return {NestedUniformScramble(ReverseBits(shuffled), Mix(seed + 1)), NestedUniformScramble(SobolSecondDimension(shuffled), Mix(seed + 2))};
+}
+
+float UnitFloat(const uint32_t bits) noexcept
+{
+    return static_cast<float>(bits >> 8U) * 0x1p-24F;
+}
+
+float RadicalInverse(const uint32_t base, uint32_t index) noexcept
+{
+    const float inverseBase = 1.0F / static_cast<float>(base);
+    uint64_t reversed = 0;
+    float scale = 1.0F;
+    while (index > 0)
+    {
+        const uint32_t next = index / base;
+        reversed = reversed * base + (index - next * base);
+        scale *= inverseBase;
+        index = next;
+    }
+    return std::min(static_cast<float>(reversed) * scale, LARGEST_BELOW_ONE);
+}
+
+// Moves a point in [0, 1) along the wrapped axis, which keeps how evenly a set of points is spread
+float Shift(const float value, const float offset) noexcept
+{
+    const float shifted = value + offset;
+    return std::min(shifted >= 1.0F ? shifted - 1.0F : shifted, LARGEST_BELOW_ONE);
+}
+
+// Void and cluster (Ulichney): starting from a few texels spread as evenly as a Gaussian energy can
+// tell, texels are ranked by repeatedly taking away the most crowded one and filling the emptiest
+// gap. Energy wraps around the edges so that the mask tiles.
+std::vector<uint16_t> BuildBlueNoise()
+{
+    constexpr float sigma = 1.5F;
+    std::vector<float> kernel(BLUE_NOISE_TEXELS);
+    for (uint32_t y = 0; y < BLUE_NOISE_SIZE; y++)
+    {
+        for (uint32_t x = 0; x < BLUE_NOISE_SIZE; x++)
+        {
+            const auto dx = static_cast<float>(std::min(x, BLUE_NOISE_SIZE - x));
+            const auto dy = static_cast<float>(std::min(y, BLUE_NOISE_SIZE - y));
+            kernel[y * BLUE_NOISE_SIZE + x] = std::exp(-(dx * dx + dy * dy) / (2.0F * sigma * sigma));
+        }
+    }
+
+    std::vector<uint8_t> pattern(BLUE_NOISE_TEXELS, 0);
+    std::vector<float> energy(BLUE_NOISE_TEXELS, 0.0F);
+    const auto toggle = [&](const uint32_t texel) {
+        pattern[texel] ^= 1U;
+        const float sign = pattern[texel] != 0 ? 1.0F : -1.0F;
+        const uint32_t tx = texel % BLUE_NOISE_SIZE;
+        const uint32_t ty = texel / BLUE_NOISE_SIZE;
+        for (uint32_t y = 0; y < BLUE_NOISE_SIZE; y++)
+        {
+            const uint32_t row = (y + BLUE_NOISE_SIZE - ty) % BLUE_NOISE_SIZE * BLUE_NOISE_SIZE;
+            for (uint32_t x = 0; x < BLUE_NOISE_SIZE; x++)
+            {
+                energy[y * BLUE_NOISE_SIZE + x] += sign * kernel[row + (x + BLUE_NOISE_SIZE - tx) % BLUE_NOISE_SIZE];
+            }
+        }
+    };
+    const auto tightestCluster = [&]() {
+        uint32_t best = BLUE_NOISE_TEXELS;
+        for (uint32_t texel = 0; texel < BLUE_NOISE_TEXELS; texel++)
+        {
+            if (pattern[texel] != 0 && (best == BLUE_NOISE_TEXELS || energy[texel] > energy[best]))
+            {
+                best = texel;
+            }
+        }
+        return best;
+    };
+    const auto largestVoid = [&]() {
+        uint32_t best = BLUE_NOISE_TEXELS;
+        for (uint32_t texel = 0; texel < BLUE_NOISE_TEXELS; texel++)
+        {
+            if (pattern[texel] == 0 && (best == BLUE_NOISE_TEXELS || energy[texel] < energy[best]))
+            {
+                best = texel;
+            }
+        }
+        return best;
+    };
+
+    // A tenth of the texels at random, then moved from clusters to voids until none would move
+    std::minstd_rand generator(1);
+    uint32_t initialCount = 0;
+    while (initialCount < BLUE_NOISE_TEXELS / 10)
+    {
+        const auto texel = static_cast<uint32_t>(generator() % BLUE_NOISE_TEXELS);
+        if (pattern[texel] == 0)
+        {
+            toggle(texel);
+            initialCount++;
+        }
+    }
+    for (uint32_t moves = 0; moves < BLUE_NOISE_TEXELS; moves++)
+    {
+        const uint32_t cluster = tightestCluster();
+        toggle(cluster);
+        const uint32_t emptiest = largestVoid();
+        toggle(emptiest);
+        if (emptiest == cluster)
+        {
+            break;
+        }
+    }
+    const std::vector<uint8_t> initialPattern = pattern;
+    const std::vector<float> initialEnergy = energy;
+
+    std::vector<uint16_t> ranks(BLUE_NOISE_TEXELS);
+    for (uint32_t rank = initialCount; rank-- > 0;)
+    {
+        const uint32_t cluster = tightestCluster();
+        toggle(cluster);
+        ranks[cluster] = static_cast<uint16_t>(rank);
+    }
+    pattern = initialPattern;
+    energy = initialEnergy;
+    for (uint32_t rank = initialCount; rank < BLUE_NOISE_TEXELS; rank++)
+    {
+        const uint32_t emptiest = largestVoid();
+        toggle(emptiest);
+        ranks[emptiest] = static_cast<uint16_t>(rank);
+    }
+    return ranks;
+}
+
+uint32_t BlueNoiseRank(const uint32_t x, const uint32_t y) noexcept
+{
+    static const std::vector<uint16_t> ranks = BuildBlueNoise();
+    return ranks[(y % BLUE_NOISE_SIZE) * BLUE_NOISE_SIZE + x % BLUE_NOISE_SIZE];
+}
+
+float BlueNoiseMask(const uint32_t x, const uint32_t y) noexcept
+{
+    return (static_cast<float>(BlueNoiseRank(x, y)) + 0.5F) / static_cast<float>(BLUE_NOISE_TEXELS);
+}
+
+std::array<float, 2> Sampler::sample(const uint32_t x, const uint32_t y, const uint32_t index, const uint32_t dimension) const noexcept
+{
+    switch (sequence)
+    {
+    case Halton:
+    {
+        const uint32_t pixelSeed = Mix(x ^ Mix(y ^ Mix(seed ^ Mix(dimension))));
+        const size_t first = 2 * dimension % HALTON_BASES.size();
+        return {Shift(RadicalInverse(HALTON_BASES[first], index), UnitFloat(Mix(pixelSeed))),
+                Shift(RadicalInverse(HALTON_BASES[first + 1], index), UnitFloat(Mix(pixelSeed + 1)))};
+    }
+    case Sobol:
+    {
+        const std::array<uint32_t, 2> point = ScrambledSobol(index, Mix(x ^ Mix(y ^ Mix(seed ^ Mix(dimension)))));
+        return {UnitFloat(point[0]), UnitFloat(point[1])};
+    }
+    case BlueNoise:
+    {
+        // One scrambling for the whole image, shifted in each pixel by the mask. Each axis of each
+        // dimension reads the mask at its own offset, so none of them line up.
+        const uint32_t dimensionSeed = Mix(seed ^ Mix(dimension));
+        const std::array<uint32_t, 2> point = ScrambledSobol(index, dimensionSeed);
+        std::array<float, 2> shifted{};
+        for (uint32_t axis = 0; axis < 2; axis++)
+        {
+            const uint32_t offset = Mix(dimensionSeed + axis);
+            const uint32_t rank = BlueNoiseRank(x + (offset & 0xffffU), y + (offset >> 16U));
+            // Wrapping addition of 32 bit fractions is the shift, with the rank at its texel's centre
+            shifted[axis] = UnitFloat(point[axis] + ((rank << 20U) | (1U << 19U)));
+        }
+        return shifted;
+    }
+    case PixelCenter:
+        break;
+    }
+    return {0.5F, 0.5F};
+}
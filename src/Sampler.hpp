@@ -0,0 +1,46 @@
+/*
+ * Sampler.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_SAMPLER_HPP_
+#define SRC_SAMPLER_HPP_
+
+#include <array>
+#include <cstdint>
+
+// Texels along each side of the blue noise mask, which tiles the image
+constexpr uint32_t BLUE_NOISE_SIZE = 64;
+
+// Where within a pixel, or within any other square domain such as an area light, each of a pixel's
+// samples is taken. Low discrepancy sequences fill the square far more evenly than random points, so
+// an estimate converges with many fewer samples. Each pixel gets its own scrambling of the sequence,
+// so that neighbouring pixels do not share an error pattern that would show as structure.
+class Sampler
+{
+  public:
+    enum Sequence
+    {
+        PixelCenter, // Every sample at the centre, as a single ray per pixel has always been
+        Halton,      // Radical inverses in bases 2 and 3, shifted by a random offset per pixel
+        Sobol,       // Owen scrambled with a seed per pixel; any power of two samples is stratified
+        BlueNoise    // Sobol shifted per pixel by a blue noise mask, so what error remains is high frequency
+    };
+
+    Sequence sequence = PixelCenter;
+    uint32_t seed = 0; // Another seed gives another, independent set of samples, e.g. for each frame
+    [[nodiscard]] bool operator==(const Sampler& other) const noexcept = default;
+
+    // The index-th sample of pixel (x, y), in [0, 1) on both axes. Each dimension is a separate pair of
+    // axes, decorrelated from the others, so that the position in the pixel can use dimension 0 and
+    // later effects such as soft shadows dimensions 1 and up.
+    [[nodiscard]] std::array<float, 2> sample(uint32_t x, uint32_t y, uint32_t index, uint32_t dimension = 0) const noexcept;
+};
+
+// The blue noise mask, repeated across the plane, at (x, y). Its values are evenly spread over
+// [0, 1), each once, and placed so that nearby texels hold values far apart.
+[[nodiscard]] float BlueNoiseMask(uint32_t x, uint32_t y) noexcept;
+
+#endif /* SRC_SAMPLER_HPP_ */
@@ -6,34 +6,118 @@
  */
 
 #include "Shape.hpp"
+#include "MeshSimplification.hpp"
 #include "Ray.hpp"
+#include "Statistics.hpp"
+#include "Trace.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 Tuple Shape::normal(const Tuple& p, const Intersection& i) const noexcept
 {
-    const Matrix<4> fullTransformInverse = getFullTransform().inverse();
-    // This is technically a hack and messes with w; set it to 0 at the end;
-    Tuple worldSpaceNormal = fullTransformInverse.transpose() * objectNormal(fullTransformInverse * p, i);
-    worldSpaceNormal.w = 0.0F;
-    return worldSpaceNormal.normalize();
+    const AffineTransform fullTransform = getFullTransform();
+    return fullTransform.transformNormal(objectNormal(fullTransform.inverse() * p, i)).normalize();
 }
 
-std::vector<Intersection> Shape::intersect(const Ray& r) const noexcept
+Intersections Shape::intersect(const Ray& r) const noexcept
 {
     return objectIntersect(r.transform(transform.inverse()));
 }
 
 Color Shape::shade(const Light& light, const Tuple& position, const Tuple& eyeVector, const bool inShadow) const noexcept
 {
-    const Light objectLight = {getFullTransform().inverse() * light.position, light.intensity};
-    const Tuple objectPosition = getFullTransform().inverse() * position;
-    return material.light(objectLight, objectPosition, eyeVector, normal(position), inShadow);
+    const AffineTransform worldToObject = getFullTransform().inverse();
+    const Light objectLight = {worldToObject * light.position, light.intensity};
+    const Tuple objectPosition = worldToObject * position;
+    return material.light(objectLight, objectPosition, eyeVector, normal(position), inShadow, Footprint(), material.texture ? textureCoordinates(position) : TextureCoordinates());
 }
 
-Matrix<4> Shape::getFullTransform() const noexcept
+TextureCoordinates Shape::textureCoordinates(const Tuple& p, const Intersection& i, const Footprint& footprint) const noexcept
 {
-    return parent != nullptr ? parent->getFullTransform() * transform : transform;
+    const AffineTransform worldToObject = getFullTransform().inverse();
+    const std::array<float, 2> uv = objectTextureCoordinates(worldToObject * p, i);
+    TextureCoordinates coordinates = {uv[0], uv[1]};
+    if (footprint.dpdx == Vector(0, 0, 0) && footprint.dpdy == Vector(0, 0, 0))
+    {
+        return coordinates;
+    }
+
+    // The footprint's corners are mapped too. Across a seam u is taken the short way round, as
+    // the jump there is not the surface stretching the image.
+    const auto difference = [&](const Tuple& offset) {
+        const std::array<float, 2> moved = objectTextureCoordinates(worldToObject * (p + offset), i);
+        const float du = moved[0] - uv[0];
+        return std::array<float, 2>{textureWrapsAround() ? du - std::round(du) : du, moved[1] - uv[1]};
+    };
+    const std::array<float, 2> dx = difference(footprint.dpdx);
+    const std::array<float, 2> dy = difference(footprint.dpdy);
+    coordinates.dudx = dx[0];
+    coordinates.dvdx = dx[1];
+    coordinates.dudy = dy[0];
+    coordinates.dvdy = dy[1];
+    return coordinates;
+}
+
+static std::atomic<uint64_t> shapeEpoch = 0;
+
+uint64_t ShapeEpoch() noexcept
+{
+    return shapeEpoch.load(std::memory_order_relaxed);
+}
+
+void AdvanceShapeEpoch() noexcept
+{
+    shapeEpoch.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AccelerationBounds::record(std::vector<BoundingBox> boundsIn) noexcept
+{
+    bounds = std::move(boundsIn);
+    matchedEpoch.store(ShapeEpoch(), std::memory_order_relaxed);
+    staleEpoch.store(UINT64_MAX, std::memory_order_relaxed);
+}
+
+void AccelerationBounds::clear() noexcept
+{
+    bounds.clear();
+    matchedEpoch.store(UINT64_MAX, std::memory_order_relaxed);
+    staleEpoch.store(UINT64_MAX, std::memory_order_relaxed);
+}
+
+AffineTransform Shape::getFullTransform() const noexcept
+{
+    if (parent == nullptr)
+    {
+        return transform;
+    }
+    return parent->getFullTransform() * transform;
+}
+
+BoundingBox Shape::parentSpaceBounds() const noexcept
+{
+    return bounds().transform(transform);
+}
+
+// Roots of at^2 + bt + c in ascending order, given a non-negative discriminant. The textbook
+// (-b ± sqrt(discriminant)) / 2a cancels catastrophically for the root nearest zero, which is the one
+// a ray leaving a surface close to its tangent plane depends on, so that root is taken as c / q instead.
+static std::array<float, 2> QuadraticRoots(const float a, const float b, const float c, const float discriminant) noexcept
+{
+    const float q = -0.5F * (b + std::copysign(std::sqrt(discriminant), b));
+    if (q == 0.0F)
+    {
+        return {0.0F, 0.0F};
+    }
+    const float t0 = q / a;
+    const float t1 = c / q;
+    return {std::min(t0, t1), std::max(t0, t1)};
+}
+
+BoundingBox Sphere::bounds() const noexcept
+{
+    return {Point(-1, -1, -1), Point(1, 1, 1)};
 }
 
 // Implicitly assumes that p is on the sphere surface and is a valid point (w = 1)
@@ -42,8 +126,16 @@ Tuple Sphere::objectNormal(const Tuple& p, [[maybe_unused]] const Intersection&
     return (p - Point(0, 0, 0));
 }
 
-std::vector<Intersection> Sphere::objectIntersect(const Ray& r) const noexcept
+std::array<float, 2> Sphere::objectTextureCoordinates(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept
+{
+    const float theta = std::atan2(p.x, p.z);
+    const float phi = std::acos(std::clamp(p.y / (p - Point(0, 0, 0)).magnitude(), -1.0F, 1.0F));
+    return {0.5F - theta / (2.0F * std::numbers::pi_v<float>), 1.0F - phi / std::numbers::pi_v<float>};
+}
+
+Intersections Sphere::objectIntersect(const Ray& r) const noexcept
 {
+    CountStatistic(RenderStatistics::SphereTests);
     // const Ray ray2 = r.transform(this->transform.inverse());
     const Tuple sphereToRay = r.origin - Point(0, 0, 0);
 
@@ -51,27 +143,39 @@ std::vector<Intersection> Sphere::objectIntersect(const Ray& r) const noexcept
     const float b = 2 * r.direction.dot(sphereToRay);
     const float c = sphereToRay.dot(sphereToRay) - 1;
 
-    const float discriminant = b * b - 4 * a * c;
+    // b^2 - 4ac loses most of its digits to cancellation for rays from far away; measuring the
+    // distance from the center to the ray's closest point directly keeps them (Haines et al.,
+    // "Precision Improvements for Ray/Sphere Intersection")
+    const Tuple closest = sphereToRay - r.direction * (b / (2 * a));
+    const float discriminant = 4 * a * (1 - closest.dot(closest));
 
-    std::vector<Intersection> intersections;
+    Intersections intersections;
     if (discriminant >= 0)
     {
-        intersections.emplace_back(Intersection((-b - sqrtf(discriminant)) / (2 * a), this));
-        intersections.emplace_back(Intersection((-b + sqrtf(discriminant)) / (2 * a), this));
+        const auto [t0, t1] = QuadraticRoots(a, b, c, discriminant);
+        intersections.emplace_back(Intersection(t0, this));
+        intersections.emplace_back(Intersection(t1, this));
     }
 
     return intersections;
 }
 
+BoundingBox Plane::bounds() const noexcept
+{
+    constexpr float infinity = std::numeric_limits<float>::infinity();
+    return {Point(-infinity, 0, -infinity), Point(infinity, 0, infinity)};
+}
+
 Tuple Plane::objectNormal([[maybe_unused]] const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept
 {
     return Vector(0, 1, 0);
 }
 
-std::vector<Intersection> Plane::objectIntersect([[maybe_unused]] const Ray& r) const noexcept
+Intersections Plane::objectIntersect([[maybe_unused]] const Ray& r) const noexcept
 {
-    std::vector<Intersection> i;
-    if (std::abs(r.direction.y) > TUPLE_EPSILON)
+    CountStatistic(RenderStatistics::PlaneTests);
+    Intersections i;
+    if (std::abs(r.direction.y) > INTERSECTION_EPSILON)
     {
         const float t = -r.origin.y / r.direction.y;
         i.emplace_back(Intersection(t, this));
@@ -79,6 +183,11 @@ std::vector<Intersection> Plane::objectIntersect([[maybe_unused]] const Ray& r)
     return i;
 }
 
+BoundingBox Cube::bounds() const noexcept
+{
+    return {Point(-1, -1, -1), Point(1, 1, 1)};
+}
+
 Tuple Cube::objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept
 {
     const float maxCoord = std::max(std::max(std::abs(p.x), std::abs(p.y)), std::abs(p.z));
@@ -97,8 +206,24 @@ Tuple Cube::objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i)
     return normal;
 }
 
-std::vector<Intersection> Cube::objectIntersect(const Ray& r) const noexcept
+std::array<float, 2> Cube::objectTextureCoordinates(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept
+{
+    const float maxCoord = std::max(std::max(std::abs(p.x), std::abs(p.y)), std::abs(p.z));
+
+    if (maxCoord == std::abs(p.x))
+    {
+        return {(1.0F + (p.x > 0 ? -p.z : p.z)) / 2.0F, (p.y + 1.0F) / 2.0F};
+    }
+    if (maxCoord == std::abs(p.y))
+    {
+        return {(p.x + 1.0F) / 2.0F, (1.0F + (p.y > 0 ? -p.z : p.z)) / 2.0F};
+    }
+    return {(1.0F + (p.z > 0 ? p.x : -p.x)) / 2.0F, (p.y + 1.0F) / 2.0F};
+}
+
+Intersections Cube::objectIntersect(const Ray& r) const noexcept
 {
+    CountStatistic(RenderStatistics::CubeTests);
     float xTMin = (-1.0F - r.origin.x) / r.direction.x;
     float xTMax = (1.0F - r.origin.x) / r.direction.x;
     if (xTMin > xTMax)
@@ -123,7 +248,7 @@ std::vector<Intersection> Cube::objectIntersect(const Ray& r) const noexcept
     const float tMin = std::max(std::max(xTMin, yTMin), zTMin);
     const float tMax = std::min(std::min(xTMax, yTMax), zTMax);
 
-    std::vector<Intersection> i;
+    Intersections i;
     if (tMax > tMin)
     {
         i.emplace_back(Intersection(tMin, this));
@@ -135,15 +260,20 @@ std::vector<Intersection> Cube::objectIntersect(const Ray& r) const noexcept
 // Must have constructor definition in source file since infinity has an incomplete type
 Cylinder::Cylinder() noexcept : minimum(-std::numeric_limits<float>::infinity()), maximum(std::numeric_limits<float>::infinity()){};
 
+BoundingBox Cylinder::bounds() const noexcept
+{
+    return {Point(-1, minimum, -1), Point(1, maximum, 1)};
+}
+
 Tuple Cylinder::objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept
 {
     const float dist = p.x * p.x + p.z * p.z;
     Tuple normal;
 
-    if (dist < 1.0F && p.y >= maximum - TUPLE_EPSILON)
+    if (dist < 1.0F && p.y >= maximum - INTERSECTION_EPSILON)
     {
         normal = Vector(0, 1, 0);
-    } else if (dist < 1.0F && p.y <= minimum + TUPLE_EPSILON)
+    } else if (dist < 1.0F && p.y <= minimum + INTERSECTION_EPSILON)
     {
         normal = Vector(0, -1, 0);
     } else
@@ -154,9 +284,10 @@ Tuple Cylinder::objectNormal(const Tuple& p, [[maybe_unused]] const Intersection
     return normal;
 }
 
-std::vector<Intersection> Cylinder::objectIntersect(const Ray& r) const noexcept
+Intersections Cylinder::objectIntersect(const Ray& r) const noexcept
 {
-    std::vector<Intersection> i;
+    CountStatistic(RenderStatistics::CylinderTests);
+    Intersections i;
 
     // Calculate discriminant
     const float a = r.direction.x * r.direction.x + r.direction.z * r.direction.z;
@@ -164,10 +295,9 @@ std::vector<Intersection> Cylinder::objectIntersect(const Ray& r) const noexcept
     const float c = r.origin.x * r.origin.x + r.origin.z * r.origin.z - 1;
     const float discriminant = b * b - 4 * a * c;
 
-    if (std::abs(a) > TUPLE_EPSILON && discriminant >= 0)
+    if (std::abs(a) > INTERSECTION_EPSILON && discriminant >= 0)
     {
-        const float t0 = (-b - sqrtf(discriminant)) / (2 * a);
-        const float t1 = (-b + sqrtf(discriminant)) / (2 * a);
+        const auto [t0, t1] = QuadraticRoots(a, b, c, discriminant);
 
         const float y0 = r.origin.y + t0 * r.direction.y;
         if (y0 > minimum && y0 < maximum)
@@ -202,15 +332,21 @@ std::vector<Intersection> Cylinder::objectIntersect(const Ray& r) const noexcept
 
 Cone::Cone() noexcept : minimum(-std::numeric_limits<float>::infinity()), maximum(std::numeric_limits<float>::infinity()){};
 
+BoundingBox Cone::bounds() const noexcept
+{
+    const float radius = std::max(std::abs(minimum), std::abs(maximum));
+    return {Point(-radius, minimum, -radius), Point(radius, maximum, radius)};
+}
+
 Tuple Cone::objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept
 {
     const float dist = p.x * p.x + p.z * p.z;
     Tuple normal;
 
-    if (closed && dist < maximum * maximum && p.y >= maximum - TUPLE_EPSILON)
+    if (closed && dist < maximum * maximum && p.y >= maximum - INTERSECTION_EPSILON)
     {
         normal = Vector(0, 1, 0);
-    } else if (closed && dist < minimum * minimum && p.y <= minimum + TUPLE_EPSILON)
+    } else if (closed && dist < minimum * minimum && p.y <= minimum + INTERSECTION_EPSILON)
     {
         normal = Vector(0, -1, 0);
     } else
@@ -223,9 +359,10 @@ Tuple Cone::objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i)
     return normal;
 }
 
-std::vector<Intersection> Cone::objectIntersect(const Ray& r) const noexcept
+Intersections Cone::objectIntersect(const Ray& r) const noexcept
 {
-    std::vector<Intersection> i;
+    CountStatistic(RenderStatistics::ConeTests);
+    Intersections i;
 
     // Calculate discriminant
     const float a = r.direction.x * r.direction.x - r.direction.y * r.direction.y + r.direction.z * r.direction.z;
@@ -237,10 +374,9 @@ std::vector<Intersection> Cone::objectIntersect(const Ray& r) const noexcept
         discriminant = 0.0F;
     }
 
-    if (std::abs(a) > TUPLE_EPSILON && discriminant >= 0)
+    if (std::abs(a) > INTERSECTION_EPSILON && discriminant >= 0)
     {
-        const float t0 = (-b - sqrtf(discriminant)) / (2 * a);
-        const float t1 = (-b + sqrtf(discriminant)) / (2 * a);
+        const auto [t0, t1] = QuadraticRoots(a, b, c, discriminant);
 
         const float y0 = r.origin.y + t0 * r.direction.y;
         if (y0 > minimum && y0 < maximum)
@@ -253,7 +389,7 @@ std::vector<Intersection> Cone::objectIntersect(const Ray& r) const noexcept
         {
             i.emplace_back(Intersection(t1, this));
         }
-    } else if (std::abs(a) < TUPLE_EPSILON)
+    } else if (std::abs(a) < INTERSECTION_EPSILON)
     {
         const float t = -c / (2 * b);
         i.emplace_back(Intersection(t, this));
@@ -289,17 +425,27 @@ Triangle::Triangle(const Tuple& v1, const Tuple& v2, const Tuple& v3) noexcept
     normalVector = edges[1].cross(edges[0]).normalize();
 }
 
+BoundingBox Triangle::bounds() const noexcept
+{
+    BoundingBox box;
+    for (const Tuple& vertex : vertices)
+    {
+        box.add(vertex);
+    }
+    return box;
+}
+
 Tuple Triangle::objectNormal([[maybe_unused]] const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept
 {
     return normalVector;
 }
 
-std::vector<Intersection> Triangle::objectIntersect(const Ray& r) const noexcept
+Intersections Triangle::objectIntersect(const Ray& r) const noexcept
 {
-
+    CountStatistic(RenderStatistics::TriangleTests);
     const Tuple directionCrossE1 = r.direction.cross(edges[1]);
     const float determinant = edges[0].dot(directionCrossE1);
-    if (std::abs(determinant) < TUPLE_EPSILON)
+    if (std::abs(determinant) < INTERSECTION_EPSILON)
     {
         return {};
     }
@@ -337,17 +483,28 @@ SmoothTriangle::SmoothTriangle(const Tuple& v1, const Tuple& v2, const Tuple& v3
     edges[1] = vertices[2] - vertices[0];
 }
 
+BoundingBox SmoothTriangle::bounds() const noexcept
+{
+    BoundingBox box;
+    for (const Tuple& vertex : vertices)
+    {
+        box.add(vertex);
+    }
+    return box;
+}
+
 Tuple SmoothTriangle::objectNormal([[maybe_unused]] const Tuple& p, const Intersection& i) const noexcept
 {
     Tuple interpolatedNormal = normals[0] * (1 - i.u - i.v) + normals[1] * i.u + normals[2] * i.v;
     return interpolatedNormal;
 }
 
-std::vector<Intersection> SmoothTriangle::objectIntersect(const Ray& r) const noexcept
+Intersections SmoothTriangle::objectIntersect(const Ray& r) const noexcept
 {
+    CountStatistic(RenderStatistics::SmoothTriangleTests);
     const Tuple directionCrossE1 = r.direction.cross(edges[1]);
     const float determinant = edges[0].dot(directionCrossE1);
-    if (std::abs(determinant) < TUPLE_EPSILON)
+    if (std::abs(determinant) < INTERSECTION_EPSILON)
     {
         return {};
     }
@@ -371,6 +528,168 @@ std::vector<Intersection> SmoothTriangle::objectIntersect(const Ray& r) const no
     return {Intersection(t, this, u, v)};
 }
 
+IndexBuffer::IndexBuffer(const std::vector<uint32_t>& indices)
+{
+    if (std::all_of(indices.begin(), indices.end(), [](const uint32_t index) { return index <= std::numeric_limits<uint16_t>::max(); }))
+    {
+        narrow.assign(indices.begin(), indices.end());
+        narrow.shrink_to_fit();
+    } else
+    {
+        wide = indices;
+    }
+}
+
+TriangleMesh::TriangleMesh(std::vector<Vertex> positionsIn, std::vector<Vertex> normalsIn, const std::vector<uint32_t>& indicesIn, std::vector<TextureVertex> textureCoordinatesIn) :
+    vertexPositions(std::move(positionsIn)),
+    vertexNormals(std::move(normalsIn)),
+    vertexTextureCoordinates(std::move(textureCoordinatesIn)),
+    faceIndices(indicesIn)
+{
+    std::vector<BoundingBox> faceBounds(faceCount());
+    for (uint32_t face = 0; face < faceBounds.size(); face++)
+    {
+        for (const Tuple& corner : corners(face))
+        {
+            faceBounds[face].add(corner);
+        }
+        meshBounds.add(faceBounds[face]);
+    }
+    bvh.build(faceBounds);
+}
+
+BoundingBox TriangleMesh::bounds() const noexcept
+{
+    return meshBounds;
+}
+
+const std::vector<TriangleMesh::Vertex>& TriangleMesh::positions() const noexcept
+{
+    return vertexPositions;
+}
+
+const std::vector<TriangleMesh::Vertex>& TriangleMesh::normals() const noexcept
+{
+    return vertexNormals;
+}
+
+const std::vector<TriangleMesh::TextureVertex>& TriangleMesh::textureVertices() const noexcept
+{
+    return vertexTextureCoordinates;
+}
+
+const IndexBuffer& TriangleMesh::indices() const noexcept
+{
+    return faceIndices;
+}
+
+size_t TriangleMesh::faceCount() const noexcept
+{
+    return faceIndices.size() / 3;
+}
+
+size_t TriangleMesh::bytes() const noexcept
+{
+    return (vertexPositions.size() + vertexNormals.size()) * sizeof(Vertex) + vertexTextureCoordinates.size() * sizeof(TextureVertex) + faceIndices.size() * faceIndices.bytesPerIndex() +
+           bvh.nodes().size() * sizeof(WideBVHNode) + bvh.primitives().size() * sizeof(uint32_t);
+}
+
+std::array<Tuple, 3> TriangleMesh::corners(const uint32_t face) const noexcept
+{
+    std::array<Tuple, 3> points;
+    for (uint32_t corner = 0; corner < 3; corner++)
+    {
+        const Vertex& position = vertexPositions[faceIndices[face * 3 + corner]];
+        points[corner] = Point(position[0], position[1], position[2]);
+    }
+    return points;
+}
+
+Tuple TriangleMesh::objectNormal([[maybe_unused]] const Tuple& p, const Intersection& i) const noexcept
+{
+    if (!vertexNormals.empty())
+    {
+        Tuple interpolatedNormal = Vector(0, 0, 0);
+        const std::array<float, 3> weights = {1 - i.u - i.v, i.u, i.v};
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            const Vertex& normal = vertexNormals[faceIndices[i.face * 3 + corner]];
+            interpolatedNormal = interpolatedNormal + Vector(normal[0], normal[1], normal[2]) * weights[corner];
+        }
+        // Corners the file gave no normal for are zero, and a face with none of them is shaded flat
+        if (interpolatedNormal.magnitude() > TUPLE_EPSILON)
+        {
+            return interpolatedNormal;
+        }
+    }
+    const std::array<Tuple, 3> points = corners(i.face);
+    return (points[2] - points[0]).cross(points[1] - points[0]).normalize();
+}
+
+std::array<float, 2> TriangleMesh::objectTextureCoordinates(const Tuple& p, const Intersection& i) const noexcept
+{
+    if (vertexTextureCoordinates.empty())
+    {
+        return {p.x, p.z};
+    }
+    const std::array<Tuple, 3> points = corners(i.face);
+    const Tuple edge1 = points[1] - points[0];
+    const Tuple edge2 = points[2] - points[0];
+    const Tuple offset = p - points[0];
+    const Tuple faceNormal = edge1.cross(edge2);
+    const float area = faceNormal.dot(faceNormal);
+    const float u = area > 0.0F ? offset.cross(edge2).dot(faceNormal) / area : i.u;
+    const float v = area > 0.0F ? edge1.cross(offset).dot(faceNormal) / area : i.v;
+
+    std::array<float, 2> interpolated = {0.0F, 0.0F};
+    const std::array<float, 3> weights = {1 - u - v, u, v};
+    for (uint32_t corner = 0; corner < 3; corner++)
+    {
+        const TextureVertex& coordinates = vertexTextureCoordinates[faceIndices[i.face * 3 + corner]];
+        interpolated[0] += coordinates[0] * weights[corner];
+        interpolated[1] += coordinates[1] * weights[corner];
+    }
+    return interpolated;
+}
+
+Intersections TriangleMesh::objectIntersect(const Ray& r) const noexcept
+{
+    Intersections intersections;
+    for (const uint32_t face : bvh.candidates(r))
+    {
+        CountStatistic(vertexNormals.empty() ? RenderStatistics::TriangleTests : RenderStatistics::SmoothTriangleTests);
+        // The same test as Triangle's, with the edges found from the shared vertices
+        const std::array<Tuple, 3> points = corners(face);
+        const Tuple edge0 = points[1] - points[0];
+        const Tuple edge1 = points[2] - points[0];
+        const Tuple directionCrossE1 = r.direction.cross(edge1);
+        const float determinant = edge0.dot(directionCrossE1);
+        if (std::abs(determinant) < INTERSECTION_EPSILON)
+        {
+            continue;
+        }
+
+        const float determinantInverse = 1.0F / determinant;
+        const Tuple v0ToOrigin = r.origin - points[0];
+        const float u = determinantInverse * v0ToOrigin.dot(directionCrossE1);
+        if (u < 0.0F || u > 1.0F)
+        {
+            continue;
+        }
+
+        const Tuple originCrossE0 = v0ToOrigin.cross(edge0);
+        const float v = determinantInverse * r.direction.dot(originCrossE0);
+        if (v < 0.0F || (u + v) > 1.0F)
+        {
+            continue;
+        }
+
+        Intersection& hit = intersections.emplace_back(determinantInverse * edge1.dot(originCrossE0), this, u, v);
+        hit.face = face;
+    }
+    return intersections;
+}
+
 std::vector<std::reference_wrapper<const Shape>> Group::objects() const noexcept
 {
     std::vector<std::reference_wrapper<const Shape>> objects;
@@ -407,10 +726,18 @@ std::vector<std::reference_wrapper<const Shape>> Group::objects() const noexcept
     {
         objects.emplace_back(std::ref(smoothTriangle));
     }
+    for (const Shape& mesh : meshes)
+    {
+        objects.emplace_back(std::ref(mesh));
+    }
     for (const Shape& csg : csgs)
     {
         objects.emplace_back(std::ref(csg));
     }
+    for (const Shape& instance : instances)
+    {
+        objects.emplace_back(std::ref(instance));
+    }
 
     return objects;
 }
@@ -447,6 +774,10 @@ std::vector<std::reference_wrapper<const Shape>> Group::allSubObjects() const no
     {
         objects.emplace_back(std::ref(smoothTriangle));
     }
+    for (const Shape& mesh : meshes)
+    {
+        objects.emplace_back(std::ref(mesh));
+    }
     for (const Shape& group : groups)
     {
         const std::vector<std::reference_wrapper<const Shape>> shapeIntersections = group.allSubObjects();
@@ -457,6 +788,11 @@ std::vector<std::reference_wrapper<const Shape>> Group::allSubObjects() const no
         const std::vector<std::reference_wrapper<const Shape>> shapeIntersections = csg.allSubObjects();
         objects.insert(objects.end(), shapeIntersections.begin(), shapeIntersections.end());
     }
+    // Hits within an instance report the instance itself as their object
+    for (const Shape& instance : instances)
+    {
+        objects.emplace_back(std::ref(instance));
+    }
 
     return objects;
 }
@@ -465,6 +801,7 @@ Group& Group::addChild(const Group& c) noexcept
 {
     groups.push_back(c);
     groups.back().parent = this;
+    AdvanceShapeEpoch();
     return groups.back();
 }
 
@@ -472,6 +809,7 @@ Sphere& Group::addChild(const Sphere& c) noexcept
 {
     spheres.push_back(c);
     spheres.back().parent = this;
+    AdvanceShapeEpoch();
     return spheres.back();
 }
 
@@ -479,18 +817,21 @@ Plane& Group::addChild(const Plane& c) noexcept
 {
     planes.push_back(c);
     planes.back().parent = this;
+    AdvanceShapeEpoch();
     return planes.back();
 }
 Cube& Group::addChild(const Cube& c) noexcept
 {
     cubes.push_back(c);
     cubes.back().parent = this;
+    AdvanceShapeEpoch();
     return cubes.back();
 }
 Cylinder& Group::addChild(const Cylinder& c) noexcept
 {
     cylinders.push_back(c);
     cylinders.back().parent = this;
+    AdvanceShapeEpoch();
     return cylinders.back();
 }
 
@@ -498,6 +839,7 @@ Cone& Group::addChild(const Cone& c) noexcept
 {
     cones.push_back(c);
     cones.back().parent = this;
+    AdvanceShapeEpoch();
     return cones.back();
 }
 
@@ -505,6 +847,7 @@ Triangle& Group::addChild(const Triangle& t) noexcept
 {
     triangles.push_back(t);
     triangles.back().parent = this;
+    AdvanceShapeEpoch();
     return triangles.back();
 }
 
@@ -512,29 +855,310 @@ SmoothTriangle& Group::addChild(const SmoothTriangle& st) noexcept
 {
     smoothTriangles.push_back(st);
     smoothTriangles.back().parent = this;
+    AdvanceShapeEpoch();
     return smoothTriangles.back();
 }
 
+TriangleMesh& Group::addChild(const TriangleMesh& mesh) noexcept
+{
+    meshes.push_back(mesh);
+    meshes.back().parent = this;
+    AdvanceShapeEpoch();
+    return meshes.back();
+}
+
 CSG& Group::addChild(const CSG& csg) noexcept
 {
     csgs.push_back(csg);
     csgs.back().parent = this;
+    AdvanceShapeEpoch();
     return csgs.back();
 }
 
+Instance& Group::addChild(const Instance& instance) noexcept
+{
+    instances.push_back(instance);
+    instances.back().parent = this;
+    AdvanceShapeEpoch();
+    return instances.back();
+}
+
+BoundingBox Group::bounds() const noexcept
+{
+    BoundingBox box;
+    forEachObject([&](const Shape& shape) {
+        box.add(shape.parentSpaceBounds());
+    });
+    return box;
+}
+
+Group::Acceleration Group::getAcceleration() const noexcept
+{
+    return acceleration;
+}
+
+void Group::setAcceleration(const Acceleration accelerationIn)
+{
+    acceleration = accelerationIn;
+    buildAcceleration();
+}
+
+void Group::buildAcceleration()
+{
+    const TraceScope trace("Group::buildAcceleration");
+    for (Group& group : groups)
+    {
+        group.buildAcceleration();
+    }
+
+    grid.clear();
+    bvh.clear();
+    builtBounds.clear();
+    childTable.clear();
+    if (acceleration == Linear)
+    {
+        return;
+    }
+
+    std::vector<BoundingBox> bounds = childBounds();
+    if (acceleration == Grid)
+    {
+        grid.build(bounds);
+    } else
+    {
+        bvh.build(bounds);
+    }
+    builtBounds.record(std::move(bounds));
+    refreshChildTable();
+}
+
+const WideBoundingVolumeHierarchy& Group::getHierarchy() const noexcept
+{
+    return bvh;
+}
+
+size_t Group::faceCount() const noexcept
+{
+    size_t count = triangles.size() + smoothTriangles.size();
+    for (const TriangleMesh& mesh : meshes)
+    {
+        count += mesh.faceCount();
+    }
+    for (const Group& group : groups)
+    {
+        count += group.faceCount();
+    }
+    return count;
+}
+
+Group Group::simplified(const float faceFraction) const
+{
+    Group copy = *this;
+    copy.simplifyMeshes(faceFraction);
+    copy.buildAcceleration();
+    return copy;
+}
+
+void Group::simplifyMeshes(const float faceFraction)
+{
+    for (TriangleMesh& mesh : meshes)
+    {
+        const auto target = static_cast<size_t>(std::lround(static_cast<float>(mesh.faceCount()) * faceFraction));
+        mesh = SimplifyMesh(mesh, std::max<size_t>(target, 1));
+    }
+    for (Group& group : groups)
+    {
+        group.simplifyMeshes(faceFraction);
+    }
+    adoptChildren();
+}
+
+void Group::selectDetail(const Tuple& eye, const float pixelSize) noexcept
+{
+    for (Group& group : groups)
+    {
+        group.selectDetail(eye, pixelSize);
+    }
+    for (Instance& instance : instances)
+    {
+        instance.selectDetail(eye, pixelSize);
+    }
+}
+
+void Group::adoptChildren() noexcept
+{
+    for (auto& group : groups)
+    {
+        group.parent = this;
+    }
+    for (auto& sphere : spheres)
+    {
+        sphere.parent = this;
+    }
+    for (auto& plane : planes)
+    {
+        plane.parent = this;
+    }
+    for (auto& cube : cubes)
+    {
+        cube.parent = this;
+    }
+    for (auto& cylinder : cylinders)
+    {
+        cylinder.parent = this;
+    }
+    for (auto& cone : cones)
+    {
+        cone.parent = this;
+    }
+    for (auto& triangle : triangles)
+    {
+        triangle.parent = this;
+    }
+    for (auto& smoothTriangle : smoothTriangles)
+    {
+        smoothTriangle.parent = this;
+    }
+    for (auto& mesh : meshes)
+    {
+        mesh.parent = this;
+    }
+    for (auto& csg : csgs)
+    {
+        csg.parent = this;
+    }
+    for (auto& instance : instances)
+    {
+        instance.parent = this;
+    }
+    refreshChildTable();
+}
+
+void Group::refreshChildTable() noexcept
+{
+    childTable.clear();
+    if (!grid.built() && !bvh.built())
+    {
+        return;
+    }
+    childTable.reserve(childCount());
+    forEachObject([&](const Shape& shape) {
+        childTable.push_back(&shape);
+    });
+}
+
+size_t Group::childCount() const noexcept
+{
+    return groups.size() + spheres.size() + planes.size() + cubes.size() + cylinders.size() + cones.size() +
+           triangles.size() + smoothTriangles.size() + meshes.size() + csgs.size() + instances.size();
+}
+
+std::vector<BoundingBox> Group::childBounds() const noexcept
+{
+    std::vector<BoundingBox> bounds;
+    bounds.reserve(childCount());
+    forEachObject([&](const Shape& shape) {
+        bounds.push_back(shape.parentSpaceBounds());
+    });
+    return bounds;
+}
+
 Tuple Group::objectNormal([[maybe_unused]] const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept
 {
     return Vector(0, 0, 0); // this should never be called, so return a clearly invalid vector
 }
 
-std::vector<Intersection> Group::objectIntersect(const Ray& r) const noexcept
+Intersections Group::objectIntersect(const Ray& r) const noexcept
 {
-    std::vector<Intersection> intersections;
-
-    for (const std::reference_wrapper<const Shape> shape : objects())
+    CountStatistic(RenderStatistics::GroupTests);
+    Intersections intersections;
+
+    // Children added or moved since the last build are not where the acceleration structure has
+    // them, so it can only be trusted while the children and their bounds still match
+    const bool useGrid = acceleration == Grid && grid.built();
+    const bool useHierarchy = acceleration == BVH && bvh.built();
+    if ((useGrid || useHierarchy) && childTable.size() == childCount() && builtBounds.matches([&]() { return childBounds(); }))
     {
-        const std::vector<Intersection> shapeIntersections = shape.get().intersect(r);
+        for (const uint32_t index : useGrid ? grid.candidates(r) : bvh.candidates(r))
+        {
+            const Intersections shapeIntersections = childTable[index]->intersect(r);
+            intersections.insert(intersections.end(), shapeIntersections.begin(), shapeIntersections.end());
+        }
+        return intersections;
+    }
+
+    forEachObject([&](const Shape& shape) {
+        const Intersections shapeIntersections = shape.intersect(r);
         intersections.insert(intersections.end(), shapeIntersections.begin(), shapeIntersections.end());
+    });
+    return intersections;
+}
+
+BoundingBox Instance::bounds() const noexcept
+{
+    return geometry->parentSpaceBounds();
+}
+
+Tuple Instance::objectNormal(const Tuple& p, const Intersection& i) const noexcept
+{
+    if (i.primitive == nullptr)
+    {
+        return Vector(0, 0, 0); // Only a hit within the geometry has a normal
+    }
+    // The primitive's parents end at the geometry's root, so its normal comes out in this instance's object space
+    return i.primitive->normal(p, i);
+}
+
+std::array<float, 2> Instance::objectTextureCoordinates(const Tuple& p, const Intersection& i) const noexcept
+{
+    if (i.primitive == nullptr)
+    {
+        return {p.x, p.z};
+    }
+    const TextureCoordinates coordinates = i.primitive->textureCoordinates(p, i);
+    return {coordinates.u, coordinates.v};
+}
+
+void Instance::selectDetail(const Tuple& eye, const float pixelSize) noexcept
+{
+    detailLevel = 0;
+    const BoundingBox box = bounds().transform(getFullTransform());
+    if (detailLevels.empty() || !box.bounded() || !(pixelSize > 0.0F))
+    {
+        return;
+    }
+    const float radius = (box.maximum - box.minimum).magnitude() / 2.0F;
+    const float distance = (box.centroid() - eye).magnitude();
+    if (distance <= radius)
+    {
+        return; // The eye is within the instance, which may then fill the screen
+    }
+    // Pixels covered by the instance's bounding sphere, taking its projected radius as radius / distance
+    const float projectedRadius = radius / distance / pixelSize;
+    const float coveredPixels = std::numbers::pi_v<float> * projectedRadius * projectedRadius;
+    while (detailLevel < detailLevels.size() && static_cast<float>(detailLevels[detailLevel]->faceCount()) >= coveredPixels)
+    {
+        detailLevel++;
+    }
+}
+
+size_t Instance::getDetailLevel() const noexcept
+{
+    return detailLevel;
+}
+
+const Group& Instance::detail() const noexcept
+{
+    return detailLevel == 0 || detailLevel > detailLevels.size() ? *geometry : *detailLevels[detailLevel - 1];
+}
+
+Intersections Instance::objectIntersect(const Ray& r) const noexcept
+{
+    Intersections intersections = detail().intersect(r);
+    for (Intersection& intersection : intersections)
+    {
+        intersection.primitive = intersection.object;
+        intersection.object = this;
     }
     return intersections;
 }
@@ -547,13 +1171,21 @@ std::vector<std::reference_wrapper<const Shape>> CSG::allSubObjects() const noex
     return leftObjects;
 }
 
+BoundingBox CSG::bounds() const noexcept
+{
+    BoundingBox box = left->parentSpaceBounds();
+    box.add(right->parentSpaceBounds());
+    return box;
+}
+
 Tuple CSG::objectNormal([[maybe_unused]] const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept
 {
     return {0, 0, 0, 0};
 }
 
-std::vector<Intersection> CSG::objectIntersect(const Ray& r) const noexcept
+Intersections CSG::objectIntersect(const Ray& r) const noexcept
 {
+    CountStatistic(RenderStatistics::CSGTests);
     auto leftIntersections = left->intersect(r);
     auto rightIntersections = right->intersect(r);
     leftIntersections.insert(leftIntersections.end(), rightIntersections.begin(), rightIntersections.end());
@@ -578,15 +1210,15 @@ bool CSG::intersectionAllowed(int operation, bool lhit, bool inl, bool inr)
     return allowed;
 }
 
-std::vector<Intersection> CSG::filterIntersections(const std::vector<Intersection>& intersections) const noexcept
+Intersections CSG::filterIntersections(std::span<const Intersection> intersections) const noexcept
 {
     bool inl = false;
     bool inr = false;
-    std::vector<Intersection> filteredIntersections;
+    Intersections filteredIntersections;
+    const auto leftSubObjects = left->allSubObjects();
 
     for (const auto& intersection : intersections)
     {
-        auto leftSubObjects = left->allSubObjects();
         const bool lhit = any_of(leftSubObjects.cbegin(), leftSubObjects.cend(), [&](std::reference_wrapper<const Shape> s) { return s.get() == *intersection.object; });
 
         if (intersectionAllowed(operation, lhit, inl, inr))
@@ -8,14 +8,27 @@
 #ifndef SRC_SHAPE_HPP_
 #define SRC_SHAPE_HPP_
 
+#include "AffineTransform.hpp"
+#include "Arena.hpp"
+#include "BoundingBox.hpp"
 #include "Material.hpp"
-#include "Matrix.hpp"
+#include "UniformGrid.hpp"
+#include "WideBoundingVolumeHierarchy.hpp"
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <numbers>
+#include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
+// How close to zero a determinant or ray direction component may get, and how far past a cap a hit
+// may land, before the intersection tests treat the ray as parallel or the hit as on the cap
+constexpr float INTERSECTION_EPSILON = 0.002F;
+
 class Ray;
 class Shape;
 
@@ -25,9 +38,12 @@ class Intersection
     // The actual fields must not be const or we can't sort a vector of hits based on intersection parameter 't'
     // However, object is fine because the pointer isn't const, the object it points to is const.
     float t;
+    uint32_t face = 0; // Of a TriangleMesh, the face hit
     const Shape* object;
     float u;
     float v;
+    // The shape actually hit when object is an Instance, whose shared geometry it belongs to
+    const Shape* primitive = nullptr;
 
     Intersection(float tIn, const Shape* objectIn) noexcept : t(tIn), object(objectIn), u(0.0F), v(0.0F){};
     Intersection(float tIn, const Shape* objectIn, float uIn, float vIn) noexcept : t(tIn), object(objectIn), u(uIn), v(vIn){};
@@ -35,14 +51,115 @@ class Intersection
     bool operator<(const Intersection& other) const noexcept { return t < other.t; }
 };
 
+// Intersection lists are produced for every ray, so they live in the per-thread render arena
+using Intersections = ArenaVector<Intersection>;
+
+// Counts the changes to shapes that can move their bounds, which are assigning a transform and adding
+// a child to a group. Acceleration structures check whether the last change moved their primitives.
+[[nodiscard]] uint64_t ShapeEpoch() noexcept;
+void AdvanceShapeEpoch() noexcept;
+
+// A shape's transform: the AffineTransform it holds, except that assigning it advances the shape epoch
+class ShapeTransform : public AffineTransform
+{
+  public:
+    ShapeTransform() noexcept = default;
+    ShapeTransform(const AffineTransform& transformIn) noexcept : AffineTransform(transformIn) {}
+    ShapeTransform(const ShapeTransform&) noexcept = default;
+    ShapeTransform(ShapeTransform&&) noexcept = default;
+    ~ShapeTransform() noexcept = default;
+    ShapeTransform& operator=(const ShapeTransform& other) noexcept
+    {
+        AffineTransform::operator=(other);
+        AdvanceShapeEpoch();
+        return *this;
+    }
+    ShapeTransform& operator=(ShapeTransform&& other) noexcept
+    {
+        AffineTransform::operator=(other);
+        AdvanceShapeEpoch();
+        return *this;
+    }
+    ShapeTransform& operator=(const AffineTransform& other) noexcept
+    {
+        AffineTransform::operator=(other);
+        AdvanceShapeEpoch();
+        return *this;
+    }
+};
+
+// The bounds an acceleration structure was built over, which tell whether it still fits its
+// primitives. They are compared again only once the shape epoch has moved on from when they last
+// matched, or last failed to, so while nothing changes a check costs two loads either way.
+class AccelerationBounds
+{
+  public:
+    AccelerationBounds() noexcept = default;
+    AccelerationBounds(const AccelerationBounds& other) : bounds(other.bounds),
+                                                          matchedEpoch(other.matchedEpoch.load(std::memory_order_relaxed)),
+                                                          staleEpoch(other.staleEpoch.load(std::memory_order_relaxed))
+    {
+    }
+    AccelerationBounds(AccelerationBounds&& other) noexcept : bounds(std::move(other.bounds)),
+                                                              matchedEpoch(other.matchedEpoch.load(std::memory_order_relaxed)),
+                                                              staleEpoch(other.staleEpoch.load(std::memory_order_relaxed))
+    {
+    }
+    ~AccelerationBounds() noexcept = default;
+    AccelerationBounds& operator=(const AccelerationBounds& other)
+    {
+        bounds = other.bounds;
+        matchedEpoch.store(other.matchedEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        staleEpoch.store(other.staleEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+    AccelerationBounds& operator=(AccelerationBounds&& other) noexcept
+    {
+        bounds = std::move(other.bounds);
+        matchedEpoch.store(other.matchedEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        staleEpoch.store(other.staleEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    void record(std::vector<BoundingBox> boundsIn) noexcept;
+    void clear() noexcept;
+    // Whether the bounds currentBounds() returns are still the recorded ones. It is only called when
+    // a shape may have changed since they last were.
+    template <typename F>
+    [[nodiscard]] bool matches(F&& currentBounds) const
+    {
+        const uint64_t epoch = ShapeEpoch();
+        if (matchedEpoch.load(std::memory_order_relaxed) == epoch)
+        {
+            return true;
+        }
+        if (staleEpoch.load(std::memory_order_relaxed) == epoch)
+        {
+            return false;
+        }
+        if (currentBounds() != bounds)
+        {
+            staleEpoch.store(epoch, std::memory_order_relaxed);
+            return false;
+        }
+        matchedEpoch.store(epoch, std::memory_order_relaxed);
+        return true;
+    }
+
+  private:
+    std::vector<BoundingBox> bounds;
+    mutable std::atomic<uint64_t> matchedEpoch = UINT64_MAX; // No epoch; nothing recorded yet
+    mutable std::atomic<uint64_t> staleEpoch = UINT64_MAX;   // Of the last failed comparison, until record or clear
+};
+
 class Shape
 {
   public:
-    Matrix<4> transform;
+    ShapeTransform transform;
     Material material;
     Shape* parent = nullptr;
 
-    Shape() noexcept : transform(IdentityMatrix()){};
+    Shape() noexcept = default;
     virtual ~Shape() noexcept = default;
     Shape(const Shape&) noexcept = default;
     Shape(Shape&&) noexcept = default;
@@ -52,15 +169,29 @@ class Shape
     bool operator==(const Shape& other) const noexcept { return transform == other.transform && material == other.material && parent == other.parent; }
 
     [[nodiscard]] Tuple normal(const Tuple& p, const Intersection& i = Intersection(0.0F, nullptr)) const noexcept;
-    [[nodiscard]] std::vector<Intersection> intersect(const Ray& r) const noexcept;
+    [[nodiscard]] Intersections intersect(const Ray& r) const noexcept;
     [[nodiscard]] Color shade(const Light& light, const Tuple& position, const Tuple& eyeVector, bool inShadow) const noexcept;
+    // Where the world space point p falls on an image texture, and how far that moves across the
+    // pixel footprint around p
+    [[nodiscard]] TextureCoordinates textureCoordinates(const Tuple& p, const Intersection& i = Intersection(0.0F, nullptr), const Footprint& footprint = Footprint()) const noexcept;
     [[nodiscard]] virtual std::vector<std::reference_wrapper<const Shape>> allSubObjects() const noexcept { return {std::ref(*this)}; };
     [[nodiscard]] virtual std::unique_ptr<Shape> clone() const noexcept = 0;
+    // Bounds in object space, before this shape's own transform is applied
+    [[nodiscard]] virtual BoundingBox bounds() const noexcept = 0;
+    // Bounds in the space of the parent group (or the world), after this shape's transform
+    [[nodiscard]] BoundingBox parentSpaceBounds() const noexcept;
+
+  protected:
+    [[nodiscard]] AffineTransform getFullTransform() const noexcept;
 
   private:
     [[nodiscard]] virtual Tuple objectNormal([[maybe_unused]] const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept = 0;
-    [[nodiscard]] virtual std::vector<Intersection> objectIntersect([[maybe_unused]] const Ray& r) const noexcept = 0;
-    [[nodiscard]] Matrix<4> getFullTransform() const noexcept;
+    [[nodiscard]] virtual Intersections objectIntersect([[maybe_unused]] const Ray& r) const noexcept = 0;
+    // u and v at an object space point. Shapes without a mapping of their own project x and z, so
+    // the image lies flat on a plane, repeating every unit.
+    [[nodiscard]] virtual std::array<float, 2> objectTextureCoordinates(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept { return {p.x, p.z}; }
+    // Whether u runs from 0 around to 1 and meets itself at a seam, across which it jumps by 1
+    [[nodiscard]] virtual bool textureWrapsAround() const noexcept { return false; }
 };
 
 class Sphere : public Shape
@@ -70,10 +201,14 @@ class Sphere : public Shape
     {
         return std::make_unique<Sphere>(*this);
     }
+    [[nodiscard]] BoundingBox bounds() const noexcept override;
 
   private:
     [[nodiscard]] Tuple objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept override;
-    [[nodiscard]] std::vector<Intersection> objectIntersect(const Ray& r) const noexcept override;
+    [[nodiscard]] Intersections objectIntersect(const Ray& r) const noexcept override;
+    // Longitude and latitude, with the image's left and right edges meeting behind the sphere at -z
+    [[nodiscard]] std::array<float, 2> objectTextureCoordinates(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept override;
+    [[nodiscard]] bool textureWrapsAround() const noexcept override { return true; }
 };
 
 class Plane : public Shape
@@ -83,10 +218,11 @@ class Plane : public Shape
     {
         return std::make_unique<Plane>(*this);
     }
+    [[nodiscard]] BoundingBox bounds() const noexcept override;
 
   private:
     [[nodiscard]] Tuple objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept override;
-    [[nodiscard]] std::vector<Intersection> objectIntersect(const Ray& r) const noexcept override;
+    [[nodiscard]] Intersections objectIntersect(const Ray& r) const noexcept override;
 };
 
 class Cube : public Shape
@@ -96,10 +232,13 @@ class Cube : public Shape
     {
         return std::make_unique<Cube>(*this);
     }
+    [[nodiscard]] BoundingBox bounds() const noexcept override;
 
   private:
     [[nodiscard]] Tuple objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept override;
-    [[nodiscard]] std::vector<Intersection> objectIntersect(const Ray& r) const noexcept override;
+    [[nodiscard]] Intersections objectIntersect(const Ray& r) const noexcept override;
+    // The whole image on each face, upright on the sides and seen from outside
+    [[nodiscard]] std::array<float, 2> objectTextureCoordinates(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept override;
 };
 
 class Cylinder : public Shape
@@ -109,6 +248,7 @@ class Cylinder : public Shape
     {
         return std::make_unique<Cylinder>(*this);
     }
+    [[nodiscard]] BoundingBox bounds() const noexcept override;
 
     float minimum;
     float maximum;
@@ -118,7 +258,7 @@ class Cylinder : public Shape
 
   private:
     [[nodiscard]] Tuple objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept override;
-    [[nodiscard]] std::vector<Intersection> objectIntersect(const Ray& r) const noexcept override;
+    [[nodiscard]] Intersections objectIntersect(const Ray& r) const noexcept override;
 };
 
 class Cone : public Shape
@@ -128,6 +268,7 @@ class Cone : public Shape
     {
         return std::make_unique<Cone>(*this);
     }
+    [[nodiscard]] BoundingBox bounds() const noexcept override;
 
     float minimum;
     float maximum;
@@ -137,7 +278,7 @@ class Cone : public Shape
 
   private:
     [[nodiscard]] Tuple objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept override;
-    [[nodiscard]] std::vector<Intersection> objectIntersect(const Ray& r) const noexcept override;
+    [[nodiscard]] Intersections objectIntersect(const Ray& r) const noexcept override;
 };
 
 class Triangle : public Shape
@@ -150,13 +291,14 @@ class Triangle : public Shape
     {
         return std::make_unique<Triangle>(*this);
     }
+    [[nodiscard]] BoundingBox bounds() const noexcept override;
 
   private:
     std::array<Tuple, 2> edges;
     Tuple normalVector;
 
     [[nodiscard]] Tuple objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept override;
-    [[nodiscard]] std::vector<Intersection> objectIntersect(const Ray& r) const noexcept override;
+    [[nodiscard]] Intersections objectIntersect(const Ray& r) const noexcept override;
 };
 
 class SmoothTriangle : public Shape
@@ -170,12 +312,13 @@ class SmoothTriangle : public Shape
     {
         return std::make_unique<SmoothTriangle>(*this);
     }
+    [[nodiscard]] BoundingBox bounds() const noexcept override;
 
   private:
     std::array<Tuple, 2> edges;
 
     [[nodiscard]] Tuple objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept override;
-    [[nodiscard]] std::vector<Intersection> objectIntersect(const Ray& r) const noexcept override;
+    [[nodiscard]] Intersections objectIntersect(const Ray& r) const noexcept override;
 };
 
 class CSG : public Shape
@@ -220,13 +363,14 @@ class CSG : public Shape
     }
 
     static bool intersectionAllowed(int operation, bool lhit, bool inl, bool inr);
-    [[nodiscard]] std::vector<Intersection> filterIntersections(const std::vector<Intersection>& intersections) const noexcept;
+    [[nodiscard]] Intersections filterIntersections(std::span<const Intersection> intersections) const noexcept;
     [[nodiscard]] std::vector<std::reference_wrapper<const Shape>> allSubObjects() const noexcept override;
     [[nodiscard]] std::unique_ptr<Shape> clone() const noexcept override
     {
         std::unique_ptr<CSG> newShape = std::make_unique<CSG>(*this);
         return newShape;
     }
+    [[nodiscard]] BoundingBox bounds() const noexcept override;
 
     enum Operation
     {
@@ -237,12 +381,113 @@ class CSG : public Shape
 
   private:
     [[nodiscard]] Tuple objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept override;
-    [[nodiscard]] std::vector<Intersection> objectIntersect(const Ray& r) const noexcept override;
+    [[nodiscard]] Intersections objectIntersect(const Ray& r) const noexcept override;
+};
+
+// Triangle corner indices, stored in 16 bits each when every index fits
+class IndexBuffer
+{
+  public:
+    IndexBuffer() noexcept = default;
+    explicit IndexBuffer(const std::vector<uint32_t>& indices);
+
+    [[nodiscard]] uint32_t operator[](size_t i) const noexcept { return narrow.empty() ? wide[i] : narrow[i]; }
+    [[nodiscard]] size_t size() const noexcept { return narrow.empty() ? wide.size() : narrow.size(); }
+    [[nodiscard]] size_t bytesPerIndex() const noexcept { return narrow.empty() ? sizeof(uint32_t) : sizeof(uint16_t); }
+
+  private:
+    std::vector<uint16_t> narrow;
+    std::vector<uint32_t> wide;
+};
+
+// Faces that share one buffer of vertices and refer to them by index, in place of a Triangle or
+// SmoothTriangle per face, which would each carry their own copies of every corner. Faces are
+// found through a hierarchy built with the mesh, so its data cannot change afterwards.
+class TriangleMesh : public Shape
+{
+  public:
+    using Vertex = std::array<float, 3>;
+    using TextureVertex = std::array<float, 2>;
+
+    // normals are per vertex, or empty to shade every face flat, and so are texture coordinates, or
+    // empty to map textures as for a plane. Every three indices make a face.
+    TriangleMesh(std::vector<Vertex> positionsIn, std::vector<Vertex> normalsIn, const std::vector<uint32_t>& indicesIn, std::vector<TextureVertex> textureCoordinatesIn = {});
+    [[nodiscard]] std::unique_ptr<Shape> clone() const noexcept override
+    {
+        return std::make_unique<TriangleMesh>(*this);
+    }
+    [[nodiscard]] BoundingBox bounds() const noexcept override;
+    [[nodiscard]] const std::vector<Vertex>& positions() const noexcept;
+    [[nodiscard]] const std::vector<Vertex>& normals() const noexcept;
+    [[nodiscard]] const std::vector<TextureVertex>& textureVertices() const noexcept;
+    [[nodiscard]] const IndexBuffer& indices() const noexcept;
+    [[nodiscard]] size_t faceCount() const noexcept;
+    // Of the vertices, indices and hierarchy
+    [[nodiscard]] size_t bytes() const noexcept;
+
+  private:
+    std::vector<Vertex> vertexPositions;
+    std::vector<Vertex> vertexNormals;
+    std::vector<TextureVertex> vertexTextureCoordinates;
+    IndexBuffer faceIndices;
+    BoundingBox meshBounds;
+    WideBoundingVolumeHierarchy bvh;
+
+    [[nodiscard]] std::array<Tuple, 3> corners(uint32_t face) const noexcept;
+    [[nodiscard]] Tuple objectNormal(const Tuple& p, const Intersection& i) const noexcept override;
+    [[nodiscard]] Intersections objectIntersect(const Ray& r) const noexcept override;
+    // Interpolated across the face hit by p's own barycentric coordinates, rather than the hit's,
+    // so points around the hit can be mapped too
+    [[nodiscard]] std::array<float, 2> objectTextureCoordinates(const Tuple& p, const Intersection& i) const noexcept override;
+};
+
+class Group;
+
+// Places a group that other instances may share, such as a parsed OBJ file, with its own transform
+// and material. The geometry is never copied, so each placement costs no more than the instance.
+// Intersections report the instance as their object and the shape hit within it as their primitive.
+// Geometry must not itself contain instances.
+class Instance : public Shape
+{
+  public:
+    std::shared_ptr<const Group> geometry;
+    // Coarser versions of geometry, each with fewer faces than the one before, for selectDetail to
+    // swap in when the instance is small on screen. They must fit within geometry's bounds.
+    std::vector<std::shared_ptr<const Group>> detailLevels;
+
+    explicit Instance(std::shared_ptr<const Group> geometryIn) noexcept : geometry(std::move(geometryIn)){};
+    [[nodiscard]] std::unique_ptr<Shape> clone() const noexcept override
+    {
+        return std::make_unique<Instance>(*this);
+    }
+    [[nodiscard]] BoundingBox bounds() const noexcept override;
+    // Picks the coarsest detail level that still has a face for every pixel the instance covers,
+    // seen from eye by a camera whose pixels are pixelSize wide at distance 1. Every ray then sees
+    // that level, so shadows and reflections agree with what the camera sees.
+    void selectDetail(const Tuple& eye, float pixelSize) noexcept;
+    // 0 for geometry itself, otherwise the index in detailLevels plus one
+    [[nodiscard]] size_t getDetailLevel() const noexcept;
+
+  private:
+    size_t detailLevel = 0;
+
+    [[nodiscard]] const Group& detail() const noexcept;
+    [[nodiscard]] Tuple objectNormal(const Tuple& p, const Intersection& i) const noexcept override;
+    [[nodiscard]] Intersections objectIntersect(const Ray& r) const noexcept override;
+    [[nodiscard]] std::array<float, 2> objectTextureCoordinates(const Tuple& p, const Intersection& i) const noexcept override;
 };
 
 class Group : public Shape
 {
   public:
+    // How objectIntersect finds the children a ray might hit
+    enum Acceleration
+    {
+        Linear, // Test every child
+        Grid,   // Uniform grid over the children's bounds
+        BVH     // Binned SAH bounding volume hierarchy over the children's bounds, collapsed to four wide nodes
+    };
+
     Group() = default;
     Group(const Group& other) noexcept : Shape(other),
                                          groups(other.groups),
@@ -253,55 +498,43 @@ class Group : public Shape
                                          cones(other.cones),
                                          triangles(other.triangles),
                                          smoothTriangles(other.smoothTriangles),
-                                         csgs(other.csgs)
+                                         meshes(other.meshes),
+                                         csgs(other.csgs),
+                                         instances(other.instances),
+                                         acceleration(other.acceleration),
+                                         grid(other.grid),
+                                         bvh(other.bvh),
+                                         builtBounds(other.builtBounds)
     {
-        for (auto& group : groups)
-        {
-            group.parent = this;
-        }
-        for (auto& sphere : spheres)
-        {
-            sphere.parent = this;
-        }
-        for (auto& plane : planes)
-        {
-            plane.parent = this;
-        }
-        for (auto& cube : cubes)
-        {
-            cube.parent = this;
-        }
-        for (auto& cylinder : cylinders)
-        {
-            cylinder.parent = this;
-        }
-        for (auto& cone : cones)
-        {
-            cone.parent = this;
-        }
-        for (auto& triangle : triangles)
-        {
-            triangle.parent = this;
-        }
-        for (auto& smoothTriangle : smoothTriangles)
-        {
-            smoothTriangle.parent = this;
-        }
-        for (auto& csg : csgs)
-        {
-            csg.parent = this;
-        }
+        adoptChildren();
+    };
+    // Children point back at their group, so they are handed over rather than left pointing at other
+    Group(Group&& other) noexcept : Shape(std::move(other)),
+                                    groups(std::move(other.groups)),
+                                    spheres(std::move(other.spheres)),
+                                    planes(std::move(other.planes)),
+                                    cubes(std::move(other.cubes)),
+                                    cylinders(std::move(other.cylinders)),
+                                    cones(std::move(other.cones)),
+                                    triangles(std::move(other.triangles)),
+                                    smoothTriangles(std::move(other.smoothTriangles)),
+                                    meshes(std::move(other.meshes)),
+                                    csgs(std::move(other.csgs)),
+                                    instances(std::move(other.instances)),
+                                    acceleration(other.acceleration),
+                                    grid(std::move(other.grid)),
+                                    bvh(std::move(other.bvh)),
+                                    builtBounds(std::move(other.builtBounds))
+    {
+        adoptChildren();
     };
-    Group(Group&&) noexcept = default;
     Group& operator=(const Group& other) noexcept
     {
         if (this == &other)
         {
             return *this;
         }
-        transform = other.transform;
-        material = other.material;
-        parent = other.parent;
+        Shape::operator=(other);
         groups = other.groups;
         spheres = other.spheres;
         planes = other.planes;
@@ -310,47 +543,41 @@ class Group : public Shape
         cones = other.cones;
         triangles = other.triangles;
         smoothTriangles = other.smoothTriangles;
+        meshes = other.meshes;
         csgs = other.csgs;
-
-        for (auto& group : groups)
-        {
-            group.parent = this;
-        }
-        for (auto& sphere : spheres)
-        {
-            sphere.parent = this;
-        }
-        for (auto& plane : planes)
-        {
-            plane.parent = this;
-        }
-        for (auto& cube : cubes)
-        {
-            cube.parent = this;
-        }
-        for (auto& cylinder : cylinders)
-        {
-            cylinder.parent = this;
-        }
-        for (auto& cone : cones)
-        {
-            cone.parent = this;
-        }
-        for (auto& triangle : triangles)
-        {
-            triangle.parent = this;
-        }
-        for (auto& smoothTriangle : smoothTriangles)
-        {
-            smoothTriangle.parent = this;
-        }
-        for (auto& csg : csgs)
+        instances = other.instances;
+        acceleration = other.acceleration;
+        grid = other.grid;
+        bvh = other.bvh;
+        builtBounds = other.builtBounds;
+        adoptChildren();
+        return *this;
+    };
+    Group& operator=(Group&& other) noexcept
+    {
+        if (this == &other)
         {
-            csg.parent = this;
+            return *this;
         }
+        Shape::operator=(std::move(other));
+        groups = std::move(other.groups);
+        spheres = std::move(other.spheres);
+        planes = std::move(other.planes);
+        cubes = std::move(other.cubes);
+        cylinders = std::move(other.cylinders);
+        cones = std::move(other.cones);
+        triangles = std::move(other.triangles);
+        smoothTriangles = std::move(other.smoothTriangles);
+        meshes = std::move(other.meshes);
+        csgs = std::move(other.csgs);
+        instances = std::move(other.instances);
+        acceleration = other.acceleration;
+        grid = std::move(other.grid);
+        bvh = std::move(other.bvh);
+        builtBounds = std::move(other.builtBounds);
+        adoptChildren();
         return *this;
     };
-    Group& operator=(Group&&) noexcept = default;
     ~Group() noexcept override = default;
     [[nodiscard]] std::vector<std::reference_wrapper<const Shape>> objects() const noexcept;
     [[nodiscard]] std::vector<std::reference_wrapper<const Shape>> allSubObjects() const noexcept override;
@@ -358,6 +585,28 @@ class Group : public Shape
     {
         return std::make_unique<Group>(*this);
     }
+    [[nodiscard]] BoundingBox bounds() const noexcept override;
+    [[nodiscard]] Acceleration getAcceleration() const noexcept;
+    // Selects the acceleration structure and builds it over the current children
+    void setAcceleration(Acceleration accelerationIn);
+    // Rebuilds this group's acceleration structure, and those of any child groups, from the
+    // current children. Needed after children are added or moved; until then a group whose
+    // structure is out of date falls back to testing every child.
+    void buildAcceleration();
+    // Build statistics are only meaningful while the acceleration is BVH
+    [[nodiscard]] const WideBoundingVolumeHierarchy& getHierarchy() const noexcept;
+    // Triangles of every kind, counting each face of a mesh, in this group and its child groups
+    [[nodiscard]] size_t faceCount() const noexcept;
+    // A copy with each mesh, here and in child groups, simplified to faceFraction of its faces
+    [[nodiscard]] Group simplified(float faceFraction) const;
+    // Has every instance here and in child groups select its detail level, as Instance::selectDetail
+    void selectDetail(const Tuple& eye, float pixelSize) noexcept;
+    // Visits the same children as objects(), in the same order, without building a list
+    template <typename F>
+    void forEachObject(F&& f) const
+    {
+        forEachIn(f, groups, spheres, planes, cubes, cylinders, cones, triangles, smoothTriangles, meshes, csgs, instances);
+    }
     // TODO(nic) can I make this a template? Each pushes elements to a different vector
     // TODO(nic) it is dangerous for these to return a reference to the object added...
     Group& addChild(const Group& c) noexcept;
@@ -368,7 +617,9 @@ class Group : public Shape
     Cone& addChild(const Cone& c) noexcept;
     Triangle& addChild(const Triangle& t) noexcept;
     SmoothTriangle& addChild(const SmoothTriangle& st) noexcept;
+    TriangleMesh& addChild(const TriangleMesh& mesh) noexcept;
     CSG& addChild(const CSG& csg) noexcept;
+    Instance& addChild(const Instance& instance) noexcept;
 
   private:
     std::vector<Group> groups;
@@ -379,10 +630,51 @@ class Group : public Shape
     std::vector<Cone> cones;
     std::vector<Triangle> triangles;
     std::vector<SmoothTriangle> smoothTriangles;
+    std::vector<TriangleMesh> meshes;
     std::vector<CSG> csgs;
+    std::vector<Instance> instances;
+    Acceleration acceleration = Linear;
+    UniformGrid grid;
+    WideBoundingVolumeHierarchy bvh;
+    AccelerationBounds builtBounds; // Of the children, as the grid or hierarchy was built over them
+    // Children in forEachObject order, which is what the acceleration structure's indices refer to
+    std::vector<const Shape*> childTable;
+
+    void adoptChildren() noexcept;
+    void refreshChildTable() noexcept;
+    // Simplifies the meshes in place without rebuilding acceleration structures, for simplified
+    void simplifyMeshes(float faceFraction);
+    [[nodiscard]] size_t childCount() const noexcept;
+    // Bounds of the children in this group's object space, in forEachObject order
+    [[nodiscard]] std::vector<BoundingBox> childBounds() const noexcept;
+
+    template <typename F, typename... Containers>
+    static void forEachIn(F& f, const Containers&... containers)
+    {
+        (
+            [&f](const auto& container) {
+                for (const Shape& shape : container)
+                {
+                    f(shape);
+                }
+            }(containers),
+            ...);
+    }
 
     [[nodiscard]] Tuple objectNormal(const Tuple& p, [[maybe_unused]] const Intersection& i) const noexcept override;
-    [[nodiscard]] std::vector<Intersection> objectIntersect(const Ray& r) const noexcept override;
+    [[nodiscard]] Intersections objectIntersect(const Ray& r) const noexcept override;
+};
+
+// How the hit point, the surface normal there and the incoming ray's direction change from one
+// pixel to the next in x and in y, at the hit of a ray traced with differentials
+class SurfaceDifferential
+{
+  public:
+    Footprint footprint;
+    Tuple dndx;
+    Tuple dndy;
+    Tuple dddx;
+    Tuple dddy;
 };
 
 struct __attribute__((aligned(128))) IntersectionDetails
@@ -399,6 +691,11 @@ struct __attribute__((aligned(128))) IntersectionDetails
     const float n1;
     const float n2;
     const bool inside;
+    const std::optional<SurfaceDifferential> differential;
+    const TextureCoordinates textureCoordinates; // Only found for textured materials
+
+    // Zero, so patterns are point sampled, for rays without differentials
+    [[nodiscard]] Footprint footprint() const noexcept { return differential ? differential->footprint : Footprint(); }
 };
 
 Sphere GlassSphere() noexcept;
@@ -0,0 +1,170 @@
+/*
+ * Statistics.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Statistics.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <vector>
+
+class StatisticsName
+{
+  public:
+    const char* label;
+    const char* key;
+};
+
+constexpr std::array<StatisticsName, RenderStatistics::CounterCount> STATISTICS_NAMES = {{
+    {"Primary rays", "primaryRays"},
+    {"Shadow rays", "shadowRays"},
+    {"Reflection rays", "reflectionRays"},
+    {"Refraction rays", "refractionRays"},
+    {"Sphere tests", "sphereTests"},
+    {"Plane tests", "planeTests"},
+    {"Cube tests", "cubeTests"},
+    {"Cylinder tests", "cylinderTests"},
+    {"Cone tests", "coneTests"},
+    {"Triangle tests", "triangleTests"},
+    {"Smooth triangle tests", "smoothTriangleTests"},
+    {"CSG tests", "csgTests"},
+    {"Group tests", "groupTests"},
+    {"Material::light calls", "lightingCalls"},
+    {"Matrix inversions", "matrixInversions"},
+    {"Texture lookups", "textureLookups"},
+    {"Texture tile loads", "textureTileLoads"},
+    {"Arena allocations", "arenaAllocations"},
+    {"Heap allocations", "heapAllocations"},
+}};
+
+bool CountedAnything(const RenderStatistics& statistics) noexcept
+{
+    return std::any_of(statistics.counts.begin(), statistics.counts.end(), [](const uint64_t count) {
+        return count > 0;
+    });
+}
+
+// Every live thread's counters, plus the totals of threads that have since exited
+class StatisticsRegistry
+{
+  public:
+    std::mutex mutex;
+    std::vector<RenderStatistics*> threads;
+    RenderStatistics retired;
+
+    static StatisticsRegistry& instance() noexcept
+    {
+        static StatisticsRegistry registry;
+        return registry;
+    }
+};
+
+class ThreadStatistics
+{
+  public:
+    RenderStatistics counters;
+
+    ThreadStatistics()
+    {
+        StatisticsRegistry& registry = StatisticsRegistry::instance();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.threads.push_back(&counters);
+    }
+
+    ~ThreadStatistics()
+    {
+        StatisticsRegistry& registry = StatisticsRegistry::instance();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), &counters));
+        registry.retired += counters;
+        registry.retired.threads += CountedAnything(counters) ? 1U : 0U;
+    }
+
+    ThreadStatistics(const ThreadStatistics&) = delete;
+    ThreadStatistics& operator=(const ThreadStatistics&) = delete;
+};
+
+RenderStatistics& RenderStatistics::operator+=(const RenderStatistics& other) noexcept
+{
+    for (uint32_t i = 0; i < CounterCount; i++)
+    {
+        counts[i] += other.counts[i];
+    }
+    threads += other.threads;
+    return *this;
+}
+
+uint64_t RenderStatistics::rays() const noexcept
+{
+    return std::accumulate(counts.begin() + PrimaryRays, counts.begin() + RefractionRays + 1, uint64_t{0});
+}
+
+uint64_t RenderStatistics::intersectionTests() const noexcept
+{
+    return std::accumulate(counts.begin() + SphereTests, counts.begin() + GroupTests + 1, uint64_t{0});
+}
+
+std::string RenderStatistics::summary() const
+{
+    std::ostringstream text;
+    text << "Render statistics over " << threads << " threads\n";
+    for (uint32_t i = 0; i < CounterCount; i++)
+    {
+        if (i == SphereTests)
+        {
+            text << "Intersection tests\n";
+        } else if (i == LightingCalls)
+        {
+            text << "Other work\n";
+        }
+        text << "  " << STATISTICS_NAMES[i].label << ": " << counts[i] << "\n";
+    }
+    return text.str();
+}
+
+std::string RenderStatistics::json() const
+{
+    std::ostringstream text;
+    text << "{\"threads\": " << threads;
+    for (uint32_t i = 0; i < CounterCount; i++)
+    {
+        text << ", \"" << STATISTICS_NAMES[i].key << "\": " << counts[i];
+    }
+    text << "}";
+    return text.str();
+}
+
+RenderStatistics RenderStatistics::Collect()
+{
+    StatisticsRegistry& registry = StatisticsRegistry::instance();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    RenderStatistics total = registry.retired;
+    for (const RenderStatistics* thread : registry.threads)
+    {
+        total += *thread;
+        total.threads += CountedAnything(*thread) ? 1U : 0U;
+    }
+    return total;
+}
+
+void RenderStatistics::Reset()
+{
+    StatisticsRegistry& registry = StatisticsRegistry::instance();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.retired = RenderStatistics();
+    for (RenderStatistics* thread : registry.threads)
+    {
+        *thread = RenderStatistics();
+    }
+}
+
+RenderStatistics& RenderStatistics::threadLocal() noexcept
+{
+    thread_local ThreadStatistics statistics;
+    return statistics.counters;
+}
@@ -0,0 +1,82 @@
+/*
+ * Statistics.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_STATISTICS_HPP_
+#define SRC_STATISTICS_HPP_
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Counts of the work done while rendering. Each thread counts into its own plain counters, so the
+// hot path takes no lock and no atomic, and Collect() sums them once the threads are idle. Counting
+// is compiled in only when RAYTRACER_STATISTICS is defined (the ENABLE_STATISTICS CMake option);
+// otherwise CountStatistic() is empty and every count stays zero.
+class RenderStatistics
+{
+  public:
+    enum Counter : uint32_t
+    {
+        PrimaryRays,
+        ShadowRays,
+        ReflectionRays,
+        RefractionRays,
+        SphereTests,
+        PlaneTests,
+        CubeTests,
+        CylinderTests,
+        ConeTests,
+        TriangleTests,
+        SmoothTriangleTests,
+        CSGTests,
+        GroupTests,
+        LightingCalls,
+        MatrixInversions,
+        TextureLookups,
+        TextureTileLoads,
+        ArenaAllocations,
+        HeapAllocations,
+        CounterCount
+    };
+
+#ifdef RAYTRACER_STATISTICS
+    static constexpr bool Enabled = true;
+#else
+    static constexpr bool Enabled = false;
+#endif
+
+    std::array<uint64_t, CounterCount> counts{};
+    // Threads that counted anything
+    uint32_t threads = 0;
+
+    [[nodiscard]] uint64_t operator[](Counter counter) const noexcept { return counts[counter]; }
+    RenderStatistics& operator+=(const RenderStatistics& other) noexcept;
+    // Rays of every kind
+    [[nodiscard]] uint64_t rays() const noexcept;
+    // objectIntersect calls of every shape type
+    [[nodiscard]] uint64_t intersectionTests() const noexcept;
+
+    // One counter per line, grouped into rays, intersection tests and other work
+    [[nodiscard]] std::string summary() const;
+    [[nodiscard]] std::string json() const;
+
+    // Sums every thread's counters since the last Reset(). Neither may run while other threads
+    // are still counting.
+    [[nodiscard]] static RenderStatistics Collect();
+    static void Reset();
+    // The calling thread's counters
+    static RenderStatistics& threadLocal() noexcept;
+};
+
+inline void CountStatistic([[maybe_unused]] const RenderStatistics::Counter counter) noexcept
+{
+#ifdef RAYTRACER_STATISTICS
+    RenderStatistics::threadLocal().counts[counter]++;
+#endif
+}
+
+#endif /* SRC_STATISTICS_HPP_ */
@@ -0,0 +1,572 @@
+/*
+ * Texture.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Texture.hpp"
+#include "Statistics.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <unistd.h>
+
+class PPMImage
+{
+  public:
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<Texel> texels;
+};
+
+// Both PPM forms share a header of whitespace separated fields, which may hold '#' comments
+PPMImage ReadPPM(const std::string& data)
+{
+    size_t position = 0;
+    const auto field = [&]() {
+        while (position < data.size() && (data[position] == '#' || std::isspace(static_cast<unsigned char>(data[position])) != 0))
+        {
+            position = data[position] == '#' ? data.find('\n', position) : position + 1;
+            position = position == std::string::npos ? data.size() : position;
+        }
+        const size_t start = position;
+        while (position < data.size() && std::isspace(static_cast<unsigned char>(data[position])) == 0)
+        {
+            position++;
+        }
+        return std::string_view(data).substr(start, position - start);
+    };
+    const auto number = [&]() {
+        const std::string_view text = field();
+        uint32_t value = 0;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (text.empty() || error != std::errc() || end != text.data() + text.size())
+        {
+            throw std::runtime_error("Texture: Invalid PPM image");
+        }
+        return value;
+    };
+
+    const std::string_view magic = field();
+    if (magic != "P3" && magic != "P6")
+    {
+        throw std::runtime_error("Texture: Only P3 and P6 PPM images can be read");
+    }
+    PPMImage image;
+    image.width = number();
+    image.height = number();
+    const uint32_t maxValue = number();
+    if (image.width == 0 || image.height == 0 || maxValue == 0 || maxValue > UINT16_MAX)
+    {
+        throw std::runtime_error("Texture: Invalid PPM image");
+    }
+    const size_t samples = size_t{image.width} * image.height * 3;
+    const auto scale = [&](const uint32_t value) {
+        return static_cast<uint8_t>((std::min(value, maxValue) * 255U + maxValue / 2U) / maxValue);
+    };
+
+    image.texels.resize(size_t{image.width} * image.height, {0, 0, 0, UINT8_MAX});
+    if (magic == "P3")
+    {
+        for (size_t sample = 0; sample < samples; sample++)
+        {
+            image.texels[sample / 3][sample % 3] = scale(number());
+        }
+        return image;
+    }
+
+    // A single whitespace character ends the header, and the samples follow as bytes, or as big
+    // endian pairs of bytes when they go above 255
+    position++;
+    const size_t bytesPerSample = maxValue > UINT8_MAX ? 2 : 1;
+    if (position > data.size() || data.size() - position < samples * bytesPerSample)
+    {
+        throw std::runtime_error("Texture: PPM image is shorter than its size");
+    }
+    for (size_t sample = 0; sample < samples; sample++)
+    {
+        const auto byte = [&](const size_t index) { return static_cast<uint32_t>(static_cast<unsigned char>(data[position + index])); };
+        const uint32_t value = bytesPerSample == 1 ? byte(sample) : (byte(sample * 2) << 8U) | byte(sample * 2 + 1);
+        image.texels[sample / 3][sample % 3] = scale(value);
+    }
+    return image;
+}
+
+// Rounded to 8 bits the same way GetPPMString writes them
+std::vector<Texel> CanvasTexels(const Canvas& image)
+{
+    const auto quantize = [](const float value) { return static_cast<uint8_t>(std::clamp(static_cast<int>(std::round(value * 255.0F)), 0, 255)); };
+    std::vector<Texel> texels;
+    texels.reserve(size_t{image.width} * image.height);
+    for (const auto& row : image.pixels)
+    {
+        for (const Color& pixel : row)
+        {
+            texels.push_back({quantize(pixel.r), quantize(pixel.g), quantize(pixel.b), UINT8_MAX});
+        }
+    }
+    return texels;
+}
+
+// Of a slot whose tile was given back
+constexpr uint64_t NO_TILE = UINT64_MAX;
+
+static std::atomic<uint64_t> nextCacheId = 1;
+
+// A thread's copy of a tile, good while the cache and generation it was copied at still match
+class ThreadTile
+{
+  public:
+    uint64_t cache = 0; // No cache has id 0, so unused copies match none
+    uint64_t generation = 0;
+    uint64_t tile = 0;
+    TextureTile texels{};
+};
+
+static thread_local std::array<ThreadTile, THREAD_TEXTURE_TILES> threadTiles;
+
+TextureCache::TextureCache(const size_t budgetBytesIn) : id(nextCacheId++), store(std::tmpfile()), budgetBytes(budgetBytesIn)
+{
+    if (!store)
+    {
+        throw std::runtime_error("TextureCache: Could not create the file texture tiles are kept in");
+    }
+}
+
+std::shared_ptr<const Texture> TextureCache::load(const std::string& fileName)
+{
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        const auto loaded = textures.find(fileName);
+        if (loaded != textures.end())
+        {
+            if (std::shared_ptr<const Texture> texture = loaded->second.lock())
+            {
+                return texture;
+            }
+        }
+    }
+
+    std::ifstream imageFile(fileName, std::ios::binary);
+    if (!imageFile)
+    {
+        throw std::runtime_error("Could not open texture file " + fileName);
+    }
+    std::ostringstream imageData;
+    imageData << imageFile.rdbuf();
+    const PPMImage image = ReadPPM(imageData.str());
+    auto texture = std::make_shared<const Texture>(image.width, image.height, image.texels, *this);
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    textures[fileName] = texture;
+    return texture;
+}
+
+void TextureCache::setBudget(const size_t budgetBytesIn)
+{
+    const std::lock_guard<std::mutex> lock(mutex);
+    budgetBytes = budgetBytesIn;
+    if (slots.size() > capacity())
+    {
+        // Tiles only ever held in memory go to the file before their slots are dropped
+        for (const Slot& slot : slots)
+        {
+            if (slot.tile != NO_TILE && !slot.stored && !writeTiles(slot.tile, &slot.texels, 1))
+            {
+                throw std::runtime_error("TextureCache: Could not write texture tiles");
+            }
+        }
+        slots.clear();
+        slots.shrink_to_fit();
+        freeSlots.clear();
+        residentTiles.clear();
+        clockHand = 0;
+    }
+}
+
+size_t TextureCache::budget() const noexcept
+{
+    const std::lock_guard<std::mutex> lock(mutex);
+    return budgetBytes;
+}
+
+size_t TextureCache::residentBytes() const noexcept
+{
+    const std::lock_guard<std::mutex> lock(mutex);
+    return (slots.size() - freeSlots.size()) * sizeof(TextureTile);
+}
+
+uint64_t TextureCache::tileLoads() const noexcept
+{
+    const std::lock_guard<std::mutex> lock(mutex);
+    return loads;
+}
+
+TextureCache& TextureCache::Shared()
+{
+    static TextureCache cache;
+    return cache;
+}
+
+// Room for one tile however small the budget, as every lookup needs at least that
+size_t TextureCache::capacity() const noexcept
+{
+    return std::max<size_t>(budgetBytes / sizeof(TextureTile), 1);
+}
+
+uint64_t TextureCache::storeTiles(const std::vector<TextureTile>& tiles)
+{
+    const std::lock_guard<std::mutex> lock(mutex);
+    const uint64_t first = allocateTiles(tiles.size());
+    if (slots.size() - freeSlots.size() + tiles.size() <= capacity())
+    {
+        for (size_t i = 0; i < tiles.size(); i++)
+        {
+            size_t index = slots.size();
+            if (freeSlots.empty())
+            {
+                slots.emplace_back();
+            } else
+            {
+                index = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            slots[index] = {first + i, false, false, tiles[i]};
+            residentTiles.emplace(first + i, index);
+        }
+        return first;
+    }
+    if (!writeTiles(first, tiles.data(), tiles.size()))
+    {
+        freeTiles(first, tiles.size());
+        throw std::runtime_error("TextureCache: Could not write texture tiles");
+    }
+    return first;
+}
+
+void TextureCache::releaseTiles(const uint64_t first, const uint64_t count) noexcept
+{
+    const std::lock_guard<std::mutex> lock(mutex);
+    std::erase_if(residentTiles, [&](const std::pair<const uint64_t, size_t>& resident) {
+        if (resident.first < first || resident.first - first >= count)
+        {
+            return false;
+        }
+        slots[resident.second].tile = NO_TILE;
+        slots[resident.second].referenced = false;
+        freeSlots.push_back(resident.second);
+        return true;
+    });
+    freeTiles(first, count);
+    generation.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t TextureCache::allocateTiles(const uint64_t count)
+{
+    for (auto range = freeRanges.begin(); range != freeRanges.end(); ++range)
+    {
+        if (range->count >= count)
+        {
+            const uint64_t first = range->first;
+            range->first += count;
+            range->count -= count;
+            if (range->count == 0)
+            {
+                freeRanges.erase(range);
+            }
+            return first;
+        }
+    }
+    const uint64_t first = allocatedTiles;
+    allocatedTiles += count;
+    return first;
+}
+
+void TextureCache::freeTiles(const uint64_t first, const uint64_t count)
+{
+    auto range = freeRanges.insert(std::lower_bound(freeRanges.begin(), freeRanges.end(), first, [](const TileRange& other, const uint64_t start) { return other.first < start; }),
+                                   {first, count});
+    if (range + 1 != freeRanges.end() && range->first + range->count == (range + 1)->first)
+    {
+        range->count += (range + 1)->count;
+        freeRanges.erase(range + 1);
+    }
+    if (range != freeRanges.begin() && (range - 1)->first + (range - 1)->count == range->first)
+    {
+        (range - 1)->count += range->count;
+        range = freeRanges.erase(range) - 1;
+    }
+    // Indices at the end are handed out again from there
+    if (range + 1 == freeRanges.end() && range->first + range->count == allocatedTiles)
+    {
+        allocatedTiles = range->first;
+        freeRanges.pop_back();
+    }
+}
+
+bool TextureCache::writeTiles(const uint64_t first, const TextureTile* tiles, const size_t count) const noexcept
+{
+    const auto* bytes = reinterpret_cast<const char*>(tiles);
+    const size_t size = count * sizeof(TextureTile);
+    for (size_t written = 0; written < size;)
+    {
+        const ssize_t result = pwrite(fileno(store.get()), bytes + written, size - written, static_cast<off_t>(first * sizeof(TextureTile) + written));
+        if (result <= 0)
+        {
+            return false;
+        }
+        written += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+Texel TextureCache::texel(const TexelAddress& address) noexcept
+{
+    return threadTile(address.tile)[address.offset];
+}
+
+std::array<Texel, 4> TextureCache::texels(const std::array<TexelAddress, 4>& addresses) noexcept
+{
+    std::array<Texel, 4> gathered{};
+    for (size_t i = 0; i < addresses.size(); i++)
+    {
+        gathered[i] = threadTile(addresses[i].tile)[addresses[i].offset];
+    }
+    return gathered;
+}
+
+const TextureTile& TextureCache::threadTile(const uint64_t tile) noexcept
+{
+    ThreadTile& copy = threadTiles[tile % THREAD_TEXTURE_TILES];
+    const uint64_t current = generation.load(std::memory_order_acquire);
+    if (copy.cache != id || copy.generation != current || copy.tile != tile)
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        copy.texels = resident(tile).texels;
+        copy.cache = id;
+        copy.generation = current;
+        copy.tile = tile;
+    }
+    return copy.texels;
+}
+
+TextureCache::Slot& TextureCache::resident(const uint64_t tile) noexcept
+{
+    const auto found = residentTiles.find(tile);
+    if (found != residentTiles.end())
+    {
+        Slot& slot = slots[found->second];
+        slot.referenced = true;
+        return slot;
+    }
+
+    // A free slot while the budget allows, otherwise the first the clock hand finds that has not
+    // been looked at since the hand last passed it
+    size_t index = slots.size();
+    if (!freeSlots.empty())
+    {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    } else if (slots.size() < capacity())
+    {
+        slots.emplace_back();
+    } else
+    {
+        while (slots[clockHand].referenced)
+        {
+            slots[clockHand].referenced = false;
+            clockHand = (clockHand + 1) % slots.size();
+        }
+        index = clockHand;
+        // A tile that cannot be written is lost, and reads back black like any other the file lacks
+        if (!slots[index].stored)
+        {
+            (void)writeTiles(slots[index].tile, &slots[index].texels, 1);
+        }
+        residentTiles.erase(slots[index].tile);
+        clockHand = (clockHand + 1) % slots.size();
+    }
+
+    Slot& slot = slots[index];
+    auto* bytes = reinterpret_cast<char*>(slot.texels.data());
+    for (size_t read = 0; read < sizeof(TextureTile);)
+    {
+        const ssize_t count = pread(fileno(store.get()), bytes + read, sizeof(TextureTile) - read, static_cast<off_t>(tile * sizeof(TextureTile) + read));
+        if (count <= 0)
+        {
+            slot.texels.fill({0, 0, 0, UINT8_MAX}); // Black rather than whatever the slot last held
+            break;
+        }
+        read += static_cast<size_t>(count);
+    }
+    slot.tile = tile;
+    slot.referenced = true;
+    slot.stored = true;
+    residentTiles.emplace(tile, index);
+    loads++;
+    CountStatistic(RenderStatistics::TextureTileLoads);
+    return slot;
+}
+
+Texture::Texture(const uint32_t widthIn, const uint32_t heightIn, const std::vector<Texel>& texels, TextureCache& cacheIn) : cache(&cacheIn)
+{
+    const TraceScope trace("Texture");
+    if (widthIn == 0 || heightIn == 0 || texels.size() != size_t{widthIn} * heightIn)
+    {
+        throw std::runtime_error("Texture: Image size does not match its texels");
+    }
+
+    // Every level's tiles are stored together, so the texture gives back one range of them
+    std::vector<TextureTile> tiles;
+    std::vector<Texel> level = texels;
+    uint32_t levelWidth = widthIn;
+    uint32_t levelHeight = heightIn;
+    while (true)
+    {
+        // Tiles past the image's right and bottom edges are padded, and the padding is never read
+        const uint32_t tilesAcross = (levelWidth + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE;
+        const uint32_t tilesDown = (levelHeight + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE;
+        const size_t levelTile = tiles.size();
+        tiles.resize(levelTile + size_t{tilesAcross} * tilesDown);
+        for (uint32_t y = 0; y < levelHeight; y++)
+        {
+            for (uint32_t x = 0; x < levelWidth; x++)
+            {
+                TextureTile& tile = tiles[levelTile + size_t{y / TEXTURE_TILE_SIZE} * tilesAcross + x / TEXTURE_TILE_SIZE];
+                tile[(y % TEXTURE_TILE_SIZE) * TEXTURE_TILE_SIZE + x % TEXTURE_TILE_SIZE] = level[size_t{y} * levelWidth + x];
+            }
+        }
+        mipLevels.push_back({levelWidth, levelHeight, tilesAcross, levelTile});
+        if (levelWidth == 1 && levelHeight == 1)
+        {
+            break;
+        }
+
+        // Each texel of the next level is the box average of the two by two texels below it. Odd
+        // sizes round up, and the last row or column stands in for the one missing past the edge.
+        const uint32_t nextWidth = (levelWidth + 1) / 2;
+        const uint32_t nextHeight = (levelHeight + 1) / 2;
+        std::vector<Texel> next(size_t{nextWidth} * nextHeight);
+        for (uint32_t y = 0; y < nextHeight; y++)
+        {
+            const std::array<uint32_t, 2> rows = {2 * y, std::min(2 * y + 1, levelHeight - 1)};
+            for (uint32_t x = 0; x < nextWidth; x++)
+            {
+                const std::array<uint32_t, 2> columns = {2 * x, std::min(2 * x + 1, levelWidth - 1)};
+                for (size_t channel = 0; channel < 3; channel++)
+                {
+                    uint32_t sum = 2; // Rounds to nearest
+                    for (const uint32_t row : rows)
+                    {
+                        for (const uint32_t column : columns)
+                        {
+                            sum += level[size_t{row} * levelWidth + column][channel];
+                        }
+                    }
+                    next[size_t{y} * nextWidth + x][channel] = static_cast<uint8_t>(sum / 4);
+                }
+                next[size_t{y} * nextWidth + x][3] = UINT8_MAX;
+            }
+        }
+        level = std::move(next);
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+    }
+
+    firstTile = cache->storeTiles(tiles);
+    tileCount = tiles.size();
+    for (Level& mip : mipLevels)
+    {
+        mip.firstTile += firstTile;
+    }
+}
+
+Texture::Texture(const Canvas& image, TextureCache& cacheIn) : Texture(image.width, image.height, CanvasTexels(image), cacheIn)
+{
+}
+
+Texture::~Texture()
+{
+    cache->releaseTiles(firstTile, tileCount);
+}
+
+uint32_t Texture::width() const noexcept
+{
+    return mipLevels.front().width;
+}
+
+uint32_t Texture::height() const noexcept
+{
+    return mipLevels.front().height;
+}
+
+size_t Texture::levels() const noexcept
+{
+    return mipLevels.size();
+}
+
+TextureCache::TexelAddress Texture::address(const size_t level, const uint32_t x, const uint32_t y) const noexcept
+{
+    const Level& mip = mipLevels[level];
+    return {mip.firstTile + uint64_t{y / TEXTURE_TILE_SIZE} * mip.tilesAcross + x / TEXTURE_TILE_SIZE, (y % TEXTURE_TILE_SIZE) * TEXTURE_TILE_SIZE + x % TEXTURE_TILE_SIZE};
+}
+
+Color TexelColor(const Texel& value) noexcept
+{
+    return {static_cast<float>(value[0]) / 255.0F, static_cast<float>(value[1]) / 255.0F, static_cast<float>(value[2]) / 255.0F};
+}
+
+Color Texture::texel(const size_t level, const uint32_t x, const uint32_t y) const noexcept
+{
+    return TexelColor(cache->texel(address(level, x, y)));
+}
+
+Color Texture::bilinear(const size_t level, const float u, const float v) const noexcept
+{
+    const Level& mip = mipLevels[level];
+    // Texel centres are half a texel in from their edges, and the image repeats past 0 and 1
+    const float s = (u - std::floor(u)) * static_cast<float>(mip.width) - 0.5F;
+    const float t = (std::ceil(v) - v) * static_cast<float>(mip.height) - 0.5F;
+    const float left = std::floor(s);
+    const float top = std::floor(t);
+    const float across = s - left;
+    const float down = t - top;
+    const uint32_t x0 = left < 0.0F ? mip.width - 1 : std::min(static_cast<uint32_t>(left), mip.width - 1);
+    const uint32_t y0 = top < 0.0F ? mip.height - 1 : std::min(static_cast<uint32_t>(top), mip.height - 1);
+    const uint32_t x1 = (x0 + 1) % mip.width;
+    const uint32_t y1 = (y0 + 1) % mip.height;
+
+    const std::array<Texel, 4> corners = cache->texels({address(level, x0, y0), address(level, x1, y0), address(level, x0, y1), address(level, x1, y1)});
+    const Color upper = TexelColor(corners[0]) * (1.0F - across) + TexelColor(corners[1]) * across;
+    const Color lower = TexelColor(corners[2]) * (1.0F - across) + TexelColor(corners[3]) * across;
+    return upper * (1.0F - down) + lower * down;
+}
+
+Color Texture::sample(const TextureCoordinates& coordinates) const noexcept
+{
+    CountStatistic(RenderStatistics::TextureLookups);
+    // The footprint's longer side, in texels of the full image, picks the level whose texels are as wide
+    const auto textureWidth = static_cast<float>(width());
+    const auto textureHeight = static_cast<float>(height());
+    const float footprint = std::max(std::hypot(coordinates.dudx * textureWidth, coordinates.dvdx * textureHeight),
+                                     std::hypot(coordinates.dudy * textureWidth, coordinates.dvdy * textureHeight));
+    const auto coarsest = static_cast<float>(levels() - 1);
+    const float level = footprint > 1.0F ? std::min(std::log2(footprint), coarsest) : 0.0F;
+
+    const auto finer = static_cast<size_t>(level);
+    const float blend = level - static_cast<float>(finer);
+    const Color color = bilinear(finer, coordinates.u, coordinates.v);
+    if (blend <= 0.0F)
+    {
+        return color;
+    }
+    return color + (bilinear(finer + 1, coordinates.u, coordinates.v) - color) * blend;
+}
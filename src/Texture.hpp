@@ -0,0 +1,192 @@
+/*
+ * Texture.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_TEXTURE_HPP_
+#define SRC_TEXTURE_HPP_
+
+#include "Canvas.hpp"
+#include "Color.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Texels along each side of a tile. A tile of 8 bit RGBA texels is then 256 bytes, four cache
+// lines, and a bilinear lookup's four texels share one tile far more often than they share a row.
+constexpr uint32_t TEXTURE_TILE_SIZE = 8;
+constexpr size_t DEFAULT_TEXTURE_CACHE_BUDGET = size_t{64} << 20U;
+// Tiles each thread keeps its own copies of, outside the budget; 32 take about 9 kB per thread
+constexpr size_t THREAD_TEXTURE_TILES = 32;
+
+// Red, green, blue and padding, four bytes with no alignment of their own, so tiles pack them end to end
+using Texel = std::array<uint8_t, 4>;
+using TextureTile = std::array<Texel, TEXTURE_TILE_SIZE * TEXTURE_TILE_SIZE>;
+
+// Where a shaded point falls on an image texture, which spans 0 to 1 in u and v and repeats beyond,
+// with v running up the image. The derivatives are how far that moves from one pixel to the next;
+// they stay zero for rays without differentials, which then read the full resolution image.
+class TextureCoordinates
+{
+  public:
+    float u = 0.0F;
+    float v = 0.0F;
+    float dudx = 0.0F;
+    float dvdx = 0.0F;
+    float dudy = 0.0F;
+    float dvdy = 0.0F;
+};
+
+class Texture;
+
+// Holds the tiles of every texture loaded through it, in memory while its budget has room for all of
+// a texture's tiles and otherwise in a temporary file. Tiles are read back from the file as lookups
+// need them, and when the budget is full the tile least recently looked at, as far as a clock sweep
+// can tell, makes way, written to the file first if it is not there yet. A texture's tiles are given
+// back when it is destroyed, for later textures to reuse.
+// Lookups may come from any thread. Each thread copies the tiles it reads into a small cache of its
+// own, THREAD_TEXTURE_TILES of them, so only lookups that miss there take the cache's lock.
+class TextureCache
+{
+  public:
+    explicit TextureCache(size_t budgetBytesIn = DEFAULT_TEXTURE_CACHE_BUDGET);
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+    TextureCache(TextureCache&&) = delete;
+    TextureCache& operator=(TextureCache&&) = delete;
+    ~TextureCache() noexcept = default;
+
+    // Reads a binary (P6) or plain (P3) PPM file, or gives the texture already read from it while
+    // anything still uses that one. Throws if the file cannot be read.
+    [[nodiscard]] std::shared_ptr<const Texture> load(const std::string& fileName);
+    // Tiles in memory beyond a smaller budget are dropped, to be read back when next looked at
+    void setBudget(size_t budgetBytesIn);
+    [[nodiscard]] size_t budget() const noexcept;
+    [[nodiscard]] size_t residentBytes() const noexcept;
+    // Tiles read back from the file since the cache was made
+    [[nodiscard]] uint64_t tileLoads() const noexcept;
+
+    // The cache scenes load their textures through unless given another
+    [[nodiscard]] static TextureCache& Shared();
+
+  private:
+    friend class Texture;
+
+    class FileCloser
+    {
+      public:
+        void operator()(FILE* file) const noexcept { std::fclose(file); }
+    };
+
+    class Slot
+    {
+      public:
+        uint64_t tile;
+        bool referenced;
+        bool stored; // Whether the file holds the tile too, or it has to be written before making way
+        TextureTile texels;
+    };
+
+    class TileRange
+    {
+      public:
+        uint64_t first;
+        uint64_t count;
+    };
+
+    // A texel by its tile and its place within the tile
+    class TexelAddress
+    {
+      public:
+        uint64_t tile;
+        uint32_t offset;
+    };
+
+    const uint64_t id; // Tells apart the copies threads hold of each cache's tiles
+    // Advanced whenever tiles are given back, as their indices may then hold another texture's tiles
+    std::atomic<uint64_t> generation = 0;
+    mutable std::mutex mutex;
+    std::unique_ptr<FILE, FileCloser> store;
+    uint64_t allocatedTiles = 0;       // Indices given out so far, in use or free
+    std::vector<TileRange> freeRanges; // Of indices given back, sorted and merged
+    size_t budgetBytes;
+    std::vector<Slot> slots;
+    std::vector<size_t> freeSlots;                      // Of tiles given back
+    std::unordered_map<uint64_t, size_t> residentTiles; // Slot of each tile in memory
+    size_t clockHand = 0;
+    uint64_t loads = 0;
+    std::unordered_map<std::string, std::weak_ptr<const Texture>> textures;
+
+    [[nodiscard]] size_t capacity() const noexcept;
+    // Gives the index of the first of tiles, which are kept in memory if the budget has room for
+    // them all and otherwise written to the file. Throws if they cannot be written.
+    [[nodiscard]] uint64_t storeTiles(const std::vector<TextureTile>& tiles);
+    // Frees count tiles from first, held by a texture that is being destroyed
+    void releaseTiles(uint64_t first, uint64_t count) noexcept;
+    [[nodiscard]] Texel texel(const TexelAddress& address) noexcept;
+    [[nodiscard]] std::array<Texel, 4> texels(const std::array<TexelAddress, 4>& addresses) noexcept;
+    // The calling thread's copy of tile, taken from the cache under its lock if the thread has none.
+    // Valid until the thread next asks for a tile.
+    [[nodiscard]] const TextureTile& threadTile(uint64_t tile) noexcept;
+    // The slot holding tile, read into one if none does. The mutex must be held.
+    [[nodiscard]] Slot& resident(uint64_t tile) noexcept;
+    // The mutex must be held by each of these
+    [[nodiscard]] uint64_t allocateTiles(uint64_t count);
+    void freeTiles(uint64_t first, uint64_t count);
+    [[nodiscard]] bool writeTiles(uint64_t first, const TextureTile* tiles, size_t count) const noexcept;
+};
+
+// An image kept as a pyramid of mip levels, each half the width and height of the one before down
+// to a single texel, so a lookup can read a level whose texels are about as large as the pixel
+// footprint rather than averaging every texel under it. Each level is stored in square tiles, which
+// live in the cache the texture was made with until the texture is destroyed; that cache must
+// outlive the texture.
+class Texture
+{
+  public:
+    // texels are the image's rows from top to bottom, as in a PPM file
+    Texture(uint32_t widthIn, uint32_t heightIn, const std::vector<Texel>& texels, TextureCache& cacheIn);
+    Texture(const Canvas& image, TextureCache& cacheIn);
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+    Texture(Texture&&) = delete;
+    Texture& operator=(Texture&&) = delete;
+    ~Texture();
+
+    [[nodiscard]] uint32_t width() const noexcept;
+    [[nodiscard]] uint32_t height() const noexcept;
+    [[nodiscard]] size_t levels() const noexcept;
+    // The texel x across and y down from the top left of a level, with level 0 the full image
+    [[nodiscard]] Color texel(size_t level, uint32_t x, uint32_t y) const noexcept;
+    // Trilinear: bilinear lookups in the two levels either side of the footprint's size, blended
+    [[nodiscard]] Color sample(const TextureCoordinates& coordinates) const noexcept;
+
+  private:
+    class Level
+    {
+      public:
+        uint32_t width;
+        uint32_t height;
+        uint32_t tilesAcross;
+        uint64_t firstTile;
+    };
+
+    TextureCache* cache;
+    std::vector<Level> mipLevels;
+    uint64_t firstTile = 0; // Every level's tiles, one after another
+    uint64_t tileCount = 0;
+
+    [[nodiscard]] TextureCache::TexelAddress address(size_t level, uint32_t x, uint32_t y) const noexcept;
+    [[nodiscard]] Color bilinear(size_t level, float u, float v) const noexcept;
+};
+
+#endif /* SRC_TEXTURE_HPP_ */
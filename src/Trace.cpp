@@ -0,0 +1,114 @@
+/*
+ * Trace.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+class TraceBuffer
+{
+  public:
+    std::vector<TraceEvent> events = std::vector<TraceEvent>(Tracer::BUFFER_CAPACITY);
+    // Including those since overwritten
+    uint64_t recorded = 0;
+    uint32_t thread = 0;
+};
+
+// Buffers outlive their threads, so the events of a thread that has exited can still be written out
+class TraceRegistry
+{
+  public:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    static TraceRegistry& instance() noexcept
+    {
+        static TraceRegistry registry;
+        return registry;
+    }
+
+    TraceBuffer& threadBuffer()
+    {
+        thread_local TraceBuffer* buffer = nullptr;
+        if (buffer == nullptr)
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            buffers.push_back(std::make_unique<TraceBuffer>());
+            buffer = buffers.back().get();
+            buffer->thread = static_cast<uint32_t>(buffers.size());
+        }
+        return *buffer;
+    }
+};
+
+void Tracer::Enable()
+{
+    TraceRegistry& registry = TraceRegistry::instance();
+    {
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto& buffer : registry.buffers)
+        {
+            buffer->recorded = 0;
+        }
+        registry.epoch = std::chrono::steady_clock::now();
+    }
+    active.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::Disable() noexcept
+{
+    active.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::record(const char* name, const std::chrono::steady_clock::time_point start, const std::chrono::steady_clock::time_point end) noexcept
+{
+    TraceRegistry& registry = TraceRegistry::instance();
+    TraceBuffer& buffer = registry.threadBuffer();
+    TraceEvent& event = buffer.events[buffer.recorded % BUFFER_CAPACITY];
+    event.name = name;
+    event.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - registry.epoch).count();
+    event.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    buffer.recorded++;
+}
+
+std::string Tracer::json()
+{
+    TraceRegistry& registry = TraceRegistry::instance();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+
+    std::ostringstream text;
+    text.setf(std::ios::fixed);
+    text.precision(3);
+    text << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for (const auto& buffer : registry.buffers)
+    {
+        if (buffer->recorded == 0)
+        {
+            continue;
+        }
+        text << (first ? "" : ",") << "\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->thread
+             << ", \"args\": {\"name\": \"Thread " << buffer->thread << "\"}}";
+        first = false;
+
+        // Oldest first, starting after the ones that have been overwritten
+        const uint64_t kept = std::min<uint64_t>(buffer->recorded, BUFFER_CAPACITY);
+        for (uint64_t i = buffer->recorded - kept; i < buffer->recorded; i++)
+        {
+            const TraceEvent& event = buffer->events[i % BUFFER_CAPACITY];
+            text << ",\n{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->thread
+                 << ", \"ts\": " << static_cast<double>(event.start) / 1000.0 << ", \"dur\": " << static_cast<double>(event.duration) / 1000.0 << "}";
+        }
+    }
+    text << "\n]}";
+    return text.str();
+}
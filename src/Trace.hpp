@@ -0,0 +1,76 @@
+/*
+ * Trace.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_TRACE_HPP_
+#define SRC_TRACE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+class TraceEvent
+{
+  public:
+    // Must outlive the trace; every traced name is a string literal
+    const char* name = nullptr;
+    // Nanoseconds since the trace was enabled
+    int64_t start = 0;
+    int64_t duration = 0;
+};
+
+// Timeline of the render phases for the Chrome trace viewer and Perfetto. Each thread records into
+// its own ring buffer of the most recent BUFFER_CAPACITY events, so recording never takes a lock,
+// and nothing at all is recorded until tracing is enabled.
+class Tracer
+{
+  public:
+    static constexpr size_t BUFFER_CAPACITY = size_t{1} << 14;
+
+    // Also restarts the timeline and drops every event recorded so far
+    static void Enable();
+    static void Disable() noexcept;
+    [[nodiscard]] static bool enabled() noexcept { return active.load(std::memory_order_relaxed); }
+
+    // Every thread's events in Chrome trace event format. Must not run while other threads are
+    // still recording.
+    [[nodiscard]] static std::string json();
+    static void record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) noexcept;
+
+  private:
+    static inline std::atomic<bool> active = false;
+};
+
+// Records the time from its construction to its destruction as one event, when tracing is enabled
+class TraceScope
+{
+  public:
+    explicit TraceScope(const char* nameIn) noexcept : name(Tracer::enabled() ? nameIn : nullptr)
+    {
+        if (name != nullptr)
+        {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    ~TraceScope()
+    {
+        if (name != nullptr)
+        {
+            Tracer::record(name, start, std::chrono::steady_clock::now());
+        }
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope(TraceScope&&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+    TraceScope& operator=(TraceScope&&) = delete;
+
+  private:
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif /* SRC_TRACE_HPP_ */
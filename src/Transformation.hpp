@@ -8,16 +8,75 @@
 #ifndef SRC_TRANSFORMATION_HPP_
 #define SRC_TRANSFORMATION_HPP_
 
+#include "ConstexprMath.hpp"
 #include "Matrix.hpp"
 #include "Tuple.hpp"
 
-Matrix<4> translation(float x, float y, float z) noexcept;
-Matrix<4> scaling(float x, float y, float z) noexcept;
-Matrix<4> rotationX(float r) noexcept;
-Matrix<4> rotationY(float r) noexcept;
-Matrix<4> rotationZ(float r) noexcept;
-Matrix<4> shearing(float xSuby, float xSubz, float ySubx, float ySubz, float zSubx, float zSuby) noexcept;
-Matrix<4> ViewTransform() noexcept;
-Matrix<4> ViewTransform(const Tuple& from, const Tuple& to, const Tuple& up) noexcept;
+// All transforms are constexpr so constant scene transforms, and products of them, fold away
+
+constexpr Matrix<4> translation(const float x, const float y, const float z) noexcept
+{
+    return Matrix<4>({{{1, 0, 0, x},
+                       {0, 1, 0, y},
+                       {0, 0, 1, z},
+                       {0, 0, 0, 1}}});
+}
+
+constexpr Matrix<4> scaling(const float x, const float y, const float z) noexcept
+{
+    return Matrix<4>({{{x, 0, 0, 0},
+                       {0, y, 0, 0},
+                       {0, 0, z, 0},
+                       {0, 0, 0, 1}}});
+}
+
+constexpr Matrix<4> rotationX(const float r) noexcept
+{
+    return Matrix<4>({{{1, 0, 0, 0},
+                       {0, ConstexprCos(r), -ConstexprSin(r), 0},
+                       {0, ConstexprSin(r), ConstexprCos(r), 0},
+                       {0, 0, 0, 1}}});
+}
+
+constexpr Matrix<4> rotationY(const float r) noexcept
+{
+    return Matrix<4>({{{ConstexprCos(r), 0, ConstexprSin(r), 0},
+                       {0, 1, 0, 0},
+                       {-ConstexprSin(r), 0, ConstexprCos(r), 0},
+                       {0, 0, 0, 1}}});
+}
+
+constexpr Matrix<4> rotationZ(const float r) noexcept
+{
+    return Matrix<4>({{{ConstexprCos(r), -ConstexprSin(r), 0, 0},
+                       {ConstexprSin(r), ConstexprCos(r), 0, 0},
+                       {0, 0, 1, 0},
+                       {0, 0, 0, 1}}});
+}
+
+constexpr Matrix<4> shearing(const float xSuby, const float xSubz, const float ySubx, const float ySubz, const float zSubx, const float zSuby) noexcept
+{
+    return Matrix<4>({{{1, xSuby, xSubz, 0},
+                       {ySubx, 1, ySubz, 0},
+                       {zSubx, zSuby, 1, 0},
+                       {0, 0, 0, 1}}});
+}
+
+constexpr Matrix<4> ViewTransform() noexcept
+{
+    return IdentityMatrix();
+}
+
+constexpr Matrix<4> ViewTransform(const Tuple& from, const Tuple& to, const Tuple& up) noexcept
+{
+    const Tuple forward = (to - from).normalize();
+    const Tuple left = forward.cross(up.normalize());
+    const Tuple trueUp = left.cross(forward);
+    const Matrix<4> orientation({{{left.x, left.y, left.z, 0},
+                                  {trueUp.x, trueUp.y, trueUp.z, 0},
+                                  {-forward.x, -forward.y, -forward.z, 0},
+                                  {0, 0, 0, 1}}});
+    return orientation * translation(-from.x, -from.y, -from.z);
+}
 
 #endif /* SRC_TRANSFORMATION_HPP_ */
@@ -8,9 +8,19 @@
 #ifndef SOURCE_TUPLE_HPP_
 #define SOURCE_TUPLE_HPP_
 
-constexpr float TUPLE_EPSILON = 0.002F; // Changed to be much much higher since it is now being used for acne removal offset; needed to be this high to work
+#include "ConstexprMath.hpp"
 
-class Tuple
+#include <type_traits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+constexpr float TUPLE_EPSILON = 0.0001F; // Comparison tolerance only; intersection tests use INTERSECTION_EPSILON
+
+// Tuple math sits in every inner loop of the renderer, so everything is inline and, where SSE2 is
+// available, done on all four lanes at once. Constant evaluation always takes the scalar path.
+class alignas(16) Tuple
 {
   public:
     float x = 0.0F;
@@ -18,28 +28,187 @@ class Tuple
     float z = 0.0F;
     float w = 0.0F;
 
-    Tuple() noexcept = default;
-    Tuple(float xIn, float yIn, float zIn, float wIn) noexcept; // : x(xIn), y(yIn), z(zIn), w(wIn) {};
+    constexpr Tuple() noexcept = default;
+    constexpr Tuple(float xIn, float yIn, float zIn, float wIn) noexcept : x(xIn), y(yIn), z(zIn), w(wIn) {}
 
     // Operator overloads
-    bool operator==(const Tuple& other) const noexcept;
-    bool operator!=(const Tuple& other) const noexcept;
-    Tuple operator+(const Tuple& other) const noexcept;
-    Tuple operator-(const Tuple& other) const noexcept;
-    Tuple operator-() const noexcept;
-    Tuple operator*(float s) const noexcept;
-    Tuple operator/(float s) const noexcept;
-
-    [[nodiscard]] bool IsPoint() const noexcept;
-    [[nodiscard]] bool IsVector() const noexcept;
-    [[nodiscard]] float magnitude() const noexcept;
-    [[nodiscard]] Tuple normalize() const noexcept;
-    [[nodiscard]] float dot(const Tuple& other) const noexcept;
-    [[nodiscard]] Tuple cross(const Tuple& other) const noexcept;
-    [[nodiscard]] Tuple reflect(const Tuple& normal) const noexcept;
+    constexpr bool operator==(const Tuple& other) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            return _mm_movemask_ps(_mm_cmplt_ps(Abs(_mm_sub_ps(lanes(), other.lanes())), _mm_set1_ps(TUPLE_EPSILON))) == 0xF;
+        }
+#endif
+        return (Abs(x - other.x) < TUPLE_EPSILON &&
+                Abs(y - other.y) < TUPLE_EPSILON &&
+                Abs(z - other.z) < TUPLE_EPSILON &&
+                Abs(w - other.w) < TUPLE_EPSILON);
+    }
+
+    constexpr bool operator!=(const Tuple& other) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            return _mm_movemask_ps(_mm_cmpgt_ps(Abs(_mm_sub_ps(lanes(), other.lanes())), _mm_set1_ps(TUPLE_EPSILON))) != 0;
+        }
+#endif
+        return (Abs(x - other.x) > TUPLE_EPSILON ||
+                Abs(y - other.y) > TUPLE_EPSILON ||
+                Abs(z - other.z) > TUPLE_EPSILON ||
+                Abs(w - other.w) > TUPLE_EPSILON);
+    }
+
+    constexpr Tuple operator+(const Tuple& other) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            return Tuple(_mm_add_ps(lanes(), other.lanes()));
+        }
+#endif
+        return {x + other.x, y + other.y, z + other.z, w + other.w};
+    }
+
+    constexpr Tuple operator-(const Tuple& other) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            return Tuple(_mm_sub_ps(lanes(), other.lanes()));
+        }
+#endif
+        return {x - other.x, y - other.y, z - other.z, w - other.w};
+    }
+
+    constexpr Tuple operator-() const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            return Tuple(_mm_xor_ps(lanes(), _mm_set1_ps(-0.0F)));
+        }
+#endif
+        return {-x, -y, -z, -w};
+    }
+
+    constexpr Tuple operator*(const float s) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            return Tuple(_mm_mul_ps(lanes(), _mm_set1_ps(s)));
+        }
+#endif
+        return {x * s, y * s, z * s, w * s};
+    }
+
+    constexpr Tuple operator/(const float s) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            return Tuple(_mm_div_ps(lanes(), _mm_set1_ps(s)));
+        }
+#endif
+        return {x / s, y / s, z / s, w / s};
+    }
+
+    [[nodiscard]] constexpr bool IsPoint() const noexcept
+    {
+        return Abs(w - 1.0F) < TUPLE_EPSILON;
+    }
+
+    [[nodiscard]] constexpr bool IsVector() const noexcept
+    {
+        return Abs(w) < TUPLE_EPSILON;
+    }
+
+    [[nodiscard]] constexpr float magnitude() const noexcept
+    {
+        return ConstexprSqrt(dot(*this));
+    }
+
+    [[nodiscard]] constexpr Tuple normalize() const noexcept
+    {
+        const float mag = magnitude();
+        return mag != 0.0F ? *this / mag : Tuple(0.0F, 0.0F, 0.0F, 0.0F);
+    }
+
+    [[nodiscard]] constexpr float dot(const Tuple& other) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            // Horizontal sum of the products: swap pairs, add, then swap halves and add again
+            const __m128 products = _mm_mul_ps(lanes(), other.lanes());
+            const __m128 pairs = _mm_add_ps(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1)));
+            return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_movehl_ps(pairs, pairs)));
+        }
+#endif
+        return x * other.x + y * other.y + z * other.z + w * other.w;
+    }
+
+    [[nodiscard]] constexpr Tuple cross(const Tuple& other) const noexcept
+    {
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated())
+        {
+            // a.yzx * b.zxy - a.zxy * b.yzx; the w lanes cancel to zero
+            const __m128 a = lanes();
+            const __m128 b = other.lanes();
+            const __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+            const __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+            const __m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+            return Tuple(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+        }
+#endif
+        return {y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x, 0.0F};
+    }
+
+    [[nodiscard]] constexpr Tuple reflect(const Tuple& normal) const noexcept
+    {
+        return *this - normal * 2 * dot(normal);
+    }
+
+  private:
+    static constexpr float Abs(const float value) noexcept
+    {
+        return value < 0.0F ? -value : value;
+    }
+
+#ifdef __SSE2__
+    explicit Tuple(const __m128 value) noexcept
+    {
+        alignas(16) float lane[4];
+        _mm_store_ps(lane, value);
+        x = lane[0];
+        y = lane[1];
+        z = lane[2];
+        w = lane[3];
+    }
+
+    [[nodiscard]] __m128 lanes() const noexcept
+    {
+        return _mm_set_ps(w, z, y, x);
+    }
+
+    static __m128 Abs(const __m128 value) noexcept
+    {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0F), value);
+    }
+#endif
 };
 
-Tuple Point(float xIn, float yIn, float zIn) noexcept;
-Tuple Vector(float xIn, float yIn, float zIn) noexcept;
+constexpr Tuple Point(float xIn, float yIn, float zIn) noexcept
+{
+    return {xIn, yIn, zIn, 1.0F};
+}
+
+constexpr Tuple Vector(float xIn, float yIn, float zIn) noexcept
+{
+    return {xIn, yIn, zIn, 0.0F};
+}
 
 #endif /* SOURCE_TUPLE_HPP_ */
@@ -0,0 +1,223 @@
+/*
+ * UniformGrid.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "UniformGrid.hpp"
+#include "Ray.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void UniformGrid::build(std::span<const BoundingBox> primitiveBounds, const float density)
+{
+    clear();
+    isBuilt = true;
+
+    for (uint32_t i = 0; i < primitiveBounds.size(); i++)
+    {
+        if (primitiveBounds[i].bounded())
+        {
+            gridBounds.add(primitiveBounds[i]);
+        } else if (!primitiveBounds[i].empty())
+        {
+            unbounded.push_back(i);
+        }
+    }
+    if (gridBounds.empty())
+    {
+        return;
+    }
+
+    // Pick a cubic cell size giving roughly density cells per primitive. Flat or thin scenes would
+    // give a zero volume, so every extent is kept to at least a small fraction of the largest.
+    const Tuple extent = gridBounds.maximum - gridBounds.minimum;
+    const float largestExtent = std::max({extent.x, extent.y, extent.z, std::numeric_limits<float>::min()});
+    const std::array<float, 3> extents = {std::max(extent.x, largestExtent * 0.001F),
+                                          std::max(extent.y, largestExtent * 0.001F),
+                                          std::max(extent.z, largestExtent * 0.001F)};
+    const auto primitiveCount = static_cast<float>(primitiveBounds.size() - unbounded.size());
+    const float cellSide = std::cbrt(extents[0] * extents[1] * extents[2] / (density * primitiveCount));
+    std::array<float, 3> sizes{};
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        cells[axis] = std::clamp(static_cast<uint32_t>(std::ceil(extents[axis] / cellSide)), 1U, MAXIMUM_RESOLUTION);
+        sizes[axis] = extents[axis] / static_cast<float>(cells[axis]);
+    }
+    cellSize = Vector(sizes[0], sizes[1], sizes[2]);
+    inverseCellSize = Vector(1.0F / sizes[0], 1.0F / sizes[1], 1.0F / sizes[2]);
+
+    // Cell ranges are padded slightly so a primitive touching a cell boundary is registered on
+    // both sides of it and rounding during traversal can never skip it
+    const auto primitives = static_cast<int64_t>(primitiveBounds.size());
+    const Tuple padding = cellSize * 0.001F;
+    std::vector<std::array<uint32_t, 6>> ranges(primitiveBounds.size());
+    const uint32_t cellCount = cells[0] * cells[1] * cells[2];
+    cellStart.assign(cellCount + 1, 0);
+
+#pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < primitives; i++)
+    {
+        const BoundingBox& box = primitiveBounds[static_cast<size_t>(i)];
+        if (!box.bounded())
+        {
+            continue;
+        }
+        const std::array<uint32_t, 3> low = cellOf(box.minimum - padding);
+        const std::array<uint32_t, 3> high = cellOf(box.maximum + padding);
+        ranges[static_cast<size_t>(i)] = {low[0], low[1], low[2], high[0], high[1], high[2]};
+        for (uint32_t z = low[2]; z <= high[2]; z++)
+        {
+            for (uint32_t y = low[1]; y <= high[1]; y++)
+            {
+                for (uint32_t x = low[0]; x <= high[0]; x++)
+                {
+                    uint32_t& count = cellStart[cellIndex(x, y, z) + 1];
+#pragma omp atomic
+                    count++;
+                }
+            }
+        }
+    }
+
+    for (uint32_t cell = 0; cell < cellCount; cell++)
+    {
+        cellStart[cell + 1] += cellStart[cell];
+    }
+
+    cellPrimitives.resize(cellStart[cellCount]);
+    std::vector<uint32_t> cursor(cellStart.begin(), cellStart.end() - 1);
+
+#pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < primitives; i++)
+    {
+        if (!primitiveBounds[static_cast<size_t>(i)].bounded())
+        {
+            continue;
+        }
+        const std::array<uint32_t, 6>& range = ranges[static_cast<size_t>(i)];
+        for (uint32_t z = range[2]; z <= range[5]; z++)
+        {
+            for (uint32_t y = range[1]; y <= range[4]; y++)
+            {
+                for (uint32_t x = range[0]; x <= range[3]; x++)
+                {
+                    uint32_t slot = 0;
+                    uint32_t& next = cursor[cellIndex(x, y, z)];
+#pragma omp atomic capture
+                    slot = next++;
+                    cellPrimitives[slot] = static_cast<uint32_t>(i);
+                }
+            }
+        }
+    }
+}
+
+void UniformGrid::clear() noexcept
+{
+    gridBounds = BoundingBox();
+    cells = {};
+    cellStart.clear();
+    cellPrimitives.clear();
+    unbounded.clear();
+    isBuilt = false;
+}
+
+bool UniformGrid::built() const noexcept
+{
+    return isBuilt;
+}
+
+std::array<uint32_t, 3> UniformGrid::resolution() const noexcept
+{
+    return cells;
+}
+
+const BoundingBox& UniformGrid::bounds() const noexcept
+{
+    return gridBounds;
+}
+
+ArenaVector<uint32_t> UniformGrid::candidates(const Ray& r) const noexcept
+{
+    ArenaVector<uint32_t> found(unbounded.begin(), unbounded.end());
+
+    const auto span = gridBounds.empty() ? std::nullopt : gridBounds.intersect(r);
+    if (!span)
+    {
+        return found;
+    }
+
+    // 3D-DDA from where the line enters the grid to where it leaves
+    const auto [tEnter, tExit] = *span;
+    std::array<uint32_t, 3> cell = cellOf(r.cast(tEnter));
+    const std::array<float, 3> origin = {r.origin.x, r.origin.y, r.origin.z};
+    const std::array<float, 3> direction = {r.direction.x, r.direction.y, r.direction.z};
+    const std::array<float, 3> lower = {gridBounds.minimum.x, gridBounds.minimum.y, gridBounds.minimum.z};
+    const std::array<float, 3> size = {cellSize.x, cellSize.y, cellSize.z};
+    std::array<int32_t, 3> step{};
+    std::array<float, 3> tNext{};
+    std::array<float, 3> tDelta{};
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        if (direction[axis] > 0.0F)
+        {
+            step[axis] = 1;
+            tNext[axis] = (lower[axis] + static_cast<float>(cell[axis] + 1) * size[axis] - origin[axis]) / direction[axis];
+            tDelta[axis] = size[axis] / direction[axis];
+        } else if (direction[axis] < 0.0F)
+        {
+            step[axis] = -1;
+            tNext[axis] = (lower[axis] + static_cast<float>(cell[axis]) * size[axis] - origin[axis]) / direction[axis];
+            tDelta[axis] = -size[axis] / direction[axis];
+        } else
+        {
+            tNext[axis] = std::numeric_limits<float>::infinity();
+            tDelta[axis] = std::numeric_limits<float>::infinity();
+        }
+    }
+
+    while (true)
+    {
+        const uint32_t index = cellIndex(cell[0], cell[1], cell[2]);
+        found.insert(found.end(), cellPrimitives.begin() + cellStart[index], cellPrimitives.begin() + cellStart[index + 1]);
+
+        uint32_t axis = tNext[0] < tNext[1] ? 0 : 1;
+        axis = tNext[2] < tNext[axis] ? 2 : axis;
+        if (tNext[axis] > tExit)
+        {
+            break;
+        }
+        const int64_t nextCell = static_cast<int64_t>(cell[axis]) + step[axis];
+        if (nextCell < 0 || nextCell >= static_cast<int64_t>(cells[axis]))
+        {
+            break;
+        }
+        cell[axis] = static_cast<uint32_t>(nextCell);
+        tNext[axis] += tDelta[axis];
+    }
+
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    return found;
+}
+
+std::array<uint32_t, 3> UniformGrid::cellOf(const Tuple& point) const noexcept
+{
+    const Tuple relative = point - gridBounds.minimum;
+    const std::array<float, 3> scaled = {relative.x * inverseCellSize.x, relative.y * inverseCellSize.y, relative.z * inverseCellSize.z};
+    std::array<uint32_t, 3> cell{};
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        cell[axis] = static_cast<uint32_t>(std::clamp(scaled[axis], 0.0F, static_cast<float>(cells[axis] - 1)));
+    }
+    return cell;
+}
+
+uint32_t UniformGrid::cellIndex(const uint32_t x, const uint32_t y, const uint32_t z) const noexcept
+{
+    return (z * cells[1] + y) * cells[0] + x;
+}
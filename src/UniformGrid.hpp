@@ -0,0 +1,56 @@
+/*
+ * UniformGrid.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_UNIFORMGRID_HPP_
+#define SRC_UNIFORMGRID_HPP_
+
+#include "Arena.hpp"
+#include "BoundingBox.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class Ray;
+
+// Buckets primitives, identified by their index in the bounds passed to build(), into a regular
+// grid of cells. Building is two linear passes (count, then fill) with no sorting, so it is cheap
+// enough to redo every frame for dynamic geometry; it pays off for dense, evenly spread
+// primitives such as scanned triangle meshes. Unbounded primitives cannot be bucketed and are
+// returned as candidates for every ray.
+class UniformGrid
+{
+  public:
+    // Cells per primitive the grid resolution aims for
+    constexpr static float DEFAULT_DENSITY = 2.0F;
+    constexpr static uint32_t MAXIMUM_RESOLUTION = 256;
+
+    void build(std::span<const BoundingBox> primitiveBounds, float density = DEFAULT_DENSITY);
+    void clear() noexcept;
+    [[nodiscard]] bool built() const noexcept;
+    [[nodiscard]] std::array<uint32_t, 3> resolution() const noexcept;
+    [[nodiscard]] const BoundingBox& bounds() const noexcept;
+    // Sorted, unique indices of every primitive that could be hit anywhere along the line of r,
+    // including behind its origin, since group intersections must report every hit
+    [[nodiscard]] ArenaVector<uint32_t> candidates(const Ray& r) const noexcept;
+
+  private:
+    BoundingBox gridBounds;
+    std::array<uint32_t, 3> cells{};
+    Tuple cellSize;
+    Tuple inverseCellSize;
+    std::vector<uint32_t> cellStart; // Offsets into cellPrimitives, one past the end for the last cell
+    std::vector<uint32_t> cellPrimitives;
+    std::vector<uint32_t> unbounded;
+    bool isBuilt = false;
+
+    [[nodiscard]] std::array<uint32_t, 3> cellOf(const Tuple& point) const noexcept;
+    [[nodiscard]] uint32_t cellIndex(uint32_t x, uint32_t y, uint32_t z) const noexcept;
+};
+
+#endif /* SRC_UNIFORMGRID_HPP_ */
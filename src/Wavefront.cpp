@@ -0,0 +1,130 @@
+/*
+ * Wavefront.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Wavefront.hpp"
+#include "Camera.hpp"
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+
+void WavefrontRenderer::RenderTile(const Camera& camera, const uint32_t xBegin, const uint32_t yBegin, const uint32_t xEnd, const uint32_t yEnd, Canvas& image) const noexcept
+{
+    const uint32_t tileWidth = xEnd - xBegin;
+    const uint32_t tileHeight = yEnd - yBegin;
+    std::vector<Color> accumulated(static_cast<size_t>(tileWidth) * tileHeight, Color::Black);
+
+    // Each of a pixel's samples is a ray of its own, weighted so that they add up to the average
+    const uint32_t samples = std::max(camera.samplesPerPixel, 1U);
+    const float sampleWeight = 1.0F / static_cast<float>(samples);
+    std::vector<WavefrontRay> queue;
+    queue.reserve(accumulated.size() * samples);
+    for (uint32_t y = yBegin; y < yEnd; y++)
+    {
+        for (uint32_t x = xBegin; x < xEnd; x++)
+        {
+            for (uint32_t sample = 0; sample < samples; sample++)
+            {
+                queue.push_back({camera.rayForSample(x, y, sample), sampleWeight, (y - yBegin) * tileWidth + (x - xBegin), MAXIMUM_RAY_DEPTH, std::nullopt});
+            }
+        }
+    }
+
+    std::minstd_rand rouletteGenerator(yBegin * camera.hSize + xBegin + 1);
+    std::vector<WavefrontRay> nextQueue;
+    std::vector<WavefrontHit> hits;
+    std::vector<uint32_t> shadingOrder;
+    std::vector<uint32_t> materialKeys;
+    std::unordered_map<const Material*, uint32_t> firstHits;
+    std::vector<uint8_t> shadowed;
+    while (!queue.empty())
+    {
+        IntersectStage(queue, hits);
+
+        // Shade hits grouped by material so consecutive shading calls touch the same data. Materials
+        // are ordered by their first hit in the queue rather than by address, which would change from
+        // run to run, and with it the order roulette draws its numbers in.
+        firstHits.clear();
+        materialKeys.resize(hits.size());
+        for (size_t i = 0; i < hits.size(); i++)
+        {
+            materialKeys[i] = firstHits.try_emplace(&hits[i].details.object.material, static_cast<uint32_t>(firstHits.size())).first->second;
+        }
+        shadingOrder.resize(hits.size());
+        std::iota(shadingOrder.begin(), shadingOrder.end(), 0);
+        std::stable_sort(shadingOrder.begin(), shadingOrder.end(), [&materialKeys](const uint32_t a, const uint32_t b) {
+            return materialKeys[a] < materialKeys[b];
+        });
+
+        ShadowStage(hits, shadingOrder, shadowed);
+
+        nextQueue.clear();
+        for (const uint32_t index : shadingOrder)
+        {
+            const WavefrontHit& hit = hits[index];
+            const IntersectionDetails& id = hit.details;
+            const Color surface = id.object.material.light(world.light, id.point, id.eyeVector, id.normalVector, shadowed[index] != 0, id.footprint(), id.textureCoordinates);
+            accumulated[hit.pixel] = accumulated[hit.pixel] + surface * hit.throughput;
+
+            if (hit.remainingCalls < 1)
+            {
+                continue;
+            }
+            for (const auto& branch : {World::reflectionBranch(id), World::refractionBranch(id)})
+            {
+                if (!branch)
+                {
+                    continue;
+                }
+                const std::optional<float> throughput = world.rayTree.survivingThroughput(hit.throughput * branch->weight, rouletteGenerator);
+                if (throughput)
+                {
+                    nextQueue.push_back({branch->ray, *throughput, hit.pixel, hit.remainingCalls - 1, branch->kind});
+                }
+            }
+        }
+        std::swap(queue, nextQueue);
+    }
+
+    for (uint32_t y = 0; y < tileHeight; y++)
+    {
+        for (uint32_t x = 0; x < tileWidth; x++)
+        {
+            image.pixels[yBegin + y][xBegin + x] = accumulated[y * tileWidth + x];
+        }
+    }
+}
+
+void WavefrontRenderer::IntersectStage(const std::vector<WavefrontRay>& queue, std::vector<WavefrontHit>& hits) const noexcept
+{
+    hits.clear();
+    for (const WavefrontRay& pending : queue)
+    {
+        if (pending.kind)
+        {
+            CountStatistic(*pending.kind);
+        }
+        // The intersection list and precomputeDetails' temporaries are released as soon as the hit is copied out
+        const ArenaScope arenaScope;
+        const Intersections intersections = world.intersect(pending.ray.ray);
+        const auto hit = Ray::hit(intersections);
+        if (hit)
+        {
+            hits.push_back({pending.ray.ray.precomputeDetails(*hit, intersections, pending.ray.differential), pending.throughput, pending.pixel, pending.remainingCalls});
+        }
+    }
+}
+
+void WavefrontRenderer::ShadowStage(const std::vector<WavefrontHit>& hits, const std::vector<uint32_t>& shadingOrder, std::vector<uint8_t>& shadowed) const noexcept
+{
+    shadowed.resize(hits.size());
+    for (const uint32_t index : shadingOrder)
+    {
+        const ArenaScope arenaScope;
+        shadowed[index] = world.isShadowed(hits[index].details.overPoint) ? 1 : 0;
+    }
+}
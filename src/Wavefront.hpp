@@ -0,0 +1,57 @@
+/*
+ * Wavefront.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_WAVEFRONT_HPP_
+#define SRC_WAVEFRONT_HPP_
+
+#include "Canvas.hpp"
+#include "Ray.hpp"
+#include "World.hpp"
+#include <optional>
+#include <vector>
+
+class Camera;
+
+// A ray waiting in a wavefront queue, tagged with the tile pixel it contributes to
+class WavefrontRay
+{
+  public:
+    DifferentialRay ray;
+    float throughput;
+    uint32_t pixel;
+    int remainingCalls;
+    std::optional<RenderStatistics::Counter> kind; // None for camera rays, counted as they are cast
+};
+
+// A queued ray that hit something, with everything the shading stage needs
+class WavefrontHit
+{
+  public:
+    IntersectionDetails details;
+    float throughput;
+    uint32_t pixel;
+    int remainingCalls;
+};
+
+// Breadth-first alternative to World::colorAt. All primary rays of a tile are generated into a
+// queue, the whole queue is intersected, hits are sorted by material and shadow-tested in bulk,
+// and the surviving reflection/refraction rays form the queue for the next bounce.
+class WavefrontRenderer
+{
+  public:
+    explicit WavefrontRenderer(const World& worldIn) noexcept : world(worldIn){};
+
+    void RenderTile(const Camera& camera, uint32_t xBegin, uint32_t yBegin, uint32_t xEnd, uint32_t yEnd, Canvas& image) const noexcept;
+
+  private:
+    const World& world;
+
+    void IntersectStage(const std::vector<WavefrontRay>& queue, std::vector<WavefrontHit>& hits) const noexcept;
+    void ShadowStage(const std::vector<WavefrontHit>& hits, const std::vector<uint32_t>& shadingOrder, std::vector<uint8_t>& shadowed) const noexcept;
+};
+
+#endif /* SRC_WAVEFRONT_HPP_ */
@@ -0,0 +1,266 @@
+/*
+ * WideBoundingVolumeHierarchy.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "WideBoundingVolumeHierarchy.hpp"
+#include "Ray.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+float WideBVHNode::step(const uint32_t axis) const noexcept
+{
+    // Exponents are kept within the normal range, so this is the bit pattern of 2^exponent
+    return std::bit_cast<float>(static_cast<uint32_t>(exponent[axis] + std::numeric_limits<float>::max_exponent - 1) << 23U);
+}
+
+BoundingBox WideBVHNode::childBounds(const uint32_t i) const noexcept
+{
+    return {Point(origin[0] + static_cast<float>(lowerX[i]) * step(0),
+                  origin[1] + static_cast<float>(lowerY[i]) * step(1),
+                  origin[2] + static_cast<float>(lowerZ[i]) * step(2)),
+            Point(origin[0] + static_cast<float>(upperX[i]) * step(0),
+                  origin[1] + static_cast<float>(upperY[i]) * step(1),
+                  origin[2] + static_cast<float>(upperZ[i]) * step(2))};
+}
+
+uint32_t WideBVHNode::intersectChildren(const Ray& r) const noexcept
+{
+    // Zero direction components are nudged to a tiny value so no slab ever computes 0 * infinity
+    const auto inverse = [](const float d) {
+        constexpr float tiny = 1e-20F;
+        return 1.0F / (std::abs(d) < tiny ? std::copysign(tiny, d) : d);
+    };
+    const std::array<float, 3> rayOrigin = {r.origin.x, r.origin.y, r.origin.z};
+    const std::array<float, 3> inverseDirection = {inverse(r.direction.x), inverse(r.direction.y), inverse(r.direction.z)};
+    const std::array<const std::array<uint8_t, WIDTH>*, 3> lowers = {&lowerX, &lowerY, &lowerZ};
+    const std::array<const std::array<uint8_t, WIDTH>*, 3> uppers = {&upperX, &upperY, &upperZ};
+
+    uint32_t mask = 0;
+#ifdef __SSE2__
+    const auto dequantize = [&](const std::array<uint8_t, WIDTH>& quantized, const uint32_t axis) {
+        int32_t packed = 0;
+        std::memcpy(&packed, quantized.data(), sizeof(packed));
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i widened = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+        return _mm_add_ps(_mm_set1_ps(origin[axis]), _mm_mul_ps(_mm_cvtepi32_ps(widened), _mm_set1_ps(step(axis))));
+    };
+
+    __m128 tNear = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+    __m128 tFar = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        const __m128 o = _mm_set1_ps(rayOrigin[axis]);
+        const __m128 inverseD = _mm_set1_ps(inverseDirection[axis]);
+        const __m128 t0 = _mm_mul_ps(_mm_sub_ps(dequantize(*lowers[axis], axis), o), inverseD);
+        const __m128 t1 = _mm_mul_ps(_mm_sub_ps(dequantize(*uppers[axis], axis), o), inverseD);
+        tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+        tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+    }
+    mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)));
+#else
+    for (uint32_t i = 0; i < WIDTH; i++)
+    {
+        float tNear = -std::numeric_limits<float>::infinity();
+        float tFar = std::numeric_limits<float>::infinity();
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            const float t0 = (origin[axis] + static_cast<float>((*lowers[axis])[i]) * step(axis) - rayOrigin[axis]) * inverseDirection[axis];
+            const float t1 = (origin[axis] + static_cast<float>((*uppers[axis])[i]) * step(axis) - rayOrigin[axis]) * inverseDirection[axis];
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+        }
+        mask |= tNear <= tFar ? 1U << i : 0U;
+    }
+#endif
+    return mask & ((1U << childCount) - 1U);
+}
+
+const BVHStatistics& WideBoundingVolumeHierarchy::build(std::span<const BoundingBox> primitiveBounds)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    clear();
+    isBuilt = true;
+
+    BoundingVolumeHierarchy binary;
+    buildStatistics = binary.build(primitiveBounds);
+    primitiveIndices = binary.primitives();
+    unbounded = binary.unboundedPrimitives();
+    if (!binary.nodes().empty())
+    {
+        nodeList.reserve(binary.nodes().size());
+        collapse(binary.nodes(), 0);
+    }
+
+    buildStatistics.buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return buildStatistics;
+}
+
+void WideBoundingVolumeHierarchy::clear() noexcept
+{
+    nodeList.clear();
+    primitiveIndices.clear();
+    unbounded.clear();
+    buildStatistics = BVHStatistics();
+    isBuilt = false;
+}
+
+bool WideBoundingVolumeHierarchy::built() const noexcept
+{
+    return isBuilt;
+}
+
+const std::vector<WideBVHNode>& WideBoundingVolumeHierarchy::nodes() const noexcept
+{
+    return nodeList;
+}
+
+const std::vector<uint32_t>& WideBoundingVolumeHierarchy::primitives() const noexcept
+{
+    return primitiveIndices;
+}
+
+const BVHStatistics& WideBoundingVolumeHierarchy::statistics() const noexcept
+{
+    return buildStatistics;
+}
+
+ArenaVector<uint32_t> WideBoundingVolumeHierarchy::candidates(const Ray& r) const noexcept
+{
+    ArenaVector<uint32_t> found(unbounded.begin(), unbounded.end());
+    if (nodeList.empty())
+    {
+        return found;
+    }
+
+    ArenaVector<uint32_t> stack;
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const WideBVHNode& node = nodeList[stack.back()];
+        stack.pop_back();
+        for (uint32_t hits = node.intersectChildren(r); hits != 0; hits &= hits - 1)
+        {
+            const auto i = static_cast<uint32_t>(std::countr_zero(hits));
+            if (node.isLeaf(i))
+            {
+                found.insert(found.end(), primitiveIndices.begin() + node.child[i], primitiveIndices.begin() + node.child[i] + node.leafCount[i]);
+            } else
+            {
+                stack.push_back(node.child[i]);
+            }
+        }
+    }
+
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+uint32_t WideBoundingVolumeHierarchy::collapse(const std::vector<BVHNode>& binaryNodes, const uint32_t binaryIndex)
+{
+    const auto wideIndex = static_cast<uint32_t>(nodeList.size());
+    nodeList.emplace_back();
+
+    // Open interior children, largest first, until there are four or only leaves remain
+    const BVHNode& parent = binaryNodes[binaryIndex];
+    std::vector<uint32_t> children;
+    if (parent.isLeaf())
+    {
+        children.push_back(binaryIndex);
+    } else
+    {
+        children = {parent.first, parent.first + 1};
+    }
+    while (children.size() < WideBVHNode::WIDTH)
+    {
+        auto largest = children.end();
+        for (auto child = children.begin(); child != children.end(); child++)
+        {
+            if (!binaryNodes[*child].isLeaf() &&
+                (largest == children.end() || binaryNodes[*child].bounds.surfaceArea() > binaryNodes[*largest].bounds.surfaceArea()))
+            {
+                largest = child;
+            }
+        }
+        if (largest == children.end())
+        {
+            break;
+        }
+        const uint32_t opened = binaryNodes[*largest].first;
+        *largest = opened;
+        children.push_back(opened + 1);
+    }
+
+    // Quantize against the parent bounds. Each step is the smallest power of two that lets 255 of
+    // them span the parent, and every child bound is then rounded outwards to a whole step.
+    WideBVHNode node;
+    node.childCount = static_cast<uint8_t>(children.size());
+    const std::array<float, 3> lower = {parent.bounds.minimum.x, parent.bounds.minimum.y, parent.bounds.minimum.z};
+    const std::array<float, 3> upper = {parent.bounds.maximum.x, parent.bounds.maximum.y, parent.bounds.maximum.z};
+    constexpr int32_t minimumExponent = std::numeric_limits<float>::min_exponent;
+    constexpr int32_t maximumExponent = std::numeric_limits<int8_t>::max();
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        const float extent = upper[axis] - lower[axis];
+        int32_t exponent = extent > 0.0F ? static_cast<int32_t>(std::ceil(std::log2(extent / 255.0F))) : minimumExponent;
+        exponent = std::clamp(exponent, minimumExponent, maximumExponent);
+        while (lower[axis] + 255.0F * std::ldexp(1.0F, exponent) < upper[axis] && exponent < maximumExponent)
+        {
+            exponent++;
+        }
+        node.origin[axis] = lower[axis];
+        node.exponent[axis] = static_cast<int8_t>(exponent);
+    }
+
+    const std::array<std::array<uint8_t, WideBVHNode::WIDTH>*, 3> lowers = {&node.lowerX, &node.lowerY, &node.lowerZ};
+    const std::array<std::array<uint8_t, WideBVHNode::WIDTH>*, 3> uppers = {&node.upperX, &node.upperY, &node.upperZ};
+    for (uint32_t i = 0; i < children.size(); i++)
+    {
+        const BoundingBox& bounds = binaryNodes[children[i]].bounds;
+        const std::array<float, 3> childLower = {bounds.minimum.x, bounds.minimum.y, bounds.minimum.z};
+        const std::array<float, 3> childUpper = {bounds.maximum.x, bounds.maximum.y, bounds.maximum.z};
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            const float step = node.step(axis);
+            const auto decode = [&](const uint32_t q) {
+                return node.origin[axis] + static_cast<float>(q) * step;
+            };
+            auto qLower = static_cast<uint32_t>(std::clamp(std::floor((childLower[axis] - node.origin[axis]) / step), 0.0F, 255.0F));
+            while (qLower > 0 && decode(qLower) > childLower[axis])
+            {
+                qLower--;
+            }
+            auto qUpper = static_cast<uint32_t>(std::clamp(std::ceil((childUpper[axis] - node.origin[axis]) / step), 0.0F, 255.0F));
+            while (qUpper < 255 && decode(qUpper) < childUpper[axis])
+            {
+                qUpper++;
+            }
+            (*lowers[axis])[i] = static_cast<uint8_t>(qLower);
+            (*uppers[axis])[i] = static_cast<uint8_t>(qUpper);
+        }
+
+        const BVHNode& binaryChild = binaryNodes[children[i]];
+        if (binaryChild.isLeaf())
+        {
+            node.leafCount[i] = static_cast<uint8_t>(binaryChild.count);
+            node.child[i] = binaryChild.first;
+        } else
+        {
+            node.child[i] = collapse(binaryNodes, children[i]);
+        }
+    }
+
+    nodeList[wideIndex] = node;
+    return wideIndex;
+}
@@ -0,0 +1,81 @@
+/*
+ * WideBoundingVolumeHierarchy.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#ifndef SRC_WIDEBOUNDINGVOLUMEHIERARCHY_HPP_
+#define SRC_WIDEBOUNDINGVOLUMEHIERARCHY_HPP_
+
+#include "Arena.hpp"
+#include "BoundingBox.hpp"
+#include "BoundingVolumeHierarchy.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class Ray;
+
+// One cache line holding up to four children. Child bounds are stored as 8 bit offsets from the
+// node's origin in steps of a power of two per axis, rounded outwards so they always contain the
+// exact bounds; a few false positives are the price of fitting all four in a line.
+class alignas(64) WideBVHNode
+{
+  public:
+    constexpr static uint32_t WIDTH = 4;
+
+    std::array<float, 3> origin = {0.0F, 0.0F, 0.0F};
+    std::array<int8_t, 3> exponent = {0, 0, 0}; // Each axis steps by 2^exponent
+    uint8_t childCount = 0;
+    std::array<uint8_t, WIDTH> leafCount = {0, 0, 0, 0}; // Zero for interior children
+    std::array<uint8_t, WIDTH> lowerX = {0, 0, 0, 0};
+    std::array<uint8_t, WIDTH> lowerY = {0, 0, 0, 0};
+    std::array<uint8_t, WIDTH> lowerZ = {0, 0, 0, 0};
+    std::array<uint8_t, WIDTH> upperX = {0, 0, 0, 0};
+    std::array<uint8_t, WIDTH> upperY = {0, 0, 0, 0};
+    std::array<uint8_t, WIDTH> upperZ = {0, 0, 0, 0};
+    std::array<uint32_t, WIDTH> child = {0, 0, 0, 0}; // Leaves: first entry in the primitive list; interior: node index
+
+    [[nodiscard]] bool isLeaf(uint32_t i) const noexcept { return leafCount[i] > 0; }
+    [[nodiscard]] float step(uint32_t axis) const noexcept;
+    // The conservative bounds child i is tested against
+    [[nodiscard]] BoundingBox childBounds(uint32_t i) const noexcept;
+    // Bit i is set if the line of r passes through child i
+    [[nodiscard]] uint32_t intersectChildren(const Ray& r) const noexcept;
+};
+
+static_assert(sizeof(WideBVHNode) == 64);
+
+// A BoundingVolumeHierarchy collapsed into four wide nodes. Each node replaces up to three levels
+// of the binary tree, always opening the child with the largest surface area first, so traversal
+// visits far fewer nodes and tests all children of one with a single set of SIMD slab tests.
+class WideBoundingVolumeHierarchy
+{
+  public:
+    // Builds the binary hierarchy, collapses it and discards it. The statistics are those of the
+    // binary hierarchy, but the build time includes the collapse.
+    const BVHStatistics& build(std::span<const BoundingBox> primitiveBounds);
+    void clear() noexcept;
+    [[nodiscard]] bool built() const noexcept;
+    [[nodiscard]] const std::vector<WideBVHNode>& nodes() const noexcept;
+    // Bounded primitives in leaf order; a leaf child covers leafCount entries from its child index
+    [[nodiscard]] const std::vector<uint32_t>& primitives() const noexcept;
+    [[nodiscard]] const BVHStatistics& statistics() const noexcept;
+    // Sorted indices of every primitive in a leaf the line of r passes through, including behind its
+    // origin, since group intersections must report every hit
+    [[nodiscard]] ArenaVector<uint32_t> candidates(const Ray& r) const noexcept;
+
+  private:
+    std::vector<WideBVHNode> nodeList;
+    std::vector<uint32_t> primitiveIndices;
+    std::vector<uint32_t> unbounded;
+    BVHStatistics buildStatistics;
+    bool isBuilt = false;
+
+    uint32_t collapse(const std::vector<BVHNode>& binaryNodes, uint32_t binaryIndex);
+};
+
+#endif /* SRC_WIDEBOUNDINGVOLUMEHIERARCHY_HPP_ */
@@ -6,9 +6,16 @@
  */
 
 #include "World.hpp"
+#include "Camera.hpp"
+#include "Statistics.hpp"
+#include "Trace.hpp"
 #include "Transformation.hpp"
 #include <algorithm>
+#include <bit>
 #include <cmath>
+#include <utility>
+
+static uint32_t rouletteSeed(const Ray& r) noexcept;
 
 World World::BaseWorld() noexcept
 {
@@ -56,29 +63,131 @@ std::vector<std::reference_wrapper<const Shape>> World::objects() const noexcept
     {
         objects.emplace_back(std::ref(group));
     }
+    for (const Instance& instance : instances)
+    {
+        objects.emplace_back(std::ref(instance));
+    }
 
     return objects;
 }
 
-std::vector<Intersection> World::intersect(Ray r) const noexcept
+size_t World::objectCount() const noexcept
+{
+    return spheres.size() + planes.size() + cubes.size() + cylinders.size() + cones.size() + groups.size() + instances.size();
+}
+
+const Shape& World::objectAt(size_t index) const noexcept
+{
+    if (index < spheres.size())
+    {
+        return spheres[index];
+    }
+    index -= spheres.size();
+    if (index < planes.size())
+    {
+        return planes[index];
+    }
+    index -= planes.size();
+    if (index < cubes.size())
+    {
+        return cubes[index];
+    }
+    index -= cubes.size();
+    if (index < cylinders.size())
+    {
+        return cylinders[index];
+    }
+    index -= cylinders.size();
+    if (index < cones.size())
+    {
+        return cones[index];
+    }
+    index -= cones.size();
+    if (index < groups.size())
+    {
+        return groups[index];
+    }
+    index -= groups.size();
+    return instances[index];
+}
+
+Shape& World::objectAt(const size_t index) noexcept
 {
-    std::vector<Intersection> intersections;
-    for (const auto object : objects())
+    return const_cast<Shape&>(std::as_const(*this).objectAt(index));
+}
+
+std::vector<BoundingBox> World::objectBounds() const
+{
+    std::vector<BoundingBox> bounds;
+    bounds.reserve(objectCount());
+    forEachObject([&](const Shape& object) {
+        bounds.push_back(object.parentSpaceBounds());
+    });
+    return bounds;
+}
+
+void World::buildAcceleration()
+{
+    const TraceScope trace("World::buildAcceleration");
+    std::vector<BoundingBox> bounds = objectBounds();
+    topLevel.build(bounds);
+    topLevelBounds.record(std::move(bounds));
+}
+
+void World::refitAcceleration()
+{
+    std::vector<BoundingBox> bounds = objectBounds();
+    if (!topLevel.refit(bounds))
     {
-        auto objectIntersections = object.get().intersect(r);
-        for (const auto& intersection : objectIntersections)
+        topLevel.build(bounds);
+    }
+    topLevelBounds.record(std::move(bounds));
+}
+
+const BoundingVolumeHierarchy& World::getTopLevel() const noexcept
+{
+    return topLevel;
+}
+
+void World::selectDetail(const Camera& camera) noexcept
+{
+    const Tuple eye = camera.transform.inverse() * Point(0, 0, 0);
+    for (Group& group : groups)
+    {
+        group.selectDetail(eye, camera.pixelSize);
+    }
+    for (Instance& instance : instances)
+    {
+        instance.selectDetail(eye, camera.pixelSize);
+    }
+}
+
+Intersections World::intersect(Ray r) const noexcept
+{
+    Intersections intersections;
+    // Objects added, removed or moved since the last build or refit are not where the top level has them
+    if (topLevel.built() && topLevel.primitiveCount() == objectCount() && topLevelBounds.matches([&]() { return objectBounds(); }))
+    {
+        for (const uint32_t index : topLevel.candidates(r))
         {
-            intersections.push_back(intersection);
+            const Intersections objectIntersections = objectAt(index).intersect(r);
+            intersections.insert(intersections.end(), objectIntersections.begin(), objectIntersections.end());
         }
+        std::sort(intersections.begin(), intersections.end());
+        return intersections;
     }
+
+    forEachObject([&](const Shape& object) {
+        const Intersections objectIntersections = object.intersect(r);
+        intersections.insert(intersections.end(), objectIntersections.begin(), objectIntersections.end());
+    });
     std::sort(intersections.begin(), intersections.end());
     return intersections;
 }
 
 Color World::shadeHit(const IntersectionDetails& id, int remainingCalls) const noexcept
 {
-    const bool shadowed = isShadowed(id.overPoint);
-    const Color surface = id.object.material.light(light, id.point, id.eyeVector, id.normalVector, shadowed);
+    const Color surface = surfaceColor(id);
     const Color reflected = reflectedColor(id, remainingCalls);
     const Color refracted = refractedColor(id, remainingCalls);
 
@@ -101,8 +210,8 @@ Color World::reflectedColor(const IntersectionDetails& id, int remainingCalls) c
         return Color::Black;
     }
 
-    const Ray reflectionRay = Ray(id.overPoint, id.reflectionVector);
-    const Color reflectedColor = colorAt(reflectionRay, remainingCalls - 1);
+    CountStatistic(RenderStatistics::ReflectionRays);
+    const Color reflectedColor = colorAt(reflectionRay(id), remainingCalls - 1);
 
     return reflectedColor * id.object.material.reflectivity;
 }
@@ -115,37 +224,108 @@ Color World::refractedColor(const IntersectionDetails& id, int remainingCalls) c
         return Color::Black;
     }
 
-    const float nRatio = id.n1 / id.n2;
-    const float cosI = id.eyeVector.dot(id.normalVector);
-    const float sin2T = nRatio * nRatio * (1 - cosI * cosI);
-    if (sin2T >= 1.0F)
+    const std::optional<DifferentialRay> refractionRay = World::refractionRay(id);
+    if (!refractionRay)
     {
         return Color::Black;
     }
-
-    const float cosT = sqrtf(1.0F - sin2T);
-    const Tuple refractionDirection = id.normalVector * (nRatio * cosI - cosT) - id.eyeVector * nRatio;
-    const Ray refractionRay = Ray(id.underPoint, refractionDirection);
-    return colorAt(refractionRay, remainingCalls - 1) * id.object.material.transparency;
+    CountStatistic(RenderStatistics::RefractionRays);
+    return colorAt(*refractionRay, remainingCalls - 1) * id.object.material.transparency;
 }
 
 Color World::colorAt(Ray r, int remainingCalls) const noexcept
 {
-    std::vector<Intersection> intersections;
-    for (const auto& object : objects())
+    return traceRayTree({r, std::nullopt}, remainingCalls, nullptr);
+}
+
+Color World::colorAt(Ray r, SurfaceFeatures& features, int remainingCalls) const noexcept
+{
+    return traceRayTree({r, std::nullopt}, remainingCalls, &features);
+}
+
+Color World::colorAt(const DifferentialRay& r, int remainingCalls) const noexcept
+{
+    return traceRayTree(r, remainingCalls, nullptr);
+}
+
+Color World::colorAt(const DifferentialRay& r, SurfaceFeatures& features, int remainingCalls) const noexcept
+{
+    return traceRayTree(r, remainingCalls, &features);
+}
+
+// Walks the reflection/refraction ray tree with an explicit stack instead of recursing through
+// shadeHit. Each pending ray carries the throughput of the path that spawned it, so branches whose
+// contribution is invisible are never traced.
+Color World::traceRayTree(const DifferentialRay& r, int remainingCalls, SurfaceFeatures* features) const noexcept
+{
+    class PendingRay
     {
-        const std::vector<Intersection> i = object.get().intersect(r);
-        for (const Intersection& event : i)
+      public:
+        DifferentialRay ray;
+        float throughput;
+        int remainingCalls;
+        std::optional<RenderStatistics::Counter> kind; // None for r, which its caster counted
+    };
+
+    // Every popped ray pushes at most two children, so the depth-first stack never grows past this
+    ArenaVector<PendingRay> pending;
+    pending.reserve(static_cast<size_t>(std::max(remainingCalls, 0)) + 2);
+    pending.push_back({r, 1.0F, remainingCalls, std::nullopt});
+
+    std::minstd_rand rouletteGenerator(rouletteSeed(r.ray));
+
+    Color color = Color::Black;
+    while (!pending.empty())
+    {
+        const PendingRay current = pending.back();
+        pending.pop_back();
+
+        if (current.kind)
+        {
+            CountStatistic(*current.kind);
+        }
+        const Intersections intersections = intersect(current.ray.ray);
+        const auto hit = Ray::hit(intersections);
+        if (!hit)
+        {
+            continue;
+        }
+
+        const IntersectionDetails id = current.ray.ray.precomputeDetails(*hit, intersections, current.ray.differential);
+        color = color + surfaceColor(id) * current.throughput;
+        // r is the first ray popped, and the only one until its branches are pushed
+        if (features != nullptr)
         {
-            intersections.push_back(event);
+            *features = {id.object.material.albedo(id.point, id.footprint(), id.textureCoordinates), id.normalVector, id.t};
+            features = nullptr;
+        }
+        if (current.remainingCalls < 1)
+        {
+            continue;
+        }
+
+        for (const auto& branch : {reflectionBranch(id), refractionBranch(id)})
+        {
+            if (!branch)
+            {
+                continue;
+            }
+
+            const std::optional<float> throughput = rayTree.survivingThroughput(current.throughput * branch->weight, rouletteGenerator);
+            if (!throughput)
+            {
+                continue;
+            }
+
+            pending.push_back({branch->ray, *throughput, current.remainingCalls - 1, branch->kind});
         }
     }
-    auto hit = Ray::hit(intersections);
-    return hit ? shadeHit(r.precomputeDetails(*hit, intersections), remainingCalls) : Color(0, 0, 0);
+    return color;
 }
 
 bool World::isShadowed(const Tuple& point) const noexcept
 {
+    CountStatistic(RenderStatistics::ShadowRays);
     const Tuple shadowVector = (light.position - point).normalize();
     const float distanceToLight = (light.position - point).magnitude();
     const Ray shadowRay = Ray(point, shadowVector);
@@ -155,3 +335,117 @@ bool World::isShadowed(const Tuple& point) const noexcept
     const bool shadowed = hit && hit->t < distanceToLight;
     return shadowed;
 }
+
+Color World::surfaceColor(const IntersectionDetails& id) const noexcept
+{
+    const bool shadowed = isShadowed(id.overPoint);
+    return id.object.material.light(light, id.point, id.eyeVector, id.normalVector, shadowed, id.footprint(), id.textureCoordinates);
+}
+
+DifferentialRay World::reflectionRay(const IntersectionDetails& id) noexcept
+{
+    DifferentialRay reflected{Ray(id.overPoint, id.reflectionVector), std::nullopt};
+    if (id.differential)
+    {
+        // r = d - 2 (d . n) n, differentiated through both the direction and the normal
+        const SurfaceDifferential& surface = *id.differential;
+        const Tuple direction = -id.eyeVector;
+        const Tuple& normal = id.normalVector;
+        const float directionDotNormal = direction.dot(normal);
+        const auto reflect = [&](const Tuple& dDirection, const Tuple& dNormal) {
+            const float dDirectionDotNormal = dDirection.dot(normal) + direction.dot(dNormal);
+            return dDirection - (dNormal * directionDotNormal + normal * dDirectionDotNormal) * 2.0F;
+        };
+        reflected.differential = RayDifferential{surface.footprint.dpdx, reflect(surface.dddx, surface.dndx),
+                                                 surface.footprint.dpdy, reflect(surface.dddy, surface.dndy)};
+    }
+    return reflected;
+}
+
+std::optional<DifferentialRay> World::refractionRay(const IntersectionDetails& id) noexcept
+{
+    const float nRatio = id.n1 / id.n2;
+    const float cosI = id.eyeVector.dot(id.normalVector);
+    const float sin2T = nRatio * nRatio * (1 - cosI * cosI);
+    // Total internal reflection
+    if (sin2T >= 1.0F)
+    {
+        return std::nullopt;
+    }
+
+    const float cosT = sqrtf(1.0F - sin2T);
+    const Tuple refractionDirection = id.normalVector * (nRatio * cosI - cosT) - id.eyeVector * nRatio;
+    DifferentialRay refracted{Ray(id.underPoint, refractionDirection), std::nullopt};
+    if (id.differential)
+    {
+        // t = nRatio d + mu n with mu = nRatio cosI - cosT, differentiated through d, n and mu
+        const SurfaceDifferential& surface = *id.differential;
+        const Tuple direction = -id.eyeVector;
+        const float mu = nRatio * cosI - cosT;
+        const auto refract = [&](const Tuple& dDirection, const Tuple& dNormal) {
+            const float dCosI = -(dDirection.dot(id.normalVector) + direction.dot(dNormal));
+            const float dMu = (nRatio - nRatio * nRatio * cosI / cosT) * dCosI;
+            return dDirection * nRatio + dNormal * mu + id.normalVector * dMu;
+        };
+        refracted.differential = RayDifferential{surface.footprint.dpdx, refract(surface.dddx, surface.dndx),
+                                                 surface.footprint.dpdy, refract(surface.dddy, surface.dndy)};
+    }
+    return refracted;
+}
+
+std::optional<RayBranch> World::reflectionBranch(const IntersectionDetails& id) noexcept
+{
+    const Material& material = id.object.material;
+    if (material.reflectivity == 0.0F)
+    {
+        return std::nullopt;
+    }
+
+    const float fresnel = material.transparency > 0.0F ? id.reflectance : 1.0F;
+    return RayBranch{reflectionRay(id), material.reflectivity * fresnel, RenderStatistics::ReflectionRays};
+}
+
+std::optional<RayBranch> World::refractionBranch(const IntersectionDetails& id) noexcept
+{
+    const Material& material = id.object.material;
+    if (material.transparency == 0.0F)
+    {
+        return std::nullopt;
+    }
+
+    const std::optional<DifferentialRay> ray = refractionRay(id);
+    if (!ray)
+    {
+        return std::nullopt;
+    }
+    const float fresnel = material.reflectivity > 0.0F ? 1.0F - id.reflectance : 1.0F;
+    return RayBranch{*ray, material.transparency * fresnel, RenderStatistics::RefractionRays};
+}
+
+std::optional<float> RayTreeSettings::survivingThroughput(const float throughput, std::minstd_rand& generator) const noexcept
+{
+    if (!russianRoulette)
+    {
+        return throughput < minimumContribution ? std::nullopt : std::optional<float>(throughput);
+    }
+    if (throughput >= rouletteThreshold)
+    {
+        return throughput;
+    }
+
+    // Survivors are re-weighted so the expected contribution is unchanged
+    std::uniform_real_distribution<float> distribution(0.0F, 1.0F);
+    const float survivalProbability = throughput / rouletteThreshold;
+    return distribution(generator) < survivalProbability ? std::optional<float>(rouletteThreshold) : std::nullopt;
+}
+
+static uint32_t rouletteSeed(const Ray& r) noexcept
+{
+    // Hash the primary ray so every pixel gets its own, reproducible roulette sequence
+    uint32_t seed = 2166136261U;
+    for (const float component : {r.origin.x, r.origin.y, r.origin.z, r.direction.x, r.direction.y, r.direction.z})
+    {
+        seed = (seed ^ std::bit_cast<uint32_t>(component)) * 16777619U;
+    }
+    return seed;
+}
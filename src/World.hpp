@@ -8,12 +8,58 @@
 #ifndef SRC_WORLD_HPP_
 #define SRC_WORLD_HPP_
 
+#include "BoundingVolumeHierarchy.hpp"
 #include "Light.hpp"
 #include "Ray.hpp"
 #include "Shape.hpp"
+#include "Statistics.hpp"
 #include <functional>
+#include <optional>
+#include <random>
 #include <vector>
 
+class Camera;
+
+constexpr int MAXIMUM_RAY_DEPTH = 4;
+
+// Controls how much of the reflection/refraction ray tree colorAt explores.
+// Branches are weighted by their path throughput (the product of reflectivity,
+// transparency and Fresnel factors along the path) and are dropped once that
+// weight can no longer make a visible difference.
+class RayTreeSettings
+{
+  public:
+    // Branches lighter than this are dropped. 1/512, below half of one 8-bit color step, is invisible
+    // in the final image but changes it slightly, so the default traces everything.
+    float minimumContribution = 0.0F;
+    bool russianRoulette = false;
+    float rouletteThreshold = 0.05F; // Branches lighter than this survive with probability weight / threshold
+
+    [[nodiscard]] bool operator==(const RayTreeSettings& other) const noexcept = default;
+    // Returns the throughput a branch should be traced with, or nothing if it should be dropped
+    [[nodiscard]] std::optional<float> survivingThroughput(float throughput, std::minstd_rand& generator) const noexcept;
+};
+
+// A secondary ray spawned at a hit, together with the fraction of its color
+// that reaches the parent ray.
+class RayBranch
+{
+  public:
+    DifferentialRay ray;
+    float weight;
+    RenderStatistics::Counter kind; // Counted once the ray is traced
+};
+
+// The first surface a camera ray hits, as a denoiser sees it: noise free values that change where
+// the image has edges. Left as it is when the ray hits nothing.
+class SurfaceFeatures
+{
+  public:
+    Color albedo;                   // Before lighting, see Material::albedo
+    Tuple normal = Vector(0, 0, 0); // World space, facing the ray
+    float depth = 0.0F;             // Distance along the ray, which for camera rays is of unit length
+};
+
 class World
 {
   public:
@@ -23,19 +69,93 @@ class World
     std::vector<Cylinder> cylinders;
     std::vector<Cone> cones;
     std::vector<Group> groups;
+    std::vector<Instance> instances;
     Light light;
+    RayTreeSettings rayTree;
 
     World() noexcept = default;
 
     [[nodiscard]] std::vector<std::reference_wrapper<const Shape>> objects() const noexcept;
-    [[nodiscard]] std::vector<Intersection> intersect(Ray r) const noexcept;
-    [[nodiscard]] Color shadeHit(const IntersectionDetails& id, int remainingCalls = 4) const noexcept;
-    [[nodiscard]] Color reflectedColor(const IntersectionDetails& id, int remainingCalls = 4) const noexcept;
-    [[nodiscard]] Color refractedColor(const IntersectionDetails& id, int remainingCalls = 4) const noexcept;
-    [[nodiscard]] Color colorAt(Ray r, int remainingCalls = 4) const noexcept;
+    [[nodiscard]] size_t objectCount() const noexcept;
+    // The object objects() would list at index
+    [[nodiscard]] const Shape& objectAt(size_t index) const noexcept;
+    [[nodiscard]] Shape& objectAt(size_t index) noexcept;
+    // World space bounds of each object, in objects() order
+    [[nodiscard]] std::vector<BoundingBox> objectBounds() const;
+    [[nodiscard]] Intersections intersect(Ray r) const noexcept;
+    [[nodiscard]] Color shadeHit(const IntersectionDetails& id, int remainingCalls = MAXIMUM_RAY_DEPTH) const noexcept;
+    [[nodiscard]] Color reflectedColor(const IntersectionDetails& id, int remainingCalls = MAXIMUM_RAY_DEPTH) const noexcept;
+    [[nodiscard]] Color refractedColor(const IntersectionDetails& id, int remainingCalls = MAXIMUM_RAY_DEPTH) const noexcept;
+    [[nodiscard]] Color colorAt(Ray r, int remainingCalls = MAXIMUM_RAY_DEPTH) const noexcept;
+    // Also records what r itself hits into features
+    [[nodiscard]] Color colorAt(Ray r, SurfaceFeatures& features, int remainingCalls = MAXIMUM_RAY_DEPTH) const noexcept;
+    // As above, with patterns and textures filtered over what r's differential covers
+    [[nodiscard]] Color colorAt(const DifferentialRay& r, int remainingCalls = MAXIMUM_RAY_DEPTH) const noexcept;
+    [[nodiscard]] Color colorAt(const DifferentialRay& r, SurfaceFeatures& features, int remainingCalls = MAXIMUM_RAY_DEPTH) const noexcept;
     [[nodiscard]] bool isShadowed(const Tuple& point) const noexcept;
+    [[nodiscard]] Color surfaceColor(const IntersectionDetails& id) const noexcept;
+
+    // Both carry a differential when id has one
+    [[nodiscard]] static DifferentialRay reflectionRay(const IntersectionDetails& id) noexcept;
+    [[nodiscard]] static std::optional<DifferentialRay> refractionRay(const IntersectionDetails& id) noexcept;
+    [[nodiscard]] static std::optional<RayBranch> reflectionBranch(const IntersectionDetails& id) noexcept;
+    [[nodiscard]] static std::optional<RayBranch> refractionBranch(const IntersectionDetails& id) noexcept;
 
     static World BaseWorld() noexcept;
+
+    // Builds the top level hierarchy over the objects' world space bounds. Each group keeps its own
+    // acceleration structure in object space, so moving an object only changes the top level.
+    // Until this is called, and after objects are added, removed or moved, every object is tested.
+    void buildAcceleration();
+    // Refits the top level to the objects' current transforms, rebuilding it only when the
+    // objects themselves have changed. Cheaper than a build, so suited to animating transforms:
+    // call it after moving objects, as intersect tests every object until the top level fits again.
+    void refitAcceleration();
+    [[nodiscard]] const BoundingVolumeHierarchy& getTopLevel() const noexcept;
+    // Has every instance select its detail level for how large it appears to camera. Needed
+    // whenever the camera or the objects move; no acceleration structure changes with it.
+    void selectDetail(const Camera& camera) noexcept;
+
+    // Visits the same shapes as objects(), in the same order, without building a list
+    template <typename F>
+    void forEachObject(F&& f) const
+    {
+        for (const Shape& sphere : spheres)
+        {
+            f(sphere);
+        }
+        for (const Shape& plane : planes)
+        {
+            f(plane);
+        }
+        for (const Shape& cube : cubes)
+        {
+            f(cube);
+        }
+        for (const Shape& cylinder : cylinders)
+        {
+            f(cylinder);
+        }
+        for (const Shape& cone : cones)
+        {
+            f(cone);
+        }
+        for (const Shape& group : groups)
+        {
+            f(group);
+        }
+        for (const Shape& instance : instances)
+        {
+            f(instance);
+        }
+    }
+
+  private:
+    BoundingVolumeHierarchy topLevel; // Refers to objects by index, so stays valid when the world is copied
+    AccelerationBounds topLevelBounds; // Of the objects, as the top level was last built or refit over them
+
+    // colorAt, recording r's own hit into features when they are given
+    [[nodiscard]] Color traceRayTree(const DifferentialRay& r, int remainingCalls, SurfaceFeatures* features) const noexcept;
 };
 
 #endif /* SRC_WORLD_HPP_ */
@@ -6,57 +6,274 @@
  */
 
 #include "YamlParser.hpp"
+#include "ObjParser.hpp"
+#include "Statistics.hpp"
+#include "Trace.hpp"
 #include "Transformation.hpp"
+#include <algorithm>
 #include <charconv>
+#include <fstream>
+#include <sstream>
 #include <stdexcept>
+#include <utility>
 
-std::vector<std::string_view> tokenizeString(std::string_view textLine, char delimiter, bool allowEmptyTokens);
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-YamlParser::YamlParser([[maybe_unused]] const std::string& inputData) : worldCamera(Camera(100, 100, 0.5, IdentityMatrix()))
+constexpr size_t STREAM_CHUNK_SIZE = size_t{1} << 20;
+// Each of an obj's 'detail-levels:' keeps this fraction of the faces of the level before it
+constexpr float DETAIL_LEVEL_FACE_FRACTION = 0.25F;
+
+YamlParser::YamlParser(const std::string_view inputData, std::filesystem::path directory) : worldCamera(Camera(100, 100, 0.5, IdentityMatrix())),
+                                                                                            sceneDirectory(std::move(directory))
 {
+    const TraceScope trace("YamlParser");
     if (inputData.empty())
     {
         return;
     }
 
-    subCommandMap.emplace("at:", [this](auto& tokens) { ParseCommandAt(tokens); });
-    subCommandMap.emplace("intensity:", [this](auto& tokens) { ParseCommandIntensity(tokens); });
-    subCommandMap.emplace("width:", [this](auto& tokens) { ParseCommandWidth(tokens); });
-    subCommandMap.emplace("height:", [this](auto& tokens) { ParseCommandHeight(tokens); });
-    subCommandMap.emplace("field-of-view:", [this](auto& tokens) { ParseCommandFOV(tokens); });
-    subCommandMap.emplace("from:", [this](auto& tokens) { ParseCommandFrom(tokens); });
-    subCommandMap.emplace("to:", [this](auto& tokens) { ParseCommandTo(tokens); });
-    subCommandMap.emplace("up:", [this](auto& tokens) { ParseCommandUp(tokens); });
-    subCommandMap.emplace("color:", [this](auto& tokens) { ParseCommandColor(tokens); });
-    subCommandMap.emplace("ambient:", [this](auto& tokens) { ParseCommandAmbient(tokens); });
-    subCommandMap.emplace("diffuse:", [this](auto& tokens) { ParseCommandDiffuse(tokens); });
-    subCommandMap.emplace("specular:", [this](auto& tokens) { ParseCommandSpecular(tokens); });
-    subCommandMap.emplace("shininess:", [this](auto& tokens) { ParseCommandShininess(tokens); });
-    subCommandMap.emplace("reflective:", [this](auto& tokens) { ParseCommandReflective(tokens); });
-    subCommandMap.emplace("transparency:", [this](auto& tokens) { ParseCommandTransparency(tokens); });
-    subCommandMap.emplace("refractive-index:", [this](auto& tokens) { ParseCommandRefractiveIndex(tokens); });
-    subCommandMap.emplace("extend:", [this](auto& tokens) { ParseCommandExtend(tokens); });
-
-    uint64_t oldLinePos = 0;
-    uint64_t newLinePos = inputData.find('\n');
-    newLinePos = newLinePos == std::string::npos ? inputData.size() : newLinePos;
-
-    while (oldLinePos <= inputData.size())
-    {
-        std::string_view textLine = std::string_view(inputData).substr(oldLinePos, newLinePos - oldLinePos);
-
-        std::vector<std::string_view> tokens = tokenizeString(textLine, ' ', false);
-        if (!tokens.empty())
+    size_t lineStart = 0;
+    while (lineStart <= inputData.size())
+    {
+        size_t lineEnd = inputData.find('\n', lineStart);
+        lineEnd = lineEnd == std::string_view::npos ? inputData.size() : lineEnd;
+        ParseLine(inputData.substr(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+    }
+
+    FinishScene();
+}
+
+YamlParser::YamlParser(std::istream& input, std::filesystem::path directory) : worldCamera(Camera(100, 100, 0.5, IdentityMatrix())),
+                                                                              sceneDirectory(std::move(directory))
+{
+    const TraceScope trace("YamlParser");
+
+    // Lines are parsed straight out of each chunk, and only a line split across two chunks is copied
+    std::vector<char> chunk(STREAM_CHUNK_SIZE);
+    std::string carried;
+    bool empty = true;
+    while (input)
+    {
+        input.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        const auto read = static_cast<size_t>(input.gcount());
+        if (read == 0)
+        {
+            break;
+        }
+        empty = false;
+
+        const std::string_view text(chunk.data(), read);
+        size_t lineStart = 0;
+        for (size_t lineEnd = text.find('\n'); lineEnd != std::string_view::npos; lineEnd = text.find('\n', lineStart))
+        {
+            if (carried.empty())
+            {
+                ParseLine(text.substr(lineStart, lineEnd - lineStart));
+            } else
+            {
+                carried.append(text.substr(lineStart, lineEnd - lineStart));
+                ParseLine(carried);
+                carried.clear();
+            }
+            lineStart = lineEnd + 1;
+        }
+        carried.append(text.substr(lineStart));
+    }
+    if (empty)
+    {
+        return;
+    }
+
+    ParseLine(carried);
+    FinishScene();
+}
+
+// Unmaps the file however parsing ends
+class MappedFile
+{
+  public:
+    void* data = MAP_FAILED;
+    size_t size = 0;
+
+    MappedFile() noexcept = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile()
+    {
+        if (data != MAP_FAILED)
+        {
+            munmap(data, size);
+        }
+    }
+};
+
+YamlParser YamlParser::FromFile(const std::string& fileName)
+{
+    const int descriptor = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0)
+    {
+        throw std::runtime_error("Could not open scene file " + fileName);
+    }
+    const std::filesystem::path directory = std::filesystem::path(fileName).parent_path();
+    MappedFile file;
+    struct stat status
+    {
+    };
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+    {
+        file.size = static_cast<size_t>(status.st_size);
+        file.data = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    }
+    close(descriptor);
+
+    // Empty files cannot be mapped, and pipes and the like have no size to map
+    if (file.data == MAP_FAILED)
+    {
+        std::ifstream stream(fileName, std::ios::binary);
+        return YamlParser(stream, directory);
+    }
+    madvise(file.data, file.size, MADV_SEQUENTIAL);
+    return YamlParser(std::string_view(static_cast<const char*>(file.data), file.size), directory);
+}
+
+LineTokens TokenizeYamlLine(const std::string_view line)
+{
+    LineTokens tokens;
+    size_t position = 0;
+    while (position < line.size())
+    {
+        // Carriage returns are whitespace so that files with Windows line endings parse the same
+        if (line[position] == ' ' || line[position] == '\r')
+        {
+            position++;
+            continue;
+        }
+        size_t tokenEnd = position;
+        while (tokenEnd < line.size() && line[tokenEnd] != ' ' && line[tokenEnd] != '\r')
+        {
+            tokenEnd++;
+        }
+        if (tokens.count == LineTokens::CAPACITY)
         {
-            ParseTokens(tokens);
+            throw std::runtime_error("Scene line has more than " + std::to_string(LineTokens::CAPACITY) + " tokens: " + std::string(line));
         }
+        tokens.tokens[tokens.count++] = line.substr(position, tokenEnd - position);
+        position = tokenEnd;
+    }
+    return tokens;
+}
 
-        oldLinePos = newLinePos + 1;
-        newLinePos = inputData.find('\n', oldLinePos);
-        newLinePos = newLinePos == std::string::npos ? inputData.size() : newLinePos;
+YamlParser::Keyword YamlParser::KeywordOf(const std::string_view token) noexcept
+{
+    // Keys are told apart by length first, so only a few comparisons are made for any token
+    switch (token.size())
+    {
+    case 3:
+        return token == "at:" ? Keyword::At : token == "to:" ? Keyword::To : token == "up:" ? Keyword::Up : Keyword::Unknown;
+    case 5:
+        return token == "from:" ? Keyword::From : token == "file:" ? Keyword::File : token == "weld:" ? Keyword::Weld : Keyword::Unknown;
+    case 6:
+        return token == "width:" ? Keyword::Width : token == "color:" ? Keyword::Color : Keyword::Unknown;
+    case 7:
+        return token == "height:" ? Keyword::Height : token == "frames:" ? Keyword::Frames : token == "extend:" ? Keyword::Extend : Keyword::Unknown;
+    case 8:
+        return token == "ambient:" ? Keyword::Ambient : token == "diffuse:" ? Keyword::Diffuse : token == "heatmap:" ? Keyword::Heatmap : token == "texture:" ? Keyword::Texture : token == "sampler:" ? Keyword::Sampler : token == "samples:" ? Keyword::Samples : token == "denoise:" ? Keyword::Denoise : Keyword::Unknown;
+    case 9:
+        return token == "specular:" ? Keyword::Specular : token == "keyframe:" ? Keyword::Keyframe : token == "material:" ? Keyword::Material : token == "children:" ? Keyword::Children : Keyword::Unknown;
+    case 10:
+        return token == "intensity:" ? Keyword::Intensity : token == "shininess:" ? Keyword::Shininess : token == "transform:" ? Keyword::Transform : Keyword::Unknown;
+    case 11:
+        return token == "reflective:" ? Keyword::Reflective : Keyword::Unknown;
+    case 13:
+        return token == "transparency:" ? Keyword::Transparency : Keyword::Unknown;
+    case 14:
+        return token == "field-of-view:" ? Keyword::FieldOfView : token == "detail-levels:" ? Keyword::DetailLevels : Keyword::Unknown;
+    case 17:
+        return token == "refractive-index:" ? Keyword::RefractiveIndex : Keyword::Unknown;
+    default:
+        return Keyword::Unknown;
     }
 }
 
+void YamlParser::ParseLine(const std::string_view line)
+{
+    const LineTokens tokens = TokenizeYamlLine(line);
+    if (tokens.empty())
+    {
+        return;
+    }
+
+    // Indentation only matters inside a group, where it tells the group's lines from its children's
+    lineColumn = static_cast<size_t>(tokens[0].data() - line.data());
+    const bool transformStep = tokens[0] == "-" && tokens.size() > 1 && tokens[1] == "[";
+    if (!openGroups.empty() && !transformStep)
+    {
+        CloseGroups(lineColumn, tokens[0] != "-");
+    }
+    ParseTokens(tokens);
+}
+
+void YamlParser::CloseGroups(const size_t column, const bool keyLine)
+{
+    if (keyLine && column > activeColumn)
+    {
+        return;
+    }
+    FinishItem();
+    activeCommand = none;
+    while (!openGroups.empty() && openGroups.back().column >= column)
+    {
+        Group finished = std::move(openGroups.back().group);
+        openGroups.pop_back();
+        if (openGroups.empty())
+        {
+            world.groups.push_back(std::move(finished));
+        } else
+        {
+            openGroups.back().group.addChild(finished);
+        }
+    }
+    if (keyLine && !openGroups.empty())
+    {
+        activeCommand = group;
+        activeTransform = &openGroups.back().group.transform;
+        activeColumn = openGroups.back().column;
+    }
+}
+
+void YamlParser::FinishScene()
+{
+    CloseGroups(0, false);
+    FinishSequence();
+    world.buildAcceleration();
+    world.selectDetail(worldCamera);
+}
+
+// Sorts keyframes by frame, keeping only the last one given for any frame
+template <typename Keyframe>
+std::vector<Keyframe> SortKeyframes(std::vector<Keyframe> keyframes)
+{
+    std::stable_sort(keyframes.begin(), keyframes.end(), [](const Keyframe& a, const Keyframe& b) {
+        return a.frame < b.frame;
+    });
+    std::vector<Keyframe> sorted;
+    for (const Keyframe& keyframe : keyframes)
+    {
+        if (!sorted.empty() && sorted.back().frame == keyframe.frame)
+        {
+            sorted.back() = keyframe;
+        } else
+        {
+            sorted.push_back(keyframe);
+        }
+    }
+    return sorted;
+}
+
 Tuple ParseVectorValue(const std::string_view x, const std::string_view y, const std::string_view z)
 {
     Tuple value = Vector(0, 0, 0);
@@ -81,7 +298,7 @@ uint32_t ParseIntValue(const std::string_view i)
     return value;
 }
 
-void YamlParser::ParseCommandAt(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandAt(const LineTokens& tokens)
 {
     if (tokens.size() != 6)
     {
@@ -96,7 +313,7 @@ void YamlParser::ParseCommandAt(const std::vector<std::string_view>& tokens)
     world.light.position = position;
 }
 
-void YamlParser::ParseCommandIntensity(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandIntensity(const LineTokens& tokens)
 {
     if (tokens.size() != 6)
     {
@@ -109,7 +326,7 @@ void YamlParser::ParseCommandIntensity(const std::vector<std::string_view>& toke
     world.light.intensity = ParseVectorValue(tokens[2], tokens[3], tokens[4]);
 }
 
-void YamlParser::ParseCommandWidth(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandWidth(const LineTokens& tokens)
 {
     if (tokens.size() != 2)
     {
@@ -123,7 +340,7 @@ void YamlParser::ParseCommandWidth(const std::vector<std::string_view>& tokens)
     worldCamera.RecalculateProperties();
 }
 
-void YamlParser::ParseCommandHeight(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandHeight(const LineTokens& tokens)
 {
     if (tokens.size() != 2)
     {
@@ -137,7 +354,7 @@ void YamlParser::ParseCommandHeight(const std::vector<std::string_view>& tokens)
     worldCamera.RecalculateProperties();
 }
 
-void YamlParser::ParseCommandFOV(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandFOV(const LineTokens& tokens)
 {
     if (tokens.size() != 2)
     {
@@ -151,7 +368,7 @@ void YamlParser::ParseCommandFOV(const std::vector<std::string_view>& tokens)
     worldCamera.RecalculateProperties();
 }
 
-void YamlParser::ParseCommandFrom(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandFrom(const LineTokens& tokens)
 {
     if (tokens.size() != 6)
     {
@@ -163,12 +380,17 @@ void YamlParser::ParseCommandFrom(const std::vector<std::string_view>& tokens)
     {
         throw std::runtime_error("Invalid 'from:' specifier for '- add: camera' command.");
     }
+    if (inKeyframe)
+    {
+        worldSequence.cameraKeyframes.back().from = fromPosition;
+        return;
+    }
     cameraFrom = fromPosition;
     worldCamera.transform = ViewTransform(cameraFrom, cameraTo, cameraUp);
     worldCamera.RecalculateProperties();
 }
 
-void YamlParser::ParseCommandTo(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandTo(const LineTokens& tokens)
 {
     if (tokens.size() != 6)
     {
@@ -180,12 +402,17 @@ void YamlParser::ParseCommandTo(const std::vector<std::string_view>& tokens)
     {
         throw std::runtime_error("Invalid 'to:' specifier for '- add: camera' command.");
     }
+    if (inKeyframe)
+    {
+        worldSequence.cameraKeyframes.back().to = toPosition;
+        return;
+    }
     cameraTo = toPosition;
     worldCamera.transform = ViewTransform(cameraFrom, cameraTo, cameraUp);
     worldCamera.RecalculateProperties();
 }
 
-void YamlParser::ParseCommandUp(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandUp(const LineTokens& tokens)
 {
     if (tokens.size() != 6)
     {
@@ -195,13 +422,41 @@ void YamlParser::ParseCommandUp(const std::vector<std::string_view>& tokens)
     {
         throw std::runtime_error("Invalid 'up:' specifier for '- add: camera' command.");
     }
+    if (inKeyframe)
+    {
+        worldSequence.cameraKeyframes.back().up = ParseVectorValue(tokens[2], tokens[3], tokens[4]);
+        return;
+    }
     cameraUp = ParseVectorValue(tokens[2], tokens[3], tokens[4]);
     worldCamera.transform = ViewTransform(cameraFrom, cameraTo, cameraUp);
     worldCamera.RecalculateProperties();
 }
 
-void YamlParser::ParseCommandAdd(const std::vector<std::string_view>& tokens)
+template <typename T>
+T& YamlParser::AddShape(std::vector<T>& worldShapes, const T& shape)
 {
+    if (openGroups.empty())
+    {
+        return worldShapes.emplace_back(shape);
+    }
+    return openGroups.back().group.addChild(shape);
+}
+
+bool YamlParser::ActiveItemHasMaterial() const noexcept
+{
+    return activeCommand == material || activeCommand == plane || activeCommand == cube || activeCommand == sphere || activeCommand == obj;
+}
+
+bool YamlParser::ActiveItemHasTransform() const noexcept
+{
+    return activeCommand == transform || activeCommand == plane || activeCommand == cube || activeCommand == sphere || activeCommand == obj ||
+           activeCommand == group;
+}
+
+void YamlParser::ParseCommandAdd(const LineTokens& tokens)
+{
+    FinishItem();
+    activeColumn = lineColumn;
     if (tokens[2].ends_with("camera"))
     {
         activeCommand = CommandType::camera;
@@ -211,26 +466,44 @@ void YamlParser::ParseCommandAdd(const std::vector<std::string_view>& tokens)
     } else if (tokens[2] == "plane")
     {
         activeCommand = CommandType::plane;
-        world.planes.emplace_back(Plane());
-        activeMaterial = &world.planes.back().material;
-        activeTransform = &world.planes.back().transform;
+        Plane& added = AddShape(world.planes, Plane());
+        activeMaterial = &added.material;
+        activeTransform = &added.transform;
+        objectKeyframes.emplace_back();
     } else if (tokens[2] == "cube")
     {
         activeCommand = CommandType::cube;
-        world.cubes.emplace_back(Cube());
-        activeMaterial = &world.cubes.back().material;
-        activeTransform = &world.cubes.back().transform;
+        Cube& added = AddShape(world.cubes, Cube());
+        activeMaterial = &added.material;
+        activeTransform = &added.transform;
+        objectKeyframes.emplace_back();
     } else if (tokens[2] == "sphere")
     {
         activeCommand = CommandType::sphere;
-        world.spheres.emplace_back(Sphere());
-        activeMaterial = &world.spheres.back().material;
-        activeTransform = &world.spheres.back().transform;
+        Sphere& added = AddShape(world.spheres, Sphere());
+        activeMaterial = &added.material;
+        activeTransform = &added.transform;
+        objectKeyframes.emplace_back();
+    } else if (tokens[2] == "obj")
+    {
+        activeCommand = CommandType::obj;
+        activeInstance = &AddShape(world.instances, Instance(nullptr));
+        activeMaterial = &activeInstance->material;
+        activeTransform = &activeInstance->transform;
+    } else if (tokens[2] == "group")
+    {
+        activeCommand = CommandType::group;
+        openGroups.push_back({Group(), lineColumn});
+        activeTransform = &openGroups.back().group.transform;
+    } else if (tokens[2] == "sequence")
+    {
+        activeCommand = CommandType::sequence;
     }
 }
 
-void YamlParser::ParseCommandDefine(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandDefine(const LineTokens& tokens)
 {
+    FinishItem();
     if (tokens[2].ends_with("material"))
     {
         activeCommand = CommandType::material;
@@ -246,140 +519,164 @@ void YamlParser::ParseCommandDefine(const std::vector<std::string_view>& tokens)
     }
 }
 
-void YamlParser::ParseCommandTransformParameter(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandTransformParameter(const LineTokens& tokens)
 {
     if (tokens.size() != 7)
     {
         throw std::runtime_error("Transform parameter command in invalid format. Expected: '- [ op, x, y, z ]'");
     }
-    if (activeCommand != transform && activeCommand != plane && activeCommand != cube && activeCommand != sphere)
+    if (!ActiveItemHasTransform())
     {
         throw std::runtime_error("Transform parameter only valid for transform definition.");
     }
+    TransformStep step;
+    step.amount = ParseVectorValue(tokens[3], tokens[4], tokens[5]);
     if (tokens[2] == "translate,")
     {
-        *activeTransform = translation(ParseFloatValue(tokens[3]),
-                                       ParseFloatValue(tokens[4]), ParseFloatValue(tokens[5])) *
-                           *activeTransform;
+        step.operation = TransformStep::Translate;
     } else if (tokens[2] == "scale,")
     {
-        *activeTransform = scaling(ParseFloatValue(tokens[3]),
-                                   ParseFloatValue(tokens[4]), ParseFloatValue(tokens[5])) *
-                           *activeTransform;
+        step.operation = TransformStep::Scale;
     } else if (tokens[2] == "rotate,")
     {
-        *activeTransform = rotationZ(ParseFloatValue(tokens[5])) * rotationY(ParseFloatValue(tokens[4])) * rotationX(ParseFloatValue(tokens[3])) * *activeTransform;
+        step.operation = TransformStep::Rotate;
     } else
     {
         throw std::runtime_error("Invalid transform operation. Expected: 'scale', 'rotate', or 'translate'");
     }
+
+    // Only shapes that can be animated keep their steps, so keyframes can be built from them
+    if (!objectKeyframes.empty())
+    {
+        if (inKeyframe)
+        {
+            objectKeyframes.back().steps.push_back(step);
+            return;
+        }
+        objectKeyframes.front().steps.push_back(step);
+    }
+    *activeTransform = step.transform() * *activeTransform;
 }
 
-void YamlParser::ParseCommandColor(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandColor(const LineTokens& tokens)
 {
     if (tokens.size() != 6)
     {
         throw std::runtime_error("'color:' command in invalid format. Expected: 'color: [ x, y, z ]'");
     }
-    if (activeCommand != material && activeCommand != plane && activeCommand != cube && activeCommand != sphere)
+    if (!ActiveItemHasMaterial())
     {
         throw std::runtime_error("Invalid 'color:' specifier for '- define: material' command.");
     }
     activeMaterial->color = ParseVectorValue(tokens[2], tokens[3], tokens[4]);
 }
 
-void YamlParser::ParseCommandAmbient(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandAmbient(const LineTokens& tokens)
 {
     if (tokens.size() != 2)
     {
         throw std::runtime_error("'ambient:' command in invalid format. Expected: 'ambient: f'");
     }
-    if (activeCommand != material && activeCommand != plane && activeCommand != cube && activeCommand != sphere)
+    if (!ActiveItemHasMaterial())
     {
         throw std::runtime_error("Invalid 'ambient:' specifier for '- define: material' command.");
     }
     activeMaterial->ambient = ParseFloatValue(tokens[1]);
 }
 
-void YamlParser::ParseCommandDiffuse(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandDiffuse(const LineTokens& tokens)
 {
     if (tokens.size() != 2)
     {
         throw std::runtime_error("'diffuse:' command in invalid format. Expected: 'diffuse: f'");
     }
-    if (activeCommand != material && activeCommand != plane && activeCommand != cube && activeCommand != sphere)
+    if (!ActiveItemHasMaterial())
     {
         throw std::runtime_error("Invalid 'diffuse:' specifier for '- define: material' command.");
     }
     activeMaterial->diffuse = ParseFloatValue(tokens[1]);
 }
 
-void YamlParser::ParseCommandSpecular(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandSpecular(const LineTokens& tokens)
 {
     if (tokens.size() != 2)
     {
         throw std::runtime_error("'specular:' command in invalid format. Expected: 'specular: f'");
     }
-    if (activeCommand != material && activeCommand != plane && activeCommand != cube && activeCommand != sphere)
+    if (!ActiveItemHasMaterial())
     {
         throw std::runtime_error("Invalid 'specular:' specifier for '- define: material' command.");
     }
     activeMaterial->specular = ParseFloatValue(tokens[1]);
 }
 
-void YamlParser::ParseCommandShininess(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandShininess(const LineTokens& tokens)
 {
     if (tokens.size() != 2)
     {
         throw std::runtime_error("'shininess:' command in invalid format. Expected: 'shininess: f'");
     }
-    if (activeCommand != material && activeCommand != plane && activeCommand != cube && activeCommand != sphere)
+    if (!ActiveItemHasMaterial())
     {
         throw std::runtime_error("Invalid 'shininess:' specifier for '- define: material' command.");
     }
     activeMaterial->shininess = ParseFloatValue(tokens[1]);
 }
 
-void YamlParser::ParseCommandReflective(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandReflective(const LineTokens& tokens)
 {
     if (tokens.size() != 2)
     {
         throw std::runtime_error("'reflective:' command in invalid format. Expected: 'reflective: f'");
     }
-    if (activeCommand != material && activeCommand != plane && activeCommand != cube && activeCommand != sphere)
+    if (!ActiveItemHasMaterial())
     {
         throw std::runtime_error("Invalid 'reflective:' specifier for '- define: material' command.");
     }
     activeMaterial->reflectivity = ParseFloatValue(tokens[1]);
 }
 
-void YamlParser::ParseCommandTransparency(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandTransparency(const LineTokens& tokens)
 {
     if (tokens.size() != 2)
     {
         throw std::runtime_error("'transparency:' command in invalid format. Expected: 'transparency: f'");
     }
-    if (activeCommand != material && activeCommand != plane && activeCommand != cube && activeCommand != sphere)
+    if (!ActiveItemHasMaterial())
     {
         throw std::runtime_error("Invalid 'transparency:' specifier for '- define: material' command.");
     }
     activeMaterial->transparency = ParseFloatValue(tokens[1]);
 }
 
-void YamlParser::ParseCommandRefractiveIndex(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandRefractiveIndex(const LineTokens& tokens)
 {
     if (tokens.size() != 2)
     {
         throw std::runtime_error("'refractive-index:' command in invalid format. Expected: 'refractive-index: f'");
     }
-    if (activeCommand != material && activeCommand != plane && activeCommand != cube && activeCommand != sphere)
+    if (!ActiveItemHasMaterial())
     {
         throw std::runtime_error("Invalid 'refractive-index:' specifier for '- define: material' command.");
     }
     activeMaterial->refractiveIndex = ParseFloatValue(tokens[1]);
 }
 
-void YamlParser::ParseCommandExtend(const std::vector<std::string_view>& tokens)
+// PPM images only, read through the shared texture cache so scenes loading the same file share it
+void YamlParser::ParseCommandTexture(const LineTokens& tokens)
+{
+    if (tokens.size() != 2)
+    {
+        throw std::runtime_error("'texture:' command in invalid format. Expected: 'texture: path'");
+    }
+    if (!ActiveItemHasMaterial())
+    {
+        throw std::runtime_error("Invalid 'texture:' specifier for '- define: material' command.");
+    }
+    activeMaterial->texture = TextureCache::Shared().load(ScenePath(tokens[1]).string());
+}
+
+void YamlParser::ParseCommandExtend(const LineTokens& tokens)
 {
     if (tokens.size() != 2)
     {
@@ -398,25 +695,405 @@ void YamlParser::ParseCommandExtend(const std::vector<std::string_view>& tokens)
     }
 }
 
-void YamlParser::ParseTokens(const std::vector<std::string_view>& tokens)
+void YamlParser::ParseCommandHeatmap(const LineTokens& tokens)
 {
-    if (tokens.size() == 3 && tokens[0] == "-" && tokens[1] == "add:")
+    if (tokens.size() != 2 || (tokens[1] != "time" && tokens[1] != "rays" && tokens[1] != "tests"))
     {
-        ParseCommandAdd(tokens);
-    } else if (tokens.size() == 3 && tokens[0] == "-" && tokens[1] == "define:")
+        throw std::runtime_error("'heatmap:' command in invalid format. Expected: 'heatmap: time', 'heatmap: rays' or 'heatmap: tests'");
+    }
+    if (activeCommand != camera)
     {
-        ParseCommandDefine(tokens);
-    } else if (tokens.size() > 1 && tokens[0] == "-" && tokens[1] == "[")
+        throw std::runtime_error("Invalid 'heatmap:' specifier for '- add: camera' command.");
+    }
+    if (tokens[1] != "time" && !RenderStatistics::Enabled)
     {
-        ParseCommandTransformParameter(tokens);
-    } else if (tokens[0] == "material:" && tokens.size() == 2)
+        throw std::runtime_error("'heatmap: " + std::string(tokens[1]) + "' needs a build with ENABLE_STATISTICS.");
+    }
+    worldCamera.costMeasure = tokens[1] == "time" ? Camera::Time : tokens[1] == "rays" ? Camera::Rays : Camera::IntersectionTests;
+}
+
+void YamlParser::ParseCommandSampler(const LineTokens& tokens)
+{
+    if (tokens.size() != 2 || (tokens[1] != "center" && tokens[1] != "halton" && tokens[1] != "sobol" && tokens[1] != "blue-noise"))
     {
-        *activeMaterial = materials[std::string(tokens[1])];
-    } else if (tokens[0] == "transform:" && tokens.size() == 2)
+        throw std::runtime_error("'sampler:' command in invalid format. Expected: 'sampler: center', 'sampler: halton', 'sampler: sobol' or 'sampler: blue-noise'");
+    }
+    if (activeCommand != camera)
     {
-        *activeTransform = transforms[std::string(tokens[1])];
-    } else if (subCommandMap.contains(std::string(tokens[0])))
+        throw std::runtime_error("Invalid 'sampler:' specifier for '- add: camera' command.");
+    }
+    worldCamera.sampler.sequence = tokens[1] == "center" ? Sampler::PixelCenter : tokens[1] == "halton" ? Sampler::Halton : tokens[1] == "sobol" ? Sampler::Sobol : Sampler::BlueNoise;
+}
+
+void YamlParser::ParseCommandSamples(const LineTokens& tokens)
+{
+    if (tokens.size() != 2 || ParseIntValue(tokens[1]) == 0)
+    {
+        throw std::runtime_error("'samples:' command in invalid format. Expected: 'samples: i' with i at least 1");
+    }
+    if (activeCommand != camera)
+    {
+        throw std::runtime_error("Invalid 'samples:' specifier for '- add: camera' command.");
+    }
+    worldCamera.samplesPerPixel = ParseIntValue(tokens[1]);
+}
+
+void YamlParser::ParseCommandDenoise(const LineTokens& tokens)
+{
+    if (tokens.size() != 2 || ParseIntValue(tokens[1]) == 0 || ParseIntValue(tokens[1]) > MAXIMUM_DENOISE_ITERATIONS)
+    {
+        throw std::runtime_error("'denoise:' command in invalid format. Expected: 'denoise: i' with i from 1 to " + std::to_string(MAXIMUM_DENOISE_ITERATIONS));
+    }
+    if (activeCommand != camera)
+    {
+        throw std::runtime_error("Invalid 'denoise:' specifier for '- add: camera' command.");
+    }
+    worldCamera.denoise = DenoiseSettings();
+    worldCamera.denoise->iterations = ParseIntValue(tokens[1]);
+}
+
+void YamlParser::ParseCommandFile(const LineTokens& tokens)
+{
+    if (tokens.size() != 2)
+    {
+        throw std::runtime_error("'file:' command in invalid format. Expected: 'file: path'");
+    }
+    if (activeCommand != obj)
+    {
+        throw std::runtime_error("Invalid 'file:' specifier for '- add: obj' command.");
+    }
+    activeMeshFile = tokens[1];
+}
+
+void YamlParser::ParseCommandChildren(const LineTokens& tokens)
+{
+    if (tokens.size() != 1)
+    {
+        throw std::runtime_error("'children:' command in invalid format. Expected: 'children:' followed by indented '- add:' items");
+    }
+    if (activeCommand != group)
+    {
+        throw std::runtime_error("Invalid 'children:' specifier for '- add: group' command.");
+    }
+}
+
+void YamlParser::ParseCommandDetailLevels(const LineTokens& tokens)
+{
+    if (tokens.size() != 2)
+    {
+        throw std::runtime_error("'detail-levels:' command in invalid format. Expected: 'detail-levels: n'");
+    }
+    if (activeCommand != obj)
+    {
+        throw std::runtime_error("Invalid 'detail-levels:' specifier for '- add: obj' command.");
+    }
+    activeDetailLevels = ParseIntValue(tokens[1]);
+}
+
+void YamlParser::ParseCommandWeld(const LineTokens& tokens)
+{
+    if (tokens.size() != 2 || !(ParseFloatValue(tokens[1]) > 0.0F))
+    {
+        throw std::runtime_error("'weld:' command in invalid format. Expected: 'weld: tolerance', a tolerance above 0");
+    }
+    if (activeCommand != obj)
+    {
+        throw std::runtime_error("Invalid 'weld:' specifier for '- add: obj' command.");
+    }
+    activeMeshOptions.weld = true;
+    activeMeshOptions.weldTolerance = ParseFloatValue(tokens[1]);
+}
+
+std::filesystem::path YamlParser::ScenePath(const std::string_view file) const
+{
+    std::filesystem::path path(file);
+    if (path.is_relative())
+    {
+        path = sceneDirectory / path;
+    }
+    return path.lexically_normal();
+}
+
+std::shared_ptr<const Group> YamlParser::LoadMesh(const std::string_view file, const MeshOptions& options)
+{
+    const std::filesystem::path path = ScenePath(file);
+    // Welded and unwelded meshes of one file differ, as do meshes welded to different tolerances
+    const std::string key = options.weld ? path.string() + "?weld=" + std::to_string(options.weldTolerance) : path.string();
+    const auto loaded = meshes.find(key);
+    if (loaded != meshes.end())
+    {
+        return loaded->second;
+    }
+
+    std::ifstream objFile(path, std::ios::binary);
+    if (!objFile)
+    {
+        throw std::runtime_error("Could not open OBJ file " + path.string());
+    }
+    std::ostringstream objText;
+    objText << objFile.rdbuf();
+    Group mesh = ObjParser(objText.str(), options).getGroup();
+    mesh.setAcceleration(Group::BVH);
+    return meshes.emplace(key, std::make_shared<const Group>(std::move(mesh))).first->second;
+}
+
+std::vector<std::shared_ptr<const Group>> YamlParser::DetailLevels(const std::shared_ptr<const Group>& geometry, const size_t count)
+{
+    std::vector<std::shared_ptr<const Group>>& levels = meshDetailLevels[geometry.get()];
+    while (levels.size() < count)
     {
-        subCommandMap[std::string(tokens[0])](tokens);
+        const Group& previous = levels.empty() ? *geometry : *levels.back();
+        Group level = previous.simplified(DETAIL_LEVEL_FACE_FRACTION);
+        if (level.faceCount() >= previous.faceCount())
+        {
+            break;
+        }
+        levels.push_back(std::make_shared<const Group>(std::move(level)));
+    }
+    return {levels.begin(), levels.begin() + static_cast<std::ptrdiff_t>(std::min(count, levels.size()))};
+}
+
+void YamlParser::ParseCommandFrames(const LineTokens& tokens)
+{
+    if (tokens.size() != 2 || ParseIntValue(tokens[1]) == 0)
+    {
+        throw std::runtime_error("'frames:' command in invalid format. Expected: 'frames: i' with i at least 1");
+    }
+    if (activeCommand != sequence)
+    {
+        throw std::runtime_error("Invalid 'frames:' specifier for '- add: sequence' command.");
+    }
+    worldSequence.frameCount = ParseIntValue(tokens[1]);
+}
+
+void YamlParser::ParseCommandKeyframe(const LineTokens& tokens)
+{
+    if (tokens.size() != 2)
+    {
+        throw std::runtime_error("'keyframe:' command in invalid format. Expected: 'keyframe: i'");
+    }
+    const uint32_t frame = ParseIntValue(tokens[1]);
+    if (activeCommand == camera)
+    {
+        // The camera's ordinary from, to and up are its pose at frame 0, and each keyframe starts
+        // from the one before it so it only has to give what changes
+        if (worldSequence.cameraKeyframes.empty())
+        {
+            worldSequence.cameraKeyframes.push_back({0, cameraFrom, cameraTo, cameraUp});
+        }
+        CameraKeyframe keyframe = worldSequence.cameraKeyframes.back();
+        keyframe.frame = frame;
+        worldSequence.cameraKeyframes.push_back(keyframe);
+    } else if (activeCommand == plane || activeCommand == cube || activeCommand == sphere)
+    {
+        if (!openGroups.empty())
+        {
+            throw std::runtime_error("'keyframe:' cannot be used for a shape inside a group.");
+        }
+        // Unlike the camera, a shape keyframe gives its whole transform
+        TransformKeyframe keyframe;
+        keyframe.frame = frame;
+        objectKeyframes.push_back(keyframe);
+    } else
+    {
+        throw std::runtime_error("'keyframe:' option must be used with: camera, plane, cube or sphere command.");
+    }
+    inKeyframe = true;
+}
+
+void YamlParser::ParseNamedTransform(const std::string_view name)
+{
+    const AffineTransform& named = transforms[std::string(name)];
+    if (activeCommand == plane || activeCommand == cube || activeCommand == sphere)
+    {
+        TransformKeyframe& keyframe = inKeyframe ? objectKeyframes.back() : objectKeyframes.front();
+        keyframe.base = named;
+        keyframe.steps.clear();
+        if (inKeyframe)
+        {
+            return;
+        }
+    }
+    *activeTransform = named;
+}
+
+void YamlParser::FinishItem()
+{
+    if (activeCommand == obj)
+    {
+        if (activeMeshFile.empty())
+        {
+            throw std::runtime_error("'- add: obj' command is missing its 'file:' specifier.");
+        }
+        activeInstance->geometry = LoadMesh(activeMeshFile, activeMeshOptions);
+    }
+    if (activeCommand == obj && activeDetailLevels > 0)
+    {
+        activeInstance->detailLevels = DetailLevels(activeInstance->geometry, activeDetailLevels);
+    }
+    activeDetailLevels = 0;
+    activeMeshFile.clear();
+    activeMeshOptions = MeshOptions();
+    if (objectKeyframes.size() > 1)
+    {
+        size_t index = world.spheres.size() - 1;
+        if (activeCommand == plane)
+        {
+            index = world.planes.size() - 1;
+        } else if (activeCommand == cube)
+        {
+            index = world.cubes.size() - 1;
+        }
+        pendingAnimations.push_back({activeCommand, index, SortKeyframes(objectKeyframes)});
+    }
+    objectKeyframes.clear();
+    inKeyframe = false;
+}
+
+void YamlParser::FinishSequence()
+{
+    worldSequence.cameraKeyframes = SortKeyframes(worldSequence.cameraKeyframes);
+    for (PendingAnimation& animation : pendingAnimations)
+    {
+        // World::objects() lists spheres, then planes, then cubes
+        size_t offset = 0;
+        if (animation.shapeType == plane)
+        {
+            offset = world.spheres.size();
+        } else if (animation.shapeType == cube)
+        {
+            offset = world.spheres.size() + world.planes.size();
+        }
+        worldSequence.objects.push_back({offset + animation.index, std::move(animation.keyframes)});
+    }
+    pendingAnimations.clear();
+}
+
+void YamlParser::ParseTokens(const LineTokens& tokens)
+{
+    if (tokens[0] == "-")
+    {
+        if (tokens.size() == 3 && tokens[1] == "add:")
+        {
+            ParseCommandAdd(tokens);
+        } else if (tokens.size() == 3 && tokens[1] == "define:")
+        {
+            ParseCommandDefine(tokens);
+        } else if (tokens.size() > 1 && tokens[1] == "[")
+        {
+            ParseCommandTransformParameter(tokens);
+        }
+        return;
+    }
+
+    switch (KeywordOf(tokens[0]))
+    {
+    case Keyword::At:
+        ParseCommandAt(tokens);
+        break;
+    case Keyword::Intensity:
+        ParseCommandIntensity(tokens);
+        break;
+    case Keyword::Width:
+        ParseCommandWidth(tokens);
+        break;
+    case Keyword::Height:
+        ParseCommandHeight(tokens);
+        break;
+    case Keyword::FieldOfView:
+        ParseCommandFOV(tokens);
+        break;
+    case Keyword::From:
+        ParseCommandFrom(tokens);
+        break;
+    case Keyword::To:
+        ParseCommandTo(tokens);
+        break;
+    case Keyword::Up:
+        ParseCommandUp(tokens);
+        break;
+    case Keyword::Color:
+        ParseCommandColor(tokens);
+        break;
+    case Keyword::Ambient:
+        ParseCommandAmbient(tokens);
+        break;
+    case Keyword::Diffuse:
+        ParseCommandDiffuse(tokens);
+        break;
+    case Keyword::Specular:
+        ParseCommandSpecular(tokens);
+        break;
+    case Keyword::Shininess:
+        ParseCommandShininess(tokens);
+        break;
+    case Keyword::Reflective:
+        ParseCommandReflective(tokens);
+        break;
+    case Keyword::Transparency:
+        ParseCommandTransparency(tokens);
+        break;
+    case Keyword::RefractiveIndex:
+        ParseCommandRefractiveIndex(tokens);
+        break;
+    case Keyword::Texture:
+        ParseCommandTexture(tokens);
+        break;
+    case Keyword::Extend:
+        ParseCommandExtend(tokens);
+        break;
+    case Keyword::Frames:
+        ParseCommandFrames(tokens);
+        break;
+    case Keyword::Keyframe:
+        ParseCommandKeyframe(tokens);
+        break;
+    case Keyword::Heatmap:
+        ParseCommandHeatmap(tokens);
+        break;
+    case Keyword::Sampler:
+        ParseCommandSampler(tokens);
+        break;
+    case Keyword::Samples:
+        ParseCommandSamples(tokens);
+        break;
+    case Keyword::Denoise:
+        ParseCommandDenoise(tokens);
+        break;
+    case Keyword::File:
+        ParseCommandFile(tokens);
+        break;
+    case Keyword::Children:
+        ParseCommandChildren(tokens);
+        break;
+    case Keyword::DetailLevels:
+        ParseCommandDetailLevels(tokens);
+        break;
+    case Keyword::Weld:
+        ParseCommandWeld(tokens);
+        break;
+    case Keyword::Material:
+        // A bare 'material:' opens an inline material, whose lines apply to the active one anyway
+        if (tokens.size() == 2)
+        {
+            if (!ActiveItemHasMaterial())
+            {
+                throw std::runtime_error("Invalid 'material:' specifier for this command.");
+            }
+            *activeMaterial = materials[std::string(tokens[1])];
+        }
+        break;
+    case Keyword::Transform:
+        if (tokens.size() == 2)
+        {
+            if (!ActiveItemHasTransform())
+            {
+                throw std::runtime_error("Invalid 'transform:' specifier for this command.");
+            }
+            ParseNamedTransform(tokens[1]);
+        }
+        break;
+    case Keyword::Unknown:
+        break;
     }
 }
@@ -8,19 +8,55 @@
 #ifndef SRC_YAMLPARSER_HPP_
 #define SRC_YAMLPARSER_HPP_
 
+#include "Animation.hpp"
 #include "Camera.hpp"
+#include "ObjParser.hpp"
 #include "World.hpp"
+#include <array>
+#include <deque>
+#include <filesystem>
+#include <istream>
+#include <memory>
 #include <string>
+#include <string_view>
 
+// The space separated tokens of one line, as views into the line's own text
+class LineTokens
+{
+  public:
+    static constexpr size_t CAPACITY = 16;
+
+    std::array<std::string_view, CAPACITY> tokens;
+    size_t count = 0;
+
+    [[nodiscard]] size_t size() const noexcept { return count; }
+    [[nodiscard]] bool empty() const noexcept { return count == 0; }
+    [[nodiscard]] std::string_view operator[](size_t i) const noexcept { return tokens[i]; }
+};
+
+// Throws if the line has more than LineTokens::CAPACITY tokens
+[[nodiscard]] LineTokens TokenizeYamlLine(std::string_view line);
+
+// Parses a scene a line at a time, so nothing but the scene itself is built up while parsing and
+// a scene streamed in from a file never has to be held in memory whole
 class YamlParser
 {
   public:
     World world;
     Camera worldCamera;
     std::unordered_map<std::string, Material> materials;
-    std::unordered_map<std::string, Matrix<4>> transforms;
+    std::unordered_map<std::string, AffineTransform> transforms;
+    Sequence worldSequence;
+    // Parsed OBJ files by path and weld tolerance, each shared by every '- add: obj' that places it
+    std::unordered_map<std::string, std::shared_ptr<const Group>> meshes;
 
-    explicit YamlParser(const std::string& inputData);
+    // Relative 'file:' paths are found from directory, or the working directory if it is empty
+    explicit YamlParser(std::string_view inputData, std::filesystem::path directory = {});
+    // Reads the scene in fixed size chunks
+    explicit YamlParser(std::istream& input, std::filesystem::path directory = {});
+    // Maps the file into memory rather than reading it, falling back to reading it in chunks.
+    // Relative 'file:' paths are found from the scene file's directory.
+    [[nodiscard]] static YamlParser FromFile(const std::string& fileName);
 
   private:
     enum CommandType
@@ -32,41 +68,143 @@ class YamlParser
         transform,
         plane,
         cube,
-        sphere
+        sphere,
+        group,
+        obj,
+        sequence
+    };
+
+    // Every key that can start a line, other than the '- ' item commands
+    enum class Keyword
+    {
+        Unknown,
+        At,
+        Intensity,
+        Width,
+        Height,
+        FieldOfView,
+        From,
+        To,
+        Up,
+        Color,
+        Ambient,
+        Diffuse,
+        Specular,
+        Shininess,
+        Reflective,
+        Transparency,
+        RefractiveIndex,
+        Texture,
+        Extend,
+        Frames,
+        Keyframe,
+        Heatmap,
+        Sampler,
+        Samples,
+        Denoise,
+        File,
+        Children,
+        DetailLevels,
+        Weld,
+        Material,
+        Transform
+    };
+
+    // An animated object, known by its shape type and position among shapes of that type until
+    // parsing finishes and its index in World::objects() is known
+    class PendingAnimation
+    {
+      public:
+        CommandType shapeType;
+        size_t index;
+        std::vector<TransformKeyframe> keyframes;
     };
 
-    std::unordered_map<std::string, std::function<void(const std::vector<std::string_view>&)>> subCommandMap;
+    // A group whose children are still being parsed, and the column its '- add: group' starts at.
+    // Lines indented no further than that column are no longer the group's.
+    class OpenGroup
+    {
+      public:
+        Group group;
+        size_t column;
+    };
 
+    std::filesystem::path sceneDirectory;
     CommandType activeCommand = none;
     std::string activeItemName;
     Material* activeMaterial = nullptr;
-    Matrix<4>* activeTransform = nullptr;
+    AffineTransform* activeTransform = nullptr;
+    Instance* activeInstance = nullptr;
+    std::deque<OpenGroup> openGroups; // Innermost last; a deque so that opening a group leaves the others in place
+    size_t lineColumn = 0;            // Of the line being parsed
+    size_t activeColumn = 0;          // Of the active item's '- add:' line
+    size_t activeDetailLevels = 0;    // Asked for by the active obj's 'detail-levels:'
+    std::string activeMeshFile;       // The active obj's 'file:', loaded once the item is finished
+    MeshOptions activeMeshOptions;    // Set by the active obj's 'weld:'
+    // Simplified versions of each parsed OBJ file, most detailed first, built as far as any obj has asked
+    std::unordered_map<const Group*, std::vector<std::shared_ptr<const Group>>> meshDetailLevels;
 
     Tuple cameraFrom;
     Tuple cameraTo;
     Tuple cameraUp;
 
-    void ParseTokens(const std::vector<std::string_view>& tokens);
-    void ParseCommandAt(const std::vector<std::string_view>& tokens);
-    void ParseCommandIntensity(const std::vector<std::string_view>& tokens);
-    void ParseCommandWidth(const std::vector<std::string_view>& tokens);
-    void ParseCommandHeight(const std::vector<std::string_view>& tokens);
-    void ParseCommandFOV(const std::vector<std::string_view>& tokens);
-    void ParseCommandFrom(const std::vector<std::string_view>& tokens);
-    void ParseCommandTo(const std::vector<std::string_view>& tokens);
-    void ParseCommandUp(const std::vector<std::string_view>& tokens);
-    void ParseCommandAdd(const std::vector<std::string_view>& tokens);
-    void ParseCommandDefine(const std::vector<std::string_view>& tokens);
-    void ParseCommandTransformParameter(const std::vector<std::string_view>& tokens);
-    void ParseCommandColor(const std::vector<std::string_view>& tokens);
-    void ParseCommandAmbient(const std::vector<std::string_view>& tokens);
-    void ParseCommandDiffuse(const std::vector<std::string_view>& tokens);
-    void ParseCommandSpecular(const std::vector<std::string_view>& tokens);
-    void ParseCommandShininess(const std::vector<std::string_view>& tokens);
-    void ParseCommandReflective(const std::vector<std::string_view>& tokens);
-    void ParseCommandTransparency(const std::vector<std::string_view>& tokens);
-    void ParseCommandRefractiveIndex(const std::vector<std::string_view>& tokens);
-    void ParseCommandExtend(const std::vector<std::string_view>& tokens);
+    std::vector<TransformKeyframe> objectKeyframes; // Of the shape being added; the first is its ordinary transform
+    std::vector<PendingAnimation> pendingAnimations;
+    bool inKeyframe = false; // Whether transform and camera lines belong to the latest keyframe
+
+    [[nodiscard]] static Keyword KeywordOf(std::string_view token) noexcept;
+    void ParseLine(std::string_view line);
+    void ParseTokens(const LineTokens& tokens);
+    void ParseCommandAt(const LineTokens& tokens);
+    void ParseCommandIntensity(const LineTokens& tokens);
+    void ParseCommandWidth(const LineTokens& tokens);
+    void ParseCommandHeight(const LineTokens& tokens);
+    void ParseCommandFOV(const LineTokens& tokens);
+    void ParseCommandFrom(const LineTokens& tokens);
+    void ParseCommandTo(const LineTokens& tokens);
+    void ParseCommandUp(const LineTokens& tokens);
+    void ParseCommandAdd(const LineTokens& tokens);
+    void ParseCommandDefine(const LineTokens& tokens);
+    void ParseCommandTransformParameter(const LineTokens& tokens);
+    void ParseCommandColor(const LineTokens& tokens);
+    void ParseCommandAmbient(const LineTokens& tokens);
+    void ParseCommandDiffuse(const LineTokens& tokens);
+    void ParseCommandSpecular(const LineTokens& tokens);
+    void ParseCommandShininess(const LineTokens& tokens);
+    void ParseCommandReflective(const LineTokens& tokens);
+    void ParseCommandTransparency(const LineTokens& tokens);
+    void ParseCommandRefractiveIndex(const LineTokens& tokens);
+    void ParseCommandTexture(const LineTokens& tokens);
+    void ParseCommandExtend(const LineTokens& tokens);
+    void ParseCommandFrames(const LineTokens& tokens);
+    void ParseCommandKeyframe(const LineTokens& tokens);
+    void ParseCommandHeatmap(const LineTokens& tokens);
+    void ParseCommandSampler(const LineTokens& tokens);
+    void ParseCommandSamples(const LineTokens& tokens);
+    void ParseCommandDenoise(const LineTokens& tokens);
+    void ParseCommandFile(const LineTokens& tokens);
+    void ParseCommandChildren(const LineTokens& tokens);
+    void ParseCommandDetailLevels(const LineTokens& tokens);
+    void ParseCommandWeld(const LineTokens& tokens);
+    void ParseNamedTransform(std::string_view name);
+    [[nodiscard]] bool ActiveItemHasMaterial() const noexcept;
+    [[nodiscard]] bool ActiveItemHasTransform() const noexcept;
+    // Adds shape to the innermost open group, or to the world if no group is open
+    template <typename T>
+    T& AddShape(std::vector<T>& worldShapes, const T& shape);
+    // file as written in the scene, found from sceneDirectory if relative
+    [[nodiscard]] std::filesystem::path ScenePath(std::string_view file) const;
+    [[nodiscard]] std::shared_ptr<const Group> LoadMesh(std::string_view file, const MeshOptions& options);
+    // Up to count levels of geometry, each with a quarter of the faces of the one before. Fewer are
+    // given if simplification stops making the mesh any smaller.
+    [[nodiscard]] std::vector<std::shared_ptr<const Group>> DetailLevels(const std::shared_ptr<const Group>& geometry, size_t count);
+    // Finishes the active item and closes the groups a line at column is outside of. keyLine says
+    // whether the line is a key, which belongs to the innermost group left open unless it is the
+    // active item's own.
+    void CloseGroups(size_t column, bool keyLine);
+    void FinishItem();
+    void FinishSequence();
+    void FinishScene();
 };
 
 #endif /* SRC_YAMLPARSER_HPP_ */
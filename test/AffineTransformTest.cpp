@@ -0,0 +1,68 @@
+/*
+ * AffineTransformTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "AffineTransform.hpp"
+#include "Transformation.hpp"
+#include "gtest/gtest.h"
+#include <numbers>
+
+TEST(AffineTransformTest, DefaultIsIdentity)
+{
+	AffineTransform t;
+
+	EXPECT_EQ(t, IdentityMatrix());
+	EXPECT_EQ(t * Point(1, 2, 3), Point(1, 2, 3));
+}
+
+TEST(AffineTransformTest, TransformsMatchMatrix)
+{
+	Matrix<4> m = translation(10, 5, 7) * scaling(5, 2, 5) * rotationX(std::numbers::pi_v<float> / 3) * shearing(1, 0, 0.5f, 0, 0, 1);
+	AffineTransform t = m;
+
+	EXPECT_EQ(t * Point(1, -2, 3), m * Point(1, -2, 3));
+	EXPECT_EQ(t * Vector(1, -2, 3), m * Vector(1, -2, 3));
+	EXPECT_EQ(t.matrix(), m);
+}
+
+TEST(AffineTransformTest, InverseMatchesMatrixInverse)
+{
+	Matrix<4> m = translation(-3, 4, 1) * rotationY(0.8f) * scaling(2, 0.5f, 3);
+	AffineTransform t = m;
+
+	EXPECT_EQ(t.inverse(), m.inverse());
+	EXPECT_EQ(t.inverse().inverse(), m);
+}
+
+TEST(AffineTransformTest, CompositionComposesInverses)
+{
+	Matrix<4> a = translation(1, 2, 3) * rotationZ(0.3f);
+	Matrix<4> b = scaling(2, 4, 0.5f) * rotationX(1.1f);
+	AffineTransform product = AffineTransform(a) * AffineTransform(b);
+
+	EXPECT_EQ(product, a * b);
+	EXPECT_EQ(product.inverse(), (a * b).inverse());
+}
+
+TEST(AffineTransformTest, TransformNormalUsesInverseTranspose)
+{
+	Matrix<4> m = translation(5, -3, 2) * scaling(1, 0.5f, 1) * rotationZ(std::numbers::pi_v<float> / 5);
+	AffineTransform t = m;
+	Tuple objectNormal = Vector(0, std::numbers::sqrt2_v<float> / 2, -std::numbers::sqrt2_v<float> / 2);
+	Tuple expected = m.inverse().transpose() * objectNormal;
+	expected.w = 0.0f;
+
+	EXPECT_EQ(t.transformNormal(objectNormal), expected);
+}
+
+TEST(AffineTransformTest, TransformsAreConstexpr)
+{
+	constexpr AffineTransform t = translation(1, 2, 3) * scaling(2, 2, 2);
+	static_assert(t * Point(1, 1, 1) == Point(3, 4, 5));
+	static_assert(t.inverse() * Point(3, 4, 5) == Point(1, 1, 1));
+
+	EXPECT_EQ(t.inverse() * Point(3, 4, 5), Point(1, 1, 1));
+}
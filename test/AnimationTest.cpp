@@ -0,0 +1,124 @@
+/*
+ * AnimationTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Animation.hpp"
+#include "Camera.hpp"
+#include "Transformation.hpp"
+#include "World.hpp"
+#include "gtest/gtest.h"
+#include <numbers>
+#include <stdexcept>
+
+TransformKeyframe StepKeyframe(uint32_t frame, TransformStep::Operation operation, const Tuple& amount)
+{
+	TransformKeyframe keyframe;
+	keyframe.frame = frame;
+	keyframe.steps.push_back({operation, amount});
+	return keyframe;
+}
+
+TEST(AnimationTest, KeyframeAppliesStepsInOrder)
+{
+	TransformKeyframe keyframe;
+	keyframe.base = scaling(2, 2, 2);
+	keyframe.steps.push_back({TransformStep::Translate, Vector(1, 0, 0)});
+	keyframe.steps.push_back({TransformStep::Rotate, Vector(0, 0, std::numbers::pi_v<float> / 2)});
+
+	EXPECT_EQ(keyframe.transform(), rotationZ(std::numbers::pi_v<float> / 2) * translation(1, 0, 0) * scaling(2, 2, 2));
+}
+
+TEST(AnimationTest, InterpolatesMatchingStepsByParameter)
+{
+	ObjectAnimation animation;
+	animation.keyframes.push_back(StepKeyframe(0, TransformStep::Rotate, Vector(0, 0, 0)));
+	animation.keyframes.push_back(StepKeyframe(10, TransformStep::Rotate, Vector(0, std::numbers::pi_v<float>, 0)));
+
+	// Halfway through a half turn is a quarter turn, not a squashed blend of the two ends
+	const AffineTransform halfway = animation.transformAt(5);
+	EXPECT_EQ(halfway, AffineTransform(rotationY(std::numbers::pi_v<float> / 2)));
+	EXPECT_FLOAT_EQ((halfway * Vector(1, 0, 0)).magnitude(), 1.0f);
+}
+
+TEST(AnimationTest, InterpolatesMismatchedStepsByElement)
+{
+	ObjectAnimation animation;
+	animation.keyframes.push_back(StepKeyframe(0, TransformStep::Translate, Vector(2, 0, 0)));
+	animation.keyframes.push_back(StepKeyframe(4, TransformStep::Scale, Vector(3, 3, 3)));
+
+	Matrix<4> expected = IdentityMatrix();
+	expected[0][3] = 1.5f;
+	expected[0][0] = 1.5f;
+	expected[1][1] = 1.5f;
+	expected[2][2] = 1.5f;
+	EXPECT_EQ(animation.transformAt(1).matrix(), expected);
+}
+
+TEST(AnimationTest, HoldsFirstAndLastKeyframes)
+{
+	ObjectAnimation animation;
+	animation.keyframes.push_back(StepKeyframe(2, TransformStep::Translate, Vector(1, 0, 0)));
+	animation.keyframes.push_back(StepKeyframe(6, TransformStep::Translate, Vector(5, 0, 0)));
+
+	EXPECT_EQ(animation.transformAt(0), AffineTransform(translation(1, 0, 0)));
+	EXPECT_EQ(animation.transformAt(4), AffineTransform(translation(3, 0, 0)));
+	EXPECT_EQ(animation.transformAt(9), AffineTransform(translation(5, 0, 0)));
+}
+
+TEST(AnimationTest, CameraInterpolatesViewParameters)
+{
+	Sequence sequence;
+	sequence.cameraKeyframes.push_back({0, Point(0, 0, -4), Point(0, 0, 0), Vector(0, 1, 0)});
+	sequence.cameraKeyframes.push_back({8, Point(0, 0, -8), Point(0, 0, 0), Vector(0, 1, 0)});
+
+	EXPECT_EQ(sequence.cameraTransformAt(4), AffineTransform(ViewTransform(Point(0, 0, -6), Point(0, 0, 0), Vector(0, 1, 0))));
+}
+
+TEST(AnimationTest, ApplyPosesCameraAndObjects)
+{
+	World w;
+	w.spheres.push_back(Sphere());
+	w.spheres.push_back(Sphere());
+	w.buildAcceleration();
+	Camera c(10, 10, 1);
+	Sequence sequence;
+	sequence.frameCount = 3;
+	sequence.cameraKeyframes.push_back({0, Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0)});
+	ObjectAnimation animation;
+	animation.object = 1;
+	animation.keyframes.push_back(StepKeyframe(0, TransformStep::Translate, Vector(0, 0, 0)));
+	animation.keyframes.push_back(StepKeyframe(2, TransformStep::Translate, Vector(0, 10, 0)));
+	sequence.objects.push_back(animation);
+
+	EXPECT_TRUE(sequence.animated());
+	sequence.apply(2, w, c);
+
+	EXPECT_EQ(c.transform, AffineTransform(ViewTransform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0))));
+	EXPECT_EQ(w.spheres[0].transform, AffineTransform());
+	EXPECT_EQ(w.spheres[1].transform, AffineTransform(translation(0, 10, 0)));
+	// The top level was refit, so the moved sphere is found where it now is
+	EXPECT_EQ(w.intersect(Ray(Point(0, 10, -5), Vector(0, 0, 1))).size(), 2);
+}
+
+TEST(AnimationTest, ApplyRefusesObjectsOutsideTheWorld)
+{
+	World w;
+	w.spheres.push_back(Sphere());
+	w.buildAcceleration();
+	Camera c(10, 10, 1);
+	Sequence sequence;
+	sequence.frameCount = 2;
+	sequence.cameraKeyframes.push_back({0, Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0)});
+	ObjectAnimation animation;
+	animation.object = 1;
+	animation.keyframes.push_back(StepKeyframe(0, TransformStep::Translate, Vector(0, 10, 0)));
+	sequence.objects.push_back(animation);
+
+	EXPECT_THROW(sequence.apply(1, w, c), std::runtime_error);
+	// Nothing was posed before the bad index was found
+	EXPECT_EQ(c.transform, AffineTransform());
+	EXPECT_EQ(w.spheres[0].transform, AffineTransform());
+}
@@ -0,0 +1,89 @@
+/*
+ * ArenaTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "gtest/gtest.h"
+#include "Arena.hpp"
+#include "Ray.hpp"
+#include "Shape.hpp"
+#include <cstdint>
+
+TEST(ArenaTest, AllocationsAreAligned)
+{
+	Arena arena(256);
+	void* a = arena.allocate(3, 1);
+	void* b = arena.allocate(16, 16);
+
+	EXPECT_NE(a, b);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 16, 0);
+}
+
+TEST(ArenaTest, ResetReusesMemory)
+{
+	Arena arena(256);
+	void* first = arena.allocate(64, 8);
+	static_cast<void>(arena.allocate(64, 8));
+	EXPECT_GE(arena.bytesInUse(), 128);
+
+	arena.reset();
+
+	EXPECT_EQ(arena.bytesInUse(), 0);
+	EXPECT_EQ(arena.allocate(64, 8), first);
+}
+
+TEST(ArenaTest, GrowsPastBlockSize)
+{
+	Arena arena(64);
+	static_cast<void>(arena.allocate(48, 8));
+	static_cast<void>(arena.allocate(48, 8));
+	static_cast<void>(arena.allocate(1000, 8));
+
+	EXPECT_GE(arena.capacity(), 1096);
+}
+
+TEST(ArenaTest, MostRecentAllocationCanBeReturned)
+{
+	Arena arena(256);
+	void* a = arena.allocate(32, 8);
+	arena.deallocate(a, 32);
+
+	EXPECT_EQ(arena.bytesInUse(), 0);
+}
+
+TEST(ArenaTest, NoArenaOutsideOfScope)
+{
+	EXPECT_EQ(Arena::current(), nullptr);
+	{
+		ArenaScope scope;
+		EXPECT_EQ(Arena::current(), &Arena::threadLocal());
+	}
+	EXPECT_EQ(Arena::current(), nullptr);
+}
+
+TEST(ArenaTest, ScopeResetsArenaWhenItEnds)
+{
+	{
+		ArenaScope scope;
+		ArenaVector<int> values = {1, 2, 3};
+		EXPECT_GT(Arena::threadLocal().bytesInUse(), 0);
+	}
+	EXPECT_EQ(Arena::threadLocal().bytesInUse(), 0);
+}
+
+TEST(ArenaTest, IntersectionsUseArenaInsideScope)
+{
+	Sphere s;
+	Ray r(Point(0, 0, -5), Vector(0, 0, 1));
+	{
+		ArenaScope scope;
+		auto xs = s.intersect(r);
+		EXPECT_EQ(xs.get_allocator().arena, Arena::current());
+		EXPECT_EQ(xs.size(), 2);
+	}
+	auto xs = s.intersect(r);
+	EXPECT_EQ(xs.get_allocator().arena, nullptr);
+	EXPECT_EQ(xs.size(), 2);
+}
@@ -0,0 +1,104 @@
+/*
+ * BoundingBoxTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "BoundingBox.hpp"
+#include "Ray.hpp"
+#include "Shape.hpp"
+#include "Transformation.hpp"
+#include "gtest/gtest.h"
+#include <numbers>
+
+TEST(BoundingBoxTest, DefaultBoxIsEmpty)
+{
+	BoundingBox box;
+
+	EXPECT_TRUE(box.empty());
+	EXPECT_FALSE(box.bounded());
+	EXPECT_FLOAT_EQ(box.surfaceArea(), 0.0f);
+}
+
+TEST(BoundingBoxTest, AddingPointsGrowsBox)
+{
+	BoundingBox box;
+	box.add(Point(-5, 2, 0));
+	box.add(Point(7, 0, -3));
+
+	EXPECT_EQ(box, BoundingBox(Point(-5, 0, -3), Point(7, 2, 0)));
+	EXPECT_TRUE(box.contains(Point(0, 1, -1)));
+	EXPECT_FALSE(box.contains(Point(0, 3, -1)));
+	EXPECT_EQ(box.centroid(), Point(1, 1, -1.5f));
+	EXPECT_EQ(box.largestAxis(), 0u);
+}
+
+TEST(BoundingBoxTest, AddingEmptyBoxChangesNothing)
+{
+	BoundingBox box(Point(-1, -1, -1), Point(1, 1, 1));
+	box.add(BoundingBox());
+
+	EXPECT_EQ(box, BoundingBox(Point(-1, -1, -1), Point(1, 1, 1)));
+}
+
+TEST(BoundingBoxTest, PrimitiveShapeBounds)
+{
+	Cylinder cylinder;
+	cylinder.minimum = -5;
+	cylinder.maximum = 3;
+	Cone cone;
+	cone.minimum = -5;
+	cone.maximum = 3;
+	Triangle triangle(Point(-3, 7, 2), Point(6, 2, -4), Point(2, -1, -1));
+
+	EXPECT_EQ(Sphere().bounds(), BoundingBox(Point(-1, -1, -1), Point(1, 1, 1)));
+	EXPECT_FALSE(Plane().bounds().bounded());
+	EXPECT_FALSE(Cylinder().bounds().bounded());
+	EXPECT_EQ(cylinder.bounds(), BoundingBox(Point(-1, -5, -1), Point(1, 3, 1)));
+	EXPECT_EQ(cone.bounds(), BoundingBox(Point(-5, -5, -5), Point(5, 3, 5)));
+	EXPECT_EQ(triangle.bounds(), BoundingBox(Point(-3, -1, -4), Point(6, 7, 2)));
+}
+
+TEST(BoundingBoxTest, TransformedBoxCoversRotatedCorners)
+{
+	BoundingBox box(Point(-1, -1, -1), Point(1, 1, 1));
+	BoundingBox rotated = box.transform(rotationX(std::numbers::pi_v<float> / 4) * rotationY(std::numbers::pi_v<float> / 4));
+
+	EXPECT_NEAR(rotated.minimum.x, -1.41421f, 0.0001f);
+	EXPECT_NEAR(rotated.minimum.y, -1.70711f, 0.0001f);
+	EXPECT_NEAR(rotated.minimum.z, -1.70711f, 0.0001f);
+	EXPECT_NEAR(rotated.maximum.x, 1.41421f, 0.0001f);
+	EXPECT_NEAR(rotated.maximum.y, 1.70711f, 0.0001f);
+	EXPECT_NEAR(rotated.maximum.z, 1.70711f, 0.0001f);
+}
+
+TEST(BoundingBoxTest, GroupBoundsContainTransformedChildren)
+{
+	Group g;
+	Sphere s;
+	s.transform = translation(2, 5, -3) * scaling(2, 2, 2);
+	Cylinder c;
+	c.minimum = -2;
+	c.maximum = 2;
+	c.transform = translation(-4, -1, 4) * scaling(0.5f, 1, 0.5f);
+	g.addChild(s);
+	g.addChild(c);
+
+	EXPECT_EQ(g.bounds(), BoundingBox(Point(-4.5f, -3, -5), Point(4, 7, 4.5f)));
+}
+
+TEST(BoundingBoxTest, RayIntersectsBox)
+{
+	BoundingBox box(Point(5, -2, 0), Point(11, 4, 7));
+
+	auto span = box.intersect(Ray(Point(15, 1, 2), Vector(-1, 0, 0)));
+	ASSERT_TRUE(span);
+	EXPECT_FLOAT_EQ(span->first, 4);
+	EXPECT_FLOAT_EQ(span->second, 10);
+
+	EXPECT_FALSE(box.intersect(Ray(Point(15, 1, 2), Vector(1, 0, 0)), 0));
+	EXPECT_TRUE(box.intersect(Ray(Point(15, 1, 2), Vector(1, 0, 0))));
+	EXPECT_FALSE(box.intersect(Ray(Point(9, -1, -8), Vector(2, 4, 6))));
+	EXPECT_FALSE(box.intersect(Ray(Point(4, 1, 2), Vector(0, 0, 1))));
+}
@@ -0,0 +1,163 @@
+/*
+ * BoundingVolumeHierarchyTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "BoundingVolumeHierarchy.hpp"
+#include "Ray.hpp"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <vector>
+
+std::vector<BoundingBox> PlaneOfUnitBoxes(int side)
+{
+	std::vector<BoundingBox> boxes;
+	for (int i = 0; i < side; i++)
+	{
+		for (int j = 0; j < side; j++)
+		{
+			const auto x = static_cast<float>(i * 3);
+			const auto y = static_cast<float>(j * 3);
+			boxes.emplace_back(Point(x - 1, y - 1, -1), Point(x + 1, y + 1, 1));
+		}
+	}
+	return boxes;
+}
+
+TEST(BoundingVolumeHierarchyTest, EmptyHierarchyHasNoCandidates)
+{
+	BoundingVolumeHierarchy bvh;
+	bvh.build({});
+
+	EXPECT_TRUE(bvh.built());
+	EXPECT_TRUE(bvh.nodes().empty());
+	EXPECT_TRUE(bvh.candidates(Ray(Point(0, 0, -5), Vector(0, 0, 1))).empty());
+}
+
+TEST(BoundingVolumeHierarchyTest, SinglePrimitiveIsOneLeaf)
+{
+	BoundingVolumeHierarchy bvh;
+	const BVHStatistics& statistics = bvh.build(PlaneOfUnitBoxes(1));
+
+	ASSERT_EQ(bvh.nodes().size(), 1u);
+	EXPECT_TRUE(bvh.nodes()[0].isLeaf());
+	EXPECT_EQ(statistics.depth, 1u);
+	EXPECT_EQ(statistics.leafCount, 1u);
+	EXPECT_FLOAT_EQ(statistics.sahCost, 1.0f);
+}
+
+TEST(BoundingVolumeHierarchyTest, StatisticsDescribeTree)
+{
+	BoundingVolumeHierarchy bvh;
+	const BVHStatistics& statistics = bvh.build(PlaneOfUnitBoxes(32));
+
+	EXPECT_EQ(statistics.nodeCount, bvh.nodes().size());
+	EXPECT_EQ(statistics.nodeCount, 2 * statistics.leafCount - 1);
+	EXPECT_GE(statistics.minimumLeafSize, 1u);
+	EXPECT_LE(statistics.maximumLeafSize, BoundingVolumeHierarchy::MAXIMUM_LEAF_SIZE);
+	EXPECT_FLOAT_EQ(statistics.averageLeafSize, 1024.0f / static_cast<float>(statistics.leafCount));
+	EXPECT_GE(statistics.depth, 6u);
+	EXPECT_LT(statistics.depth, 32u);
+	// Far cheaper than testing all 1024 boxes
+	EXPECT_GT(statistics.sahCost, 1.0f);
+	EXPECT_LT(statistics.sahCost, 100.0f);
+	EXPECT_GE(statistics.buildSeconds, 0.0);
+	EXPECT_FALSE(statistics.summary().empty());
+}
+
+TEST(BoundingVolumeHierarchyTest, ChildrenLieWithinParents)
+{
+	BoundingVolumeHierarchy bvh;
+	bvh.build(PlaneOfUnitBoxes(16));
+
+	for (const BVHNode& node : bvh.nodes())
+	{
+		if (!node.isLeaf())
+		{
+			EXPECT_TRUE(node.bounds.contains(bvh.nodes()[node.first].bounds.minimum));
+			EXPECT_TRUE(node.bounds.contains(bvh.nodes()[node.first].bounds.maximum));
+			EXPECT_TRUE(node.bounds.contains(bvh.nodes()[node.first + 1].bounds.minimum));
+			EXPECT_TRUE(node.bounds.contains(bvh.nodes()[node.first + 1].bounds.maximum));
+		}
+	}
+}
+
+TEST(BoundingVolumeHierarchyTest, CandidatesAlongRay)
+{
+	BoundingVolumeHierarchy bvh;
+	bvh.build(PlaneOfUnitBoxes(16));
+
+	// Straight through the middle of the box at (30, 30), which is index 10 * 16 + 10
+	auto candidates = bvh.candidates(Ray(Point(30, 30, -5), Vector(0, 0, 1)));
+	EXPECT_NE(std::find(candidates.begin(), candidates.end(), 170u), candidates.end());
+	EXPECT_LE(candidates.size(), BoundingVolumeHierarchy::MAXIMUM_LEAF_SIZE);
+
+	// Along the row of boxes at x = 21, so every box in it, even those behind the origin
+	candidates = bvh.candidates(Ray(Point(21, 20, 0), Vector(0, 1, 0)));
+	ASSERT_GE(candidates.size(), 16u);
+	EXPECT_TRUE(std::is_sorted(candidates.begin(), candidates.end()));
+	for (uint32_t j = 0; j < 16; j++)
+	{
+		EXPECT_NE(std::find(candidates.begin(), candidates.end(), 7 * 16 + j), candidates.end());
+	}
+}
+
+TEST(BoundingVolumeHierarchyTest, CoincidentCentroidsStillLimitLeafSize)
+{
+	BoundingVolumeHierarchy bvh;
+	std::vector<BoundingBox> boxes(20, BoundingBox(Point(-1, -1, -1), Point(1, 1, 1)));
+	const BVHStatistics& statistics = bvh.build(boxes);
+
+	EXPECT_LE(statistics.maximumLeafSize, BoundingVolumeHierarchy::MAXIMUM_LEAF_SIZE);
+	EXPECT_EQ(bvh.candidates(Ray(Point(0, 0, -5), Vector(0, 0, 1))).size(), 20u);
+}
+
+TEST(BoundingVolumeHierarchyTest, UnboundedPrimitivesAreAlwaysCandidates)
+{
+	BoundingVolumeHierarchy bvh;
+	std::vector<BoundingBox> boxes = PlaneOfUnitBoxes(4);
+	boxes.push_back(BoundingBox::Infinite());
+	bvh.build(boxes);
+
+	auto candidates = bvh.candidates(Ray(Point(0, 0, 50), Vector(1, 0, 0)));
+	ASSERT_EQ(candidates.size(), 1u);
+	EXPECT_EQ(candidates[0], 16u);
+}
+
+TEST(BoundingVolumeHierarchyTest, RefitKeepsShapeAndMovesBounds)
+{
+	BoundingVolumeHierarchy bvh;
+	std::vector<BoundingBox> boxes = PlaneOfUnitBoxes(8);
+	bvh.build(boxes);
+	const std::vector<BVHNode> before = bvh.nodes();
+
+	boxes[5] = BoundingBox(Point(99, 99, 99), Point(100, 100, 100));
+	ASSERT_TRUE(bvh.refit(boxes));
+
+	ASSERT_EQ(bvh.nodes().size(), before.size());
+	for (size_t i = 0; i < before.size(); i++)
+	{
+		EXPECT_EQ(bvh.nodes()[i].first, before[i].first);
+		EXPECT_EQ(bvh.nodes()[i].count, before[i].count);
+	}
+	EXPECT_EQ(bvh.nodes()[0].bounds.maximum, Point(100, 100, 100));
+	// Only the moved box's leaf reaches out there
+	auto candidates = bvh.candidates(Ray(Point(99.5f, 99.5f, 0), Vector(0, 0, 1)));
+	EXPECT_NE(std::find(candidates.begin(), candidates.end(), 5u), candidates.end());
+	EXPECT_LE(candidates.size(), BoundingVolumeHierarchy::MAXIMUM_LEAF_SIZE);
+	EXPECT_GT(bvh.statistics().sahCost, 0.0f);
+}
+
+TEST(BoundingVolumeHierarchyTest, RefitRejectsDifferentPrimitives)
+{
+	BoundingVolumeHierarchy bvh;
+	std::vector<BoundingBox> boxes = PlaneOfUnitBoxes(4);
+	bvh.build(boxes);
+
+	EXPECT_FALSE(bvh.refit(PlaneOfUnitBoxes(5)));
+	boxes[3] = BoundingBox::Infinite();
+	EXPECT_FALSE(bvh.refit(boxes));
+	EXPECT_EQ(bvh.primitiveCount(), 16u);
+}
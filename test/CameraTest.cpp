@@ -13,6 +13,7 @@
 #include "Transformation.hpp"
 #include "World.hpp"
 #include "Canvas.hpp"
+#include "Statistics.hpp"
 
 TEST(CameraTest, CameraConstruction)
 {
@@ -28,6 +29,43 @@ TEST(CameraTest, CameraConstruction)
 	EXPECT_EQ(c.transform, IdentityMatrix());
 }
 
+TEST(CameraTest, CamerasRenderingDifferentlyAreNotEqual)
+{
+	const Camera c(160, 120, std::numbers::pi / 2);
+	EXPECT_EQ(c, Camera(160, 120, std::numbers::pi / 2));
+
+	Camera wavefront = c;
+	wavefront.renderMode = Camera::Wavefront;
+	EXPECT_NE(c, wavefront);
+
+	Camera costs = c;
+	costs.costMeasure = Camera::Rays;
+	EXPECT_NE(c, costs);
+
+	Camera tiles = c;
+	tiles.tileSize = 8;
+	EXPECT_NE(c, tiles);
+
+	Camera sobol = c;
+	sobol.sampler.sequence = Sampler::Sobol;
+	EXPECT_NE(c, sobol);
+
+	Camera seeded = c;
+	seeded.sampler.seed = 1;
+	EXPECT_NE(c, seeded);
+
+	Camera sampled = c;
+	sampled.samplesPerPixel = 4;
+	EXPECT_NE(c, sampled);
+
+	Camera denoised = c;
+	denoised.denoise = DenoiseSettings();
+	EXPECT_NE(c, denoised);
+	Camera filteredFurther = denoised;
+	filteredFurther.denoise->iterations = 3;
+	EXPECT_NE(denoised, filteredFurther);
+}
+
 TEST(CameraTest, PixelSizeForHorizontalCanvas)
 {
 	Camera c = Camera(200, 125, std::numbers::pi / 2);
@@ -70,6 +108,57 @@ TEST(CameraTest, RayThroughCanvasWhenCameraTransformed)
 	EXPECT_EQ(r.direction, Vector(sqrt(2) / 2, 0, -sqrt(2) / 2));
 }
 
+TEST(CameraTest, RayDifferentialsMatchNeighbouringPixels)
+{
+	Camera c = Camera(201, 101, std::numbers::pi / 2);
+	c.transform = rotationY(std::numbers::pi / 4) * translation(0, -2, 5);
+	const DifferentialRay r = c.differentialRayForPixel(30, 20, 0.5F, 0.5F);
+	const Ray right = c.rayForPixel(31, 20);
+	const Ray below = c.rayForPixel(30, 21);
+
+	EXPECT_EQ(r.ray.direction, c.rayForPixel(30, 20).direction);
+	ASSERT_TRUE(r.differential);
+	EXPECT_EQ(r.differential->originX, Vector(0, 0, 0));
+	EXPECT_EQ(r.differential->originY, Vector(0, 0, 0));
+	const Tuple dx = right.direction - r.ray.direction;
+	const Tuple dy = below.direction - r.ray.direction;
+	EXPECT_NEAR(r.differential->directionX.x, dx.x, 1e-4);
+	EXPECT_NEAR(r.differential->directionX.y, dx.y, 1e-4);
+	EXPECT_NEAR(r.differential->directionX.z, dx.z, 1e-4);
+	EXPECT_NEAR(r.differential->directionY.x, dy.x, 1e-4);
+	EXPECT_NEAR(r.differential->directionY.y, dy.y, 1e-4);
+	EXPECT_NEAR(r.differential->directionY.z, dy.z, 1e-4);
+}
+
+TEST(CameraTest, RayThroughPointWithinPixel)
+{
+	Camera c = Camera(201, 101, std::numbers::pi / 2);
+
+	EXPECT_EQ(c.rayForPixel(100, 50, 0.5F, 0.5F).direction, c.rayForPixel(100, 50).direction);
+	// The top left corner of the top left pixel is the corner of the canvas
+	EXPECT_EQ(c.rayForPixel(0, 0, 0.0F, 0.0F).direction, Vector(0.66630, 0.33481, -0.66630));
+	EXPECT_EQ(c.rayForPixel(0, 0, 1.0F, 1.0F).direction, c.rayForPixel(1, 1, 0.0F, 0.0F).direction);
+}
+
+TEST(CameraTest, SampleRaysNarrowTheirDifferentials)
+{
+	Camera c = Camera(201, 101, std::numbers::pi / 2);
+	c.sampler.sequence = Sampler::Sobol;
+	const DifferentialRay pixel = c.differentialRayForPixel(30, 20, 0.5F, 0.5F);
+
+	// A single sample still covers the whole pixel
+	EXPECT_EQ(c.rayForSample(30, 20, 0).differential->directionX, pixel.differential->directionX);
+	c.samplesPerPixel = 4;
+	for (uint32_t i = 0; i < c.samplesPerPixel; i++)
+	{
+		const DifferentialRay r = c.rayForSample(30, 20, i);
+		const std::array<float, 2> position = c.sampler.sample(30, 20, i);
+		EXPECT_EQ(r.ray.direction, c.rayForPixel(30, 20, position[0], position[1]).direction);
+		EXPECT_NEAR(r.differential->directionX.magnitude(), pixel.differential->directionX.magnitude() / 2, 1e-4);
+		EXPECT_NEAR(r.differential->directionY.magnitude(), pixel.differential->directionY.magnitude() / 2, 1e-4);
+	}
+}
+
 TEST(CameraTest, RenderingAWorld)
 {
 	World w = World::BaseWorld();
@@ -91,3 +180,164 @@ TEST(CameraTest, RenderingAWorld)
 
 
 
+
+TEST(CameraTest, WavefrontRenderMatchesDepthFirstRender)
+{
+	World w = World::BaseWorld();
+	Plane p;
+	p.transform = translation(0, -1, 0);
+	p.material.reflectivity = 0.5f;
+	p.material.transparency = 0.5f;
+	p.material.refractiveIndex = 1.5f;
+	w.planes.push_back(p);
+	Camera c = Camera(21, 13, std::numbers::pi / 2);
+	c.transform = ViewTransform(Point(0, 1, -5), Point(0, 0, 0), Vector(0, 1, 0));
+	c.tileSize = 8;
+	Canvas depthFirst = c.Render(w);
+	c.renderMode = Camera::Wavefront;
+	Canvas wavefront = c.Render(w);
+
+	for (uint32_t y = 0; y < c.vSize; y++)
+	{
+		for (uint32_t x = 0; x < c.hSize; x++)
+		{
+			EXPECT_EQ(wavefront.pixels[y][x], depthFirst.pixels[y][x]);
+		}
+	}
+}
+
+TEST(CameraTest, WavefrontRouletteDoesNotDependOnMaterialAddresses)
+{
+	// Two reflective spheres, stored in opposite orders so their materials' addresses are too
+	Sphere left;
+	left.transform = translation(-1.2f, 0, 0);
+	left.material.reflectivity = 0.5f;
+	Sphere right;
+	right.transform = translation(1.2f, 0, 0);
+	right.material.color = Color(0.2f, 0.4f, 0.9f);
+	right.material.reflectivity = 0.7f;
+	Plane floor;
+	floor.transform = translation(0, -1, 0);
+	floor.material.reflectivity = 0.3f;
+	std::vector<World> worlds(2);
+	for (World& w : worlds)
+	{
+		w.light = Light(Point(-10, 10, -10), Color(1, 1, 1));
+		w.rayTree.russianRoulette = true;
+		w.rayTree.rouletteThreshold = 1.0f;
+		w.spheres = &w == &worlds[0] ? std::vector<Sphere>{left, right} : std::vector<Sphere>{right, left};
+		w.planes.push_back(floor);
+		w.buildAcceleration();
+	}
+
+	Camera c = Camera(21, 13, std::numbers::pi / 2);
+	c.transform = ViewTransform(Point(0, 1, -5), Point(0, 0, 0), Vector(0, 1, 0));
+	c.renderMode = Camera::Wavefront;
+	EXPECT_EQ(c.Render(worlds[0]).GetPPMString(), c.Render(worlds[1]).GetPPMString());
+}
+
+TEST(CameraTest, RenderingAWorldInWavefrontMode)
+{
+	World w = World::BaseWorld();
+	Camera c = Camera(11, 11, std::numbers::pi / 2);
+	c.transform = ViewTransform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0));
+	c.renderMode = Camera::Wavefront;
+	Canvas image = c.Render(w);
+
+	EXPECT_EQ(image.pixels[5][5], Color(0.38066, 0.47583, 0.2855));
+}
+
+TEST(CameraTest, RenderingWithSamples)
+{
+	World w = World::BaseWorld();
+	Camera c = Camera(11, 11, std::numbers::pi / 2);
+	c.transform = ViewTransform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0));
+	c.sampler.sequence = Sampler::BlueNoise;
+	c.samplesPerPixel = 16;
+	const Canvas depthFirst = c.Render(w);
+	c.renderMode = Camera::Wavefront;
+	const Canvas wavefront = c.Render(w);
+
+	// The pixel's average is close to its centre, where the sphere's shading changes slowly
+	EXPECT_NEAR(depthFirst.pixels[5][5].r, 0.38066, 0.01);
+	EXPECT_NEAR(depthFirst.pixels[5][5].g, 0.47583, 0.01);
+	EXPECT_NEAR(depthFirst.pixels[5][5].b, 0.2855, 0.01);
+	for (uint32_t y = 0; y < c.vSize; y++)
+	{
+		for (uint32_t x = 0; x < c.hSize; x++)
+		{
+			EXPECT_EQ(wavefront.pixels[y][x], depthFirst.pixels[y][x]);
+		}
+	}
+}
+
+TEST(CameraTest, RenderingWithFeatures)
+{
+	World w = World::BaseWorld();
+	Camera c = Camera(11, 11, std::numbers::pi / 2);
+	c.transform = ViewTransform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0));
+	FeatureBuffers features(c.hSize, c.vSize);
+	const Canvas image = c.Render(w, features);
+	const Canvas plain = c.Render(w);
+
+	EXPECT_EQ(image.pixels[5][5], plain.pixels[5][5]);
+	EXPECT_EQ(features.albedo.pixels[5][5], Color(0.8, 1.0, 0.6));
+	EXPECT_EQ(features.normal.pixels[5][5], Color(0, 0, -1));
+	EXPECT_EQ(features.depth.pixels[5][5], Color(4, 4, 4));
+	// The corner sees nothing
+	EXPECT_EQ(image.pixels[0][0], Color(0, 0, 0));
+	EXPECT_EQ(features.depth.pixels[0][0], Color(0, 0, 0));
+
+	// With several samples, the features are averaged like the colour
+	c.sampler.sequence = Sampler::Sobol;
+	c.samplesPerPixel = 4;
+	FeatureBuffers sampledFeatures(c.hSize, c.vSize);
+	const Canvas sampled = c.Render(w, sampledFeatures);
+	EXPECT_EQ(sampled.pixels[5][5], c.Render(w).pixels[5][5]);
+	// Off centre, the sphere curves away from the camera
+	EXPECT_GT(sampledFeatures.depth.pixels[5][5].r, 4);
+	EXPECT_LT(sampledFeatures.depth.pixels[5][5].r, 4.2);
+}
+
+TEST(CameraTest, RenderingWithCostsMatchesRender)
+{
+	World w = World::BaseWorld();
+	Camera c = Camera(11, 11, std::numbers::pi / 2);
+	c.transform = ViewTransform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0));
+	c.costMeasure = Camera::Time;
+	Canvas costs(c.hSize, c.vSize);
+	Canvas image = c.Render(w, costs);
+	Canvas expected = c.Render(w);
+
+	bool anyCost = false;
+	for (uint32_t y = 0; y < c.vSize; y++)
+	{
+		for (uint32_t x = 0; x < c.hSize; x++)
+		{
+			EXPECT_EQ(image.pixels[y][x], expected.pixels[y][x]);
+			EXPECT_GE(costs.pixels[y][x].r, 0.0f);
+			EXPECT_EQ(costs.pixels[y][x].r, costs.pixels[y][x].g);
+			anyCost = anyCost || costs.pixels[y][x].r > 0.0f;
+		}
+	}
+	EXPECT_TRUE(anyCost);
+}
+
+TEST(CameraTest, RenderingWithCostsCountsRaysPerPixel)
+{
+	if constexpr (!RenderStatistics::Enabled)
+	{
+		GTEST_SKIP() << "Built without ENABLE_STATISTICS";
+	}
+
+	World w = World::BaseWorld();
+	Camera c = Camera(11, 11, std::numbers::pi / 2);
+	c.transform = ViewTransform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0));
+	c.costMeasure = Camera::Rays;
+	Canvas costs(c.hSize, c.vSize);
+	(void)c.Render(w, costs);
+
+	// A miss traces only its primary ray, a hit on the matte spheres adds a shadow ray
+	EXPECT_EQ(costs.pixels[0][0].r, 1.0f);
+	EXPECT_EQ(costs.pixels[5][5].r, 2.0f);
+}
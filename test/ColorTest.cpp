@@ -71,4 +71,23 @@ TEST(ColorTest, MultiplyColors)
 	EXPECT_EQ(c1 * c2, Color(0.9, 0.2, 0.04));
 }
 
+TEST(ColorTest, ColorsAreConstexpr)
+{
+	static_assert(Color::White * 0.5f == Color(0.5f, 0.5f, 0.5f));
+	static_assert(Color::Black + Color(0.1f, 0.2f, 0.3f) != Color::Black);
+
+	EXPECT_EQ(Color::White * 0.5f, Color(0.5f, 0.5f, 0.5f));
+}
+
+TEST(ColorTest, PaddingLaneIsIgnoredByComparison)
+{
+	Color a = Color(0.1f, 0.2f, 0.3f);
+	Color b = a;
+	b.padding = 1.0f;
+
+	EXPECT_EQ(a, b);
+	EXPECT_FALSE(a != b);
+	EXPECT_EQ(sizeof(Color), 16u);
+}
+
 
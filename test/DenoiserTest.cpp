@@ -0,0 +1,192 @@
+/*
+ * DenoiserTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Denoiser.hpp"
+#include "gtest/gtest.h"
+
+#include <cmath>
+
+// A flat surface facing the camera, one unit away, with white albedo
+FeatureBuffers FlatFeatures(const uint32_t width, const uint32_t height)
+{
+	FeatureBuffers features(width, height);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			features.albedo.pixels[y][x] = Color(1, 1, 1);
+			features.normal.pixels[y][x] = Color(0, 0, -1);
+			features.depth.pixels[y][x] = Color(1, 1, 1);
+		}
+	}
+	return features;
+}
+
+// Deterministic noise of up to amplitude either way
+float Noise(const uint32_t x, const uint32_t y, const float amplitude)
+{
+	return amplitude * (static_cast<float>((x * 7919U + y * 104729U) % 101U) / 50.0F - 1.0F);
+}
+
+float MeanSquaredError(const Canvas& image, const uint32_t xBegin, const uint32_t xEnd, const float expected)
+{
+	float error = 0.0F;
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		for (uint32_t x = xBegin; x < xEnd; x++)
+		{
+			error += (image.pixels[y][x].g - expected) * (image.pixels[y][x].g - expected);
+		}
+	}
+	return error / static_cast<float>(image.height * (xEnd - xBegin));
+}
+
+TEST(DenoiserTest, NoiseOnOneSurfaceIsSmoothed)
+{
+	const FeatureBuffers features = FlatFeatures(32, 32);
+	Canvas image(32, 32);
+	for (uint32_t y = 0; y < 32; y++)
+	{
+		for (uint32_t x = 0; x < 32; x++)
+		{
+			const float value = 0.5F + Noise(x, y, 0.1F);
+			image.pixels[y][x] = Color(value, value, value);
+		}
+	}
+
+	const Canvas denoised = Denoise(image, features);
+	EXPECT_LT(MeanSquaredError(denoised, 0, 32, 0.5F), MeanSquaredError(image, 0, 32, 0.5F) / 10.0F);
+}
+
+TEST(DenoiserTest, NormalEdgesAreKept)
+{
+	// Two faces of a box meeting down the middle, one lit and one not
+	FeatureBuffers features = FlatFeatures(32, 16);
+	Canvas image(32, 16);
+	for (uint32_t y = 0; y < 16; y++)
+	{
+		for (uint32_t x = 0; x < 32; x++)
+		{
+			const float value = (x < 16 ? 0.8F : 0.2F) + Noise(x, y, 0.05F);
+			image.pixels[y][x] = Color(value, value, value);
+			features.normal.pixels[y][x] = x < 16 ? Color(-1, 0, 0) : Color(0, 0, -1);
+		}
+	}
+
+	const Canvas denoised = Denoise(image, features);
+	EXPECT_LT(MeanSquaredError(denoised, 0, 16, 0.8F), 1e-4F);
+	EXPECT_LT(MeanSquaredError(denoised, 16, 32, 0.2F), 1e-4F);
+}
+
+TEST(DenoiserTest, DepthEdgesAreKept)
+{
+	// A nearer surface in front of a farther one facing the same way
+	FeatureBuffers features = FlatFeatures(32, 16);
+	Canvas image(32, 16);
+	for (uint32_t y = 0; y < 16; y++)
+	{
+		for (uint32_t x = 0; x < 32; x++)
+		{
+			const float value = (x < 16 ? 0.8F : 0.2F) + Noise(x, y, 0.05F);
+			image.pixels[y][x] = Color(value, value, value);
+			features.depth.pixels[y][x] = x < 16 ? Color(1, 1, 1) : Color(3, 3, 3);
+		}
+	}
+
+	const Canvas denoised = Denoise(image, features);
+	EXPECT_LT(MeanSquaredError(denoised, 0, 16, 0.8F), 1e-4F);
+	EXPECT_LT(MeanSquaredError(denoised, 16, 32, 0.2F), 1e-4F);
+}
+
+TEST(DenoiserTest, SlantedSurfacesAreSmoothed)
+{
+	// Depth changes steadily across a slanted floor, which is not an edge
+	FeatureBuffers features = FlatFeatures(32, 32);
+	Canvas image(32, 32);
+	for (uint32_t y = 0; y < 32; y++)
+	{
+		for (uint32_t x = 0; x < 32; x++)
+		{
+			const float value = 0.5F + Noise(x, y, 0.1F);
+			image.pixels[y][x] = Color(value, value, value);
+			const float depth = 1.0F + 0.5F * static_cast<float>(y);
+			features.depth.pixels[y][x] = Color(depth, depth, depth);
+		}
+	}
+
+	const Canvas denoised = Denoise(image, features);
+	EXPECT_LT(MeanSquaredError(denoised, 0, 32, 0.5F), MeanSquaredError(image, 0, 32, 0.5F) / 10.0F);
+}
+
+TEST(DenoiserTest, AlbedoDetailIsKept)
+{
+	// Evenly lit checkers, whose noise free detail is all albedo
+	FeatureBuffers features = FlatFeatures(16, 16);
+	Canvas image(16, 16);
+	for (uint32_t y = 0; y < 16; y++)
+	{
+		for (uint32_t x = 0; x < 16; x++)
+		{
+			const Color albedo = (x + y) % 2 == 0 ? Color(0.9F, 0.1F, 0.5F) : Color(0.2F, 0.6F, 0.3F);
+			features.albedo.pixels[y][x] = albedo;
+			image.pixels[y][x] = albedo * 0.7F;
+		}
+	}
+
+	const Canvas denoised = Denoise(image, features);
+	for (uint32_t y = 0; y < 16; y++)
+	{
+		for (uint32_t x = 0; x < 16; x++)
+		{
+			EXPECT_EQ(denoised.pixels[y][x], image.pixels[y][x]);
+		}
+	}
+}
+
+TEST(DenoiserTest, BackgroundIsLeftAlone)
+{
+	FeatureBuffers features = FlatFeatures(16, 16);
+	Canvas image(16, 16);
+	for (uint32_t y = 0; y < 16; y++)
+	{
+		for (uint32_t x = 0; x < 16; x++)
+		{
+			image.pixels[y][x] = x < 8 ? Color(Noise(x, y, 0.5F), 0, 0) : Color(1, 1, 1);
+			if (x < 8)
+			{
+				features.albedo.pixels[y][x] = Color(0, 0, 0);
+				features.normal.pixels[y][x] = Color(0, 0, 0);
+				features.depth.pixels[y][x] = Color(0, 0, 0);
+			}
+		}
+	}
+
+	const Canvas denoised = Denoise(image, features);
+	for (uint32_t y = 0; y < 16; y++)
+	{
+		for (uint32_t x = 0; x < 16; x++)
+		{
+			EXPECT_EQ(denoised.pixels[y][x], image.pixels[y][x]);
+		}
+	}
+}
+
+TEST(DenoiserTest, NoIterationsChangeNothing)
+{
+	const FeatureBuffers features = FlatFeatures(8, 8);
+	Canvas image(8, 8);
+	image.pixels[3][4] = Color(1, 0.5, 0.25);
+	DenoiseSettings settings;
+	settings.iterations = 0;
+
+	EXPECT_EQ(Denoise(image, features, settings).pixels[3][4], Color(1, 0.5, 0.25));
+}
+
+TEST(DenoiserTest, FeaturesMustMatchImage)
+{
+	EXPECT_THROW((void)Denoise(Canvas(8, 8), FlatFeatures(8, 7)), std::runtime_error);
+}
@@ -0,0 +1,48 @@
+/*
+ * HeatmapTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Heatmap.hpp"
+#include "gtest/gtest.h"
+
+TEST(HeatmapTest, ColorsRunFromDarkBlueToPaleYellow)
+{
+	EXPECT_EQ(HeatmapColor(0.0f), Color(0.0f, 0.0f, 0.2f));
+	EXPECT_EQ(HeatmapColor(0.5f), Color(0.8f, 0.1f, 0.3f));
+	EXPECT_EQ(HeatmapColor(1.0f), Color(1.0f, 1.0f, 0.8f));
+	EXPECT_EQ(HeatmapColor(0.125f), Color(0.15f, 0.0f, 0.4f));
+}
+
+TEST(HeatmapTest, ColorsClampOutOfRangeCosts)
+{
+	EXPECT_EQ(HeatmapColor(-1.0f), HeatmapColor(0.0f));
+	EXPECT_EQ(HeatmapColor(5.0f), HeatmapColor(1.0f));
+}
+
+TEST(HeatmapTest, FreeImageIsAllCold)
+{
+	Canvas costs(4, 3);
+	Canvas heatmap = CostHeatmap(costs);
+
+	EXPECT_EQ(heatmap.width, 4u);
+	EXPECT_EQ(heatmap.height, 3u);
+	EXPECT_EQ(heatmap.pixels[2][3], HeatmapColor(0.0f));
+}
+
+TEST(HeatmapTest, OutliersDoNotWashOutTheScale)
+{
+	Canvas costs(200, 1);
+	for (uint32_t x = 0; x < 200; x++)
+	{
+		costs.pixels[0][x] = x < 100 ? Color(1, 1, 1) : Color(2, 2, 2);
+	}
+	costs.pixels[0][0] = Color(1000, 1000, 1000);
+	Canvas heatmap = CostHeatmap(costs);
+
+	EXPECT_EQ(heatmap.pixels[0][1], HeatmapColor(0.5f));
+	EXPECT_EQ(heatmap.pixels[0][150], HeatmapColor(1.0f));
+	EXPECT_EQ(heatmap.pixels[0][0], HeatmapColor(1.0f));
+}
@@ -10,6 +10,7 @@
 #include "Material.hpp"
 #include "Tuple.hpp"
 #include "Light.hpp"
+#include "Texture.hpp"
 #include <cmath>
 
 TEST(MaterialTest, DefaultMaterial)
@@ -107,6 +108,42 @@ TEST(MaterialTest, LightingWithSurfaceInShadow)
 	EXPECT_EQ(result, Color(0.1, 0.1, 0.1));
 }
 
+TEST(MaterialTest, LightingWithTexture)
+{
+	TextureCache cache;
+	Canvas image(2, 1);
+	image.pixels[0][0] = Color(1, 0, 0);
+	image.pixels[0][1] = Color(0, 0, 1);
+	Material m;
+	m.pattern = Pattern::Stripe(Color::White, Color::Black);
+	m.texture = std::make_shared<const Texture>(image, cache);
+	m.ambient = 1;
+	m.diffuse = 0;
+	m.specular = 0;
+	Tuple eyeV = Vector(0, 0, -1);
+	Tuple normalV = Vector(0, 0, -1);
+	Light light(Point(0, 0, -10), Color(1, 1, 1));
+
+	// The texture takes the place of the pattern
+	EXPECT_EQ(m.light(light, Point(0, 0, 0), eyeV, normalV, false, Footprint(), {0.25, 0.5}), Color(1, 0, 0));
+	EXPECT_EQ(m.light(light, Point(0, 0, 0), eyeV, normalV, false, Footprint(), {0.75, 0.5}), Color(0, 0, 1));
+}
+
+TEST(MaterialTest, Albedo)
+{
+	TextureCache cache;
+	Canvas image(1, 1);
+	image.pixels[0][0] = Color(0, 0, 1);
+	Material m;
+	m.color = Color(0.5, 0.25, 1);
+
+	EXPECT_EQ(m.albedo(Point(0, 0, 0)), Color(0.5, 0.25, 1));
+	m.pattern = Pattern::Stripe(Color::White, Color::Black);
+	EXPECT_EQ(m.albedo(Point(1.5, 0, 0)), Color::Black);
+	m.texture = std::make_shared<const Texture>(image, cache);
+	EXPECT_EQ(m.albedo(Point(1.5, 0, 0), Footprint(), {0.5, 0.5}), Color(0, 0, 1));
+}
+
 TEST(MaterialTest, DefaultMaterialReflectivity)
 {
 	Material m;
@@ -463,3 +463,24 @@ TEST(MatrixTest, MatrixInversion)
 	EXPECT_EQ(G * F.inverse(), E);
 }
 
+TEST(MatrixTest, MatrixOperationsAreConstexpr)
+{
+	constexpr Matrix<4> A({{
+		{-5, 2, 6, -8},
+		{1, -5, 1, 8},
+		{7, 7, -6, -7},
+		{1, -3, 7, 4}
+	}});
+	constexpr Matrix<4> B = A.inverse();
+
+	static_assert(A.determinant() == 532);
+	static_assert(A.submatrix(2, 1).determinant() == A.minor(2, 1));
+	static_assert(A * IdentityMatrix() == A);
+	static_assert(A * B == IdentityMatrix());
+	static_assert(A.transpose().transpose() == A);
+	static_assert(IdentityMatrix() * Point(1, 2, 3) == Point(1, 2, 3));
+
+	// Constant and runtime evaluation agree
+	Matrix<4> runtimeA = A;
+	EXPECT_EQ(runtimeA.inverse(), B);
+}
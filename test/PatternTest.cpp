@@ -183,6 +183,51 @@ TEST(PatternTest, CheckersRepeatInZ)
 	EXPECT_EQ(p.colorAt(Point(0, 0, 2)), Color::White);
 }
 
+TEST(PatternTest, FilteredStripeAveragesAcrossStripes)
+{
+	Pattern p = Pattern::Stripe(Color::White, Color::Black);
+
+	EXPECT_EQ(p.colorAt(Point(0.5, 0, 0), Vector(0, 0, 0)), Color::White);
+	EXPECT_EQ(p.colorAt(Point(0.5, 0, 0), Vector(0.25, 3, 3)), Color::White);
+	EXPECT_EQ(p.colorAt(Point(-0.5, 0, 0), Vector(0.25, 0, 0)), Color::Black);
+	EXPECT_EQ(p.colorAt(Point(1, 0, 0), Vector(0.5, 0, 0)), Color(0.5, 0.5, 0.5));
+	EXPECT_EQ(p.colorAt(Point(0.3, 0, 0), Vector(10, 0, 0)), Color(0.5, 0.5, 0.5));
+	EXPECT_EQ(p.colorAt(Point(1.125, 0, 0), Vector(0.25, 0, 0)), Color(0.25, 0.25, 0.25));
+}
+
+TEST(PatternTest, FilteredCheckersAverageAcrossCells)
+{
+	Pattern p = Pattern::Checker(Color::White, Color::Black);
+
+	EXPECT_EQ(p.colorAt(Point(0.5, 0.5, 1.5), Vector(0.1, 0.1, 0.1)), Color::Black);
+	EXPECT_EQ(p.colorAt(Point(0.5, 0, 0.5), Vector(4, 0, 4)), Color(0.5, 0.5, 0.5));
+	// Three quarters of the box is in cells whose x and z floors are both even or both odd
+	EXPECT_EQ(p.colorAt(Point(1, 0, 1), Vector(0.5, 0, 0.5)), Color(0.5, 0.5, 0.5));
+	EXPECT_EQ(p.colorAt(Point(0.75, 0, 0.75), Vector(0.5, 0, 0.5)), Color(0.625, 0.625, 0.625));
+	// A footprint lying along a cell boundary only averages along its width
+	EXPECT_EQ(p.colorAt(Point(0.5, 0, 0.5), Vector(0.25, 0, 0.25)), Color::White);
+}
+
+TEST(PatternTest, PatternsWithoutFilterArePointSampled)
+{
+	Pattern p = Pattern::Ring(Color::White, Color::Black);
+
+	EXPECT_EQ(p.colorAt(Point(0.5, 0, 0), Vector(5, 5, 5)), p.colorAt(Point(0.5, 0, 0)));
+	EXPECT_EQ(p.colorAt(Point(1.5, 0, 0), Vector(5, 5, 5)), p.colorAt(Point(1.5, 0, 0)));
+}
+
+TEST(PatternTest, FootprintFilteredInPatternSpace)
+{
+	Pattern p = Pattern::Stripe(Color::White, Color::Black);
+	const Footprint footprint = {Vector(0.2, 0, 0), Vector(0, 0, 0.2)};
+
+	EXPECT_EQ(p.colorAt(Point(0.5, 0, 0), footprint), Color::White);
+	EXPECT_EQ(p.colorAt(Point(0.5, 0, 0), Footprint()), Color::White);
+	p.transform = scaling(0.1, 0.1, 0.1);
+	EXPECT_EQ(p.colorAt(Point(0.5, 0, 0), footprint), Color(0.5, 0.5, 0.5));
+	EXPECT_EQ(p.colorAt(Point(0.15, 0, 0), Footprint()), Color::Black);
+}
+
 TEST(PatternTest, TestPatternWithObjectTransform)
 {
 	Sphere s = Sphere();
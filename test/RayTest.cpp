@@ -12,6 +12,7 @@
 #include "World.hpp"
 #include <cmath>
 #include <array>
+#include <random>
 
 
 TEST(RayTest, RayCreation)
@@ -88,8 +89,62 @@ TEST(RayTest, PrecomputeIntersectionCalculatesOverPoint)
 	auto i = s.intersect(r);
 	auto id = r.precomputeDetails(*r.hit(i), i);
 
-	EXPECT_LT(id.overPoint.z, -TUPLE_EPSILON / 2);
-	EXPECT_LT(id.overPoint.z, id.point.z);
+	EXPECT_LT(id.overPoint.z, id.point.z - RAY_OFFSET_MINIMUM / 2);
+	EXPECT_GT(id.underPoint.z, id.point.z + RAY_OFFSET_MINIMUM / 2);
+}
+
+TEST(RayTest, OffsetRayOriginUsesMinimumNearOrigin)
+{
+	Tuple p = OffsetRayOrigin(Point(0, 1, 0), Vector(0, 1, 0), 1.0f);
+
+	EXPECT_FLOAT_EQ(p.y, 1.0f + RAY_OFFSET_MINIMUM);
+	EXPECT_EQ(p.w, 1.0f);
+}
+
+TEST(RayTest, OffsetRayOriginScalesWithMagnitude)
+{
+	const float magnitude = 100000.0f;
+	Tuple p = OffsetRayOrigin(Point(magnitude, 0, 0), Vector(1, 0, 0), magnitude);
+
+	// Far from the origin the offset must clear the rounding error of the hit point itself
+	EXPECT_GE(p.x - magnitude, RAY_OFFSET_ULPS * (std::nextafter(magnitude, 2 * magnitude) - magnitude));
+	EXPECT_GT(p.x - magnitude, RAY_OFFSET_MINIMUM);
+}
+
+TEST(RayTest, OverPointClearsSurfaceFarFromOrigin)
+{
+	Ray r(Point(100000, 0, -5), Vector(0, 0, 1));
+	Sphere s;
+	s.transform = translation(100000, 0, 0);
+	auto i = s.intersect(r);
+	auto id = r.precomputeDetails(*r.hit(i), i);
+
+	auto fromOverPoint = s.intersect(Ray(id.overPoint, Vector(0, 0, -1)));
+	EXPECT_FALSE(Ray(id.overPoint, Vector(0, 0, -1)).hit(fromOverPoint));
+}
+
+TEST(RayTest, GrazingRaysFromOverPointMissTheirSurface)
+{
+	// Near the origin the offset is the minimum, which must clear the error of the quadratic for a
+	// ray leaving the surface almost along its tangent plane
+	Sphere s;
+	std::minstd_rand generator(7);
+	std::uniform_real_distribution<float> unit(-1, 1);
+	uint32_t selfHits = 0;
+	for (uint32_t i = 0; i < 5000; i++)
+	{
+		const Tuple target = Point(unit(generator) * 0.5f, unit(generator) * 0.5f, unit(generator) * 0.5f);
+		const Tuple origin = target + Vector(unit(generator), unit(generator), unit(generator)).normalize() * 50.0f;
+		const Ray r(origin, (target - origin).normalize());
+		auto xs = s.intersect(r);
+		auto id = r.precomputeDetails(*r.hit(xs), xs);
+
+		const Tuple across = Vector(unit(generator), unit(generator), unit(generator));
+		const Tuple tangent = (across - id.normalVector * across.dot(id.normalVector)).normalize();
+		const Ray grazing(id.overPoint, (tangent + id.normalVector * 0.01f).normalize());
+		selfHits += grazing.hit(s.intersect(grazing)) ? 1 : 0;
+	}
+	EXPECT_EQ(selfHits, 0u);
 }
 
 TEST(RayTest, PrecomputeIntersectionCalculatesReflectionVector)
@@ -168,6 +223,53 @@ TEST(RayTest, SchlickReflectanceWithSmallAngleAndN2GreaterThanN1)
 	EXPECT_NEAR(id.reflectance, 0.48873, COLOR_EPSILON); // Just slightly out of precision for EXPECT_FLOAT_EQ
 }
 
+TEST(RayTest, PrecomputeFootprintOnPlane)
+{
+	Plane p;
+	p.material.pattern = Pattern::Checker(Color::White, Color::Black);
+	const RayDifferential differential = {Vector(0.01, 0, 0), Vector(0.01, 0, 0), Vector(0, 0, 0), Vector(0, 0.01, 0.01)};
+	const Ray r(Point(0, 2, 0), Vector(0, -1, 0));
+	auto intersections = p.intersect(r);
+	auto id = r.precomputeDetails(*r.hit(intersections), intersections, differential);
+
+	ASSERT_TRUE(id.differential);
+	EXPECT_EQ(id.footprint().dpdx, Vector(0.03, 0, 0));
+	// The part of the direction change along the ray only moves the hit along the plane
+	EXPECT_EQ(id.footprint().dpdy, Vector(0, 0, 0.02));
+	EXPECT_EQ(id.differential->dndx, Vector(0, 0, 0));
+
+	auto plainId = r.precomputeDetails(*r.hit(intersections), intersections);
+	EXPECT_FALSE(plainId.differential);
+	EXPECT_EQ(plainId.footprint().dpdx, Vector(0, 0, 0));
+}
+
+TEST(RayTest, PrecomputeTextureCoordinates)
+{
+	TextureCache cache;
+	Plane p;
+	p.material.texture = std::make_shared<const Texture>(Canvas(4, 4), cache);
+	const RayDifferential differential = {Vector(0, 0, 0), Vector(0.01, 0, 0), Vector(0, 0, 0), Vector(0, 0, 0.01)};
+	const Ray r(Point(0.25, 2, 1.5), Vector(0, -1, 0));
+	auto intersections = p.intersect(r);
+	auto id = r.precomputeDetails(*r.hit(intersections), intersections, differential);
+
+	EXPECT_FLOAT_EQ(id.textureCoordinates.u, 0.25F);
+	EXPECT_FLOAT_EQ(id.textureCoordinates.v, 1.5F);
+	EXPECT_NEAR(id.textureCoordinates.dudx, 0.02F, 1e-5F);
+	EXPECT_NEAR(id.textureCoordinates.dvdy, 0.02F, 1e-5F);
+	EXPECT_NEAR(id.textureCoordinates.dvdx, 0.0F, 1e-5F);
+}
+
+TEST(RayTest, NoFootprintWithoutPatternOrSpawnedRays)
+{
+	Plane p;
+	const RayDifferential differential = {Vector(0, 0, 0), Vector(0.01, 0, 0), Vector(0, 0, 0), Vector(0, 0, 0.01)};
+	const Ray r(Point(0, 2, 0), Vector(0, -1, 0));
+	auto intersections = p.intersect(r);
+
+	EXPECT_FALSE(r.precomputeDetails(*r.hit(intersections), intersections, differential).differential);
+}
+
 TEST(RayTest, IntersectionWithUV)
 {
 	Sphere s;
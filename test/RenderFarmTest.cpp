@@ -0,0 +1,389 @@
+/*
+ * RenderFarmTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "RenderFarm.hpp"
+#include "YamlParser.hpp"
+#include "gtest/gtest.h"
+#include <fstream>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+const std::string FarmScene = R"(
+- add: camera
+  width: 40
+  height: 30
+  field-of-view: 0.785
+  from: [ 0, 1.5, -5 ]
+  to: [ 0, 1, 0 ]
+  up: [ 0, 1, 0 ]
+
+- add: light
+  at: [ -10, 10, -10 ]
+  intensity: [ 1, 1, 1 ]
+
+- add: plane
+
+- add: sphere
+  transform:
+    - [ translate, 0, 1, 0 ]
+)";
+
+const std::string FarmSequence = R"(
+- add: sequence
+  frames: 4
+
+- add: camera
+  width: 20
+  height: 20
+  field-of-view: 0.785
+  from: [ 0, 1.5, -5 ]
+  to: [ 0, 1, 0 ]
+  up: [ 0, 1, 0 ]
+  keyframe: 3
+  from: [ 5, 1.5, 0 ]
+
+- add: light
+  at: [ -10, 10, -10 ]
+  intensity: [ 1, 1, 1 ]
+
+- add: cube
+  transform:
+    - [ translate, 0, 0, 0 ]
+  keyframe: 3
+    - [ translate, 0, 2, 0 ]
+)";
+
+// Worker threads each serve one end of a socket pair, the other end going to the coordinator
+class LocalFarm
+{
+  public:
+	std::vector<int> coordinatorEnds;
+	std::vector<std::thread> threads;
+
+	explicit LocalFarm(int workerCount, int failingWorkerCount = 0)
+	{
+		for (int i = 0; i < workerCount + failingWorkerCount; i++)
+		{
+			int pair[2];
+			EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+			coordinatorEnds.push_back(pair[0]);
+			const int workerEnd = pair[1];
+			if (i < workerCount)
+			{
+				threads.emplace_back([workerEnd]() {
+					RunRenderWorker(workerEnd);
+					close(workerEnd);
+				});
+			} else
+			{
+				// Answers like a worker until it is handed a tile, then disconnects without replying
+				threads.emplace_back([workerEnd]() {
+					std::optional<FarmMessage> message;
+					while ((message = ReceiveFarmMessage(workerEnd)) && message->type != FarmMessage::Tile)
+					{
+						if (message->type == FarmMessage::Frame)
+						{
+							FarmMessage ready;
+							ready.type = FarmMessage::Ready;
+							ready.append(uint32_t{40});
+							ready.append(uint32_t{30});
+							ready.append(uint32_t{1});
+							SendFarmMessage(workerEnd, ready);
+						}
+					}
+					close(workerEnd);
+				});
+			}
+		}
+	}
+
+	~LocalFarm()
+	{
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+};
+
+TEST(RenderFarmTest, MessageRoundTrip)
+{
+	int pair[2];
+	ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+
+	FarmMessage sent;
+	sent.type = FarmMessage::Tile;
+	sent.append(uint32_t{7});
+	sent.append(1.5f);
+	sent.appendText("directory");
+	RenderStatistics statistics;
+	statistics.threads = 3;
+	statistics.counts[RenderStatistics::ShadowRays] = 11;
+	sent.appendStatistics(statistics);
+	SendFarmMessage(pair[0], sent);
+
+	std::optional<FarmMessage> received = ReceiveFarmMessage(pair[1]);
+	ASSERT_TRUE(received);
+	EXPECT_EQ(received->type, FarmMessage::Tile);
+	size_t offset = 0;
+	EXPECT_EQ(received->read<uint32_t>(offset), 7u);
+	EXPECT_EQ(received->read<float>(offset), 1.5f);
+	EXPECT_EQ(received->readText(offset), "directory");
+	const RenderStatistics receivedStatistics = received->readStatistics(offset);
+	EXPECT_EQ(receivedStatistics.threads, 3u);
+	EXPECT_EQ(receivedStatistics.counts, statistics.counts);
+	EXPECT_THROW((void)received->read<uint32_t>(offset), std::runtime_error);
+
+	close(pair[0]);
+	EXPECT_FALSE(ReceiveFarmMessage(pair[1]));
+	close(pair[1]);
+}
+
+TEST(RenderFarmTest, FarmMatchesLocalRender)
+{
+	YamlParser parser(FarmScene);
+	const Canvas expected = parser.worldCamera.Render(parser.world);
+
+	LocalFarm farm(2);
+	RenderCoordinator coordinator(farm.coordinatorEnds);
+	coordinator.tileSize = 8;
+	const Canvas image = coordinator.render(FarmScene, 0);
+
+	EXPECT_EQ(image.width, 40u);
+	EXPECT_EQ(image.height, 30u);
+	EXPECT_EQ(image.GetPPMString(), expected.GetPPMString());
+	EXPECT_EQ(coordinator.frameCount(), 1u);
+}
+
+TEST(RenderFarmTest, WorkersReportWhatTheyCountedForEachFrame)
+{
+	if constexpr (!RenderStatistics::Enabled)
+	{
+		GTEST_SKIP() << "Built without ENABLE_STATISTICS";
+	}
+
+	// Counts are per process, so the worker must be the only one in this one
+	LocalFarm farm(1);
+	RenderCoordinator coordinator(farm.coordinatorEnds);
+	coordinator.tileSize = 8;
+	for (uint32_t frame = 0; frame < 2; frame++)
+	{
+		(void)coordinator.render(FarmScene, frame);
+		EXPECT_EQ(coordinator.statistics()[RenderStatistics::PrimaryRays], 40u * 30u);
+		EXPECT_GT(coordinator.statistics()[RenderStatistics::ShadowRays], 0u);
+	}
+}
+
+TEST(RenderFarmTest, FailedWorkersTilesAreRetried)
+{
+	YamlParser parser(FarmScene);
+	const Canvas expected = parser.worldCamera.Render(parser.world);
+
+	LocalFarm farm(1, 2);
+	RenderCoordinator coordinator(farm.coordinatorEnds);
+	coordinator.tileSize = 8;
+	const Canvas image = coordinator.render(FarmScene, 0);
+
+	EXPECT_EQ(image.GetPPMString(), expected.GetPPMString());
+	EXPECT_EQ(coordinator.liveWorkerCount(), 1u);
+}
+
+TEST(RenderFarmTest, EveryWorkerFailingThrows)
+{
+	LocalFarm farm(0, 2);
+	RenderCoordinator coordinator(farm.coordinatorEnds);
+
+	EXPECT_THROW((void)coordinator.render(FarmScene, 0), std::runtime_error);
+	EXPECT_EQ(coordinator.liveWorkerCount(), 0u);
+}
+
+TEST(RenderFarmTest, SequenceFramesMatchLocalRender)
+{
+	LocalFarm farm(2);
+	RenderCoordinator coordinator(farm.coordinatorEnds);
+	coordinator.tileSize = 8;
+	(void)coordinator.render(FarmSequence, 0);
+	EXPECT_EQ(coordinator.frameCount(), 4u);
+
+	const Canvas image = coordinator.render(FarmSequence, 2);
+
+	YamlParser parser(FarmSequence);
+	parser.worldSequence.apply(2, parser.world, parser.worldCamera);
+	EXPECT_EQ(image.GetPPMString(), parser.worldCamera.Render(parser.world).GetPPMString());
+}
+
+TEST(RenderFarmTest, SceneDirectoryIsSentToWorkers)
+{
+	{
+		std::ofstream file(::testing::TempDir() + "RenderFarmTriangle.obj");
+		file << "v -1 0 0\n"
+				"v 1 0 0\n"
+				"v 0 2 0\n"
+				"f 1 2 3\n";
+	}
+	const std::string scene = FarmScene + "\n- add: obj\n  file: RenderFarmTriangle.obj\n";
+	YamlParser parser(scene, ::testing::TempDir());
+	const Canvas expected = parser.worldCamera.Render(parser.world);
+
+	LocalFarm farm(2);
+	RenderCoordinator coordinator(farm.coordinatorEnds);
+	coordinator.tileSize = 8;
+	EXPECT_EQ(coordinator.render(scene, 0, ::testing::TempDir()).GetPPMString(), expected.GetPPMString());
+
+	// Without it the file is looked for in the working directory, and every worker fails
+	LocalFarm otherFarm(1);
+	RenderCoordinator otherCoordinator(otherFarm.coordinatorEnds);
+	EXPECT_THROW((void)otherCoordinator.render(scene, 0), std::runtime_error);
+}
+
+TEST(RenderFarmTest, DenoisedScenesAreRefused)
+{
+	LocalFarm farm(1);
+	RenderCoordinator coordinator(farm.coordinatorEnds);
+	const std::string scene = "- add: camera\n  width: 8\n  height: 8\n  denoise: 2\n";
+
+	try
+	{
+		(void)coordinator.render(scene, 0);
+		ADD_FAILURE() << "A denoised scene was rendered on the farm";
+	} catch (const std::runtime_error& error)
+	{
+		EXPECT_NE(std::string(error.what()).find("denoise"), std::string::npos);
+	}
+}
+
+TEST(RenderFarmTest, OversizedMessagesAreRefused)
+{
+	int pair[2];
+	ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+
+	FarmMessage header;
+	header.append(uint32_t{FarmMessage::Scene});
+	header.append(MAXIMUM_FARM_MESSAGE_SIZE + 1);
+	ASSERT_EQ(send(pair[0], header.payload.data(), header.payload.size(), 0), static_cast<ssize_t>(header.payload.size()));
+	EXPECT_THROW((void)ReceiveFarmMessage(pair[1]), std::runtime_error);
+
+	close(pair[0]);
+	close(pair[1]);
+}
+
+TEST(RenderFarmTest, WorkerReportsSceneErrorsInsteadOfThrowing)
+{
+	LocalFarm farm(1);
+	RenderCoordinator coordinator(farm.coordinatorEnds);
+
+	try
+	{
+		(void)coordinator.render("- add: light\n  at: nowhere\n", 0);
+		FAIL() << "A scene that does not parse cannot be rendered";
+	} catch (const std::runtime_error& error)
+	{
+		EXPECT_NE(std::string(error.what()).find("The last said"), std::string::npos);
+	}
+	EXPECT_EQ(coordinator.liveWorkerCount(), 0u);
+}
+
+TEST(RenderFarmTest, TruncatedPixelsAreRetriedElsewhere)
+{
+	YamlParser parser(FarmScene);
+	const Canvas expected = parser.worldCamera.Render(parser.world);
+
+	LocalFarm farm(1);
+	int pair[2];
+	ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+	const int workerEnd = pair[1];
+	// Answers tiles with the tile id and a single channel of one pixel, then waits to be dropped
+	std::thread truncating([workerEnd]() {
+		try
+		{
+			std::optional<FarmMessage> message;
+			while ((message = ReceiveFarmMessage(workerEnd)))
+			{
+				size_t offset = 0;
+				FarmMessage reply;
+				if (message->type == FarmMessage::Frame)
+				{
+					reply.type = FarmMessage::Ready;
+					reply.append(uint32_t{40});
+					reply.append(uint32_t{30});
+					reply.append(uint32_t{1});
+				} else if (message->type == FarmMessage::Tile)
+				{
+					reply.type = FarmMessage::Pixels;
+					reply.append(message->read<uint32_t>(offset));
+					reply.append(1.0F);
+				} else
+				{
+					continue;
+				}
+				SendFarmMessage(workerEnd, reply);
+			}
+		} catch (const std::exception&)
+		{
+		}
+		close(workerEnd);
+	});
+
+	std::vector<int> workers = farm.coordinatorEnds;
+	workers.push_back(pair[0]);
+	{
+		RenderCoordinator coordinator(workers);
+		coordinator.tileSize = 8;
+		EXPECT_EQ(coordinator.render(FarmScene, 0).GetPPMString(), expected.GetPPMString());
+		EXPECT_EQ(coordinator.liveWorkerCount(), 1u);
+	}
+	truncating.join();
+}
+
+TEST(RenderFarmTest, WorkerRefusesTilesOutsideTheImage)
+{
+	int pair[2];
+	ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+	std::thread worker([&]() { RunRenderWorker(pair[1]); });
+
+	FarmMessage scene;
+	scene.type = FarmMessage::Scene;
+	scene.appendText("");
+	scene.payload.insert(scene.payload.end(), FarmScene.begin(), FarmScene.end());
+	SendFarmMessage(pair[0], scene);
+	FarmMessage frame;
+	frame.type = FarmMessage::Frame;
+	frame.append(uint32_t{0});
+	SendFarmMessage(pair[0], frame);
+	std::optional<FarmMessage> ready = ReceiveFarmMessage(pair[0]);
+	ASSERT_TRUE(ready);
+	EXPECT_EQ(ready->type, FarmMessage::Ready);
+
+	// Begins past its end, which would otherwise ask the renderer for a tile of negative width
+	FarmMessage tile;
+	tile.type = FarmMessage::Tile;
+	for (const uint32_t value : {0U, 30U, 0U, 2U, 8U})
+	{
+		tile.append(value);
+	}
+	SendFarmMessage(pair[0], tile);
+	std::optional<FarmMessage> failed = ReceiveFarmMessage(pair[0]);
+	ASSERT_TRUE(failed);
+	EXPECT_EQ(failed->type, FarmMessage::Failed);
+
+	worker.join();
+	close(pair[0]);
+	close(pair[1]);
+}
+
+TEST(RenderFarmTest, WorkersThatNeverAnswerTimeOut)
+{
+	int pair[2];
+	ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+	RenderCoordinator coordinator({pair[0]});
+	coordinator.workerTimeout = std::chrono::milliseconds(50);
+
+	EXPECT_THROW((void)coordinator.render(FarmScene, 0), std::runtime_error);
+	EXPECT_EQ(coordinator.liveWorkerCount(), 0u);
+	close(pair[1]);
+}
@@ -0,0 +1,293 @@
+/*
+ * RenderServiceTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "RenderService.hpp"
+#include "Transformation.hpp"
+#include "YamlParser.hpp"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <fstream>
+#include <numbers>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+const std::string ServiceScene = R"(
+- add: camera
+  width: 24
+  height: 16
+  field-of-view: 0.785
+  from: [ 0, 1.5, -5 ]
+  to: [ 0, 1, 0 ]
+  up: [ 0, 1, 0 ]
+
+- add: light
+  at: [ -10, 10, -10 ]
+  intensity: [ 1, 1, 1 ]
+
+- add: plane
+
+- add: sphere
+  transform:
+    - [ translate, 0, 1, 0 ]
+)";
+
+RenderRequest ViewRequest(const Tuple& from, uint32_t width, uint32_t height, uint32_t samples)
+{
+	RenderRequest request;
+	request.scene = ServiceScene;
+	request.width = width;
+	request.height = height;
+	request.samples = samples;
+	request.overrideView = true;
+	request.from = from;
+	request.to = Point(0, 1, 0);
+	request.up = Vector(0, 1, 0);
+	request.fieldOfView = 0.6F;
+	return request;
+}
+
+TEST(RenderServiceTest, RequestMessageRoundTrip)
+{
+	RenderRequest request = ViewRequest(Point(1, 2, 3), 640, 480, 9);
+	request.frame = 5;
+	request.directory = "/scenes";
+
+	const RenderRequest decoded = RenderRequest::FromMessage(request.message());
+	EXPECT_EQ(decoded.scene, ServiceScene);
+	EXPECT_EQ(decoded.directory, "/scenes");
+	EXPECT_EQ(decoded.frame, 5u);
+	EXPECT_EQ(decoded.width, 640u);
+	EXPECT_EQ(decoded.height, 480u);
+	EXPECT_EQ(decoded.samples, 9u);
+	EXPECT_TRUE(decoded.overrideView);
+	EXPECT_EQ(decoded.from, Point(1, 2, 3));
+	EXPECT_EQ(decoded.to, Point(0, 1, 0));
+	EXPECT_EQ(decoded.up, Vector(0, 1, 0));
+	EXPECT_EQ(decoded.fieldOfView, 0.6F);
+}
+
+TEST(RenderServiceTest, DefaultRequestUsesSceneCamera)
+{
+	YamlParser parser(ServiceScene);
+	RenderService service;
+	RenderRequest request;
+	request.scene = ServiceScene;
+
+	EXPECT_EQ(service.render(request).GetPPMString(), parser.worldCamera.Render(parser.world).GetPPMString());
+}
+
+TEST(RenderServiceTest, OverriddenViewMatchesCamera)
+{
+	YamlParser parser(ServiceScene);
+	const Camera camera(20, 10, 0.6F, ViewTransform(Point(3, 2, -4), Point(0, 1, 0), Vector(0, 1, 0)));
+	RenderService service;
+
+	EXPECT_EQ(service.render(ViewRequest(Point(3, 2, -4), 20, 10, 1)).GetPPMString(), camera.Render(parser.world).GetPPMString());
+}
+
+TEST(RenderServiceTest, SamplesArePlacedByTheSampler)
+{
+	YamlParser parser(ServiceScene);
+	Camera camera(8, 6, 0.6F, ViewTransform(Point(0, 1.5f, -5), Point(0, 1, 0), Vector(0, 1, 0)));
+	camera.samplesPerPixel = 4;
+	camera.sampler.sequence = Sampler::Sobol;
+	RenderService service;
+
+	EXPECT_EQ(service.render(ViewRequest(Point(0, 1.5f, -5), 8, 6, 4)).GetPPMString(), camera.Render(parser.world).GetPPMString());
+}
+
+TEST(RenderServiceTest, RepeatedScenesAreBuiltOnce)
+{
+	RenderService service;
+	(void)service.render(ViewRequest(Point(0, 1.5f, -5), 8, 8, 1));
+	(void)service.render(ViewRequest(Point(5, 1.5f, 0), 16, 8, 1));
+	EXPECT_EQ(service.sceneBuildCount(), 1u);
+	EXPECT_EQ(service.cachedSceneCount(), 1u);
+
+	RenderRequest other = ViewRequest(Point(0, 1.5f, -5), 8, 8, 1);
+	other.scene += "\n- add: cube\n";
+	(void)service.render(other);
+	EXPECT_EQ(service.sceneBuildCount(), 2u);
+	EXPECT_EQ(service.cachedSceneCount(), 2u);
+}
+
+TEST(RenderServiceTest, ScenesFindFilesFromTheirDirectory)
+{
+	{
+		std::ofstream file(::testing::TempDir() + "RenderServiceTriangle.obj");
+		file << "v -1 0 0\n"
+				"v 1 0 0\n"
+				"v 0 2 0\n"
+				"f 1 2 3\n";
+	}
+	RenderRequest request;
+	request.scene = ServiceScene + "\n- add: obj\n  file: RenderServiceTriangle.obj\n";
+	request.directory = ::testing::TempDir();
+	YamlParser parser(request.scene, request.directory);
+	RenderService service;
+
+	EXPECT_EQ(service.render(request).GetPPMString(), parser.worldCamera.Render(parser.world).GetPPMString());
+	// The same text in another directory is another scene
+	request.directory = ::testing::TempDir() + "NoSuchDirectory";
+	EXPECT_THROW((void)service.render(request), std::runtime_error);
+	EXPECT_EQ(service.sceneBuildCount(), 1u);
+}
+
+TEST(RenderServiceTest, CacheEvictsLeastRecentlyUsed)
+{
+	RenderService service;
+	service.cacheCapacity = 2;
+	RenderRequest first = ViewRequest(Point(0, 1.5f, -5), 4, 4, 1);
+	RenderRequest second = first;
+	second.scene += "\n- add: cube\n";
+	RenderRequest third = first;
+	third.scene += "\n- add: sphere\n";
+
+	(void)service.render(first);
+	(void)service.render(second);
+	(void)service.render(first);
+	(void)service.render(third); // Evicts second
+	EXPECT_EQ(service.sceneBuildCount(), 3u);
+	(void)service.render(first);
+	EXPECT_EQ(service.sceneBuildCount(), 3u);
+	(void)service.render(second);
+	EXPECT_EQ(service.sceneBuildCount(), 4u);
+	EXPECT_EQ(service.cachedSceneCount(), 2u);
+}
+
+TEST(RenderServiceTest, InvalidRequestsThrow)
+{
+	RenderService service;
+	EXPECT_THROW((void)service.render(ViewRequest(Point(0, 1.5f, -5), 8, 8, 257)), std::runtime_error);
+	EXPECT_THROW((void)service.render(ViewRequest(Point(0, 1.5f, -5), 8, 0, 1)), std::runtime_error);
+
+	RenderRequest flat = ViewRequest(Point(0, 1.5f, -5), 8, 8, 1);
+	flat.fieldOfView = 0.0F;
+	EXPECT_THROW((void)service.render(flat), std::runtime_error);
+	flat.fieldOfView = std::numbers::pi_v<float>;
+	EXPECT_THROW((void)service.render(flat), std::runtime_error);
+
+	RenderRequest unparsable;
+	unparsable.scene = "- add: sequence\n  frames: 0\n";
+	EXPECT_THROW((void)service.render(unparsable), std::runtime_error);
+	EXPECT_EQ(service.cachedSceneCount(), 0u);
+
+	// The scene camera's size may be kept, so the image size is only checked once the scene is parsed
+	EXPECT_THROW((void)service.render(ViewRequest(Point(0, 1.5f, -5), 65536, 65536, 1)), std::runtime_error);
+}
+
+TEST(RenderServiceTest, DenoisedAndHeatmapScenesAreRefused)
+{
+	RenderService service;
+	RenderRequest denoised;
+	denoised.scene = ServiceScene + "\n- add: camera\n  denoise: 2\n";
+	RenderRequest heatmap;
+	heatmap.scene = ServiceScene + "\n- add: camera\n  heatmap: time\n";
+
+	EXPECT_THROW((void)service.render(denoised), std::runtime_error);
+	EXPECT_THROW((void)service.render(heatmap), std::runtime_error);
+}
+
+TEST(RenderServiceTest, QueuedRequestsAreAnsweredOnConnection)
+{
+	int pair[2];
+	ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+	RenderService service;
+	service.bandHeight = 3;
+	std::thread reader([&]() { service.serveConnection(pair[1]); });
+
+	const Canvas image = RequestRender(pair[0], ViewRequest(Point(0, 1.5f, -5), 10, 7, 1));
+	EXPECT_EQ(image.GetPPMString(), service.render(ViewRequest(Point(0, 1.5f, -5), 10, 7, 1)).GetPPMString());
+
+	// A failed request is reported without losing the connection
+	RenderRequest unparsable;
+	unparsable.scene = "- add: sequence\n  frames: 0\n";
+	EXPECT_THROW((void)RequestRender(pair[0], unparsable), std::runtime_error);
+	EXPECT_EQ(RequestRender(pair[0], ViewRequest(Point(5, 1.5f, 0), 6, 4, 1)).height, 4u);
+	EXPECT_EQ(service.sceneBuildCount(), 1u);
+
+	close(pair[0]);
+	reader.join();
+}
+
+TEST(RenderServiceTest, StatisticsAreReportedWithTheImage)
+{
+	if constexpr (!RenderStatistics::Enabled)
+	{
+		GTEST_SKIP() << "Built without ENABLE_STATISTICS";
+	}
+
+	int pair[2];
+	ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+	RenderService service;
+	service.bandHeight = 3;
+	std::thread reader([&]() { service.serveConnection(pair[1]); });
+
+	// Counted afresh for each image
+	for (const uint32_t width : {10u, 6u})
+	{
+		RenderStatistics statistics;
+		EXPECT_EQ(RequestRender(pair[0], ViewRequest(Point(0, 1.5f, -5), width, 7, 1), &statistics).width, width);
+		EXPECT_EQ(statistics[RenderStatistics::PrimaryRays], width * 7u);
+	}
+
+	close(pair[0]);
+	reader.join();
+}
+
+TEST(RenderServiceTest, StopEndsServeWithClientsConnected)
+{
+	const std::string endpoint = "unix:/tmp/RenderServiceTest." + std::to_string(getpid());
+	RenderService service;
+	std::thread server([&]() { service.serve(endpoint); });
+
+	int client = -1;
+	for (int attempt = 0; attempt < 100 && client < 0; attempt++)
+	{
+		try
+		{
+			client = OpenEndpoint(endpoint, false);
+		} catch (const std::runtime_error&)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+	ASSERT_GE(client, 0);
+	EXPECT_EQ(RequestRender(client, ViewRequest(Point(0, 1.5f, -5), 6, 4, 1)).height, 4u);
+
+	// The client stays connected, so its reader is only unblocked by stop
+	service.stop();
+	server.join();
+	close(client);
+}
+
+TEST(RenderServiceTest, ClientsNotReadingRepliesAreDropped)
+{
+	RenderService service;
+	service.sendTimeout = std::chrono::milliseconds(100);
+
+	// The stalled client asks for far more than its socket buffers hold and never reads any of it
+	int stalled[2];
+	ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, stalled), 0);
+	const int bufferSize = 4096;
+	setsockopt(stalled[1], SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+	setsockopt(stalled[0], SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+	std::thread stalledReader([&]() { service.serveConnection(stalled[1]); });
+	SendFarmMessage(stalled[0], ViewRequest(Point(0, 1.5f, -5), 200, 150, 1).message());
+
+	// Queued behind it, another client is still answered, and the stalled one's reader has ended
+	int pair[2];
+	ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+	std::thread reader([&]() { service.serveConnection(pair[1]); });
+	EXPECT_EQ(RequestRender(pair[0], ViewRequest(Point(0, 1.5f, -5), 6, 4, 1)).height, 4u);
+	stalledReader.join();
+
+	close(pair[0]);
+	reader.join();
+	close(stalled[0]);
+}
@@ -0,0 +1,151 @@
+/*
+ * SamplerTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Sampler.hpp"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <set>
+#include <vector>
+
+// How many of the first count samples of pixel (x, y) fall in each of the cells cells
+std::vector<uint32_t> CellCounts(const Sampler& sampler, const uint32_t x, const uint32_t y, const uint32_t count, const uint32_t across, const uint32_t down)
+{
+	std::vector<uint32_t> cells(across * down, 0);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const std::array<float, 2> point = sampler.sample(x, y, i);
+		EXPECT_GE(point[0], 0.0F);
+		EXPECT_LT(point[0], 1.0F);
+		EXPECT_GE(point[1], 0.0F);
+		EXPECT_LT(point[1], 1.0F);
+		cells[static_cast<uint32_t>(point[1] * down) * across + static_cast<uint32_t>(point[0] * across)]++;
+	}
+	return cells;
+}
+
+TEST(SamplerTest, PixelCenter)
+{
+	const Sampler sampler;
+	EXPECT_EQ(sampler.sequence, Sampler::PixelCenter);
+	EXPECT_EQ(sampler.sample(3, 4, 0), (std::array<float, 2>{0.5F, 0.5F}));
+	EXPECT_EQ(sampler.sample(3, 4, 7, 2), (std::array<float, 2>{0.5F, 0.5F}));
+}
+
+TEST(SamplerTest, SobolIsStratifiedInEveryPixel)
+{
+	Sampler sampler;
+	sampler.sequence = Sampler::Sobol;
+	for (uint32_t pixel = 0; pixel < 8; pixel++)
+	{
+		// The first 16 points fill every cell of a 4x4, 16x1 and 1x16 grid once
+		for (const auto& [across, down] : {std::pair{4U, 4U}, std::pair{16U, 1U}, std::pair{1U, 16U}, std::pair{2U, 8U}})
+		{
+			const std::vector<uint32_t> cells = CellCounts(sampler, pixel, 2 * pixel, 16, across, down);
+			EXPECT_EQ(std::set<uint32_t>(cells.begin(), cells.end()), std::set<uint32_t>{1});
+		}
+	}
+}
+
+TEST(SamplerTest, BlueNoiseIsStratifiedInEveryPixel)
+{
+	Sampler sampler;
+	sampler.sequence = Sampler::BlueNoise;
+	for (uint32_t pixel = 0; pixel < 8; pixel++)
+	{
+		// The same points as Sobol, shifted around each axis, which keeps every gap between them
+		// on an axis, wrapping around, under two of the strips each had to itself
+		for (size_t axis = 0; axis < 2; axis++)
+		{
+			std::vector<float> positions;
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				positions.push_back(sampler.sample(3 * pixel, pixel, i)[axis]);
+			}
+			std::sort(positions.begin(), positions.end());
+			float widestGap = positions.front() + 1.0F - positions.back();
+			for (size_t i = 1; i < positions.size(); i++)
+			{
+				widestGap = std::max(widestGap, positions[i] - positions[i - 1]);
+			}
+			EXPECT_LT(widestGap, 2.0F / 16.0F);
+		}
+	}
+}
+
+TEST(SamplerTest, HaltonIsStratifiedOnEachAxis)
+{
+	Sampler sampler;
+	sampler.sequence = Sampler::Halton;
+	const std::vector<uint32_t> columns = CellCounts(sampler, 5, 9, 8, 8, 1);
+	EXPECT_EQ(std::set<uint32_t>(columns.begin(), columns.end()), std::set<uint32_t>{1});
+	const std::vector<uint32_t> rows = CellCounts(sampler, 5, 9, 9, 1, 9);
+	EXPECT_EQ(std::set<uint32_t>(rows.begin(), rows.end()), std::set<uint32_t>{1});
+}
+
+TEST(SamplerTest, PixelsAndDimensionsAreDecorrelated)
+{
+	for (const Sampler::Sequence sequence : {Sampler::Halton, Sampler::Sobol, Sampler::BlueNoise})
+	{
+		Sampler sampler;
+		sampler.sequence = sequence;
+		const std::array<float, 2> first = sampler.sample(0, 0, 0);
+		EXPECT_NE(sampler.sample(1, 0, 0), first);
+		EXPECT_NE(sampler.sample(0, 1, 0), first);
+		EXPECT_NE(sampler.sample(0, 0, 0, 1), first);
+		sampler.seed = 1;
+		EXPECT_NE(sampler.sample(0, 0, 0), first);
+	}
+}
+
+TEST(SamplerTest, ConvergesFasterThanRandomSamples)
+{
+	// The share of the pixel under a circle of radius 0.8 about its corner, which is 0.16 pi
+	const float area = 0.16F * std::numbers::pi_v<float>;
+	for (const Sampler::Sequence sequence : {Sampler::Halton, Sampler::Sobol, Sampler::BlueNoise})
+	{
+		Sampler sampler;
+		sampler.sequence = sequence;
+		float totalError = 0.0F;
+		for (uint32_t pixel = 0; pixel < 16; pixel++)
+		{
+			uint32_t inside = 0;
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				const std::array<float, 2> point = sampler.sample(pixel, 0, i);
+				inside += point[0] * point[0] + point[1] * point[1] < 0.64F ? 1 : 0;
+			}
+			totalError += std::abs(static_cast<float>(inside) / 256.0F - area);
+		}
+		// 256 random samples would be off by around 0.025 on average
+		EXPECT_LT(totalError / 16.0F, 0.012F);
+	}
+}
+
+TEST(SamplerTest, BlueNoiseMask)
+{
+	std::set<float> values;
+	float neighbourDifference = 0.0F;
+	for (uint32_t y = 0; y < BLUE_NOISE_SIZE; y++)
+	{
+		for (uint32_t x = 0; x < BLUE_NOISE_SIZE; x++)
+		{
+			values.insert(BlueNoiseMask(x, y));
+			neighbourDifference += std::abs(BlueNoiseMask(x, y) - BlueNoiseMask(x + 1, y));
+		}
+	}
+	// Every value once, evenly spread
+	ASSERT_EQ(values.size(), BLUE_NOISE_SIZE * BLUE_NOISE_SIZE);
+	EXPECT_FLOAT_EQ(*values.begin(), 0.5F / (BLUE_NOISE_SIZE * BLUE_NOISE_SIZE));
+	EXPECT_FLOAT_EQ(*values.rbegin(), 1.0F - 0.5F / (BLUE_NOISE_SIZE * BLUE_NOISE_SIZE));
+	// White noise neighbours differ by a third on average; blue noise neighbours by more
+	EXPECT_GT(neighbourDifference / (BLUE_NOISE_SIZE * BLUE_NOISE_SIZE), 0.38F);
+	// And it tiles
+	EXPECT_EQ(BlueNoiseMask(3, 5), BlueNoiseMask(3 + BLUE_NOISE_SIZE, 5 + 2 * BLUE_NOISE_SIZE));
+}
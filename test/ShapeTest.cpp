@@ -7,13 +7,18 @@
 
 #include "Shape.hpp"
 #include "ObjParser.hpp"
+#include "MeshSimplification.hpp"
 #include "gtest/gtest.h"
 #include "Tuple.hpp"
 #include "Ray.hpp"
 #include "Transformation.hpp"
 #include "Material.hpp"
+#include <algorithm>
 #include <cmath>
+#include <map>
 #include <numbers>
+#include <random>
+#include <set>
 
 
 TEST(SphereTest, RaySphereIntersectionNormal)
@@ -326,6 +331,21 @@ TEST(PlaneTest, Clone)
 	EXPECT_EQ(sClone->transform, translation(5, 0, 0));
 }
 
+TEST(PlaneTest, TextureCoordinates)
+{
+	Plane p;
+	p.transform = translation(0, 1, 0);
+	Footprint footprint;
+	footprint.dpdx = Vector(0.5, 0, 0.25);
+
+	const TextureCoordinates coordinates = p.textureCoordinates(Point(1.25, 1, -0.5), Intersection(1, &p), footprint);
+	EXPECT_FLOAT_EQ(coordinates.u, 1.25F);
+	EXPECT_FLOAT_EQ(coordinates.v, -0.5F);
+	EXPECT_FLOAT_EQ(coordinates.dudx, 0.5F);
+	EXPECT_FLOAT_EQ(coordinates.dvdx, 0.25F);
+	EXPECT_FLOAT_EQ(coordinates.dudy, 0.0F);
+}
+
 TEST(SphereTest, GlassSphereFactory)
 {
 	Sphere s = GlassSphere();
@@ -335,6 +355,37 @@ TEST(SphereTest, GlassSphereFactory)
 	EXPECT_FLOAT_EQ(s.material.refractiveIndex, 1.5f);
 }
 
+TEST(SphereTest, TextureCoordinates)
+{
+	Sphere s;
+	s.transform = scaling(2, 2, 2);
+
+	const auto uv = [&](const Tuple& p) {
+		const TextureCoordinates coordinates = s.textureCoordinates(p);
+		return std::array<float, 2>{coordinates.u, coordinates.v};
+	};
+	EXPECT_EQ(uv(Point(0, 0, -2)), (std::array<float, 2>{0.0F, 0.5F}));
+	EXPECT_EQ(uv(Point(2, 0, 0)), (std::array<float, 2>{0.25F, 0.5F}));
+	EXPECT_EQ(uv(Point(0, 0, 2)), (std::array<float, 2>{0.5F, 0.5F}));
+	EXPECT_EQ(uv(Point(-2, 0, 0)), (std::array<float, 2>{0.75F, 0.5F}));
+	EXPECT_EQ(uv(Point(0, 2, 0)), (std::array<float, 2>{0.5F, 1.0F}));
+	EXPECT_EQ(uv(Point(0, -2, 0)), (std::array<float, 2>{0.5F, 0.0F}));
+}
+
+TEST(SphereTest, TextureFootprintAcrossSeam)
+{
+	Sphere s;
+	Footprint footprint;
+	footprint.dpdx = Vector(0.02, 0, 0);
+	footprint.dpdy = Vector(0, 0.02, 0);
+
+	// u wraps from 1 to 0 between the point and its neighbour, which is no wider a step than elsewhere
+	const TextureCoordinates seam = s.textureCoordinates(Point(-0.01, 0, -1), Intersection(1, &s), footprint);
+	EXPECT_NEAR(seam.dudx, 0.02F / (2 * std::numbers::pi_v<float>), 1e-4F);
+	EXPECT_NEAR(seam.dvdy, 0.02F / std::numbers::pi_v<float>, 1e-4F);
+	EXPECT_NEAR(seam.dvdx, 0, 1e-4F);
+}
+
 TEST(CubeTest, IntersectWithRay)
 {
 	Cube c;
@@ -458,6 +509,23 @@ TEST(CubeTest, Clone)
 	EXPECT_EQ(sClone->transform, translation(5, 0, 0));
 }
 
+TEST(CubeTest, TextureCoordinatesOnEachFace)
+{
+	Cube c;
+	const auto uv = [&](const Tuple& p) {
+		const TextureCoordinates coordinates = c.textureCoordinates(p);
+		return std::array<float, 2>{coordinates.u, coordinates.v};
+	};
+
+	// The same corner of the image, a quarter in from the left and the top, on every face
+	EXPECT_EQ(uv(Point(-0.5, 0.5, 1)), (std::array<float, 2>{0.25F, 0.75F}));
+	EXPECT_EQ(uv(Point(0.5, 0.5, -1)), (std::array<float, 2>{0.25F, 0.75F}));
+	EXPECT_EQ(uv(Point(-1, 0.5, -0.5)), (std::array<float, 2>{0.25F, 0.75F}));
+	EXPECT_EQ(uv(Point(1, 0.5, 0.5)), (std::array<float, 2>{0.25F, 0.75F}));
+	EXPECT_EQ(uv(Point(-0.5, 1, -0.5)), (std::array<float, 2>{0.25F, 0.75F}));
+	EXPECT_EQ(uv(Point(-0.5, -1, 0.5)), (std::array<float, 2>{0.25F, 0.75F}));
+}
+
 TEST(CylinderTest, RayMissesCylinder)
 {
 	Cylinder c;
@@ -990,6 +1058,242 @@ TEST(GroupTest, Clone)
 	EXPECT_EQ(sClone->transform, translation(5, 0, 0));
 }
 
+Group TriangleSoup(int count)
+{
+	Group g;
+	std::minstd_rand generator(7);
+	std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+	for (int i = 0; i < count; i++)
+	{
+		const Tuple corner = Point(position(generator), position(generator), position(generator));
+		g.addChild(Triangle(corner,
+							corner + Vector(offset(generator), offset(generator), offset(generator)),
+							corner + Vector(offset(generator), offset(generator), offset(generator))));
+	}
+	Sphere s;
+	s.transform = translation(2, 3, 4) * scaling(3, 3, 3);
+	g.addChild(s);
+	g.addChild(Plane());
+	return g;
+}
+
+TEST(GroupTest, GridGroupMatchesLinearGroup)
+{
+	Group linear = TriangleSoup(2000);
+	Group grid = linear;
+	grid.setAcceleration(Group::Grid);
+
+	std::minstd_rand generator(11);
+	std::uniform_real_distribution<float> coordinate(-12.0f, 12.0f);
+	for (int i = 0; i < 200; i++)
+	{
+		Ray r(Point(coordinate(generator), coordinate(generator), coordinate(generator)),
+			  Vector(coordinate(generator), coordinate(generator), coordinate(generator)));
+		auto expected = linear.intersect(r);
+		auto actual = grid.intersect(r);
+		ASSERT_EQ(actual.size(), expected.size());
+
+		std::sort(expected.begin(), expected.end());
+		std::sort(actual.begin(), actual.end());
+		for (size_t j = 0; j < expected.size(); j++)
+		{
+			EXPECT_FLOAT_EQ(actual[j].t, expected[j].t);
+			EXPECT_EQ(actual[j].object->bounds(), expected[j].object->bounds());
+		}
+	}
+}
+
+TEST(GroupTest, GridGroupFallsBackUntilRebuilt)
+{
+	Group g;
+	g.setAcceleration(Group::Grid);
+	Sphere s;
+	s.transform = translation(0, 0, 5);
+	g.addChild(s);
+	Ray r(Point(0, 0, -5), Vector(0, 0, 1));
+
+	EXPECT_EQ(g.intersect(r).size(), 2);
+	g.buildAcceleration();
+	EXPECT_EQ(g.intersect(r).size(), 2);
+	EXPECT_EQ(g.getAcceleration(), Group::Grid);
+}
+
+TEST(GroupTest, BVHGroupFallsBackWhenChildrenMove)
+{
+	Group g;
+	for (int i = 1; i < 20; i++)
+	{
+		Sphere s;
+		s.transform = translation(static_cast<float>(i * 3), 0, 0);
+		g.addChild(s);
+	}
+	// Added last, so that no later child moves it
+	Sphere& moved = g.addChild(Sphere());
+	g.setAcceleration(Group::BVH);
+	Ray r(Point(0, 10, -5), Vector(0, 0, 1));
+	EXPECT_EQ(g.intersect(r).size(), 0);
+
+	moved.transform = translation(0, 10, 0);
+	EXPECT_EQ(g.intersect(r).size(), 2);
+	g.buildAcceleration();
+	EXPECT_EQ(g.intersect(r).size(), 2);
+}
+
+TEST(GroupTest, StaleBoundsAreComparedOncePerEpoch)
+{
+	const BoundingBox unit(Point(-1, -1, -1), Point(1, 1, 1));
+	const BoundingBox moved(Point(0, 0, 0), Point(2, 2, 2));
+	AccelerationBounds built;
+	built.record({unit});
+	int comparisons = 0;
+	const auto current = [&]() {
+		comparisons++;
+		return std::vector<BoundingBox>{moved};
+	};
+
+	AdvanceShapeEpoch();
+	EXPECT_FALSE(built.matches(current));
+	EXPECT_FALSE(built.matches(current));
+	EXPECT_EQ(comparisons, 1);
+	// Until something else changes, or the bounds are recorded again
+	AdvanceShapeEpoch();
+	EXPECT_FALSE(built.matches(current));
+	EXPECT_EQ(comparisons, 2);
+	built.record({moved});
+	EXPECT_TRUE(built.matches(current));
+	EXPECT_EQ(comparisons, 2);
+}
+
+TEST(GroupTest, CopiedGridGroupIntersectsItsOwnChildren)
+{
+	Group original = TriangleSoup(100);
+	original.setAcceleration(Group::Grid);
+	Group copy = original;
+	Ray r(Point(2, 3, -20), Vector(0, 0, 1));
+
+	auto intersections = copy.intersect(r);
+	ASSERT_FALSE(intersections.empty());
+	for (const auto& intersection : intersections)
+	{
+		EXPECT_EQ(intersection.object->parent, &copy);
+	}
+}
+
+TEST(GroupTest, BVHGroupMatchesLinearGroup)
+{
+	Group linear = TriangleSoup(2000);
+	Group bvh = linear;
+	bvh.setAcceleration(Group::BVH);
+
+	std::minstd_rand generator(13);
+	std::uniform_real_distribution<float> coordinate(-12.0f, 12.0f);
+	for (int i = 0; i < 200; i++)
+	{
+		Ray r(Point(coordinate(generator), coordinate(generator), coordinate(generator)),
+			  Vector(coordinate(generator), coordinate(generator), coordinate(generator)));
+		auto expected = linear.intersect(r);
+		auto actual = bvh.intersect(r);
+		ASSERT_EQ(actual.size(), expected.size());
+
+		std::sort(expected.begin(), expected.end());
+		std::sort(actual.begin(), actual.end());
+		for (size_t j = 0; j < expected.size(); j++)
+		{
+			EXPECT_FLOAT_EQ(actual[j].t, expected[j].t);
+			EXPECT_EQ(actual[j].object->bounds(), expected[j].object->bounds());
+		}
+	}
+}
+
+TEST(GroupTest, BVHGroupReportsStatistics)
+{
+	Group g = TriangleSoup(500);
+	EXPECT_FALSE(g.getHierarchy().built());
+
+	g.setAcceleration(Group::BVH);
+	EXPECT_TRUE(g.getHierarchy().built());
+	// Every triangle and the sphere; the plane is unbounded so stays out of the tree
+	const BVHStatistics& statistics = g.getHierarchy().statistics();
+	EXPECT_FLOAT_EQ(statistics.averageLeafSize * static_cast<float>(statistics.leafCount), 501.0f);
+
+	g.setAcceleration(Group::Linear);
+	EXPECT_FALSE(g.getHierarchy().built());
+}
+
+TEST(GroupTest, MovedGroupAdoptsChildren)
+{
+	Group g;
+	g.addChild(Sphere());
+	g.addChild(Group()).addChild(Cube());
+
+	Group moved = std::move(g);
+	const auto children = moved.objects();
+	EXPECT_EQ(children[0].get().parent, &moved);
+	EXPECT_EQ(children[1].get().parent, &moved);
+
+	// Growing a vector of groups moves them
+	std::vector<Group> groups;
+	groups.push_back(moved);
+	groups.resize(8);
+	EXPECT_EQ(groups[0].objects()[0].get().parent, &groups[0]);
+}
+
+TEST(InstanceTest, InstancesShareGeometry)
+{
+	auto geometry = std::make_shared<Group>();
+	Sphere s;
+	s.transform = translation(5, 0, 0);
+	const Sphere& sRef = geometry->addChild(s);
+	Instance left(geometry);
+	Instance right(geometry);
+	right.transform = translation(0, 3, 0);
+
+	const auto leftHits = left.intersect(Ray(Point(5, 0, -10), Vector(0, 0, 1)));
+	const auto rightHits = right.intersect(Ray(Point(5, 3, -10), Vector(0, 0, 1)));
+	const auto missedHits = right.intersect(Ray(Point(5, 0, -10), Vector(0, 0, 1)));
+
+	ASSERT_EQ(leftHits.size(), 2);
+	ASSERT_EQ(rightHits.size(), 2);
+	EXPECT_TRUE(missedHits.empty());
+	EXPECT_EQ(leftHits[0].object, &left);
+	EXPECT_EQ(leftHits[0].primitive, &sRef);
+	EXPECT_EQ(rightHits[0].object, &right);
+	EXPECT_EQ(rightHits[0].primitive, &sRef);
+	EXPECT_EQ(left.geometry, right.geometry);
+}
+
+TEST(InstanceTest, NormalOfHitInInstance)
+{
+	auto geometry = std::make_shared<Group>();
+	geometry->transform = scaling(1, 2, 3);
+	Sphere s;
+	s.transform = translation(5, 0, 0);
+	const Sphere& sRef = geometry->addChild(s);
+	Instance instance(geometry);
+	instance.transform = rotationY(std::numbers::pi / 2);
+
+	Intersection i(0, &instance);
+	i.primitive = &sRef;
+
+	// Matches a sphere placed by the same transforms through nested groups
+	EXPECT_EQ(instance.normal(Point(1.7321, 1.1547, -5.5774), i), Vector(0.2857, 0.4286, -0.8571));
+	EXPECT_EQ(instance.normal(Point(1, 1, 1)), Vector(0, 0, 0));
+}
+
+TEST(InstanceTest, Bounds)
+{
+	auto geometry = std::make_shared<Group>();
+	geometry->transform = translation(1, 0, 0);
+	geometry->addChild(Sphere());
+	Instance instance(geometry);
+	instance.transform = scaling(2, 2, 2);
+
+	EXPECT_EQ(instance.bounds().minimum, Point(0, -1, -1));
+	EXPECT_EQ(instance.bounds().maximum, Point(2, 1, 1));
+	EXPECT_EQ(instance.parentSpaceBounds().maximum, Point(4, 2, 2));
+}
+
 TEST(TriangleTest, ConstructTriangle)
 {
 	Tuple p1 = Point(0, 1, 0);
@@ -1232,6 +1536,287 @@ TEST(SmoothTriangleTest, Clone)
 	EXPECT_EQ(sClone->transform, translation(5, 0, 0));
 }
 
+TEST(TriangleMeshTest, IndexBufferWidth)
+{
+	const IndexBuffer narrow(std::vector<uint32_t>{0, 1, 65535});
+	const IndexBuffer wide(std::vector<uint32_t>{0, 1, 65536});
+
+	EXPECT_EQ(narrow.bytesPerIndex(), 2);
+	EXPECT_EQ(wide.bytesPerIndex(), 4);
+	EXPECT_EQ(narrow[2], 65535);
+	EXPECT_EQ(wide[2], 65536);
+	EXPECT_EQ(wide.size(), 3);
+}
+
+TEST(TriangleMeshTest, MatchesTriangles)
+{
+	const TriangleMesh mesh({{0, 1, 0}, {-1, 0, 0}, {1, 0, 0}, {2, 1, 0}}, {}, {0, 1, 2, 0, 2, 3});
+	const Triangle first(Point(0, 1, 0), Point(-1, 0, 0), Point(1, 0, 0));
+	const Triangle second(Point(0, 1, 0), Point(1, 0, 0), Point(2, 1, 0));
+
+	EXPECT_EQ(mesh.faceCount(), 2);
+	EXPECT_EQ(mesh.bounds().minimum, Point(-1, 0, 0));
+	EXPECT_EQ(mesh.bounds().maximum, Point(2, 1, 0));
+
+	const Ray r(Point(1, 0.5, -2), Vector(0, 0, 1));
+	const auto xs = mesh.intersect(r);
+	const auto expected = second.intersect(r);
+	ASSERT_EQ(xs.size(), 1);
+	EXPECT_EQ(xs[0].face, 1);
+	EXPECT_EQ(xs[0].t, expected[0].t);
+	EXPECT_EQ(mesh.normal(Point(1, 0.5, 0), xs[0]), second.normal(Point(1, 0.5, 0)));
+	EXPECT_TRUE(mesh.intersect(Ray(Point(-2, 0.5, -2), Vector(0, 0, 1))).empty());
+	EXPECT_EQ(mesh.intersect(Ray(Point(0, 0.5, -2), Vector(0, 0, 1)))[0].t, first.intersect(Ray(Point(0, 0.5, -2), Vector(0, 0, 1)))[0].t);
+}
+
+TEST(TriangleMeshTest, NormalInterpolation)
+{
+	const TriangleMesh mesh({{0, 1, 0}, {-1, 0, 0}, {1, 0, 0}}, {{0, 1, 0}, {-1, 0, 0}, {1, 0, 0}}, {0, 1, 2});
+	Intersection i(1, &mesh, 0.45, 0.25);
+
+	EXPECT_EQ(mesh.normal(Point(0, 0, 0), i), Vector(-0.5547, 0.83205, 0));
+}
+
+TEST(TriangleMeshTest, FacesWithoutNormalsAreFlat)
+{
+	const TriangleMesh mesh({{0, 1, 0}, {-1, 0, 0}, {1, 0, 0}}, {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}}, {0, 1, 2});
+	const Triangle t(Point(0, 1, 0), Point(-1, 0, 0), Point(1, 0, 0));
+	Intersection i(1, &mesh, 0.45, 0.25);
+
+	EXPECT_EQ(mesh.normal(Point(0, 0.5, 0), i), t.normal(Point(0, 0.5, 0)));
+}
+
+TEST(TriangleMeshTest, TextureCoordinates)
+{
+	const TriangleMesh mesh({{0, 1, 0}, {-1, 0, 0}, {1, 0, 0}}, {}, {0, 1, 2}, {{0.5, 1}, {0, 0}, {1, 0}});
+	const Intersections xs = mesh.intersect(Ray(Point(0.25, 0.25, -2), Vector(0, 0, 1)));
+	ASSERT_EQ(xs.size(), 1);
+	Footprint footprint;
+	footprint.dpdx = Vector(0.1, 0, 0);
+
+	const TextureCoordinates coordinates = mesh.textureCoordinates(Point(0.25, 0.25, 0), xs[0], footprint);
+	EXPECT_FLOAT_EQ(coordinates.u, 0.625F);
+	EXPECT_FLOAT_EQ(coordinates.v, 0.25F);
+	// Points around the hit are mapped by where they are, not by the hit's barycentric coordinates
+	EXPECT_NEAR(coordinates.dudx, 0.05F, 1e-5F);
+	EXPECT_NEAR(coordinates.dvdx, 0.0F, 1e-5F);
+	// Without texture coordinates a mesh is mapped as a plane would be
+	const TriangleMesh plain({{0, 1, 0}, {-1, 0, 0}, {1, 0, 0}}, {}, {0, 1, 2});
+	EXPECT_FLOAT_EQ(plain.textureCoordinates(Point(0.25, 0.25, 0), xs[0]).u, 0.25F);
+}
+
+// A size by size grid of squares, two faces each, in the z = 0 plane from the origin, with
+// texture coordinates spanning the whole grid
+TriangleMesh GridMesh(uint32_t size)
+{
+	std::vector<TriangleMesh::Vertex> positions;
+	std::vector<TriangleMesh::TextureVertex> textureCoordinates;
+	std::vector<uint32_t> indices;
+	for (uint32_t y = 0; y <= size; y++)
+	{
+		for (uint32_t x = 0; x <= size; x++)
+		{
+			positions.push_back({static_cast<float>(x), static_cast<float>(y), 0});
+			textureCoordinates.push_back({static_cast<float>(x) / static_cast<float>(size), static_cast<float>(y) / static_cast<float>(size)});
+		}
+	}
+	for (uint32_t y = 0; y < size; y++)
+	{
+		for (uint32_t x = 0; x < size; x++)
+		{
+			const uint32_t corner = y * (size + 1) + x;
+			indices.insert(indices.end(), {corner, corner + 1, corner + size + 2, corner, corner + size + 2, corner + size + 1});
+		}
+	}
+	return TriangleMesh(positions, {}, indices, textureCoordinates);
+}
+
+// A unit sphere of rings latitude rings and segments faces around each, with normals
+TriangleMesh SphereMesh(uint32_t rings, uint32_t segments)
+{
+	std::vector<TriangleMesh::Vertex> positions = {{0, 1, 0}};
+	for (uint32_t ring = 1; ring < rings; ring++)
+	{
+		const float theta = std::numbers::pi_v<float> * static_cast<float>(ring) / static_cast<float>(rings);
+		for (uint32_t segment = 0; segment < segments; segment++)
+		{
+			const float phi = 2 * std::numbers::pi_v<float> * static_cast<float>(segment) / static_cast<float>(segments);
+			positions.push_back({std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)});
+		}
+	}
+	positions.push_back({0, -1, 0});
+	const auto bottom = static_cast<uint32_t>(positions.size() - 1);
+	const auto at = [&](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * segments + segment % segments; };
+
+	std::vector<uint32_t> indices;
+	for (uint32_t segment = 0; segment < segments; segment++)
+	{
+		indices.insert(indices.end(), {0, at(1, segment), at(1, segment + 1)});
+		for (uint32_t ring = 1; ring + 1 < rings; ring++)
+		{
+			indices.insert(indices.end(), {at(ring, segment), at(ring + 1, segment), at(ring + 1, segment + 1)});
+			indices.insert(indices.end(), {at(ring, segment), at(ring + 1, segment + 1), at(ring, segment + 1)});
+		}
+		indices.insert(indices.end(), {bottom, at(rings - 1, segment + 1), at(rings - 1, segment)});
+	}
+	return TriangleMesh(positions, positions, indices);
+}
+
+TEST(MeshSimplificationTest, FlatGridKeepsItsOutline)
+{
+	const TriangleMesh grid = GridMesh(8);
+	const TriangleMesh simplified = SimplifyMesh(grid, 2);
+
+	EXPECT_EQ(simplified.faceCount(), 2);
+	EXPECT_EQ(simplified.positions().size(), 4);
+	EXPECT_EQ(simplified.bounds(), grid.bounds());
+	for (const TriangleMesh::Vertex& position : simplified.positions())
+	{
+		EXPECT_EQ(position[2], 0);
+	}
+	EXPECT_FALSE(simplified.intersect(Ray(Point(7.5, 0.5, -1), Vector(0, 0, 1))).empty());
+	EXPECT_FALSE(simplified.intersect(Ray(Point(0.5, 7.5, -1), Vector(0, 0, 1))).empty());
+}
+
+TEST(MeshSimplificationTest, SphereReachesTarget)
+{
+	const TriangleMesh sphere = SphereMesh(8, 16);
+	const TriangleMesh simplified = SimplifyMesh(sphere, sphere.faceCount() / 4);
+
+	EXPECT_EQ(sphere.faceCount(), 224);
+	EXPECT_LE(simplified.faceCount(), 56);
+	EXPECT_GE(simplified.faceCount(), 50);
+	EXPECT_EQ(simplified.normals().size(), simplified.positions().size());
+	for (const TriangleMesh::Vertex& position : simplified.positions())
+	{
+		const float length = std::sqrt(position[0] * position[0] + position[1] * position[1] + position[2] * position[2]);
+		EXPECT_LE(length, 1.0001F);
+		EXPECT_GE(length, 0.9F);
+	}
+	const auto xs = simplified.intersect(Ray(Point(0.1, 0.05, -5), Vector(0, 0, 1)));
+	ASSERT_EQ(xs.size(), 2);
+	EXPECT_NEAR(std::min(xs[0].t, xs[1].t), 4, 0.2);
+}
+
+// Whether every edge of the mesh is shared by exactly two faces, as on a closed surface, and no
+// two faces have the same corners
+bool IsClosedManifold(const TriangleMesh& mesh)
+{
+	std::map<std::pair<uint32_t, uint32_t>, int> edgeUses;
+	std::set<std::array<uint32_t, 3>> faces;
+	for (size_t face = 0; face < mesh.faceCount(); face++)
+	{
+		std::array<uint32_t, 3> corners = {mesh.indices()[face * 3], mesh.indices()[face * 3 + 1], mesh.indices()[face * 3 + 2]};
+		for (size_t corner = 0; corner < 3; corner++)
+		{
+			const uint32_t a = corners[corner];
+			const uint32_t b = corners[(corner + 1) % 3];
+			if (a == b)
+			{
+				return false;
+			}
+			edgeUses[{std::min(a, b), std::max(a, b)}]++;
+		}
+		std::sort(corners.begin(), corners.end());
+		if (!faces.insert(corners).second)
+		{
+			return false;
+		}
+	}
+	return std::all_of(edgeUses.begin(), edgeUses.end(), [](const auto& edge) { return edge.second == 2; });
+}
+
+TEST(MeshSimplificationTest, TetrahedronIsNotFolded)
+{
+	const std::vector<TriangleMesh::Vertex> positions = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+	const TriangleMesh tetrahedron(positions, {}, {0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3});
+	ASSERT_TRUE(IsClosedManifold(tetrahedron));
+
+	// Any collapse would leave two faces back to back with the same corners
+	const TriangleMesh simplified = SimplifyMesh(tetrahedron, 1);
+	EXPECT_EQ(simplified.faceCount(), 4);
+	EXPECT_TRUE(IsClosedManifold(simplified));
+}
+
+TEST(MeshSimplificationTest, SphereStaysClosedWhenSimplifiedAway)
+{
+	const TriangleMesh sphere = SphereMesh(8, 16);
+	ASSERT_TRUE(IsClosedManifold(sphere));
+
+	const TriangleMesh simplified = SimplifyMesh(sphere, 1);
+	EXPECT_GE(simplified.faceCount(), 4);
+	EXPECT_TRUE(IsClosedManifold(simplified));
+}
+
+TEST(MeshSimplificationTest, TextureCoordinatesFollowVertices)
+{
+	const TriangleMesh simplified = SimplifyMesh(GridMesh(8), 8);
+
+	ASSERT_EQ(simplified.textureVertices().size(), simplified.positions().size());
+	for (size_t vertex = 0; vertex < simplified.positions().size(); vertex++)
+	{
+		EXPECT_NEAR(simplified.textureVertices()[vertex][0], simplified.positions()[vertex][0] / 8, 1e-5F);
+		EXPECT_NEAR(simplified.textureVertices()[vertex][1], simplified.positions()[vertex][1] / 8, 1e-5F);
+	}
+}
+
+TEST(MeshSimplificationTest, SimplifiedGroup)
+{
+	Group group;
+	group.addChild(GridMesh(4));
+	Group inner;
+	inner.addChild(SphereMesh(8, 16));
+	inner.addChild(Triangle(Point(0, 1, 0), Point(-1, 0, 0), Point(1, 0, 0)));
+	group.addChild(inner);
+	group.setAcceleration(Group::BVH);
+
+	const Group simplified = group.simplified(0.25F);
+	EXPECT_EQ(group.faceCount(), 32 + 224 + 1);
+	EXPECT_LE(simplified.faceCount(), 8 + 56 + 1);
+	EXPECT_EQ(simplified.getAcceleration(), Group::BVH);
+	EXPECT_TRUE(group.bounds().contains(simplified.bounds().minimum));
+	EXPECT_TRUE(group.bounds().contains(simplified.bounds().maximum));
+	EXPECT_FALSE(simplified.intersect(Ray(Point(0.5, 0.5, -1), Vector(0, 0, 1))).empty());
+}
+
+TEST(InstanceTest, SelectDetailBySize)
+{
+	auto geometry = std::make_shared<Group>();
+	geometry->addChild(SphereMesh(8, 16));
+	Instance instance(geometry);
+	instance.detailLevels.push_back(std::make_shared<const Group>(geometry->simplified(0.25F)));
+	const float pixelSize = 0.01F;
+
+	instance.selectDetail(Point(0, 0, -5), pixelSize);
+	EXPECT_EQ(instance.getDetailLevel(), 0);
+	instance.selectDetail(Point(0, 0, -1000), pixelSize);
+	EXPECT_EQ(instance.getDetailLevel(), 1);
+	EXPECT_EQ(instance.intersect(Ray(Point(0, 0, -1000), Vector(0, 0, 1))).size(), 2);
+	instance.selectDetail(Point(0, 0, 0), pixelSize);
+	EXPECT_EQ(instance.getDetailLevel(), 0);
+
+	// The instance's own transform counts toward its size on screen
+	instance.transform = scaling(100, 100, 100);
+	instance.selectDetail(Point(0, 0, -1000), pixelSize);
+	EXPECT_EQ(instance.getDetailLevel(), 0);
+}
+
+TEST(InstanceTest, TextureCoordinatesOfPrimitive)
+{
+	auto geometry = std::make_shared<Group>();
+	Sphere sphere;
+	sphere.transform = translation(0, 0, 1);
+	geometry->addChild(sphere);
+	Instance instance(geometry);
+	instance.transform = scaling(2, 2, 2);
+
+	const Intersections xs = instance.intersect(Ray(Point(0, 0, -10), Vector(0, 0, 1)));
+	ASSERT_EQ(xs.size(), 2);
+	const TextureCoordinates coordinates = instance.textureCoordinates(Point(0, 0, 0), std::min(xs[0], xs[1]));
+	EXPECT_FLOAT_EQ(coordinates.u, 0.0F);
+	EXPECT_FLOAT_EQ(coordinates.v, 0.5F);
+}
+
 TEST(ObjParserTest, IgnoreLineCountForEmptyString)
 {
 	std::string empty = "";
@@ -1449,6 +2034,128 @@ TEST(ObjParserTest, GroupParsingError)
 	}
 }
 
+TEST(ObjParserTest, MeshSharesVertices)
+{
+	std::string data =
+			"v -1 1 0\n"
+			"v -1 0 0\n"
+			"v 1 0 0\n"
+			"v 1 1 0\n"
+			"v 0 2 0\n"
+			"f 1 2 3 4 5\n"
+			"g Second\n"
+			"f 1 2 3\n";
+	ObjParser parser(data, MeshOptions());
+
+	const auto objects = parser.defaultGroup.objects();
+	ASSERT_EQ(objects.size(), 1);
+	const auto& mesh = dynamic_cast<const TriangleMesh&>(objects[0].get());
+	EXPECT_EQ(mesh.faceCount(), 3);
+	EXPECT_EQ(mesh.positions().size(), 5);
+	EXPECT_TRUE(mesh.normals().empty());
+	EXPECT_EQ(mesh.indices().bytesPerIndex(), 2);
+	EXPECT_EQ(mesh.indices()[7], 3);
+	EXPECT_EQ(mesh.indices()[8], 4);
+	EXPECT_EQ(dynamic_cast<const TriangleMesh&>(parser.namedGroups["Second"].objects()[0].get()).positions().size(), 3);
+}
+
+TEST(ObjParserTest, MeshKeepsNormals)
+{
+	std::string data =
+			"v 0 1 0\n"
+			"v -1 0 0\n"
+			"v 1 0 0\n"
+			"vn -1 0 0\n"
+			"vn 1 0 0\n"
+			"vn 0 1 0\n"
+			"f 1//3 2//1 3//2\n"
+			"f 1//1 2//1 3//1\n";
+	ObjParser parser(data, MeshOptions());
+
+	const auto& mesh = dynamic_cast<const TriangleMesh&>(parser.defaultGroup.objects()[0].get());
+	// Only the second corner repeats both its vertex and its normal
+	EXPECT_EQ(mesh.positions().size(), 5);
+	ASSERT_EQ(mesh.normals().size(), 5);
+	EXPECT_EQ(mesh.indices()[4], mesh.indices()[1]);
+	EXPECT_EQ(mesh.normals()[0], (TriangleMesh::Vertex{0, 1, 0}));
+}
+
+TEST(ObjParserTest, MeshTextureCoordinates)
+{
+	std::string data =
+			"v 0 1 0\n"
+			"v -1 0 0\n"
+			"v 1 0 0\n"
+			"vt 0.5 1\n"
+			"vt 0 0 0\n"
+			"vt 1 0\n"
+			"f 1/1 2/2 3/3\n"
+			"f 1/2 2/2 3/3\n";
+	ObjParser parser(data, MeshOptions());
+
+	EXPECT_EQ(parser.textureVertices.size(), 3);
+	const auto& mesh = dynamic_cast<const TriangleMesh&>(parser.defaultGroup.objects()[0].get());
+	// Corners sharing a vertex but not a texture vertex are kept apart
+	EXPECT_EQ(mesh.positions().size(), 4);
+	ASSERT_EQ(mesh.textureVertices().size(), 4);
+	EXPECT_EQ(mesh.textureVertices()[0], (TriangleMesh::TextureVertex{0.5, 1}));
+	EXPECT_EQ(mesh.textureVertices()[mesh.indices()[3]], (TriangleMesh::TextureVertex{0, 0}));
+	EXPECT_NE(mesh.indices()[3], mesh.indices()[0]);
+	EXPECT_EQ(mesh.indices()[4], mesh.indices()[1]);
+	EXPECT_EQ(mesh.indices()[5], mesh.indices()[2]);
+}
+
+TEST(ObjParserTest, TextureVertexParsingError)
+{
+	std::string badVertex = "vt 0.5\n";
+	std::string badIndex =
+			"v 0 1 0\n"
+			"v -1 0 0\n"
+			"v 1 0 0\n"
+			"vt 0 0\n"
+			"f 1/1 2/1 3/2\n";
+
+	EXPECT_THROW(ObjParser parser(badVertex), std::runtime_error);
+	EXPECT_THROW(ObjParser(badIndex, MeshOptions()), std::runtime_error);
+}
+
+TEST(ObjParserTest, MeshWelding)
+{
+	// Every face repeats its corners, as many CAD exports do
+	std::string data =
+			"v 0 0 0\n"
+			"v 1 0 0\n"
+			"v 0 1 0\n"
+			"v 1.000001 0 0\n"
+			"v 1 1 0\n"
+			"v 0 1.000001 0\n"
+			"f 1 2 3\n"
+			"f 4 5 6\n";
+	MeshOptions welded;
+	welded.weld = true;
+	MeshOptions invalid = welded;
+	invalid.weldTolerance = 0;
+
+	ObjParser unweldedParser(data, MeshOptions());
+	ObjParser weldedParser(data, welded);
+	EXPECT_EQ(dynamic_cast<const TriangleMesh&>(unweldedParser.defaultGroup.objects()[0].get()).positions().size(), 6);
+	const auto& mesh = dynamic_cast<const TriangleMesh&>(weldedParser.defaultGroup.objects()[0].get());
+	EXPECT_EQ(mesh.positions().size(), 4);
+	EXPECT_EQ(mesh.indices()[3], mesh.indices()[1]);
+	EXPECT_EQ(mesh.indices()[5], mesh.indices()[2]);
+	EXPECT_THROW(ObjParser(data, invalid), std::runtime_error);
+}
+
+TEST(ObjParserTest, MeshFaceIndexError)
+{
+	std::string data =
+			"v 0 0 0\n"
+			"v 1 0 0\n"
+			"f 1 2 3\n";
+
+	EXPECT_THROW(ObjParser(data, MeshOptions()), std::runtime_error);
+}
+
 TEST(ConstructiveSolidGeometry, Creation)
 {
 	std::unique_ptr<Shape> s1 = std::make_unique<Sphere>();
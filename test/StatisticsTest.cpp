@@ -0,0 +1,122 @@
+/*
+ * StatisticsTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Statistics.hpp"
+#include "Camera.hpp"
+#include "Transformation.hpp"
+#include "World.hpp"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <numbers>
+#include <thread>
+
+TEST(StatisticsTest, AddingSumsEveryCounter)
+{
+	RenderStatistics a;
+	a.counts[RenderStatistics::PrimaryRays] = 3;
+	a.counts[RenderStatistics::HeapAllocations] = 1;
+	a.threads = 1;
+	RenderStatistics b;
+	b.counts[RenderStatistics::PrimaryRays] = 4;
+	b.threads = 2;
+
+	a += b;
+	EXPECT_EQ(a[RenderStatistics::PrimaryRays], 7u);
+	EXPECT_EQ(a[RenderStatistics::HeapAllocations], 1u);
+	EXPECT_EQ(a[RenderStatistics::ShadowRays], 0u);
+	EXPECT_EQ(a.threads, 3u);
+}
+
+TEST(StatisticsTest, SummaryAndJsonNameEveryCounter)
+{
+	RenderStatistics statistics;
+	statistics.counts[RenderStatistics::ShadowRays] = 12;
+	statistics.counts[RenderStatistics::CSGTests] = 5;
+	statistics.threads = 2;
+
+	const std::string summary = statistics.summary();
+	EXPECT_NE(summary.find("over 2 threads"), std::string::npos);
+	EXPECT_NE(summary.find("Shadow rays: 12"), std::string::npos);
+	EXPECT_NE(summary.find("CSG tests: 5"), std::string::npos);
+
+	const std::string json = statistics.json();
+	EXPECT_EQ(json.front(), '{');
+	EXPECT_EQ(json.back(), '}');
+	EXPECT_NE(json.find("\"threads\": 2"), std::string::npos);
+	EXPECT_NE(json.find("\"shadowRays\": 12"), std::string::npos);
+	EXPECT_NE(json.find("\"csgTests\": 5"), std::string::npos);
+	EXPECT_NE(json.find("\"heapAllocations\": 0"), std::string::npos);
+}
+
+TEST(StatisticsTest, RenderCountsItsWork)
+{
+	if constexpr (!RenderStatistics::Enabled)
+	{
+		GTEST_SKIP() << "Built without ENABLE_STATISTICS";
+	}
+
+	World w = World::BaseWorld();
+	Camera c(11, 11, std::numbers::pi_v<float> / 2, ViewTransform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0)));
+	(void)c.Render(w);
+	const RenderStatistics statistics = RenderStatistics::Collect();
+
+	EXPECT_EQ(statistics[RenderStatistics::PrimaryRays], 121u);
+	EXPECT_GT(statistics[RenderStatistics::SphereTests], 0u);
+	EXPECT_GT(statistics[RenderStatistics::ShadowRays], 0u);
+	EXPECT_EQ(statistics[RenderStatistics::LightingCalls], statistics[RenderStatistics::ShadowRays]);
+	EXPECT_EQ(statistics[RenderStatistics::PlaneTests], 0u);
+	EXPECT_GE(statistics.threads, 1u);
+}
+
+TEST(StatisticsTest, OnlyTracedBranchesAreCounted)
+{
+	if constexpr (!RenderStatistics::Enabled)
+	{
+		GTEST_SKIP() << "Built without ENABLE_STATISTICS";
+	}
+
+	World w = World::BaseWorld();
+	Plane floor;
+	floor.transform = translation(0, -1, 0);
+	floor.material.reflectivity = 0.5f;
+	w.planes.push_back(floor);
+	const Ray r(Point(0, 0, -3), Vector(0, -std::sqrt(2.0f) / 2, std::sqrt(2.0f) / 2));
+
+	// Too light to pass the minimum contribution, so never traced
+	w.rayTree.minimumContribution = 0.6f;
+	RenderStatistics::Reset();
+	(void)w.colorAt(r);
+	EXPECT_EQ(RenderStatistics::Collect()[RenderStatistics::ReflectionRays], 0u);
+
+	w.rayTree.minimumContribution = 0.0f;
+	RenderStatistics::Reset();
+	(void)w.colorAt(r);
+	EXPECT_EQ(RenderStatistics::Collect()[RenderStatistics::ReflectionRays], 1u);
+}
+
+TEST(StatisticsTest, ExitedThreadsAreStillCollected)
+{
+	if constexpr (!RenderStatistics::Enabled)
+	{
+		GTEST_SKIP() << "Built without ENABLE_STATISTICS";
+	}
+
+	RenderStatistics::Reset();
+	std::thread counting([]() {
+		CountStatistic(RenderStatistics::ReflectionRays);
+		CountStatistic(RenderStatistics::ReflectionRays);
+	});
+	counting.join();
+	CountStatistic(RenderStatistics::ReflectionRays);
+
+	const RenderStatistics statistics = RenderStatistics::Collect();
+	EXPECT_EQ(statistics[RenderStatistics::ReflectionRays], 3u);
+	EXPECT_EQ(statistics.threads, 2u);
+
+	RenderStatistics::Reset();
+	EXPECT_EQ(RenderStatistics::Collect()[RenderStatistics::ReflectionRays], 0u);
+}
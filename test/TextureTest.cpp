@@ -0,0 +1,270 @@
+/*
+ * TextureTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Texture.hpp"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+// Red counts texels across and green counts them down, so every texel of the full image differs
+std::vector<Texel> CountingTexels(const uint32_t width, const uint32_t height)
+{
+	std::vector<Texel> texels;
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			texels.push_back({static_cast<uint8_t>(x), static_cast<uint8_t>(y), 0, 255});
+		}
+	}
+	return texels;
+}
+
+TEST(TextureTest, BuildsMipLevelsDownToOneTexel)
+{
+	TextureCache cache;
+	const Texture texture(5, 2, CountingTexels(5, 2), cache);
+
+	EXPECT_EQ(texture.width(), 5);
+	EXPECT_EQ(texture.height(), 2);
+	// 5x2, 3x1, 2x1, 1x1
+	ASSERT_EQ(texture.levels(), 4);
+	EXPECT_EQ(texture.texel(0, 4, 1), Color(4.0F / 255.0F, 1.0F / 255.0F, 0));
+	// The last column stands in for the one missing past the right edge
+	EXPECT_EQ(texture.texel(1, 0, 0), Color(1.0F / 255.0F, 1.0F / 255.0F, 0));
+	EXPECT_EQ(texture.texel(1, 2, 0), Color(4.0F / 255.0F, 1.0F / 255.0F, 0));
+}
+
+TEST(TextureTest, TexelsAcrossManyTiles)
+{
+	TextureCache cache;
+	const Texture texture(20, 19, CountingTexels(20, 19), cache);
+
+	for (uint32_t y = 0; y < 19; y++)
+	{
+		for (uint32_t x = 0; x < 20; x++)
+		{
+			EXPECT_EQ(texture.texel(0, x, y), Color(static_cast<float>(x) / 255.0F, static_cast<float>(y) / 255.0F, 0));
+		}
+	}
+}
+
+TEST(TextureTest, FromCanvas)
+{
+	TextureCache cache;
+	Canvas image(2, 2);
+	image.pixels[0][1] = Color(1, 0.5, 2);
+	const Texture texture(image, cache);
+
+	EXPECT_EQ(texture.texel(0, 1, 0), Color(1, 128.0F / 255.0F, 1));
+	EXPECT_EQ(texture.texel(0, 0, 0), Color(0, 0, 0));
+	EXPECT_EQ(texture.texel(1, 0, 0), Color(64.0F / 255.0F, 32.0F / 255.0F, 64.0F / 255.0F));
+}
+
+TEST(TextureTest, SampleAtTexelCentres)
+{
+	TextureCache cache;
+	const Texture texture(4, 4, CountingTexels(4, 4), cache);
+
+	// v runs up the image, so the top row is at v near 1
+	EXPECT_EQ(texture.sample({0.375F, 0.875F}), texture.texel(0, 1, 0));
+	EXPECT_EQ(texture.sample({0.875F, 0.125F}), texture.texel(0, 3, 3));
+	// Repeating past 0 and 1
+	EXPECT_EQ(texture.sample({1.375F, -0.875F}), texture.texel(0, 1, 3));
+}
+
+TEST(TextureTest, SampleBlendsNeighbouringTexels)
+{
+	TextureCache cache;
+	const Texture texture(4, 4, CountingTexels(4, 4), cache);
+
+	// Half way between texels 1 and 2 across, and texels 0 and 1 down
+	const Color blended = texture.sample({0.5F, 0.75F});
+	EXPECT_FLOAT_EQ(blended.r, 1.5F / 255.0F);
+	EXPECT_FLOAT_EQ(blended.g, 0.5F / 255.0F);
+	// Half way between the last texel and the first, across the edge the image repeats at
+	EXPECT_FLOAT_EQ(texture.sample({0.0F, 0.875F}).r, 1.5F / 255.0F);
+}
+
+TEST(TextureTest, FootprintChoosesMipLevel)
+{
+	TextureCache cache;
+	std::vector<Texel> texels;
+	for (uint32_t i = 0; i < 64; i++)
+	{
+		texels.push_back((i + i / 8) % 2 == 0 ? Texel{255, 255, 255, 255} : Texel{0, 0, 0, 255});
+	}
+	const Texture checkers(8, 8, texels, cache);
+	ASSERT_EQ(checkers.levels(), 4);
+
+	// Without a footprint the texel itself is read
+	EXPECT_EQ(checkers.sample({0.0625F, 0.9375F}), Color(1, 1, 1));
+	// A footprint two texels wide reads level 1, where each texel averages two black and two white
+	const Color level1 = checkers.sample({0.0625F, 0.9375F, 0.25F, 0.0F, 0.0F, 0.25F});
+	EXPECT_NEAR(level1.r, 0.5F, 0.01F);
+	// Between levels the two are blended, and wider footprints than the image stop at the last level
+	const Color between = checkers.sample({0.0625F, 0.9375F, 0.125F * std::sqrt(2.0F), 0.0F, 0.0F, 0.0F});
+	EXPECT_NEAR(between.r, 0.75F, 0.01F);
+	const Color coarsest = checkers.sample({0.3F, 0.6F, 0.0F, 0.0F, 0.0F, 40.0F});
+	EXPECT_NEAR(coarsest.r, 0.5F, 0.01F);
+}
+
+TEST(TextureTest, CacheStaysWithinBudget)
+{
+	TextureCache cache(4 * sizeof(TextureTile));
+	const Texture texture(64, 64, CountingTexels(64, 64), cache);
+
+	for (uint32_t pass = 0; pass < 2; pass++)
+	{
+		for (uint32_t y = 0; y < 64; y += 3)
+		{
+			for (uint32_t x = 0; x < 64; x += 5)
+			{
+				EXPECT_EQ(texture.texel(0, x, y), Color(static_cast<float>(x) / 255.0F, static_cast<float>(y) / 255.0F, 0));
+			}
+		}
+	}
+	EXPECT_EQ(cache.residentBytes(), 4 * sizeof(TextureTile));
+	// Every tile of the image was read back at least once per pass
+	EXPECT_GE(cache.tileLoads(), 128);
+}
+
+TEST(TextureTest, TilesThatFitAreNeverWrittenOut)
+{
+	TextureCache cache;
+	const Texture texture(16, 16, CountingTexels(16, 16), cache);
+
+	// 4 tiles of the full image and one for each of 8x8, 4x4, 2x2 and 1x1
+	EXPECT_EQ(cache.residentBytes(), 8 * sizeof(TextureTile));
+	EXPECT_EQ(texture.texel(0, 9, 3), Color(9.0F / 255.0F, 3.0F / 255.0F, 0));
+	EXPECT_EQ(cache.tileLoads(), 0);
+}
+
+TEST(TextureTest, ResidentTilesAreNotReadAgain)
+{
+	TextureCache cache(2 * sizeof(TextureTile));
+	const Texture texture(16, 16, CountingTexels(16, 16), cache);
+	EXPECT_EQ(cache.residentBytes(), 0);
+
+	(void)texture.texel(0, 0, 0);
+	(void)texture.texel(0, 7, 7);
+	EXPECT_EQ(cache.tileLoads(), 1);
+	(void)texture.texel(0, 8, 0);
+	EXPECT_EQ(cache.tileLoads(), 2);
+	EXPECT_EQ(cache.residentBytes(), 2 * sizeof(TextureTile));
+}
+
+TEST(TextureTest, ShrinkingBudgetDropsTiles)
+{
+	TextureCache cache;
+	const Texture texture(32, 32, CountingTexels(32, 32), cache);
+	// 16 tiles of the full image, 4 of 16x16 and one for each of the rest
+	EXPECT_EQ(cache.residentBytes(), 24 * sizeof(TextureTile));
+
+	// Tiles that were only ever in memory are written out as they are dropped
+	cache.setBudget(2 * sizeof(TextureTile));
+	EXPECT_EQ(cache.budget(), 2 * sizeof(TextureTile));
+	EXPECT_EQ(cache.residentBytes(), 0);
+	EXPECT_EQ(texture.texel(0, 3, 17), Color(3.0F / 255.0F, 17.0F / 255.0F, 0));
+	EXPECT_EQ(cache.tileLoads(), 1);
+}
+
+TEST(TextureTest, DestroyedTexturesGiveBackTheirTiles)
+{
+	TextureCache cache;
+	{
+		const Texture texture(16, 16, CountingTexels(16, 16), cache);
+		EXPECT_EQ(texture.texel(0, 9, 3), Color(9.0F / 255.0F, 3.0F / 255.0F, 0));
+	}
+	EXPECT_EQ(cache.residentBytes(), 0);
+
+	// The next texture reuses the tiles, and this thread's copies of the old ones are not read
+	const Texture white(16, 16, std::vector<Texel>(256, {255, 255, 255, 255}), cache);
+	EXPECT_EQ(white.texel(0, 9, 3), Color(1, 1, 1));
+	EXPECT_EQ(cache.residentBytes(), 8 * sizeof(TextureTile));
+}
+
+TEST(TextureTest, ThreadsLookUpTogether)
+{
+	TextureCache cache(16 * sizeof(TextureTile));
+	const Texture texture(64, 64, CountingTexels(64, 64), cache);
+
+	std::vector<std::thread> threads;
+	std::atomic<int> wrong = 0;
+	for (uint32_t thread = 0; thread < 4; thread++)
+	{
+		threads.emplace_back([&, thread]() {
+			for (uint32_t i = 0; i < 4096; i++)
+			{
+				const uint32_t x = (i * 7 + thread * 13) % 64;
+				const uint32_t y = (i * 3 + thread * 5) % 64;
+				if (texture.texel(0, x, y) != Color(static_cast<float>(x) / 255.0F, static_cast<float>(y) / 255.0F, 0))
+				{
+					wrong++;
+				}
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	EXPECT_EQ(wrong, 0);
+	EXPECT_LE(cache.residentBytes(), 16 * sizeof(TextureTile));
+}
+
+std::string WriteTextureFile(const std::string& name, const std::string& contents)
+{
+	const std::string fileName = ::testing::TempDir() + name;
+	std::ofstream file(fileName, std::ios::binary);
+	file << contents;
+	return fileName;
+}
+
+TEST(TextureTest, LoadPlainPPM)
+{
+	TextureCache cache;
+	const std::string fileName = WriteTextureFile("TexturePlain.ppm", "P3\n# A comment\n2 1\n15\n15 0 0  0 5 15\n");
+	const std::shared_ptr<const Texture> texture = cache.load(fileName);
+
+	ASSERT_EQ(texture->width(), 2);
+	ASSERT_EQ(texture->height(), 1);
+	EXPECT_EQ(texture->texel(0, 0, 0), Color(1, 0, 0));
+	EXPECT_EQ(texture->texel(0, 1, 0), Color(0, 85.0F / 255.0F, 1));
+}
+
+TEST(TextureTest, LoadBinaryPPM)
+{
+	TextureCache cache;
+	std::string contents = "P6 1 2 255\n";
+	contents += std::string{'\xff', '\x80', '\x00', '\x00', '\x00', '\x40'};
+	const std::shared_ptr<const Texture> texture = cache.load(WriteTextureFile("TextureBinary.ppm", contents));
+
+	EXPECT_EQ(texture->texel(0, 0, 0), Color(1, 128.0F / 255.0F, 0));
+	EXPECT_EQ(texture->texel(0, 0, 1), Color(0, 0, 64.0F / 255.0F));
+}
+
+TEST(TextureTest, LoadsOfOneFileShareTexture)
+{
+	TextureCache cache;
+	const std::string fileName = WriteTextureFile("TextureShared.ppm", "P3 1 1 255 1 2 3\n");
+
+	const std::shared_ptr<const Texture> first = cache.load(fileName);
+	EXPECT_EQ(cache.load(fileName), first);
+}
+
+TEST(TextureTest, ImproperPPM)
+{
+	TextureCache cache;
+	EXPECT_THROW((void)cache.load(::testing::TempDir() + "NoSuchTexture.ppm"), std::runtime_error);
+	EXPECT_THROW((void)cache.load(WriteTextureFile("TextureMagic.ppm", "P5 1 1 255 0\n")), std::runtime_error);
+	EXPECT_THROW((void)cache.load(WriteTextureFile("TextureSize.ppm", "P3 0 1 255\n")), std::runtime_error);
+	EXPECT_THROW((void)cache.load(WriteTextureFile("TextureShort.ppm", "P3 2 1 255 1 2 3 4\n")), std::runtime_error);
+	EXPECT_THROW((void)cache.load(WriteTextureFile("TextureShortBinary.ppm", "P6 2 1 255\nabc")), std::runtime_error);
+}
@@ -0,0 +1,114 @@
+/*
+ * TraceTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "Trace.hpp"
+#include "Camera.hpp"
+#include "Transformation.hpp"
+#include "World.hpp"
+#include "gtest/gtest.h"
+#include <numbers>
+#include <thread>
+
+size_t Occurrences(const std::string& text, const std::string& pattern)
+{
+	size_t count = 0;
+	for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1))
+	{
+		count++;
+	}
+	return count;
+}
+
+TEST(TraceTest, DisabledTracerRecordsNothing)
+{
+	Tracer::Enable();
+	Tracer::Disable();
+	{
+		const TraceScope scope("TraceTest disabled");
+	}
+
+	EXPECT_FALSE(Tracer::enabled());
+	EXPECT_EQ(Tracer::json().find("TraceTest disabled"), std::string::npos);
+}
+
+TEST(TraceTest, ScopeRecordsCompleteEvent)
+{
+	Tracer::Enable();
+	{
+		const TraceScope scope("TraceTest scope");
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+	Tracer::Disable();
+
+	const std::string json = Tracer::json();
+	EXPECT_EQ(json.rfind("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [", 0), 0u);
+	const size_t event = json.find("{\"name\": \"TraceTest scope\", \"ph\": \"X\"");
+	ASSERT_NE(event, std::string::npos);
+	const size_t duration = json.find("\"dur\": ", event);
+	EXPECT_GE(std::stod(json.substr(duration + 7)), 2000.0);
+}
+
+TEST(TraceTest, EnablingDropsEarlierEvents)
+{
+	Tracer::Enable();
+	{
+		const TraceScope scope("TraceTest earlier");
+	}
+	Tracer::Enable();
+	Tracer::Disable();
+
+	EXPECT_EQ(Tracer::json().find("TraceTest earlier"), std::string::npos);
+}
+
+TEST(TraceTest, ThreadsRecordOnTheirOwnTimelines)
+{
+	Tracer::Enable();
+	std::thread other([]() { const TraceScope scope("TraceTest thread"); });
+	other.join();
+	{
+		const TraceScope scope("TraceTest thread");
+	}
+	Tracer::Disable();
+
+	const std::string json = Tracer::json();
+	EXPECT_EQ(Occurrences(json, "TraceTest thread"), 2u);
+	EXPECT_EQ(Occurrences(json, "\"thread_name\""), 2u);
+}
+
+TEST(TraceTest, RingBufferKeepsMostRecentEvents)
+{
+	Tracer::Enable();
+	const auto now = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < 10; i++)
+	{
+		Tracer::record("TraceTest old", now, now);
+	}
+	for (size_t i = 0; i < Tracer::BUFFER_CAPACITY; i++)
+	{
+		Tracer::record("TraceTest new", now, now);
+	}
+	Tracer::Disable();
+
+	const std::string json = Tracer::json();
+	EXPECT_EQ(Occurrences(json, "TraceTest old"), 0u);
+	EXPECT_EQ(Occurrences(json, "TraceTest new"), Tracer::BUFFER_CAPACITY);
+}
+
+TEST(TraceTest, RenderRecordsEveryRow)
+{
+	World w = World::BaseWorld();
+	Camera c = Camera(11, 7, std::numbers::pi / 2);
+	c.transform = ViewTransform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0));
+
+	Tracer::Enable();
+	(void)c.Render(w);
+	Tracer::Disable();
+
+	const std::string json = Tracer::json();
+	EXPECT_EQ(Occurrences(json, "\"Camera::Render\""), 1u);
+	EXPECT_EQ(Occurrences(json, "\"Render row\""), 7u);
+}
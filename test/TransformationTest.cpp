@@ -140,3 +140,21 @@ TEST(TransformationTest, ArbitraryViewTransform)
 
 
 
+
+TEST(TransformationTest, TransformsAreConstexpr)
+{
+	constexpr Matrix<4> transform = translation(10, 5, 7) * scaling(5, 5, 5) * rotationX(std::numbers::pi_v<float> / 2);
+	constexpr Tuple p = transform * Point(1, 0, 1);
+	static_assert(p == Point(15, 0, 7));
+
+	constexpr Matrix<4> view = ViewTransform(Point(0, 0, 8), Point(0, 0, 0), Vector(0, 1, 0));
+	static_assert(view == translation(0, 0, -8));
+
+	// The compile-time trig stays within comparison tolerance of the runtime result
+	float angle = 0.7f;
+	constexpr Matrix<4> rotation = rotationY(0.7f);
+	EXPECT_EQ(rotation, rotationY(angle));
+	float wrappedAngle = -7.5f;
+	constexpr Matrix<4> wrappedRotation = rotationZ(-7.5f);
+	EXPECT_EQ(wrappedRotation, rotationZ(wrappedAngle));
+}
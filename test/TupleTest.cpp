@@ -198,6 +198,40 @@ TEST(TupleTest, ReflectOffSlantedSurface)
 	EXPECT_EQ(r, Vector(1, 0, 0));
 }
 
+TEST(TupleTest, ArithmeticIsConstexpr)
+{
+	constexpr Tuple a = Point(1, 2, 3);
+	constexpr Tuple b = Vector(2, 3, 4);
+	static_assert(a + b == Point(3, 5, 7));
+	static_assert(Vector(1, 2, 3).cross(b) == Vector(-1, 2, -1));
+	static_assert(b.dot(b) == 29.0f);
+
+	EXPECT_EQ(a + b, Point(3, 5, 7));
+}
+
+TEST(TupleTest, RuntimeMatchesConstantEvaluation)
+{
+	constexpr Tuple a = Tuple(1.5f, -2, 3, 0.25f);
+	constexpr Tuple b = Tuple(-4, 5.5f, 6, 1);
+	constexpr float dot = a.dot(b);
+	constexpr Tuple cross = a.cross(b);
+	constexpr Tuple difference = a - b;
+
+	Tuple x = a;
+	Tuple y = b;
+	EXPECT_FLOAT_EQ(x.dot(y), dot);
+	EXPECT_EQ(x.cross(y), cross);
+	EXPECT_EQ(x - y, difference);
+	EXPECT_EQ(-x, Tuple(-1.5f, 2, -3, -0.25f));
+	EXPECT_NE(x, y);
+}
+
+TEST(TupleTest, TuplesAreAligned)
+{
+	EXPECT_EQ(alignof(Tuple), 16u);
+	EXPECT_EQ(sizeof(Tuple), 16u);
+}
+
 
 
 
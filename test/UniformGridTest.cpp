@@ -0,0 +1,92 @@
+/*
+ * UniformGridTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "UniformGrid.hpp"
+#include "Ray.hpp"
+#include "gtest/gtest.h"
+#include <vector>
+
+std::vector<BoundingBox> RowOfUnitBoxes(int count)
+{
+	std::vector<BoundingBox> boxes;
+	for (int i = 0; i < count; i++)
+	{
+		const auto x = static_cast<float>(i * 3);
+		boxes.emplace_back(Point(x - 1, -1, -1), Point(x + 1, 1, 1));
+	}
+	return boxes;
+}
+
+TEST(UniformGridTest, EmptyGridHasNoCandidates)
+{
+	UniformGrid grid;
+	grid.build({});
+
+	EXPECT_TRUE(grid.built());
+	EXPECT_TRUE(grid.candidates(Ray(Point(0, 0, -5), Vector(0, 0, 1))).empty());
+}
+
+TEST(UniformGridTest, ResolutionFollowsExtents)
+{
+	UniformGrid grid;
+	grid.build(RowOfUnitBoxes(32));
+
+	EXPECT_EQ(grid.bounds(), BoundingBox(Point(-1, -1, -1), Point(94, 1, 1)));
+	EXPECT_GT(grid.resolution()[0], grid.resolution()[1]);
+	EXPECT_GT(grid.resolution()[0], grid.resolution()[2]);
+}
+
+TEST(UniformGridTest, CandidatesAlongRay)
+{
+	UniformGrid grid;
+	grid.build(RowOfUnitBoxes(32));
+
+	// Straight through the middle of box 10 only
+	auto candidates = grid.candidates(Ray(Point(30, 0, -5), Vector(0, 0, 1)));
+	EXPECT_NE(std::find(candidates.begin(), candidates.end(), 10u), candidates.end());
+	EXPECT_LT(candidates.size(), 4u);
+
+	// Along the whole row, so every box
+	candidates = grid.candidates(Ray(Point(-10, 0, 0), Vector(1, 0, 0)));
+	EXPECT_EQ(candidates.size(), 32u);
+}
+
+TEST(UniformGridTest, CandidatesIncludeBoxesBehindOrigin)
+{
+	UniformGrid grid;
+	grid.build(RowOfUnitBoxes(32));
+
+	auto candidates = grid.candidates(Ray(Point(200, 0, 0), Vector(1, 0, 0)));
+	EXPECT_EQ(candidates.size(), 32u);
+}
+
+TEST(UniformGridTest, CandidatesAreSortedAndUnique)
+{
+	UniformGrid grid;
+	std::vector<BoundingBox> boxes = RowOfUnitBoxes(8);
+	boxes.emplace_back(Point(-1, -1, -1), Point(22, 1, 1)); // Spans every cell
+	grid.build(boxes);
+
+	auto candidates = grid.candidates(Ray(Point(-10, 0.5f, 0.5f), Vector(1, 0, 0)));
+	ASSERT_EQ(candidates.size(), 9u);
+	for (uint32_t i = 0; i < candidates.size(); i++)
+	{
+		EXPECT_EQ(candidates[i], i);
+	}
+}
+
+TEST(UniformGridTest, UnboundedPrimitivesAreAlwaysCandidates)
+{
+	UniformGrid grid;
+	std::vector<BoundingBox> boxes = RowOfUnitBoxes(4);
+	boxes.push_back(BoundingBox::Infinite());
+	grid.build(boxes);
+
+	auto candidates = grid.candidates(Ray(Point(0, 50, 5), Vector(0, 1, 0)));
+	ASSERT_EQ(candidates.size(), 1u);
+	EXPECT_EQ(candidates[0], 4u);
+}
@@ -0,0 +1,144 @@
+/*
+ * WideBoundingVolumeHierarchyTest.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nic
+ */
+
+#include "WideBoundingVolumeHierarchy.hpp"
+#include "Ray.hpp"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+std::vector<BoundingBox> RandomBoxes(int count)
+{
+	std::vector<BoundingBox> boxes;
+	std::minstd_rand generator(3);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> size(0.01f, 2.0f);
+	for (int i = 0; i < count; i++)
+	{
+		const Tuple corner = Point(position(generator), position(generator), position(generator));
+		boxes.emplace_back(corner, corner + Vector(size(generator), size(generator), size(generator)));
+	}
+	return boxes;
+}
+
+TEST(WideBoundingVolumeHierarchyTest, NodeFillsOneCacheLine)
+{
+	EXPECT_EQ(sizeof(WideBVHNode), 64u);
+	EXPECT_EQ(alignof(WideBVHNode), 64u);
+}
+
+TEST(WideBoundingVolumeHierarchyTest, EmptyHierarchyHasNoCandidates)
+{
+	WideBoundingVolumeHierarchy bvh;
+	bvh.build({});
+
+	EXPECT_TRUE(bvh.built());
+	EXPECT_TRUE(bvh.nodes().empty());
+	EXPECT_TRUE(bvh.candidates(Ray(Point(0, 0, -5), Vector(0, 0, 1))).empty());
+}
+
+TEST(WideBoundingVolumeHierarchyTest, SinglePrimitiveIsOneLeafChild)
+{
+	WideBoundingVolumeHierarchy bvh;
+	bvh.build(std::vector<BoundingBox>{BoundingBox(Point(-1, -1, -1), Point(1, 1, 1))});
+
+	ASSERT_EQ(bvh.nodes().size(), 1u);
+	EXPECT_EQ(bvh.nodes()[0].childCount, 1u);
+	EXPECT_TRUE(bvh.nodes()[0].isLeaf(0));
+	EXPECT_EQ(bvh.candidates(Ray(Point(0, 0, -5), Vector(0, 0, 1))).size(), 1u);
+	EXPECT_TRUE(bvh.candidates(Ray(Point(0, 5, -5), Vector(0, 0, 1))).empty());
+}
+
+TEST(WideBoundingVolumeHierarchyTest, CollapsesBinaryTree)
+{
+	const std::vector<BoundingBox> boxes = RandomBoxes(2000);
+	BoundingVolumeHierarchy binary;
+	binary.build(boxes);
+	WideBoundingVolumeHierarchy wide;
+	const BVHStatistics& statistics = wide.build(boxes);
+
+	EXPECT_EQ(statistics.nodeCount, binary.nodes().size());
+	EXPECT_LT(wide.nodes().size() * 2, binary.nodes().size());
+	for (const WideBVHNode& node : wide.nodes())
+	{
+		EXPECT_GE(node.childCount, 1u);
+		EXPECT_LE(node.childCount, WideBVHNode::WIDTH);
+	}
+}
+
+TEST(WideBoundingVolumeHierarchyTest, QuantizedBoundsContainChildren)
+{
+	const std::vector<BoundingBox> boxes = RandomBoxes(500);
+	WideBoundingVolumeHierarchy bvh;
+	bvh.build(boxes);
+
+	// Every primitive sits in exactly one leaf, whose quantized bounds contain it
+	std::vector<uint32_t> reached;
+	for (const WideBVHNode& node : bvh.nodes())
+	{
+		for (uint32_t i = 0; i < node.childCount; i++)
+		{
+			if (!node.isLeaf(i))
+			{
+				continue;
+			}
+			const BoundingBox bounds = node.childBounds(i);
+			for (uint32_t j = 0; j < node.leafCount[i]; j++)
+			{
+				const uint32_t primitive = bvh.primitives()[node.child[i] + j];
+				EXPECT_TRUE(bounds.contains(boxes[primitive].minimum));
+				EXPECT_TRUE(bounds.contains(boxes[primitive].maximum));
+				reached.push_back(primitive);
+			}
+		}
+	}
+	std::sort(reached.begin(), reached.end());
+	EXPECT_EQ(std::unique(reached.begin(), reached.end()), reached.end());
+	EXPECT_EQ(reached.size(), boxes.size());
+}
+
+TEST(WideBoundingVolumeHierarchyTest, CandidatesCoverExactHits)
+{
+	const std::vector<BoundingBox> boxes = RandomBoxes(2000);
+	WideBoundingVolumeHierarchy bvh;
+	bvh.build(boxes);
+
+	std::minstd_rand generator(5);
+	std::uniform_real_distribution<float> coordinate(-60.0f, 60.0f);
+	for (int i = 0; i < 100; i++)
+	{
+		Ray r(Point(coordinate(generator), coordinate(generator), coordinate(generator)),
+			  Vector(coordinate(generator), coordinate(generator), coordinate(generator)));
+		// Axis aligned rays exercise the zero direction handling
+		if (i % 10 == 0)
+		{
+			r.direction = Vector(0, 0, 1);
+		}
+		const auto candidates = bvh.candidates(r);
+		EXPECT_TRUE(std::is_sorted(candidates.begin(), candidates.end()));
+		for (uint32_t j = 0; j < boxes.size(); j++)
+		{
+			if (boxes[j].intersect(r))
+			{
+				EXPECT_TRUE(std::binary_search(candidates.begin(), candidates.end(), j));
+			}
+		}
+	}
+}
+
+TEST(WideBoundingVolumeHierarchyTest, UnboundedPrimitivesAreAlwaysCandidates)
+{
+	std::vector<BoundingBox> boxes = RandomBoxes(16);
+	boxes.push_back(BoundingBox::Infinite());
+	WideBoundingVolumeHierarchy bvh;
+	bvh.build(boxes);
+
+	auto candidates = bvh.candidates(Ray(Point(0, 0, 500), Vector(1, 0, 0)));
+	ASSERT_EQ(candidates.size(), 1u);
+	EXPECT_EQ(candidates[0], 16u);
+}
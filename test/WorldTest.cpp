@@ -12,6 +12,8 @@
 #include "Transformation.hpp"
 #include "Ray.hpp"
 #include <cmath>
+#include <numbers>
+#include <random>
 
 TEST(WorldTest, DefaultWorld)
 {
@@ -195,6 +197,48 @@ TEST(WorldTest, ReflectedColorForReflectiveMaterial)
 	EXPECT_EQ(c, Color(0.19032f, 0.2379f, 0.14274));
 }
 
+TEST(WorldTest, CurvedMirrorSpreadsReflectedDifferential)
+{
+	const RayDifferential differential = {Vector(0, 0, 0), Vector(0.001, 0, 0), Vector(0, 0, 0), Vector(0, 0.001, 0)};
+	const Ray r(Point(0, 0, -5), Vector(0, 0, 1));
+
+	Plane flat;
+	flat.transform = translation(0, 0, -1) * rotationX(std::numbers::pi / 2);
+	flat.material.reflectivity = 1.0F;
+	auto flatHits = flat.intersect(r);
+	const auto flatReflection = World::reflectionRay(r.precomputeDetails(*r.hit(flatHits), flatHits, differential));
+
+	Sphere curved;
+	curved.material.reflectivity = 1.0F;
+	auto curvedHits = curved.intersect(r);
+	const auto curvedReflection = World::reflectionRay(r.precomputeDetails(*r.hit(curvedHits), curvedHits, differential));
+
+	ASSERT_TRUE(flatReflection.differential);
+	ASSERT_TRUE(curvedReflection.differential);
+	EXPECT_EQ(flatReflection.differential->originX, Vector(0.004, 0, 0));
+	EXPECT_EQ(flatReflection.differential->directionX, Vector(0.001, 0, 0));
+	EXPECT_EQ(curvedReflection.differential->originX, Vector(0.004, 0, 0));
+	// The unit sphere's normal turns by as much as the hit moves, and the reflection by twice that
+	EXPECT_NEAR(curvedReflection.differential->directionX.x, 0.009, 1e-4);
+	EXPECT_NEAR(curvedReflection.differential->directionY.y, 0.009, 1e-4);
+}
+
+TEST(WorldTest, RefractedRayKeepsDifferential)
+{
+	const RayDifferential differential = {Vector(0, 0, 0), Vector(0.001, 0, 0), Vector(0, 0, 0), Vector(0, 0.001, 0)};
+	const Ray r(Point(0, 0, -5), Vector(0, 0, 1));
+	const Sphere glass = GlassSphere();
+	auto hits = glass.intersect(r);
+	const auto refracted = World::refractionRay(r.precomputeDetails(*r.hit(hits), hits, differential));
+
+	ASSERT_TRUE(refracted);
+	ASSERT_TRUE(refracted->differential);
+	EXPECT_EQ(refracted->differential->originX, Vector(0.004, 0, 0));
+	// Entering a sphere of index 1.5 bends neighbouring rays toward each other
+	EXPECT_LT(refracted->differential->directionX.x, 0.0);
+	EXPECT_EQ(refracted->ray.direction, Vector(0, 0, 1));
+}
+
 TEST(WorldTest, ShadeHitWithReflectiveMaterial)
 {
 	World w = World::BaseWorld();
@@ -381,3 +425,259 @@ TEST(WorldTest, WorldCanHoldAllSupportedShapes)
 
 
 
+
+TEST(WorldTest, ColorAtMatchesRecursiveShadeHit)
+{
+	World w = World::BaseWorld();
+	w.rayTree.minimumContribution = 0.0f;
+	Plane p;
+	p.transform = translation(0, -1, 0);
+	p.material.reflectivity = 0.5f;
+	p.material.transparency = 0.5f;
+	p.material.refractiveIndex = 1.5f;
+	w.planes.push_back(p);
+	Sphere s;
+	s.transform = translation(0, -3.5, -0.5);
+	s.material.color = Color(1, 0, 0);
+	s.material.ambient = 0.5f;
+	w.spheres.push_back(s);
+	Ray r = Ray(Point(0, 0, -3), Vector(0, -sqrt(2) / 2, sqrt(2) / 2));
+	auto intersections = w.intersect(r);
+	auto id = r.precomputeDetails(*r.hit(intersections), intersections);
+
+	EXPECT_EQ(w.colorAt(r, 5), w.shadeHit(id, 5));
+	EXPECT_EQ(w.colorAt(r, 5), Color(0.93391, 0.69643, 0.69243));
+}
+
+TEST(WorldTest, ColorAtRecordsFeaturesOfFirstHit)
+{
+	World w = World::BaseWorld();
+	w.spheres[0].material.reflectivity = 0.5f;
+	const Ray r = Ray(Point(0, 0, -5), Vector(0, 0, 1));
+	SurfaceFeatures features;
+
+	EXPECT_EQ(w.colorAt(r, features), w.colorAt(r));
+	// The reflection traced from the hit does not replace it
+	EXPECT_EQ(features.albedo, Color(0.8, 1.0, 0.6));
+	EXPECT_EQ(features.normal, Vector(0, 0, -1));
+	EXPECT_FLOAT_EQ(features.depth, 4);
+
+	SurfaceFeatures missed;
+	EXPECT_EQ(w.colorAt(Ray(Point(0, 0, -5), Vector(0, 1, 0)), missed), Color(0, 0, 0));
+	EXPECT_EQ(missed.depth, 0);
+	EXPECT_EQ(missed.normal, Vector(0, 0, 0));
+}
+
+TEST(WorldTest, ColorAtDropsBranchesBelowMinimumContribution)
+{
+	World w = World::BaseWorld();
+	w.rayTree.minimumContribution = 0.6f;
+	Plane p = Plane();
+	p.transform = translation(0, -1, 0);
+	p.material.reflectivity = 0.5f;
+	w.planes.push_back(p);
+
+	Ray r = Ray(Point(0, 0, -3), Vector(0, -sqrt(2) / 2, sqrt(2) / 2));
+	auto intersections = w.intersect(r);
+	auto comps = r.precomputeDetails(*r.hit(intersections), intersections);
+
+	EXPECT_EQ(w.colorAt(r), w.surfaceColor(comps));
+}
+
+TEST(WorldTest, RussianRouletteIsReproducible)
+{
+	World w;
+	w.rayTree.russianRoulette = true;
+	w.rayTree.rouletteThreshold = 1.0f;
+	w.light = Light(Point(0, 0, 0), Color::White);
+	w.planes.emplace_back(Plane());
+	w.planes[0].material.reflectivity = 0.5f;
+	w.planes[0].transform = translation(0, -1, 0);
+	w.planes.emplace_back(Plane());
+	w.planes[1].material.reflectivity = 0.5f;
+	w.planes[1].transform = translation(0, 1, 0);
+	Ray r = Ray(Point(0, 0, 0), Vector(0, 1, 0.1));
+
+	EXPECT_EQ(w.colorAt(r, 10), w.colorAt(r, 10));
+}
+
+TEST(WorldTest, RussianRouletteEndsLowThroughputBranches)
+{
+	RayTreeSettings settings;
+	settings.russianRoulette = true;
+	settings.rouletteThreshold = 0.5f;
+	std::minstd_rand generator(1);
+
+	EXPECT_EQ(settings.survivingThroughput(0.75f, generator), 0.75f);
+	uint32_t survivors = 0;
+	for (uint32_t trial = 0; trial < 10000; trial++)
+	{
+		const auto survived = settings.survivingThroughput(0.05f, generator);
+		if (survived)
+		{
+			EXPECT_EQ(*survived, 0.5f);
+			survivors++;
+		}
+	}
+	// One in ten is expected to survive
+	EXPECT_GT(survivors, 900u);
+	EXPECT_LT(survivors, 1100u);
+}
+
+TEST(WorldTest, RussianRouletteAveragesToColorWithoutRoulette)
+{
+	World w;
+	w.light = Light(Point(0, 0, 0), Color::White);
+	w.planes.emplace_back(Plane());
+	w.planes[0].material.reflectivity = 0.5f;
+	w.planes[0].transform = translation(0, -1, 0);
+	w.planes.emplace_back(Plane());
+	w.planes[1].material.reflectivity = 0.5f;
+	w.planes[1].transform = translation(0, 1, 0);
+	const Tuple direction = Vector(0, 1, 0.1);
+	const Color expected = w.colorAt(Ray(Point(0, 0, 0), direction), 10);
+
+	w.rayTree.russianRoulette = true;
+	w.rayTree.rouletteThreshold = 1.0f;
+	// Moving the origin along the ray keeps its path but gives it another roulette seed
+	constexpr uint32_t seeds = 4000;
+	Color sum = Color::Black;
+	uint32_t cutShort = 0;
+	for (uint32_t i = 0; i < seeds; i++)
+	{
+		const Color color = w.colorAt(Ray(Point(0, 0, 0) + direction * (float(i) * 1e-5f), direction), 10);
+		sum = sum + color;
+		cutShort += color == expected ? 0 : 1;
+	}
+	const Color average = sum * (1.0f / seeds);
+
+	EXPECT_GT(cutShort, seeds / 2);
+	EXPECT_NEAR(average.r, expected.r, 0.02f * expected.r);
+	EXPECT_NEAR(average.g, expected.g, 0.02f * expected.g);
+	EXPECT_NEAR(average.b, expected.b, 0.02f * expected.b);
+}
+
+TEST(WorldTest, BranchWeightsIncludeFresnelTerm)
+{
+	World w = World::BaseWorld();
+	Plane p;
+	p.transform = translation(0, -1, 0);
+	p.material.reflectivity = 0.5f;
+	p.material.transparency = 0.5f;
+	p.material.refractiveIndex = 1.5f;
+	w.planes.push_back(p);
+	Ray r = Ray(Point(0, 0, -3), Vector(0, -sqrt(2) / 2, sqrt(2) / 2));
+	auto intersections = w.intersect(r);
+	auto id = r.precomputeDetails(*r.hit(intersections), intersections);
+
+	auto reflection = World::reflectionBranch(id);
+	auto refraction = World::refractionBranch(id);
+
+	ASSERT_TRUE(reflection);
+	ASSERT_TRUE(refraction);
+	EXPECT_FLOAT_EQ(reflection->weight, 0.5f * id.reflectance);
+	EXPECT_FLOAT_EQ(refraction->weight, 0.5f * (1 - id.reflectance));
+}
+
+TEST(WorldTest, ObjectAtFollowsObjectsOrder)
+{
+	World w = World::BaseWorld();
+	w.planes.push_back(Plane());
+	w.cubes.push_back(Cube());
+	w.groups.push_back(Group());
+	auto refs = w.objects();
+
+	ASSERT_EQ(w.objectCount(), refs.size());
+	for (size_t i = 0; i < refs.size(); i++)
+	{
+		EXPECT_EQ(&w.objectAt(i), &refs[i].get());
+	}
+}
+
+World RowOfSpheres(int count)
+{
+	World w;
+	for (int i = 0; i < count; i++)
+	{
+		Sphere s;
+		s.transform = translation(static_cast<float>(i * 3), 0, 0);
+		w.spheres.push_back(s);
+	}
+	w.planes.push_back(Plane());
+	return w;
+}
+
+TEST(WorldTest, TopLevelMatchesLinearIntersection)
+{
+	World linear = RowOfSpheres(50);
+	World accelerated = linear;
+	accelerated.buildAcceleration();
+
+	for (int i = 0; i < 50; i++)
+	{
+		Ray r(Point(static_cast<float>(i) * 3.1f, 0.5f, -5), Vector(0.1f, -0.05f, 1));
+		auto expected = linear.intersect(r);
+		auto actual = accelerated.intersect(r);
+		ASSERT_EQ(actual.size(), expected.size());
+		for (size_t j = 0; j < expected.size(); j++)
+		{
+			EXPECT_FLOAT_EQ(actual[j].t, expected[j].t);
+			EXPECT_EQ(actual[j].object->transform, expected[j].object->transform);
+		}
+	}
+}
+
+TEST(WorldTest, RefitFollowsMovedObjects)
+{
+	World w = RowOfSpheres(50);
+	w.buildAcceleration();
+	const uint32_t nodeCount = w.getTopLevel().statistics().nodeCount;
+	Ray r(Point(0, 10, -5), Vector(0, 0, 1));
+	EXPECT_EQ(w.intersect(r).size(), 0);
+
+	w.spheres[20].transform = translation(0, 10, 0);
+	w.refitAcceleration();
+
+	EXPECT_EQ(w.getTopLevel().statistics().nodeCount, nodeCount);
+	ASSERT_EQ(w.intersect(r).size(), 2);
+	EXPECT_FLOAT_EQ(w.intersect(r)[0].t, 4);
+}
+
+TEST(WorldTest, MovedObjectsAreTestedBeforeRefit)
+{
+	World w = RowOfSpheres(50);
+	w.buildAcceleration();
+	Ray r(Point(0, 10, -5), Vector(0, 0, 1));
+	EXPECT_EQ(w.intersect(r).size(), 0);
+
+	w.spheres[20].transform = translation(0, 10, 0);
+	ASSERT_EQ(w.intersect(r).size(), 2);
+	EXPECT_FLOAT_EQ(w.intersect(r)[0].t, 4);
+}
+
+TEST(WorldTest, TopLevelStaysInUseWhenBoundsAreUnchanged)
+{
+	World w = RowOfSpheres(10);
+	w.buildAcceleration();
+	// Turning a sphere about its centre leaves its bounds where they were
+	w.spheres[3].transform = translation(9, 0, 0) * rotationY(1.0f);
+	Ray r(Point(9, 0, -5), Vector(0, 0, 1));
+
+	ASSERT_EQ(w.intersect(r).size(), 2);
+	EXPECT_FLOAT_EQ(w.intersect(r)[0].t, 4);
+}
+
+TEST(WorldTest, AddedObjectsAreTestedBeforeRebuild)
+{
+	World w = RowOfSpheres(10);
+	w.buildAcceleration();
+	Sphere s;
+	s.transform = translation(0, 10, 0);
+	w.spheres.push_back(s);
+	Ray r(Point(0, 10, -5), Vector(0, 0, 1));
+
+	EXPECT_EQ(w.intersect(r).size(), 2);
+	w.refitAcceleration();
+	EXPECT_EQ(w.getTopLevel().primitiveCount(), w.objectCount());
+	EXPECT_EQ(w.intersect(r).size(), 2);
+}
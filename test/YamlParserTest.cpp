@@ -8,6 +8,8 @@
 #include "gtest/gtest.h"
 #include "YamlParser.hpp"
 #include "Transformation.hpp"
+#include <fstream>
+#include <sstream>
 
 TEST(YamlParser, EmptyStringGivesDefaultWorld)
 {
@@ -801,3 +803,483 @@ TEST(YamlParser, ImproperUseOfExtendCommand)
 
 
 
+
+TEST(YamlParser, AddSequence)
+{
+	std::string sequenceString =
+			"- add: sequence\n"
+			"  frames: 24\n"
+			"- add: camera\n"
+			"  width: 100\n"
+			"  height: 100\n"
+			"  field-of-view: 0.5\n"
+			"  from: [ 0, 0, -5 ]\n"
+			"  to: [ 0, 0, 0 ]\n"
+			"  up: [ 0, 1, 0 ]\n"
+			"  keyframe: 12\n"
+			"  from: [ 5, 0, 0 ]\n"
+			"  keyframe: 23\n"
+			"  up: [ 1, 0, 0 ]\n";
+	YamlParser parser(sequenceString);
+
+	EXPECT_TRUE(parser.worldSequence.animated());
+	EXPECT_EQ(parser.worldSequence.frameCount, 24u);
+	ASSERT_EQ(parser.worldSequence.cameraKeyframes.size(), 3u);
+	EXPECT_EQ(parser.worldSequence.cameraKeyframes[0].from, Point(0, 0, -5));
+	EXPECT_EQ(parser.worldSequence.cameraKeyframes[1].frame, 12u);
+	EXPECT_EQ(parser.worldSequence.cameraKeyframes[1].from, Point(5, 0, 0));
+	EXPECT_EQ(parser.worldSequence.cameraKeyframes[2].from, Point(5, 0, 0));
+	EXPECT_EQ(parser.worldSequence.cameraKeyframes[2].up, Vector(1, 0, 0));
+	// The keyframes do not change the camera as parsed
+	EXPECT_EQ(parser.worldCamera, Camera(100, 100, 0.5, ViewTransform(Point(0, 0, -5), Point(0, 0, 0), Vector(0, 1, 0))));
+}
+
+TEST(YamlParser, AddShapeKeyframes)
+{
+	std::string keyframeString =
+			"- define: lift-transform\n"
+			"  value:\n"
+			"    - [ translate, 0, 1, 0 ]\n"
+			"- add: sphere\n"
+			"- add: cube\n"
+			"  transform:\n"
+			"    - [ scale, 2, 2, 2 ]\n"
+			"  keyframe: 10\n"
+			"    - [ scale, 4, 4, 4 ]\n"
+			"  keyframe: 5\n"
+			"  transform: lift-transform\n";
+	YamlParser parser(keyframeString);
+
+	EXPECT_EQ(parser.world.cubes[0].transform, AffineTransform(scaling(2, 2, 2)));
+	ASSERT_EQ(parser.worldSequence.objects.size(), 1u);
+	const ObjectAnimation& animation = parser.worldSequence.objects[0];
+	EXPECT_EQ(&parser.world.objectAt(animation.object), &parser.world.cubes[0]);
+	ASSERT_EQ(animation.keyframes.size(), 3u);
+	EXPECT_EQ(animation.keyframes[1].frame, 5u);
+	EXPECT_EQ(animation.transformAt(5), AffineTransform(translation(0, 1, 0)));
+	EXPECT_EQ(animation.transformAt(10), AffineTransform(scaling(4, 4, 4)));
+}
+
+TEST(YamlParser, ImproperFramesCommand)
+{
+	std::string framesString =
+			"- add: sequence\n"
+			"  frames: 0\n";
+
+	EXPECT_THROW(YamlParser parser(framesString), std::runtime_error);
+}
+
+TEST(YamlParser, ImproperUseOfKeyframeCommand)
+{
+	std::string keyframeString =
+			"- add: light\n"
+			"  keyframe: 3\n";
+
+	EXPECT_THROW(YamlParser parser(keyframeString), std::runtime_error);
+}
+
+TEST(YamlParser, HeatmapCommand)
+{
+	std::string heatmapString =
+			"- add: camera\n"
+			"  width: 10\n"
+			"  heatmap: time\n";
+
+	YamlParser parser(heatmapString);
+	EXPECT_EQ(parser.worldCamera.costMeasure, Camera::Time);
+}
+
+TEST(YamlParser, ImproperHeatmapCommand)
+{
+	std::string measureString =
+			"- add: camera\n"
+			"  heatmap: colors\n";
+	std::string lightString =
+			"- add: light\n"
+			"  heatmap: time\n";
+
+	EXPECT_THROW(YamlParser parser(measureString), std::runtime_error);
+	EXPECT_THROW(YamlParser parser(lightString), std::runtime_error);
+}
+
+TEST(YamlParser, SamplerCommands)
+{
+	std::string samplerString =
+			"- add: camera\n"
+			"  width: 10\n"
+			"  sampler: blue-noise\n"
+			"  samples: 16\n";
+
+	YamlParser parser(samplerString);
+	EXPECT_EQ(parser.worldCamera.sampler.sequence, Sampler::BlueNoise);
+	EXPECT_EQ(parser.worldCamera.samplesPerPixel, 16);
+	EXPECT_EQ(YamlParser("- add: camera\n  sampler: halton\n").worldCamera.sampler.sequence, Sampler::Halton);
+	EXPECT_EQ(YamlParser("- add: camera\n  sampler: sobol\n").worldCamera.sampler.sequence, Sampler::Sobol);
+	EXPECT_EQ(YamlParser("- add: camera\n  width: 10\n").worldCamera.samplesPerPixel, 1);
+}
+
+TEST(YamlParser, ImproperSamplerCommands)
+{
+	EXPECT_THROW(YamlParser parser("- add: camera\n  sampler: random\n"), std::runtime_error);
+	EXPECT_THROW(YamlParser parser("- add: light\n  sampler: sobol\n"), std::runtime_error);
+	EXPECT_THROW(YamlParser parser("- add: camera\n  samples: 0\n"), std::runtime_error);
+	EXPECT_THROW(YamlParser parser("- add: sphere\n  samples: 4\n"), std::runtime_error);
+}
+
+TEST(YamlParser, DenoiseCommand)
+{
+	YamlParser parser("- add: camera\n  width: 10\n  denoise: 3\n");
+	ASSERT_TRUE(parser.worldCamera.denoise);
+	EXPECT_EQ(parser.worldCamera.denoise->iterations, 3);
+	EXPECT_FALSE(YamlParser("- add: camera\n  width: 10\n").worldCamera.denoise);
+}
+
+TEST(YamlParser, ImproperDenoiseCommand)
+{
+	EXPECT_THROW(YamlParser parser("- add: camera\n  denoise: 0\n"), std::runtime_error);
+	EXPECT_THROW(YamlParser parser("- add: camera\n  denoise: 13\n"), std::runtime_error);
+	EXPECT_THROW(YamlParser parser("- add: light\n  denoise: 2\n"), std::runtime_error);
+}
+
+TEST(YamlParser, TokenizeYamlLine)
+{
+	const std::string line = "  - add:  sphere\r";
+	const LineTokens tokens = TokenizeYamlLine(line);
+
+	ASSERT_EQ(tokens.size(), 3);
+	EXPECT_EQ(tokens[0], "-");
+	EXPECT_EQ(tokens[1], "add:");
+	EXPECT_EQ(tokens[2], "sphere");
+	EXPECT_EQ(tokens[2].data(), line.data() + 10);
+	EXPECT_TRUE(TokenizeYamlLine("   \r").empty());
+}
+
+TEST(YamlParser, TokenizeYamlLineWithTooManyTokens)
+{
+	std::string line;
+	for (size_t i = 0; i <= LineTokens::CAPACITY; i++)
+	{
+		line += "x ";
+	}
+
+	EXPECT_THROW((void)TokenizeYamlLine(line), std::runtime_error);
+}
+
+TEST(YamlParser, StreamMatchesString)
+{
+	// Enough blank lines to push the sphere's lines across the first chunk boundary
+	std::string sceneString(1 << 20, ' ');
+	for (size_t i = 100; i < sceneString.size(); i += 100)
+	{
+		sceneString[i] = '\n';
+	}
+	sceneString +=
+			"\n- add: sphere\n"
+			"  material:\n"
+			"    color: [ 0.5, 0.25, 1 ]\n"
+			"  transform:\n"
+			"    - [ translate, 1, 2, 3 ]\n";
+	std::istringstream sceneStream(sceneString);
+
+	YamlParser stringParser(sceneString);
+	YamlParser streamParser(sceneStream);
+	ASSERT_EQ(streamParser.world.spheres.size(), 1);
+	EXPECT_EQ(streamParser.world.spheres[0].material, stringParser.world.spheres[0].material);
+	EXPECT_EQ(streamParser.world.spheres[0].transform, stringParser.world.spheres[0].transform);
+}
+
+TEST(YamlParser, FromFile)
+{
+	const std::string fileName = ::testing::TempDir() + "YamlParserFromFile.yml";
+	{
+		std::ofstream file(fileName);
+		file << "- add: camera\n"
+				"  width: 12\n"
+				"- add: plane\n";
+	}
+	std::ofstream(::testing::TempDir() + "YamlParserEmpty.yml").close();
+
+	YamlParser parser = YamlParser::FromFile(fileName);
+	EXPECT_EQ(parser.worldCamera.hSize, 12);
+	EXPECT_EQ(parser.world.planes.size(), 1);
+	EXPECT_TRUE(YamlParser::FromFile(::testing::TempDir() + "YamlParserEmpty.yml").world.planes.empty());
+	EXPECT_THROW((void)YamlParser::FromFile(::testing::TempDir() + "NoSuchScene.yml"), std::runtime_error);
+}
+
+std::string WriteTriangleObj(const std::string& name)
+{
+	const std::string fileName = ::testing::TempDir() + name;
+	std::ofstream file(fileName);
+	file << "v -1 1 0\n"
+			"v -1 0 0\n"
+			"v 1 0 0\n"
+			"f 1 2 3\n";
+	return fileName;
+}
+
+TEST(YamlParser, AddObjSharesParsedFile)
+{
+	WriteTriangleObj("YamlParserTriangle.obj");
+	std::string objString =
+			"- add: obj\n"
+			"  file: YamlParserTriangle.obj\n"
+			"  material:\n"
+			"    color: [ 1, 0, 0 ]\n"
+			"- add: obj\n"
+			"  file: ./YamlParserTriangle.obj\n"
+			"  transform:\n"
+			"    - [ translate, 0, 0, 5 ]\n";
+
+	YamlParser parser(objString, ::testing::TempDir());
+	ASSERT_EQ(parser.world.instances.size(), 2);
+	EXPECT_EQ(parser.meshes.size(), 1);
+	EXPECT_EQ(parser.world.instances[0].geometry, parser.world.instances[1].geometry);
+	EXPECT_EQ(parser.world.instances[0].material.color, Color(1, 0, 0));
+	EXPECT_EQ(parser.world.instances[1].transform, translation(0, 0, 5));
+
+	const Intersections hits = parser.world.intersect(Ray(Point(-0.5, 0.5, -10), Vector(0, 0, 1)));
+	ASSERT_EQ(hits.size(), 2);
+	EXPECT_FLOAT_EQ(hits[0].t, 10);
+	EXPECT_FLOAT_EQ(hits[1].t, 15);
+}
+
+TEST(YamlParser, ImproperObjCommand)
+{
+	WriteTriangleObj("YamlParserTriangle.obj");
+	std::string missingFileString =
+			"- add: obj\n"
+			"  material:\n"
+			"    color: [ 1, 0, 0 ]\n";
+	std::string unknownFileString =
+			"- add: obj\n"
+			"  file: NoSuchMesh.obj\n";
+	std::string fileOnSphereString =
+			"- add: sphere\n"
+			"  file: YamlParserTriangle.obj\n";
+
+	EXPECT_THROW(YamlParser parser(missingFileString, ::testing::TempDir()), std::runtime_error);
+	EXPECT_THROW(YamlParser parser(unknownFileString, ::testing::TempDir()), std::runtime_error);
+	EXPECT_THROW(YamlParser parser(fileOnSphereString, ::testing::TempDir()), std::runtime_error);
+}
+
+TEST(YamlParser, MaterialTexture)
+{
+	{
+		std::ofstream file(::testing::TempDir() + "YamlParserTexture.ppm");
+		file << "P3\n2 1\n255\n255 0 0 0 0 255\n";
+	}
+	std::string textureString =
+			"- define: earth-material\n"
+			"  value:\n"
+			"    texture: YamlParserTexture.ppm\n"
+			"- add: sphere\n"
+			"  material: earth-material\n"
+			"- add: cube\n"
+			"  material:\n"
+			"    texture: ./YamlParserTexture.ppm\n";
+
+	YamlParser parser(textureString, ::testing::TempDir());
+	ASSERT_EQ(parser.world.spheres.size(), 1);
+	ASSERT_EQ(parser.world.cubes.size(), 1);
+	const std::shared_ptr<const Texture>& texture = parser.world.spheres[0].material.texture;
+	ASSERT_TRUE(texture);
+	EXPECT_EQ(texture->width(), 2);
+	EXPECT_EQ(texture->texel(0, 1, 0), Color(0, 0, 1));
+	// Both paths name the same file, which is read once
+	EXPECT_EQ(parser.world.cubes[0].material.texture, texture);
+}
+
+TEST(YamlParser, ImproperTextureCommand)
+{
+	std::string missingFileString =
+			"- add: sphere\n"
+			"  texture: NoSuchTexture.ppm\n";
+	std::string textureOnCameraString =
+			"- add: camera\n"
+			"  texture: YamlParserTexture.ppm\n";
+	std::string noPathString =
+			"- add: sphere\n"
+			"  texture:\n";
+
+	EXPECT_THROW(YamlParser parser(missingFileString, ::testing::TempDir()), std::runtime_error);
+	EXPECT_THROW(YamlParser parser(textureOnCameraString, ::testing::TempDir()), std::runtime_error);
+	EXPECT_THROW(YamlParser parser(noPathString, ::testing::TempDir()), std::runtime_error);
+}
+
+TEST(YamlParser, AddObjWithDetailLevels)
+{
+	const std::string fileName = ::testing::TempDir() + "YamlParserGrid.obj";
+	{
+		std::ofstream file(fileName);
+		for (int y = 0; y <= 8; y++)
+		{
+			for (int x = 0; x <= 8; x++)
+			{
+				file << "v " << x << " " << y << " 0\n";
+			}
+		}
+		for (int y = 0; y < 8; y++)
+		{
+			for (int x = 0; x < 8; x++)
+			{
+				const int corner = y * 9 + x + 1;
+				file << "f " << corner << " " << corner + 1 << " " << corner + 10 << " " << corner + 9 << "\n";
+			}
+		}
+	}
+	std::string objString =
+			"- add: camera\n"
+			"  width: 100\n"
+			"  height: 100\n"
+			"  field-of-view: 0.5\n"
+			"  from: [ 4, 4, -100000 ]\n"
+			"  to: [ 4, 4, 0 ]\n"
+			"  up: [ 0, 1, 0 ]\n"
+			"- add: obj\n"
+			"  detail-levels: 2\n"
+			"  file: YamlParserGrid.obj\n"
+			"- add: obj\n"
+			"  file: YamlParserGrid.obj\n"
+			"  detail-levels: 5\n";
+
+	YamlParser parser(objString, ::testing::TempDir());
+	ASSERT_EQ(parser.world.instances.size(), 2);
+	const Instance& twoLevels = parser.world.instances[0];
+	ASSERT_EQ(twoLevels.detailLevels.size(), 2);
+	EXPECT_LE(twoLevels.detailLevels[0]->faceCount(), 32);
+	EXPECT_LE(twoLevels.detailLevels[1]->faceCount(), 8);
+	// Levels are shared, and stop once the grid is down to a single face
+	const Instance& allLevels = parser.world.instances[1];
+	ASSERT_EQ(allLevels.detailLevels.size(), 4);
+	EXPECT_EQ(allLevels.detailLevels[0], twoLevels.detailLevels[0]);
+	EXPECT_EQ(allLevels.detailLevels[3]->faceCount(), 1);
+	// Seen from far off, the coarsest level is selected
+	EXPECT_EQ(allLevels.getDetailLevel(), 4);
+}
+
+TEST(YamlParser, ImproperDetailLevelsCommand)
+{
+	WriteTriangleObj("YamlParserTriangle.obj");
+	std::string sphereString =
+			"- add: sphere\n"
+			"  detail-levels: 2\n";
+	std::string missingCountString =
+			"- add: obj\n"
+			"  file: YamlParserTriangle.obj\n"
+			"  detail-levels:\n";
+
+	EXPECT_THROW(YamlParser parser(sphereString, ::testing::TempDir()), std::runtime_error);
+	EXPECT_THROW(YamlParser parser(missingCountString, ::testing::TempDir()), std::runtime_error);
+}
+
+TEST(YamlParser, AddObjWithWeld)
+{
+	{
+		std::ofstream file(::testing::TempDir() + "YamlParserQuad.obj");
+		file << "v 0 0 0\n"
+				"v 1 0 0\n"
+				"v 1 1 0\n"
+				"v 0 0 0\n"
+				"v 1 1 0\n"
+				"v 0 1 0\n"
+				"f 1 2 3\n"
+				"f 4 5 6\n";
+	}
+	std::string objString =
+			"- add: obj\n"
+			"  weld: 0.001\n"
+			"  file: YamlParserQuad.obj\n"
+			"- add: obj\n"
+			"  file: YamlParserQuad.obj\n"
+			"  weld: 0.001\n"
+			"- add: obj\n"
+			"  file: YamlParserQuad.obj\n";
+
+	YamlParser parser(objString, ::testing::TempDir());
+	ASSERT_EQ(parser.world.instances.size(), 3);
+	// Welding applies wherever 'weld:' is written, and welded and unwelded meshes are kept apart
+	EXPECT_EQ(parser.meshes.size(), 2);
+	EXPECT_EQ(parser.world.instances[0].geometry, parser.world.instances[1].geometry);
+	const auto& welded = dynamic_cast<const TriangleMesh&>(parser.world.instances[0].geometry->objects()[0].get());
+	const auto& unwelded = dynamic_cast<const TriangleMesh&>(parser.world.instances[2].geometry->objects()[0].get());
+	EXPECT_EQ(welded.positions().size(), 4);
+	EXPECT_EQ(unwelded.positions().size(), 6);
+}
+
+TEST(YamlParser, ImproperWeldCommand)
+{
+	WriteTriangleObj("YamlParserTriangle.obj");
+	std::string sphereString =
+			"- add: sphere\n"
+			"  weld: 0.001\n";
+	std::string zeroToleranceString =
+			"- add: obj\n"
+			"  file: YamlParserTriangle.obj\n"
+			"  weld: 0\n";
+	std::string missingToleranceString =
+			"- add: obj\n"
+			"  file: YamlParserTriangle.obj\n"
+			"  weld:\n";
+
+	EXPECT_THROW(YamlParser parser(sphereString, ::testing::TempDir()), std::runtime_error);
+	EXPECT_THROW(YamlParser parser(zeroToleranceString, ::testing::TempDir()), std::runtime_error);
+	EXPECT_THROW(YamlParser parser(missingToleranceString, ::testing::TempDir()), std::runtime_error);
+}
+
+TEST(YamlParser, AddGroupWithChildren)
+{
+	std::string groupString =
+			"- add: group\n"
+			"  transform:\n"
+			"    - [ translate, 1, 0, 0 ]\n"
+			"  children:\n"
+			"    - add: sphere\n"
+			"      transform:\n"
+			"        - [ scale, 2, 2, 2 ]\n"
+			"    - add: group\n"
+			"      children:\n"
+			"        - add: cube\n"
+			"    - add: plane\n"
+			"  transform:\n"
+			"    - [ translate, 0, 1, 0 ]\n"
+			"- add: sphere\n";
+
+	YamlParser parser(groupString);
+	ASSERT_EQ(parser.world.groups.size(), 1);
+	ASSERT_EQ(parser.world.spheres.size(), 1);
+	EXPECT_TRUE(parser.world.planes.empty());
+	EXPECT_TRUE(parser.world.cubes.empty());
+
+	const Group& group = parser.world.groups[0];
+	EXPECT_EQ(group.transform, translation(0, 1, 0) * translation(1, 0, 0));
+	const auto children = group.objects();
+	ASSERT_EQ(children.size(), 3);
+	const auto& nested = dynamic_cast<const Group&>(children[0].get());
+	EXPECT_EQ(children[1].get().transform, scaling(2, 2, 2));
+	EXPECT_NE(dynamic_cast<const Plane*>(&children[2].get()), nullptr);
+	EXPECT_EQ(nested.objects().size(), 1);
+	EXPECT_EQ(nested.parent, &group);
+	EXPECT_EQ(parser.world.spheres[0].transform, AffineTransform());
+}
+
+TEST(YamlParser, ImproperGroupCommand)
+{
+	std::string childrenString =
+			"- add: sphere\n"
+			"  children:\n";
+	std::string materialString =
+			"- add: group\n"
+			"  material:\n"
+			"    color: [ 1, 0, 0 ]\n";
+	std::string keyframeString =
+			"- add: sequence\n"
+			"  frames: 2\n"
+			"- add: group\n"
+			"  children:\n"
+			"    - add: sphere\n"
+			"      keyframe: 1\n";
+
+	EXPECT_THROW(YamlParser parser(childrenString), std::runtime_error);
+	EXPECT_THROW(YamlParser parser(materialString), std::runtime_error);
+	EXPECT_THROW(YamlParser parser(keyframeString), std::runtime_error);
+}